@@ -35,12 +35,22 @@ typedef enum {
 
 GsAppList	*gs_app_list_copy		(GsAppList	*list);
 guint		 gs_app_list_get_size_peak	(GsAppList	*list);
+guint		 gs_app_list_get_n_compared	(GsAppList	*list);
 void		 gs_app_list_filter_duplicates	(GsAppList	*list,
 						 GsAppListFilterFlags flags);
 void		 gs_app_list_randomize		(GsAppList	*list);
 void		 gs_app_list_remove_all		(GsAppList	*list);
 void		 gs_app_list_truncate		(GsAppList	*list,
 						 guint		 length);
+void		 gs_app_list_truncate_sorted	(GsAppList	*list,
+						 guint		 length,
+						 GsAppListSortFunc func,
+						 gpointer	 user_data);
+void		 gs_app_list_truncate_sorted_by_key (GsAppList	*list,
+						 guint		 length,
+						 GsAppListSortKeyFunc func,
+						 GsAppListSortFlags flags,
+						 gpointer	 user_data);
 gboolean	 gs_app_list_has_flag		(GsAppList	*list,
 						 GsAppListFlags	 flag);
 void		 gs_app_list_add_flag		(GsAppList	*list,
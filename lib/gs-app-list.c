@@ -20,6 +20,7 @@
 #include "config.h"
 
 #include <glib.h>
+#include <string.h>
 
 #include "gs-app-private.h"
 #include "gs-app-list-private.h"
@@ -31,6 +32,11 @@ struct _GsAppList
 	GObject			 parent_instance;
 	GPtrArray		*array;
 	GMutex			 mutex;
+	GHashTable		*hash_by_id;	/* (nullable) component ID : GPtrArray of GsApp, in list order */
+	GHashTable		*hash_by_ptr;	/* (nullable) (owned) GsApp : first position in the list */
+	GPtrArray		*unindexed;	/* (nullable) GsApps with no unique ID when indexed */
+	gint			 index_stale;	/* (atomic) set by indexed apps, see gs_app_add_unique_id_watch() */
+	guint			 n_compared;	/* unique IDs compared by lookups */
 	guint			 size_peak;
 	GsAppListFlags		 flags;
 	GsAppState		 state;
@@ -164,6 +170,12 @@ static GPtrArray *
 gs_app_list_get_watched (GsAppList *list)
 {
 	GPtrArray *apps = g_ptr_array_new ();
+
+	/* nothing to do, so avoid walking the whole list on every add */
+	if ((list->flags & (GS_APP_LIST_FLAG_WATCH_APPS |
+			    GS_APP_LIST_FLAG_WATCH_APPS_ADDONS |
+			    GS_APP_LIST_FLAG_WATCH_APPS_RELATED)) == 0)
+		return apps;
 	for (guint i = 0; i < list->array->len; i++) {
 		GsApp *app_tmp = g_ptr_array_index (list->array, i);
 		gs_app_list_add_watched_for_app (list, apps, app_tmp);
@@ -281,17 +293,170 @@ gs_app_list_get_size_peak (GsAppList *list)
 	return list->size_peak;
 }
 
+/* The index is a cache of the array, built lazily on the first lookup and
+ * thrown away whenever the array is reordered or shrunk. Appending keeps the
+ * buckets in list order, so only removals and sorts need a rebuild.
+ *
+ * Apps are bucketed by the component ID section of their unique ID, which is
+ * the one section that is never a wildcard in lookups in practice. Apps with
+ * no unique ID yet (lazy-loaded) are kept in @unindexed, and apps whose own
+ * component ID is a wildcard, e.g. from an empty ID, can match any lookup so
+ * their bucket is searched too. Each indexed app sets @index_stale if its
+ * unique ID changes, which drops the index on the next lookup as the app may
+ * be in the wrong bucket. Every bucket hit is still checked with
+ * as_utils_data_id_equal() so the wildcard rules are unchanged. */
+static void
+gs_app_list_index_invalidate (GsAppList *list)
+{
+	GHashTableIter iter;
+	gpointer app;
+
+	if (list->hash_by_ptr != NULL) {
+		g_hash_table_iter_init (&iter, list->hash_by_ptr);
+		while (g_hash_table_iter_next (&iter, &app, NULL))
+			gs_app_remove_unique_id_watch (GS_APP (app), &list->index_stale);
+	}
+	g_clear_pointer (&list->hash_by_id, g_hash_table_unref);
+	g_clear_pointer (&list->hash_by_ptr, g_hash_table_unref);
+	g_clear_pointer (&list->unindexed, g_ptr_array_unref);
+}
+
+/* returns the bucket @app is or would be indexed in, or %NULL */
+static GPtrArray *
+gs_app_list_index_get_bucket (GsAppList *list, GsApp *app, gboolean create)
+{
+	const gchar *unique_id = gs_app_get_unique_id (app);
+	const gchar *cid = NULL;
+	gsize cid_len = 0;
+	g_autofree gchar *cid_key = NULL;
+	GPtrArray *bucket;
+
+	if (unique_id != NULL)
+		cid = gs_app_unique_id_get_cid (unique_id, &cid_len);
+	if (cid == NULL)
+		return list->unindexed;
+	cid_key = g_strndup (cid, cid_len);
+	bucket = g_hash_table_lookup (list->hash_by_id, cid_key);
+	if (bucket == NULL && create) {
+		bucket = g_ptr_array_new ();
+		g_hash_table_insert (list->hash_by_id, g_steal_pointer (&cid_key), bucket);
+	}
+	return bucket;
+}
+
+static void
+gs_app_list_index_add_app (GsAppList *list, GsApp *app, guint position)
+{
+	/* watch before reading the unique ID so that a change in between
+	 * is not missed; the first position is the one lookups return */
+	if (!g_hash_table_contains (list->hash_by_ptr, app)) {
+		g_hash_table_insert (list->hash_by_ptr, g_object_ref (app),
+				     GUINT_TO_POINTER (position));
+		gs_app_add_unique_id_watch (app, &list->index_stale);
+	}
+	g_ptr_array_add (gs_app_list_index_get_bucket (list, app, TRUE), app);
+}
+
+static void
+gs_app_list_index_build (GsAppList *list)
+{
+	if (list->hash_by_id != NULL)
+		return;
+	g_atomic_int_set (&list->index_stale, FALSE);
+	list->hash_by_id = g_hash_table_new_full (g_str_hash, g_str_equal,
+						  g_free, (GDestroyNotify) g_ptr_array_unref);
+	list->hash_by_ptr = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+						   g_object_unref, NULL);
+	list->unindexed = g_ptr_array_new ();
+	for (guint i = 0; i < list->array->len; i++)
+		gs_app_list_index_add_app (list, g_ptr_array_index (list->array, i), i);
+}
+
+static void
+gs_app_list_index_ensure (GsAppList *list)
+{
+	/* an indexed app had its unique ID changed */
+	if (g_atomic_int_get (&list->index_stale))
+		gs_app_list_index_invalidate (list);
+	gs_app_list_index_build (list);
+}
+
 static GsApp *
-gs_app_list_lookup_safe (GsAppList *list, const gchar *unique_id)
+gs_app_list_lookup_linear (GsAppList *list, const gchar *unique_id)
 {
 	for (guint i = 0; i < list->array->len; i++) {
 		GsApp *app = g_ptr_array_index (list->array, i);
+		list->n_compared++;
 		if (as_utils_data_id_equal (gs_app_get_unique_id (app), unique_id))
 			return app;
 	}
 	return NULL;
 }
 
+static GsApp *
+gs_app_list_lookup_bucket (GsAppList *list, GPtrArray *bucket, const gchar *unique_id)
+{
+	if (bucket == NULL)
+		return NULL;
+	for (guint i = 0; i < bucket->len; i++) {
+		GsApp *app = g_ptr_array_index (bucket, i);
+		list->n_compared++;
+		if (as_utils_data_id_equal (gs_app_get_unique_id (app), unique_id))
+			return app;
+	}
+	return NULL;
+}
+
+static GsApp *
+gs_app_list_lookup_safe (GsAppList *list, const gchar *unique_id)
+{
+	GsApp *app;
+	GsApp *app_wildcard;
+	const gchar *cid;
+	gsize cid_len = 0;
+	g_autofree gchar *cid_key = NULL;
+
+	if (unique_id == NULL)
+		return NULL;
+
+	/* wildcard component IDs can match any bucket */
+	cid = gs_app_unique_id_get_cid (unique_id, &cid_len);
+	if (cid == NULL || (cid_len == 1 && cid[0] == '*'))
+		return gs_app_list_lookup_linear (list, unique_id);
+
+	gs_app_list_index_ensure (list);
+	cid_key = g_strndup (cid, cid_len);
+	app = gs_app_list_lookup_bucket (list, g_hash_table_lookup (list->hash_by_id, cid_key), unique_id);
+	app_wildcard = gs_app_list_lookup_bucket (list, g_hash_table_lookup (list->hash_by_id, "*"), unique_id);
+
+	/* the first match in list order wins */
+	if (app == NULL)
+		return app_wildcard;
+	if (app_wildcard != NULL &&
+	    GPOINTER_TO_UINT (g_hash_table_lookup (list->hash_by_ptr, app_wildcard)) <
+	    GPOINTER_TO_UINT (g_hash_table_lookup (list->hash_by_ptr, app)))
+		return app_wildcard;
+	return app;
+}
+
+/**
+ * gs_app_list_get_n_compared:
+ * @list: A #GsAppList
+ *
+ * Gets how many unique IDs have been compared by lookups and duplicate
+ * checks on the list, which is only useful for the self tests.
+ *
+ * Returns: the number of comparisons
+ **/
+guint
+gs_app_list_get_n_compared (GsAppList *list)
+{
+	g_autoptr(GMutexLocker) locker = NULL;
+	g_return_val_if_fail (GS_IS_APP_LIST (list), 0);
+	locker = g_mutex_locker_new (&list->mutex);
+	return list->n_compared;
+}
+
 /**
  * gs_app_list_lookup:
  * @list: A #GsAppList
@@ -353,6 +518,29 @@ gs_app_list_add_flag (GsAppList *list, GsAppListFlags flag)
 	}
 }
 
+static gboolean
+gs_app_list_check_for_duplicate_wildcard (GsAppList *list, GsApp *app)
+{
+	GPtrArray *bucket;
+
+	/* only wildcards with the same component ID can have the same unique ID */
+	gs_app_list_index_ensure (list);
+	bucket = gs_app_list_index_get_bucket (list, app, FALSE);
+	if (bucket == NULL)
+		return TRUE;
+	for (guint i = 0; i < bucket->len; i++) {
+		GsApp *app_tmp = g_ptr_array_index (bucket, i);
+		if (!gs_app_has_quirk (app_tmp, GS_APP_QUIRK_IS_WILDCARD))
+			continue;
+		/* not adding exactly the same wildcard */
+		list->n_compared++;
+		if (g_strcmp0 (gs_app_get_unique_id (app_tmp),
+			       gs_app_get_unique_id (app)) == 0)
+			return FALSE;
+	}
+	return TRUE;
+}
+
 static gboolean
 gs_app_list_check_for_duplicate (GsAppList *list, GsApp *app)
 {
@@ -360,24 +548,13 @@ gs_app_list_check_for_duplicate (GsAppList *list, GsApp *app)
 	const gchar *id;
 
 	/* adding a wildcard */
-	if (gs_app_has_quirk (app, GS_APP_QUIRK_IS_WILDCARD)) {
-		for (guint i = 0; i < list->array->len; i++) {
-			GsApp *app_tmp = g_ptr_array_index (list->array, i);
-			if (!gs_app_has_quirk (app_tmp, GS_APP_QUIRK_IS_WILDCARD))
-				continue;
-			/* not adding exactly the same wildcard */
-			if (g_strcmp0 (gs_app_get_unique_id (app_tmp),
-				       gs_app_get_unique_id (app)) == 0)
-				return FALSE;
-		}
-		return TRUE;
-	}
+	if (gs_app_has_quirk (app, GS_APP_QUIRK_IS_WILDCARD))
+		return gs_app_list_check_for_duplicate_wildcard (list, app);
 
-	for (guint i = 0; i < list->array->len; i++) {
-		GsApp *app_tmp = g_ptr_array_index (list->array, i);
-		if (app_tmp == app)
-			return FALSE;
-	}
+	/* the set of instances is valid even if the ID buckets are not */
+	gs_app_list_index_build (list);
+	if (g_hash_table_contains (list->hash_by_ptr, app))
+		return FALSE;
 
 	/* does not exist */
 	id = gs_app_get_unique_id (app);
@@ -406,25 +583,19 @@ typedef enum {
 static void
 gs_app_list_add_safe (GsAppList *list, GsApp *app, GsAppListAddFlag flag)
 {
-	const gchar *id;
-
 	/* check for duplicate */
 	if ((flag & GS_APP_LIST_ADD_FLAG_CHECK_FOR_DUPE) > 0 &&
 	    !gs_app_list_check_for_duplicate (list, app))
 		return;
 
-	/* if we're lazy-loading the ID then we can't use the ID hash */
-	id = gs_app_get_unique_id (app);
-	if (id == NULL) {
-		gs_app_list_maybe_watch_app (list, app);
-		g_ptr_array_add (list->array, g_object_ref (app));
-		return;
-	}
-
 	/* just use the ref */
 	gs_app_list_maybe_watch_app (list, app);
 	g_ptr_array_add (list->array, g_object_ref (app));
 
+	/* appending keeps the index in list order */
+	if (list->hash_by_id != NULL)
+		gs_app_list_index_add_app (list, app, list->array->len - 1);
+
 	/* update the historical max */
 	if (list->array->len > list->size_peak)
 		list->size_peak = list->array->len;
@@ -478,7 +649,8 @@ gs_app_list_remove (GsAppList *list, GsApp *app)
 	g_return_if_fail (GS_IS_APP (app));
 
 	locker = g_mutex_locker_new (&list->mutex);
-	g_ptr_array_remove (list->array, app);
+	if (g_ptr_array_remove (list->array, app))
+		gs_app_list_index_invalidate (list);
 	gs_app_list_maybe_unwatch_app (list, app);
 
 	/* recalculate global state */
@@ -560,6 +732,7 @@ gs_app_list_remove_all_safe (GsAppList *list)
 		gs_app_list_maybe_unwatch_app (list, app);
 	}
 	g_ptr_array_set_size (list->array, 0);
+	gs_app_list_index_invalidate (list);
 	gs_app_list_invalidate_state (list);
 	gs_app_list_invalidate_progress (list);
 }
@@ -650,6 +823,267 @@ gs_app_list_sort (GsAppList *list, GsAppListSortFunc func, gpointer user_data)
 	helper.func = func;
 	helper.user_data = user_data;
 	g_ptr_array_sort_with_data (list->array, gs_app_list_sort_cb, &helper);
+	gs_app_list_index_invalidate (list);
+}
+
+typedef struct {
+	gchar		*key;  /* (owned) (nullable) */
+	GsApp		*app;  /* (unowned) */
+	guint		 idx;  /* position in the list before sorting */
+} GsAppListSortKey;
+
+static gint
+gs_app_list_sort_key_cb (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+	const GsAppListSortKey *key1 = a;
+	const GsAppListSortKey *key2 = b;
+	GsAppListSortFlags flags = GPOINTER_TO_UINT (user_data);
+
+	if (flags & GS_APP_LIST_SORT_FLAG_DESCENDING)
+		return g_strcmp0 (key2->key, key1->key);
+	return g_strcmp0 (key1->key, key2->key);
+}
+
+/**
+ * gs_app_list_sort_by_key:
+ * @list: A #GsAppList
+ * @func: A #GsAppListSortKeyFunc
+ * @flags: #GsAppListSortFlags, e.g. %GS_APP_LIST_SORT_FLAG_DESCENDING
+ * @user_data: user data to pass to @func
+ *
+ * Sorts the application list by the keys returned from @func, which is
+ * called exactly once for each application rather than once per comparison.
+ * This is much cheaper than gs_app_list_sort() when building a key needs
+ * allocations or collation. Applications with equal keys keep their order.
+ *
+ * Since: 42
+ **/
+void
+gs_app_list_sort_by_key (GsAppList *list,
+			 GsAppListSortKeyFunc func,
+			 GsAppListSortFlags flags,
+			 gpointer user_data)
+{
+	g_autoptr(GMutexLocker) locker = NULL;
+	g_autofree GsAppListSortKey *keys = NULL;
+	guint len;
+
+	g_return_if_fail (GS_IS_APP_LIST (list));
+	g_return_if_fail (func != NULL);
+
+	locker = g_mutex_locker_new (&list->mutex);
+	len = list->array->len;
+	if (len < 2)
+		return;
+
+	/* decorate, sort, undecorate */
+	keys = g_new (GsAppListSortKey, len);
+	for (guint i = 0; i < len; i++) {
+		keys[i].app = g_ptr_array_index (list->array, i);
+		keys[i].key = func (keys[i].app, user_data);
+	}
+	g_qsort_with_data (keys, (gint) len, sizeof (GsAppListSortKey),
+			   gs_app_list_sort_key_cb, GUINT_TO_POINTER (flags));
+	for (guint i = 0; i < len; i++) {
+		list->array->pdata[i] = keys[i].app;
+		g_free (keys[i].key);
+	}
+	gs_app_list_index_invalidate (list);
+}
+
+typedef struct {
+	GsAppListSortFunc	 func;  /* (nullable) */
+	GsAppListSortKeyFunc	 key_func;  /* (nullable) */
+	GsAppListSortFlags	 flags;
+	gpointer		 user_data;
+} GsAppListSelectHelper;
+
+/* a total order, falling back to the list position so that the selection
+ * gives the same result as a stable sort */
+static gint
+gs_app_list_select_cb (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+	const GsAppListSortKey *key1 = a;
+	const GsAppListSortKey *key2 = b;
+	const GsAppListSelectHelper *helper = user_data;
+	gint rc;
+
+	if (helper->func != NULL)
+		rc = helper->func (key1->app, key2->app, helper->user_data);
+	else
+		rc = gs_app_list_sort_key_cb (key1, key2, GUINT_TO_POINTER (helper->flags));
+	if (rc != 0)
+		return rc;
+	if (key1->idx < key2->idx)
+		return -1;
+	return key1->idx > key2->idx ? 1 : 0;
+}
+
+/* the largest key of the heap is at the root */
+static void
+gs_app_list_heap_sift_down (GsAppListSortKey *heap,
+			    guint len,
+			    guint i,
+			    const GsAppListSelectHelper *helper)
+{
+	for (;;) {
+		guint largest = i;
+		guint left = 2 * i + 1;
+		guint right = left + 1;
+		GsAppListSortKey tmp;
+
+		if (left < len &&
+		    gs_app_list_select_cb (&heap[left], &heap[largest], (gpointer) helper) > 0)
+			largest = left;
+		if (right < len &&
+		    gs_app_list_select_cb (&heap[right], &heap[largest], (gpointer) helper) > 0)
+			largest = right;
+		if (largest == i)
+			return;
+		tmp = heap[i];
+		heap[i] = heap[largest];
+		heap[largest] = tmp;
+		i = largest;
+	}
+}
+
+static void
+gs_app_list_truncate_sorted_internal (GsAppList *list,
+				      guint length,
+				      const GsAppListSelectHelper *helper)
+{
+	g_autoptr(GMutexLocker) locker = NULL;
+	g_autofree GsAppListSortKey *heap = NULL;
+	g_autofree gboolean *selected = NULL;
+	g_autofree gpointer *pdata = NULL;
+	guint len;
+	guint n_heap;
+	guint n_pdata;
+
+	/* everything */
+	if (length == 0) {
+		list->flags |= GS_APP_LIST_FLAG_IS_TRUNCATED;
+		gs_app_list_remove_all (list);
+		return;
+	}
+
+	locker = g_mutex_locker_new (&list->mutex);
+	len = list->array->len;
+	if (len < 2)
+		return;
+
+	/* keep the smallest @length apps seen so far in a bounded max-heap,
+	 * so each of the other apps costs at most O(log @length) compares */
+	n_heap = MIN (length, len);
+	heap = g_new (GsAppListSortKey, n_heap);
+	for (guint i = 0; i < len; i++) {
+		GsAppListSortKey key;
+
+		key.app = g_ptr_array_index (list->array, i);
+		key.idx = i;
+		key.key = helper->key_func != NULL ? helper->key_func (key.app, helper->user_data) : NULL;
+		if (i < n_heap) {
+			heap[i] = key;
+			if (i == n_heap - 1) {
+				for (guint j = n_heap / 2; j > 0; j--)
+					gs_app_list_heap_sift_down (heap, n_heap, j - 1, helper);
+			}
+			continue;
+		}
+		if (gs_app_list_select_cb (&key, &heap[0], (gpointer) helper) < 0) {
+			g_free (heap[0].key);
+			heap[0] = key;
+			gs_app_list_heap_sift_down (heap, n_heap, 0, helper);
+		} else {
+			g_free (key.key);
+		}
+	}
+
+	/* only the survivors need sorting */
+	g_qsort_with_data (heap, (gint) n_heap, sizeof (GsAppListSortKey),
+			   gs_app_list_select_cb, (gpointer) helper);
+
+	/* put the survivors first, in order, and the rest after them so they
+	 * get unreffed when the array is shrunk */
+	selected = g_new0 (gboolean, len);
+	pdata = g_new (gpointer, len);
+	for (guint i = 0; i < n_heap; i++) {
+		pdata[i] = heap[i].app;
+		selected[heap[i].idx] = TRUE;
+		g_free (heap[i].key);
+	}
+	n_pdata = n_heap;
+	for (guint i = 0; i < len; i++) {
+		if (!selected[i])
+			pdata[n_pdata++] = g_ptr_array_index (list->array, i);
+	}
+	memcpy (list->array->pdata, pdata, len * sizeof (gpointer));
+
+	if (n_heap < len) {
+		list->flags |= GS_APP_LIST_FLAG_IS_TRUNCATED;
+		g_ptr_array_set_size (list->array, n_heap);
+	}
+	gs_app_list_index_invalidate (list);
+}
+
+/**
+ * gs_app_list_truncate_sorted:
+ * @list: A #GsAppList
+ * @length: the new length
+ * @func: A #GsAppListSortFunc
+ * @user_data: user data to pass to @func
+ *
+ * Keeps only the first @length applications of the list as sorted by @func,
+ * in sorted order. This gives the same result as a stable sort followed by
+ * gs_app_list_truncate(), but only the applications which are kept are fully
+ * sorted, so it is much cheaper when @length is small compared to the size
+ * of the list.
+ *
+ * If the list has no more than @length applications it is just sorted.
+ *
+ * Since: 42
+ **/
+void
+gs_app_list_truncate_sorted (GsAppList *list,
+			     guint length,
+			     GsAppListSortFunc func,
+			     gpointer user_data)
+{
+	GsAppListSelectHelper helper = { func, NULL, GS_APP_LIST_SORT_FLAG_NONE, user_data };
+
+	g_return_if_fail (GS_IS_APP_LIST (list));
+	g_return_if_fail (func != NULL);
+
+	gs_app_list_truncate_sorted_internal (list, length, &helper);
+}
+
+/**
+ * gs_app_list_truncate_sorted_by_key:
+ * @list: A #GsAppList
+ * @length: the new length
+ * @func: A #GsAppListSortKeyFunc
+ * @flags: #GsAppListSortFlags, e.g. %GS_APP_LIST_SORT_FLAG_DESCENDING
+ * @user_data: user data to pass to @func
+ *
+ * Keeps only the first @length applications of the list as sorted by the keys
+ * returned from @func, in the same way as gs_app_list_truncate_sorted().
+ * @func is called exactly once for each application.
+ *
+ * Since: 42
+ **/
+void
+gs_app_list_truncate_sorted_by_key (GsAppList *list,
+				    guint length,
+				    GsAppListSortKeyFunc func,
+				    GsAppListSortFlags flags,
+				    gpointer user_data)
+{
+	GsAppListSelectHelper helper = { NULL, func, flags, user_data };
+
+	g_return_if_fail (GS_IS_APP_LIST (list));
+	g_return_if_fail (func != NULL);
+
+	gs_app_list_truncate_sorted_internal (list, length, &helper);
 }
 
 /**
@@ -682,6 +1116,7 @@ gs_app_list_truncate (GsAppList *list, guint length)
 	/* remove the apps in the positions larger than the length */
 	locker = g_mutex_locker_new (&list->mutex);
 	g_ptr_array_set_size (list->array, length);
+	gs_app_list_index_invalidate (list);
 }
 
 static gint
@@ -738,6 +1173,7 @@ gs_app_list_randomize (GsAppList *list)
 		gs_app_set_metadata (app, key, sort_key);
 	}
 	g_ptr_array_sort_with_data (list->array, gs_app_list_randomize_cb, list);
+	gs_app_list_index_invalidate (list);
 	for (i = 0; i < gs_app_list_length (list); i++) {
 		app = gs_app_list_index (list, i);
 		gs_app_set_metadata (app, key, NULL);
@@ -764,56 +1200,200 @@ gs_app_list_filter_app_is_better (GsApp *app, GsApp *found, GsAppListFilterFlags
 	return FALSE;
 }
 
-static GPtrArray *
-gs_app_list_filter_app_get_keys (GsApp *app, GsAppListFilterFlags flags)
+/* A key used to find duplicates. This is the concatenation of the pieces,
+ * which are borrowed from the app so no strings are built; a key with no
+ * pieces stands for the app instance itself. */
+typedef struct {
+	const gchar	*pieces[5];  /* (unowned) */
+	guint		 n_pieces;
+	guint		 hash;
+	guint		 idx;  /* position in the list, or G_MAXUINT if unused */
+} GsAppListFilterKey;
+
+/* an open-addressing hash table of GsAppListFilterKey, with linear probing */
+typedef struct {
+	GsAppListFilterKey	*slots;
+	guint			 mask;
+	guint			 n_used;
+} GsAppListFilterTable;
+
+/* hashes the same way as g_str_hash() on the concatenated pieces */
+static void
+gs_app_list_filter_add_key (GArray *keys,
+			    guint idx,
+			    const gchar * const *pieces,
+			    guint n_pieces)
 {
-	GPtrArray *keys = g_ptr_array_new_with_free_func (g_free);
-	g_autoptr(GString) key = NULL;
+	GsAppListFilterKey key = { { NULL }, n_pieces, 5381, idx };
+
+	for (guint i = 0; i < n_pieces; i++) {
+		key.pieces[i] = pieces[i];
+		for (const gchar *p = pieces[i]; *p != '\0'; p++)
+			key.hash = (key.hash << 5) + key.hash + (guint) (guchar) *p;
+	}
+	g_array_append_val (keys, key);
+}
+
+static void
+gs_app_list_filter_app_get_keys (GsApp *app,
+				 guint idx,
+				 GsAppListFilterFlags flags,
+				 GArray *keys)
+{
+	const gchar *pieces[5];
+	guint n_pieces = 0;
+	gsize key_len = 0;
+
+	g_array_set_size (keys, 0);
 
 	/* just use the unique ID */
 	if (flags == GS_APP_LIST_FILTER_FLAG_NONE) {
-		if (gs_app_get_unique_id (app) != NULL)
-			g_ptr_array_add (keys, g_strdup (gs_app_get_unique_id (app)));
-		return keys;
+		const gchar *unique_id = gs_app_get_unique_id (app);
+		if (unique_id != NULL)
+			gs_app_list_filter_add_key (keys, idx, &unique_id, 1);
+		return;
 	}
 
 	/* use the ID and any provided items */
 	if (flags & GS_APP_LIST_FILTER_FLAG_KEY_ID_PROVIDES) {
 		GPtrArray *provided = gs_app_get_provided (app);
-		g_ptr_array_add (keys, g_strdup (gs_app_get_id (app)));
+		const gchar *id = gs_app_get_id (app);
+		if (id != NULL)
+			gs_app_list_filter_add_key (keys, idx, &id, 1);
 		for (guint i = 0; i < provided->len; i++) {
 			AsProvided *prov = g_ptr_array_index (provided, i);
 			GPtrArray *items;
 			if (as_provided_get_kind (prov) != AS_PROVIDED_KIND_ID)
 				continue;
 			items = as_provided_get_items (prov);
-			for (guint j = 0; j < items->len; j++)
-				g_ptr_array_add (keys, g_strdup (g_ptr_array_index (items, j)));
+			for (guint j = 0; j < items->len; j++) {
+				const gchar *item = g_ptr_array_index (items, j);
+				gs_app_list_filter_add_key (keys, idx, &item, 1);
+			}
 		}
-		return keys;
+		return;
 	}
 
-	/* specific compound type */
-	key = g_string_new (NULL);
+	/* specific compound type, joined with ':' */
 	if (flags & GS_APP_LIST_FILTER_FLAG_KEY_ID) {
 		const gchar *tmp = gs_app_get_id (app);
 		if (tmp != NULL)
-			g_string_append (key, gs_app_get_id (app));
+			pieces[n_pieces++] = tmp;
 	}
 	if (flags & GS_APP_LIST_FILTER_FLAG_KEY_SOURCE) {
 		const gchar *tmp = gs_app_get_source_default (app);
-		if (tmp != NULL)
-			g_string_append_printf (key, ":%s", tmp);
+		if (tmp != NULL) {
+			pieces[n_pieces++] = ":";
+			pieces[n_pieces++] = tmp;
+		}
 	}
 	if (flags & GS_APP_LIST_FILTER_FLAG_KEY_VERSION) {
 		const gchar *tmp = gs_app_get_version (app);
-		if (tmp != NULL)
-			g_string_append_printf (key, ":%s", tmp);
+		if (tmp != NULL) {
+			pieces[n_pieces++] = ":";
+			pieces[n_pieces++] = tmp;
+		}
+	}
+	for (guint i = 0; i < n_pieces; i++)
+		key_len += strlen (pieces[i]);
+	if (key_len == 0)
+		return;
+	gs_app_list_filter_add_key (keys, idx, pieces, n_pieces);
+}
+
+static gboolean
+gs_app_list_filter_key_equal (GPtrArray *array,
+			      const GsAppListFilterKey *key1,
+			      const GsAppListFilterKey *key2)
+{
+	const gchar *s1;
+	const gchar *s2;
+	guint i1 = 0;
+	guint i2 = 0;
+
+	if (key1->hash != key2->hash)
+		return FALSE;
+
+	/* the same instance */
+	if (key1->n_pieces == 0 || key2->n_pieces == 0) {
+		return key1->n_pieces == key2->n_pieces &&
+		       g_ptr_array_index (array, key1->idx) == g_ptr_array_index (array, key2->idx);
+	}
+
+	/* compare the concatenated pieces */
+	s1 = key1->pieces[0];
+	s2 = key2->pieces[0];
+	for (;;) {
+		while (*s1 == '\0' && ++i1 < key1->n_pieces)
+			s1 = key1->pieces[i1];
+		while (*s2 == '\0' && ++i2 < key2->n_pieces)
+			s2 = key2->pieces[i2];
+		if (*s1 != *s2)
+			return FALSE;
+		if (*s1 == '\0')
+			return TRUE;
+		s1++;
+		s2++;
+	}
+}
+
+static void
+gs_app_list_filter_table_init (GsAppListFilterTable *table, guint n_keys)
+{
+	guint size = 16;
+
+	/* keep the load factor below a half */
+	while (size < n_keys * 2)
+		size *= 2;
+	table->slots = g_new (GsAppListFilterKey, size);
+	for (guint i = 0; i < size; i++)
+		table->slots[i].idx = G_MAXUINT;
+	table->mask = size - 1;
+	table->n_used = 0;
+}
+
+/* returns the slot holding @key, or the empty slot where it would go */
+static GsAppListFilterKey *
+gs_app_list_filter_table_lookup (GsAppListFilterTable *table,
+				 GPtrArray *array,
+				 const GsAppListFilterKey *key)
+{
+	for (guint i = key->hash & table->mask;; i = (i + 1) & table->mask) {
+		GsAppListFilterKey *slot = &table->slots[i];
+		if (slot->idx == G_MAXUINT ||
+		    gs_app_list_filter_key_equal (array, slot, key))
+			return slot;
+	}
+}
+
+static void
+gs_app_list_filter_table_insert (GsAppListFilterTable *table,
+				 GPtrArray *array,
+				 const GsAppListFilterKey *key)
+{
+	GsAppListFilterKey *slot = gs_app_list_filter_table_lookup (table, array, key);
+
+	/* replace the app for an existing key */
+	if (slot->idx != G_MAXUINT) {
+		slot->idx = key->idx;
+		return;
+	}
+	*slot = *key;
+	table->n_used++;
+
+	/* grow */
+	if (table->n_used * 2 > table->mask + 1) {
+		g_autofree GsAppListFilterKey *slots = table->slots;
+		guint n_used = table->n_used;
+		guint size = table->mask + 1;
+
+		gs_app_list_filter_table_init (table, size);
+		for (guint i = 0; i < size; i++) {
+			if (slots[i].idx != G_MAXUINT)
+				*gs_app_list_filter_table_lookup (table, array, &slots[i]) = slots[i];
+		}
+		table->n_used = n_used;
 	}
-	if (key->len == 0)
-		return keys;
-	g_ptr_array_add (keys, g_string_free (g_steal_pointer (&key), FALSE));
-	return keys;
 }
 
 /**
@@ -828,73 +1408,97 @@ gs_app_list_filter_app_get_keys (GsApp *app, GsAppListFilterFlags flags)
 void
 gs_app_list_filter_duplicates (GsAppList *list, GsAppListFilterFlags flags)
 {
-	g_autoptr(GHashTable) hash = NULL;
-	g_autoptr(GHashTable) kept_apps = NULL;
-	g_autoptr(GsAppList) old = NULL;
+	GsAppListFilterTable table;
+	g_autoptr(GArray) keys = NULL;
 	g_autoptr(GMutexLocker) locker = NULL;
+	g_autofree gboolean *kept = NULL;
+	g_autofree GsAppListFilterKey *slots = NULL;
+	gboolean watching;
+	guint len;
+	guint n_kept = 0;
 
 	g_return_if_fail (GS_IS_APP_LIST (list));
 
 	locker = g_mutex_locker_new (&list->mutex);
+	len = list->array->len;
+	if (len < 2)
+		return;
 
-	/* a hash table to hold apps with unique app ids */
-	hash = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
-	/* a hash table containing apps we want to keep */
-	kept_apps = g_hash_table_new (g_direct_hash, g_direct_equal);
-
-	for (guint i = 0; i < list->array->len; i++) {
-		GsApp *app = gs_app_list_index (list, i);
-		GsApp *found = NULL;
-		g_autoptr(GPtrArray) keys = NULL;
+	/* the keys of the apps we want to keep, and the keys of the app being
+	 * looked at, which are reused for each app */
+	gs_app_list_filter_table_init (&table, len);
+	keys = g_array_sized_new (FALSE, FALSE, sizeof (GsAppListFilterKey), 8);
+	kept = g_new0 (gboolean, len);
 
-		/* get all the keys used to identify this app */
-		keys = gs_app_list_filter_app_get_keys (app, flags);
+	for (guint i = 0; i < len; i++) {
+		GsApp *app = g_ptr_array_index (list->array, i);
+		guint found = G_MAXUINT;
+
+		/* get all the keys used to identify this app, and fall back to
+		 * the instance in case the same one is in the list twice */
+		gs_app_list_filter_app_get_keys (app, i, flags, keys);
+		if (keys->len == 0) {
+			GsAppListFilterKey key = { { NULL }, 0, g_direct_hash (app), i };
+			g_array_append_val (keys, key);
+		}
 		for (guint j = 0; j < keys->len; j++) {
-			const gchar *key = g_ptr_array_index (keys, j);
-			found = g_hash_table_lookup (hash, key);
-			if (found != NULL)
+			const GsAppListFilterKey *key = &g_array_index (keys, GsAppListFilterKey, j);
+			found = gs_app_list_filter_table_lookup (&table, list->array, key)->idx;
+			if (found != G_MAXUINT)
 				break;
 		}
 
-		/* new app */
-		if (found == NULL) {
+		/* new app, or better than the one we had */
+		if (found == G_MAXUINT ||
+		    (flags != GS_APP_LIST_FILTER_FLAG_NONE &&
+		     gs_app_list_filter_app_is_better (app, g_ptr_array_index (list->array, found), flags))) {
 			for (guint j = 0; j < keys->len; j++) {
-				const gchar *key = g_ptr_array_index (keys, j);
-				g_hash_table_insert (hash, g_strdup (key), app);
+				gs_app_list_filter_table_insert (&table, list->array,
+								 &g_array_index (keys, GsAppListFilterKey, j));
 			}
-			g_hash_table_add (kept_apps, app);
-			continue;
+			if (found != G_MAXUINT)
+				kept[found] = FALSE;
+			kept[i] = TRUE;
 		}
+	}
+	slots = table.slots;
 
-		/* better? */
-		if (flags != GS_APP_LIST_FILTER_FLAG_NONE) {
-			if (gs_app_list_filter_app_is_better (app, found, flags)) {
-				for (guint j = 0; j < keys->len; j++) {
-					const gchar *key = g_ptr_array_index (keys, j);
-					g_hash_table_insert (hash, g_strdup (key), app);
-				}
-				g_hash_table_remove (kept_apps, found);
-				g_hash_table_add (kept_apps, app);
-				continue;
-			}
-			continue;
-		}
-		continue;
+	for (guint i = 0; i < len; i++) {
+		if (kept[i])
+			n_kept++;
 	}
+	if (n_kept == len)
+		return;
 
-	/* deep copy to a temp list and clear the current one */
-	old = gs_app_list_copy (list);
-	gs_app_list_remove_all_safe (list);
+	/* the related apps may be shared, so watch the kept apps again */
+	watching = (list->flags & (GS_APP_LIST_FLAG_WATCH_APPS |
+				   GS_APP_LIST_FLAG_WATCH_APPS_ADDONS |
+				   GS_APP_LIST_FLAG_WATCH_APPS_RELATED)) != 0;
+	if (watching) {
+		for (guint i = 0; i < len; i++)
+			gs_app_list_maybe_unwatch_app (list, g_ptr_array_index (list->array, i));
+	}
 
-	/* add back the apps we want to keep */
-	for (guint i = 0; i < old->array->len; i++) {
-		GsApp *app = gs_app_list_index (old, i);
-		if (g_hash_table_contains (kept_apps, app)) {
-			gs_app_list_add_safe (list, app, GS_APP_LIST_ADD_FLAG_NONE);
-			/* In case the same instance is in the 'list' multiple times */
-			g_hash_table_remove (kept_apps, app);
-		}
+	/* move the kept apps to the front in order, and drop the rest */
+	n_kept = 0;
+	for (guint i = 0; i < len; i++) {
+		gpointer tmp;
+		if (!kept[i])
+			continue;
+		tmp = list->array->pdata[n_kept];
+		list->array->pdata[n_kept] = list->array->pdata[i];
+		list->array->pdata[i] = tmp;
+		n_kept++;
 	}
+	g_ptr_array_set_size (list->array, n_kept);
+
+	if (watching) {
+		for (guint i = 0; i < n_kept; i++)
+			gs_app_list_maybe_watch_app (list, g_ptr_array_index (list->array, i));
+	}
+	gs_app_list_index_invalidate (list);
+	gs_app_list_invalidate_state (list);
+	gs_app_list_invalidate_progress (list);
 }
 
 /**
@@ -954,6 +1558,7 @@ static void
 gs_app_list_finalize (GObject *object)
 {
 	GsAppList *list = GS_APP_LIST (object);
+	gs_app_list_index_invalidate (list);
 	g_ptr_array_unref (list->array);
 	g_mutex_clear (&list->mutex);
 	G_OBJECT_CLASS (gs_app_list_parent_class)->finalize (object);
@@ -42,6 +42,21 @@ typedef enum {
 /* All the properties which use #GsAppListFilterFlags are guint64s. */
 G_STATIC_ASSERT (sizeof (GsAppListFilterFlags) == sizeof (guint64));
 
+/**
+ * GsAppListSortFlags:
+ * @GS_APP_LIST_SORT_FLAG_NONE:		No flags set
+ * @GS_APP_LIST_SORT_FLAG_DESCENDING:	Sort the keys in descending order
+ *
+ * Flags to use when sorting with gs_app_list_sort_by_key().
+ *
+ * Since: 42
+ **/
+typedef enum {
+	GS_APP_LIST_SORT_FLAG_NONE		= 0,
+	GS_APP_LIST_SORT_FLAG_DESCENDING	= 1 << 0,
+	GS_APP_LIST_SORT_FLAG_LAST,  /*< skip >*/
+} GsAppListSortFlags;
+
 #define GS_TYPE_APP_LIST (gs_app_list_get_type ())
 
 G_DECLARE_FINAL_TYPE (GsAppList, gs_app_list, GS, APP_LIST, GObject)
@@ -61,6 +76,21 @@ G_DECLARE_FINAL_TYPE (GsAppList, gs_app_list, GS, APP_LIST, GObject)
 typedef gint	 (*GsAppListSortFunc)		(GsApp		*app1,
 						 GsApp		*app2,
 						 gpointer	 user_data);
+
+/**
+ * GsAppListSortKeyFunc:
+ * @app: a #GsApp
+ * @user_data: user data passed into the sort function
+ *
+ * Builds a key for @app which sorts in the wanted order when compared with
+ * strcmp(). It is called once for each app in a sort.
+ *
+ * Returns: (transfer full) (nullable): a newly allocated sort key, or %NULL
+ *     to sort before every other key
+ * Since: 42
+ */
+typedef gchar	*(*GsAppListSortKeyFunc)	(GsApp		*app,
+						 gpointer	 user_data);
 typedef gboolean (*GsAppListFilterFunc)		(GsApp		*app,
 						 gpointer	 user_data);
 
@@ -79,6 +109,10 @@ guint		 gs_app_list_length		(GsAppList	*list);
 void		 gs_app_list_sort		(GsAppList	*list,
 						 GsAppListSortFunc func,
 						 gpointer	 user_data);
+void		 gs_app_list_sort_by_key	(GsAppList	*list,
+						 GsAppListSortKeyFunc func,
+						 GsAppListSortFlags flags,
+						 gpointer	 user_data);
 void		 gs_app_list_filter		(GsAppList	*list,
 						 GsAppListFilterFunc func,
 						 gpointer	 user_data);
@@ -26,5 +26,14 @@ void		 gs_app_set_pending_action	(GsApp		*app,
 						 GsPluginAction	 action);
 gint		 gs_app_compare_priority	(GsApp		*app1,
 						 GsApp		*app2);
+void		 gs_app_get_notify_stats	(guint		*n_queued,
+						 guint		*n_merged,
+						 guint		*n_dispatched);
+const gchar	*gs_app_unique_id_get_cid	(const gchar	*unique_id,
+						 gsize		*cid_len);
+void		 gs_app_add_unique_id_watch	(GsApp		*app,
+						 gint		*stale);
+void		 gs_app_remove_unique_id_watch	(GsApp		*app,
+						 gint		*stale);
 
 G_END_DECLS
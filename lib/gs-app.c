@@ -45,6 +45,7 @@
 #include "gs-desktop-data.h"
 #include "gs-enums.h"
 #include "gs-icon.h"
+#include "gs-icon-pack.h"
 #include "gs-key-colors.h"
 #include "gs-os-release.h"
 #include "gs-plugin.h"
@@ -60,8 +61,10 @@ typedef struct
 	gchar			*id;
 	gchar			*unique_id;
 	gboolean		 unique_id_valid;
+	GPtrArray		*unique_id_watches;	/* (nullable) (element-type gint) (not owned) */
 	gchar			*branch;
 	gchar			*name;
+	gchar			*name_sort_key;  /* (nullable) (owned), from @name, computed on demand */
 	gchar			*renamed_from;
 	GsAppQuality		 name_quality;
 	GPtrArray		*icons;  /* (nullable) (owned) (element-type AsIcon), sorted by pixel size, smallest first */
@@ -361,6 +364,113 @@ gs_app_get_unique_id_unlocked (GsApp *app)
 	return priv->unique_id;
 }
 
+/**
+ * gs_app_unique_id_get_cid:
+ * @unique_id: a unique ID, e.g. `system/flatpak/flathub/org.gimp.GIMP/stable`
+ * @cid_len: (out): return location for the length of the component ID
+ *
+ * Finds the component ID section of a unique ID, without copying it.
+ *
+ * Returns: a pointer into @unique_id, or %NULL if it is not made of five
+ *   sections
+ **/
+const gchar *
+gs_app_unique_id_get_cid (const gchar *unique_id, gsize *cid_len)
+{
+	const gchar *cid = unique_id;
+	const gchar *end;
+
+	/* scope/bundle-kind/origin/cid/branch */
+	for (guint i = 0; i < 3; i++) {
+		cid = strchr (cid, '/');
+		if (cid == NULL)
+			return NULL;
+		cid++;
+	}
+	end = strchr (cid, '/');
+	if (end == NULL || strchr (end + 1, '/') != NULL)
+		return NULL;
+	*cid_len = (gsize) (end - cid);
+	return cid;
+}
+
+/* mutex must be held */
+static void
+gs_app_notify_unique_id_watches_unlocked (GsApp *app)
+{
+	GsAppPrivate *priv = gs_app_get_instance_private (app);
+
+	if (priv->unique_id_watches == NULL)
+		return;
+	for (guint i = 0; i < priv->unique_id_watches->len; i++)
+		g_atomic_int_set ((gint *) g_ptr_array_index (priv->unique_id_watches, i), TRUE);
+}
+
+/* mutex must be held */
+static void
+gs_app_invalidate_unique_id_unlocked (GsApp *app)
+{
+	GsAppPrivate *priv = gs_app_get_instance_private (app);
+	const gchar *cid = NULL;
+	const gchar *id;
+	gsize cid_len = 0;
+
+	priv->unique_id_valid = FALSE;
+
+	/* the rebuilt unique ID takes its component ID from @id, which may
+	 * not be the one in the unique ID the app was last indexed under */
+	if (priv->id == NULL) {
+		gs_app_notify_unique_id_watches_unlocked (app);
+		return;
+	}
+	id = priv->id[0] != '\0' ? priv->id : "*";
+	if (priv->unique_id != NULL)
+		cid = gs_app_unique_id_get_cid (priv->unique_id, &cid_len);
+	if (cid == NULL || strlen (id) != cid_len || strncmp (cid, id, cid_len) != 0)
+		gs_app_notify_unique_id_watches_unlocked (app);
+}
+
+/**
+ * gs_app_add_unique_id_watch:
+ * @app: a #GsApp
+ * @stale: a flag to set
+ *
+ * Asks for @stale to be atomically set to %TRUE whenever the component ID
+ * section of the unique ID of @app may have changed, so that anything
+ * indexing apps by it can tell when its index has gone stale.
+ *
+ * The same flag may be added to many apps, but only once to each.
+ **/
+void
+gs_app_add_unique_id_watch (GsApp *app, gint *stale)
+{
+	GsAppPrivate *priv = gs_app_get_instance_private (app);
+	g_autoptr(GMutexLocker) locker = NULL;
+	g_return_if_fail (GS_IS_APP (app));
+	locker = g_mutex_locker_new (&priv->mutex);
+	if (priv->unique_id_watches == NULL)
+		priv->unique_id_watches = g_ptr_array_new ();
+	g_ptr_array_add (priv->unique_id_watches, stale);
+}
+
+/**
+ * gs_app_remove_unique_id_watch:
+ * @app: a #GsApp
+ * @stale: a flag added with gs_app_add_unique_id_watch()
+ *
+ * Stops setting @stale when the unique ID of @app changes.
+ **/
+void
+gs_app_remove_unique_id_watch (GsApp *app, gint *stale)
+{
+	GsAppPrivate *priv = gs_app_get_instance_private (app);
+	g_autoptr(GMutexLocker) locker = NULL;
+	g_return_if_fail (GS_IS_APP (app));
+	locker = g_mutex_locker_new (&priv->mutex);
+	if (priv->unique_id_watches != NULL)
+		g_ptr_array_remove_fast (priv->unique_id_watches, stale);
+}
+
 /**
  * gs_app_compare_priority:
  * @app1: a #GsApp
@@ -767,20 +877,41 @@ gs_app_to_string_append (GsApp *app, GString *str)
 	g_string_append_printf (str, "\n");
 }
 
+/* Property changes are notified from an idle in the default main context,
+ * as they can happen in any thread. Rather than adding a source for every
+ * change, collect the (app, pspec) pairs until the next idle dispatch and
+ * only notify each of them once, in the order they were first queued. */
 typedef struct {
-	GsApp *app;
-	GParamSpec *pspec;
-} AppNotifyData;
+	GMutex		 mutex;
+	GHashTable	*pending;	/* (owned) GsApp : (owned) GPtrArray of GParamSpec */
+	GPtrArray	*pending_apps;	/* (element-type GsApp) (unowned), in queued order */
+	guint		 idle_id;
+	guint		 n_queued;
+	guint		 n_merged;
+	guint		 n_dispatched;
+} GsAppNotifyQueue;
+
+static GsAppNotifyQueue notify_queue;
 
 static gboolean
 notify_idle_cb (gpointer data)
 {
-	AppNotifyData *notify_data = data;
-
-	g_object_notify_by_pspec (G_OBJECT (notify_data->app), notify_data->pspec);
-
-	g_object_unref (notify_data->app);
-	g_free (notify_data);
+	g_autoptr(GHashTable) pending = NULL;
+	g_autoptr(GPtrArray) pending_apps = NULL;
+
+	g_mutex_lock (&notify_queue.mutex);
+	pending = g_steal_pointer (&notify_queue.pending);
+	pending_apps = g_steal_pointer (&notify_queue.pending_apps);
+	notify_queue.idle_id = 0;
+	notify_queue.n_dispatched++;
+	g_mutex_unlock (&notify_queue.mutex);
+
+	for (guint i = 0; i < pending_apps->len; i++) {
+		GsApp *app = g_ptr_array_index (pending_apps, i);
+		GPtrArray *pspecs = g_hash_table_lookup (pending, app);
+		for (guint j = 0; j < pspecs->len; j++)
+			g_object_notify_by_pspec (G_OBJECT (app), g_ptr_array_index (pspecs, j));
+	}
 
 	return G_SOURCE_REMOVE;
 }
@@ -788,13 +919,53 @@ notify_idle_cb (gpointer data)
 static void
 gs_app_queue_notify (GsApp *app, GParamSpec *pspec)
 {
-	AppNotifyData *notify_data;
+	GPtrArray *pspecs;
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&notify_queue.mutex);
+
+	notify_queue.n_queued++;
+	if (notify_queue.pending == NULL) {
+		notify_queue.pending = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+							      g_object_unref,
+							      (GDestroyNotify) g_ptr_array_unref);
+		notify_queue.pending_apps = g_ptr_array_new ();
+	}
+	pspecs = g_hash_table_lookup (notify_queue.pending, app);
+	if (pspecs == NULL) {
+		pspecs = g_ptr_array_new ();
+		g_hash_table_insert (notify_queue.pending, g_object_ref (app), pspecs);
+		g_ptr_array_add (notify_queue.pending_apps, app);
+	}
+	if (g_ptr_array_find (pspecs, pspec, NULL))
+		notify_queue.n_merged++;
+	else
+		g_ptr_array_add (pspecs, pspec);
 
-	notify_data = g_new (AppNotifyData, 1);
-	notify_data->app = g_object_ref (app);
-	notify_data->pspec = pspec;
+	if (notify_queue.idle_id == 0)
+		notify_queue.idle_id = g_idle_add (notify_idle_cb, NULL);
+}
 
-	g_idle_add (notify_idle_cb, notify_data);
+/**
+ * gs_app_get_notify_stats:
+ * @n_queued: (out) (optional): return location for the number of property
+ *   changes queued
+ * @n_merged: (out) (optional): return location for how many of those were
+ *   merged into a notification which was already pending
+ * @n_dispatched: (out) (optional): return location for the number of idle
+ *   dispatches which emitted the notifications
+ *
+ * Gets counters for the property notifications of all #GsApp instances,
+ * which are coalesced and emitted from the default main context.
+ **/
+void
+gs_app_get_notify_stats (guint *n_queued, guint *n_merged, guint *n_dispatched)
+{
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&notify_queue.mutex);
+	if (n_queued != NULL)
+		*n_queued = notify_queue.n_queued;
+	if (n_merged != NULL)
+		*n_merged = notify_queue.n_merged;
+	if (n_dispatched != NULL)
+		*n_dispatched = notify_queue.n_dispatched;
 }
 
 /**
@@ -830,7 +1001,7 @@ gs_app_set_id (GsApp *app, const gchar *id)
 	g_return_if_fail (GS_IS_APP (app));
 	locker = g_mutex_locker_new (&priv->mutex);
 	if (_g_set_str (&priv->id, id))
-		priv->unique_id_valid = FALSE;
+		gs_app_invalidate_unique_id_unlocked (app);
 }
 
 /**
@@ -864,9 +1035,12 @@ void
 gs_app_set_scope (GsApp *app, AsComponentScope scope)
 {
 	GsAppPrivate *priv = gs_app_get_instance_private (app);
+	g_autoptr(GMutexLocker) locker = NULL;
 
 	g_return_if_fail (GS_IS_APP (app));
 
+	locker = g_mutex_locker_new (&priv->mutex);
+
 	/* same */
 	if (scope == priv->scope)
 		return;
@@ -874,7 +1048,7 @@ gs_app_set_scope (GsApp *app, AsComponentScope scope)
 	priv->scope = scope;
 
 	/* no longer valid */
-	priv->unique_id_valid = FALSE;
+	gs_app_invalidate_unique_id_unlocked (app);
 }
 
 /**
@@ -908,9 +1082,12 @@ void
 gs_app_set_bundle_kind (GsApp *app, AsBundleKind bundle_kind)
 {
 	GsAppPrivate *priv = gs_app_get_instance_private (app);
+	g_autoptr(GMutexLocker) locker = NULL;
 
 	g_return_if_fail (GS_IS_APP (app));
 
+	locker = g_mutex_locker_new (&priv->mutex);
+
 	/* same */
 	if (bundle_kind == priv->bundle_kind)
 		return;
@@ -918,7 +1095,7 @@ gs_app_set_bundle_kind (GsApp *app, AsBundleKind bundle_kind)
 	priv->bundle_kind = bundle_kind;
 
 	/* no longer valid */
-	priv->unique_id_valid = FALSE;
+	gs_app_invalidate_unique_id_unlocked (app);
 }
 
 /**
@@ -1394,7 +1571,7 @@ gs_app_set_kind (GsApp *app, AsComponentKind kind)
 	gs_app_queue_notify (app, obj_props[PROP_KIND]);
 
 	/* no longer valid */
-	priv->unique_id_valid = FALSE;
+	gs_app_invalidate_unique_id_unlocked (app);
 }
 
 /**
@@ -1443,6 +1620,7 @@ gs_app_set_unique_id (GsApp *app, const gchar *unique_id)
 	g_free (priv->unique_id);
 	priv->unique_id = g_strdup (unique_id);
 	priv->unique_id_valid = TRUE;
+	gs_app_notify_unique_id_watches_unlocked (app);
 }
 
 /**
@@ -1486,8 +1664,39 @@ gs_app_set_name (GsApp *app, GsAppQuality quality, const gchar *name)
 	if (quality < priv->name_quality)
 		return;
 	priv->name_quality = quality;
-	if (_g_set_str (&priv->name, name))
+	if (_g_set_str (&priv->name, name)) {
+		g_clear_pointer (&priv->name_sort_key, g_free);
 		gs_app_queue_notify (app, obj_props[PROP_NAME]);
+	}
+}
+
+/**
+ * gs_app_dup_name_sort_key:
+ * @app: a #GsApp
+ *
+ * Gets a key for sorting applications by name, as returned by
+ * gs_utils_sort_key() for the name. It is computed the first time it is
+ * needed and kept until the name changes.
+ *
+ * A copy is returned, as the name may be changed from another thread. It is
+ * meant to be used with gs_app_list_sort_by_key(), which only asks for the
+ * key of each application once.
+ *
+ * Returns: (transfer full) (nullable): a string, or %NULL if the name is unset
+ *
+ * Since: 42
+ **/
+gchar *
+gs_app_dup_name_sort_key (GsApp *app)
+{
+	GsAppPrivate *priv = gs_app_get_instance_private (app);
+	g_autoptr(GMutexLocker) locker = NULL;
+	g_return_val_if_fail (GS_IS_APP (app), NULL);
+
+	locker = g_mutex_locker_new (&priv->mutex);
+	if (priv->name_sort_key == NULL && priv->name != NULL)
+		priv->name_sort_key = gs_utils_sort_key (priv->name);
+	return g_strdup (priv->name_sort_key);
 }
 
 /**
@@ -1563,7 +1772,7 @@ gs_app_set_branch (GsApp *app, const gchar *branch)
 	g_return_if_fail (GS_IS_APP (app));
 	locker = g_mutex_locker_new (&priv->mutex);
 	if (_g_set_str (&priv->branch, branch))
-		priv->unique_id_valid = FALSE;
+		gs_app_invalidate_unique_id_unlocked (app);
 }
 
 /**
@@ -1858,7 +2067,8 @@ gs_app_set_developer_name (GsApp *app, const gchar *developer_name)
  * Icons which come from a remote server (over HTTP or HTTPS) will be returned
  * as a pointer into a local cache, which may not have been populated. You must
  * call gs_remote_icon_ensure_cached() on icons of type #GsRemoteIcon to
- * download them; this function will not do that for you.
+ * download them; this function will not do that for you. Once downloaded,
+ * they are returned as a #GdkTexture from the #GsIconPack.
  *
  * This function may do disk I/O or image resizing, but it will not do network
  * I/O to load a pixbuf. It should be acceptable to call this from a UI thread.
@@ -1899,8 +2109,24 @@ gs_app_get_icon_for_size (GsApp       *app,
 		if (icon_width == 0 || icon_width * icon_scale < size * scale)
 			continue;
 
-		if (icon_width * icon_scale >= size * scale)
+		if (icon_width * icon_scale >= size * scale) {
+			GsIconPack *pack = gs_icon_pack_get_default ();
+
+			/* Downloaded icons are rendered straight from the
+			 * icon pack, already scaled. */
+			if (GS_IS_REMOTE_ICON (icon) && pack != NULL) {
+				GdkTexture *texture = gs_icon_pack_lookup (pack,
+									   gs_remote_icon_get_uri (GS_REMOTE_ICON (icon)),
+									   size * scale);
+				if (texture != NULL) {
+					gs_icon_set_width (G_ICON (texture), (guint) gdk_texture_get_width (texture));
+					gs_icon_set_height (G_ICON (texture), (guint) gdk_texture_get_height (texture));
+					return G_ICON (texture);
+				}
+			}
+
 			return g_object_ref (icon);
+		}
 	}
 
 	g_debug ("Found no icons of the right size; checking themed icons");
@@ -1971,6 +2197,35 @@ gs_app_get_icons (GsApp *app)
 	return priv->icons;
 }
 
+/**
+ * gs_app_dup_icons:
+ * @app: a #GsApp
+ *
+ * Gets a copy of the icons for the application, which is safe to iterate
+ * while another thread adds icons to @app.
+ *
+ * Like gs_app_get_icons(), this will never return an empty array.
+ *
+ * Returns: (transfer container) (element-type GIcon) (nullable): an array of
+ *     icons, or %NULL if there are no icons
+ *
+ * Since: 42
+ **/
+GPtrArray *
+gs_app_dup_icons (GsApp *app)
+{
+	GsAppPrivate *priv = gs_app_get_instance_private (app);
+	g_autoptr(GMutexLocker) locker = NULL;
+	g_return_val_if_fail (GS_IS_APP (app), NULL);
+
+	locker = g_mutex_locker_new (&priv->mutex);
+
+	if (priv->icons == NULL || priv->icons->len == 0)
+		return NULL;
+
+	return g_ptr_array_copy (priv->icons, (GCopyFunc) g_object_ref, NULL);
+}
+
 static gint
 icon_sort_width_cb (gconstpointer a,
                     gconstpointer b)
@@ -2875,7 +3130,7 @@ gs_app_set_origin (GsApp *app, const gchar *origin)
 	priv->origin = g_strdup (origin);
 
 	/* no longer valid */
-	priv->unique_id_valid = FALSE;
+	gs_app_invalidate_unique_id_unlocked (app);
 }
 
 /**
@@ -4285,18 +4540,33 @@ gs_app_get_is_update_downloaded (GsApp *app)
 	return priv->is_update_downloaded;
 }
 
-static void
-calculate_key_colors (GsApp *app)
+static const gchar *
+get_key_colors_cache_filename (void)
 {
-	GsAppPrivate *priv = gs_app_get_instance_private (app);
+	static gsize initialised = 0;
+	static gchar *filename = NULL;
+
+	if (g_once_init_enter (&initialised)) {
+		filename = gs_utils_get_cache_filename ("key-colors", "key-colors.bin",
+							GS_UTILS_CACHE_FLAG_WRITEABLE |
+							GS_UTILS_CACHE_FLAG_CREATE_DIRECTORY,
+							NULL);
+		g_once_init_leave (&initialised, 1);
+	}
+	return filename;
+}
+
+/* Returns %NULL if the key colors can only be calculated from the main thread
+ * and @main_thread is %FALSE, as they need the icon theme. */
+static GArray *
+calculate_key_colors (GsApp    *app,
+                      gboolean  main_thread)
+{
+	g_autoptr(GArray) key_colors = g_array_new (FALSE, FALSE, sizeof (GdkRGBA));
 	g_autoptr(GIcon) icon_small = NULL;
 	g_autoptr(GdkPixbuf) pb_small = NULL;
 	const gchar *overrides_str;
 
-	/* Lazily create the array */
-	if (priv->key_colors == NULL)
-		priv->key_colors = g_array_new (FALSE, FALSE, sizeof (GdkRGBA));
-
 	/* Look for an override first. Parse and use it if possible. This is
 	 * typically specified in the appdata for an app as:
 	 * |[
@@ -4329,10 +4599,10 @@ calculate_key_colors (GsApp *app)
 				rgba.green = (gdouble) green / 255.0;
 				rgba.blue = (gdouble) blue / 255.0;
 				rgba.alpha = 1.0;
-				g_array_append_val (priv->key_colors, rgba);
+				g_array_append_val (key_colors, rgba);
 			}
 
-			return;
+			return g_steal_pointer (&key_colors);
 		} else {
 			g_warning ("Invalid value for GnomeSoftware::key-colors for %s: %s",
 				   gs_app_get_id (app), local_error->message);
@@ -4345,10 +4615,15 @@ calculate_key_colors (GsApp *app)
 
 	if (icon_small == NULL) {
 		g_debug ("no pixbuf, so no key colors");
-		return;
+		return g_steal_pointer (&key_colors);
+	} else if (GDK_IS_TEXTURE (icon_small)) {
+		g_autoptr(GdkPixbuf) pb = gdk_pixbuf_get_from_texture (GDK_TEXTURE (icon_small));
+		pb_small = gdk_pixbuf_scale_simple (pb, 32, 32, GDK_INTERP_BILINEAR);
 	} else if (G_IS_LOADABLE_ICON (icon_small)) {
 		g_autoptr(GInputStream) icon_stream = g_loadable_icon_load (G_LOADABLE_ICON (icon_small), 32, NULL, NULL, NULL);
 		pb_small = gdk_pixbuf_new_from_stream_at_scale (icon_stream, 32, 32, TRUE, NULL, NULL);
+	} else if (G_IS_THEMED_ICON (icon_small) && !main_thread) {
+		return NULL;
 	} else if (G_IS_THEMED_ICON (icon_small)) {
 		g_autoptr(GtkIconPaintable) icon_paintable = NULL;
 		g_autoptr(GtkIconTheme) theme = NULL;
@@ -4416,17 +4691,18 @@ calculate_key_colors (GsApp *app)
 
 	} else {
 		g_debug ("unsupported pixbuf, so no key colors");
-		return;
+		return g_steal_pointer (&key_colors);
 	}
 
 	if (pb_small == NULL) {
 		g_debug ("pixbuf couldn’t be loaded, so no key colors");
-		return;
+		return g_steal_pointer (&key_colors);
 	}
 
-	/* get a list of key colors */
-	g_clear_pointer (&priv->key_colors, g_array_unref);
-	priv->key_colors = gs_calculate_key_colors (pb_small);
+	/* get a list of key colors, remembered across runs by icon */
+	if (get_key_colors_cache_filename () != NULL)
+		return gs_calculate_key_colors_cached (pb_small, get_key_colors_cache_filename ());
+	return gs_calculate_key_colors (pb_small);
 }
 
 /**
@@ -4443,11 +4719,83 @@ GArray *
 gs_app_get_key_colors (GsApp *app)
 {
 	GsAppPrivate *priv = gs_app_get_instance_private (app);
+	g_autoptr(GArray) key_colors = NULL;
+	g_autoptr(GMutexLocker) locker = NULL;
+
 	g_return_val_if_fail (GS_IS_APP (app), NULL);
 
+	locker = g_mutex_locker_new (&priv->mutex);
+	if (priv->key_colors != NULL)
+		return priv->key_colors;
+	g_clear_pointer (&locker, g_mutex_locker_free);
+
+	/* not done under the lock, as loading the icon may take a while */
+	key_colors = calculate_key_colors (app, TRUE);
+
+	locker = g_mutex_locker_new (&priv->mutex);
 	if (priv->key_colors == NULL)
-		calculate_key_colors (app);
+		priv->key_colors = g_steal_pointer (&key_colors);
+
+	return priv->key_colors;
+}
+
+/**
+ * gs_app_ensure_key_colors:
+ * @app: a #GsApp
+ *
+ * Calculates the key colors of the application icon, if they are not already
+ * known, so that gs_app_get_key_colors() does not need to do it when it is
+ * first called from the UI.
+ *
+ * This is meant to be called from a worker thread, after the icons have been
+ * downloaded. Key colors for themed icons are left to be calculated lazily,
+ * as they need the icon theme.
+ *
+ * Since: 42
+ **/
+void
+gs_app_ensure_key_colors (GsApp *app)
+{
+	GsAppPrivate *priv = gs_app_get_instance_private (app);
+	g_autoptr(GArray) key_colors = NULL;
+	g_autoptr(GMutexLocker) locker = NULL;
+
+	g_return_if_fail (GS_IS_APP (app));
 
+	locker = g_mutex_locker_new (&priv->mutex);
+	if (priv->key_colors != NULL)
+		return;
+	g_clear_pointer (&locker, g_mutex_locker_free);
+
+	key_colors = calculate_key_colors (app, FALSE);
+	if (key_colors == NULL)
+		return;
+
+	locker = g_mutex_locker_new (&priv->mutex);
+	if (priv->key_colors == NULL) {
+		priv->key_colors = g_steal_pointer (&key_colors);
+		gs_app_queue_notify (app, obj_props[PROP_KEY_COLORS]);
+	}
+}
+
+/**
+ * gs_app_peek_key_colors:
+ * @app: a #GsApp
+ *
+ * Gets the key colors of the application icon, if they are already known,
+ * without calculating them.
+ *
+ * Returns: (element-type GdkRGBA) (transfer none) (nullable): a list, or %NULL
+ *
+ * Since: 42
+ **/
+GArray *
+gs_app_peek_key_colors (GsApp *app)
+{
+	GsAppPrivate *priv = gs_app_get_instance_private (app);
+	g_autoptr(GMutexLocker) locker = NULL;
+	g_return_val_if_fail (GS_IS_APP (app), NULL);
+	locker = g_mutex_locker_new (&priv->mutex);
 	return priv->key_colors;
 }
 
@@ -5141,8 +5489,10 @@ gs_app_finalize (GObject *object)
 	g_mutex_clear (&priv->mutex);
 	g_free (priv->id);
 	g_free (priv->unique_id);
+	g_clear_pointer (&priv->unique_id_watches, g_ptr_array_unref);
 	g_free (priv->branch);
 	g_free (priv->name);
+	g_free (priv->name_sort_key);
 	g_free (priv->renamed_from);
 	g_free (priv->url_missing);
 	g_clear_pointer (&priv->urls, g_hash_table_unref);
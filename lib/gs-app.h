@@ -274,6 +274,7 @@ const gchar	*gs_app_get_name		(GsApp		*app);
 void		 gs_app_set_name		(GsApp		*app,
 						 GsAppQuality	 quality,
 						 const gchar	*name);
+gchar		*gs_app_dup_name_sort_key	(GsApp		*app);
 const gchar	*gs_app_get_renamed_from	(GsApp		*app);
 void		 gs_app_set_renamed_from	(GsApp		*app,
 						 const gchar	*renamed_from);
@@ -374,6 +375,7 @@ GIcon		*gs_app_get_icon_for_size	(GsApp		*app,
 						 guint		 scale,
 						 const gchar	*fallback_icon_name);
 GPtrArray	*gs_app_get_icons		(GsApp		*app);
+GPtrArray	*gs_app_dup_icons		(GsApp		*app);
 void		 gs_app_add_icon		(GsApp		*app,
 						 GIcon		*icon);
 void		 gs_app_remove_all_icons	(GsApp		*app);
@@ -445,6 +447,8 @@ GPtrArray	*gs_app_get_categories		(GsApp		*app);
 void		 gs_app_set_categories		(GsApp		*app,
 						 GPtrArray	*categories);
 GArray		*gs_app_get_key_colors		(GsApp		*app);
+GArray		*gs_app_peek_key_colors		(GsApp		*app);
+void		 gs_app_ensure_key_colors	(GsApp		*app);
 void		 gs_app_set_key_colors		(GsApp		*app,
 						 GArray		*key_colors);
 void		 gs_app_add_key_color		(GsApp		*app,
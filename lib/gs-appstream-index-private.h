@@ -0,0 +1,49 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ * vi:set noexpandtab tabstop=8 shiftwidth=8:
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ */
+
+#pragma once
+
+#include <glib.h>
+#include <glib-object.h>
+#include <xmlb.h>
+
+G_BEGIN_DECLS
+
+#define GS_TYPE_APPSTREAM_INDEX (gs_appstream_index_get_type ())
+
+G_DECLARE_FINAL_TYPE (GsAppstreamIndex, gs_appstream_index, GS, APPSTREAM_INDEX, GObject)
+
+/**
+ * GsAppstreamIndexMatch:
+ * @component: the matching `<component>` node
+ * @match_value: a bitmask of #AsSearchTokenMatch values
+ *
+ * A single result of gs_appstream_index_search().
+ */
+typedef struct {
+	XbNode		*component;
+	guint16		 match_value;
+} GsAppstreamIndexMatch;
+
+GsAppstreamIndex *gs_appstream_index_new_for_silo	(XbSilo			*silo,
+							 const gchar		*filename,
+							 GCancellable		*cancellable,
+							 GError			**error);
+GPtrArray	*gs_appstream_index_get_components	(GsAppstreamIndex	*self);
+GArray		*gs_appstream_index_search		(GsAppstreamIndex	*self,
+							 const gchar * const	*values);
+guint		 gs_appstream_index_count_desktop_group	(GsAppstreamIndex	*self,
+							 const gchar		*desktop_group);
+GPtrArray	*gs_appstream_index_get_desktop_group_components (GsAppstreamIndex *self,
+							 const gchar		*desktop_group);
+GPtrArray	*gs_appstream_index_lookup_id		(GsAppstreamIndex	*self,
+							 const gchar		*id);
+GPtrArray	*gs_appstream_index_lookup_pkgname	(GsAppstreamIndex	*self,
+							 const gchar		*pkgname);
+
+G_END_DECLS
@@ -0,0 +1,856 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ * vi:set noexpandtab tabstop=8 shiftwidth=8:
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ */
+
+/**
+ * SECTION:gs-appstream-index
+ * @short_description: Lookup tables built alongside an AppStream silo
+ *
+ * #GsAppstreamIndex holds data derived from an #XbSilo which would otherwise
+ * need a full scan of every `<component>` for each request, such as the
+ * inverted token index used for searching and the components in each
+ * category.
+ *
+ * The index is built once when the silo is (re)compiled and is saved as a
+ * #GVariant next to the silo blob, so later runs can simply map it. The silo
+ * GUID is stored in the file, and the index is rebuilt if it does not match.
+ * The tables used to find components by ID and package name are only kept in
+ * memory, and are rebuilt each time the index is loaded.
+ *
+ * Components are referred to by their position in the
+ * `components/component` query, which is stable for a given silo.
+ */
+
+#include "config.h"
+
+#include <appstream.h>
+#include <string.h>
+
+#include "gs-appstream-index-private.h"
+
+/* guid, n_components, sorted tokens, component positions and
+ * #AsSearchTokenMatch values for each token, then sorted categories and
+ * the component positions for each category */
+#define GS_APPSTREAM_INDEX_FORMAT	"(usuasaauaaqasaau)"
+#define GS_APPSTREAM_INDEX_VERSION	2
+
+struct _GsAppstreamIndex
+{
+	GObject			 parent_instance;
+	GPtrArray		*components;	/* (element-type XbNode) */
+	GVariant		*root;
+	GVariant		*tokens;	/* as */
+	GVariant		*positions;	/* aau */
+	GVariant		*match_values;	/* aaq */
+	GVariant		*categories;	/* as */
+	GVariant		*category_positions;	/* aau */
+	GHashTable		*ids;		/* (element-type utf8 GPtrArray) */
+	GHashTable		*pkgnames;	/* (element-type utf8 GPtrArray) */
+};
+
+G_DEFINE_TYPE (GsAppstreamIndex, gs_appstream_index, G_TYPE_OBJECT)
+
+typedef struct {
+	guint32		 position;
+	guint16		 match_value;
+} GsAppstreamIndexPosting;
+
+static void
+gs_appstream_index_add_token (GHashTable *tokens,
+			      const gchar *token,
+			      guint32 position,
+			      guint16 match_value)
+{
+	GArray *postings = g_hash_table_lookup (tokens, token);
+	GsAppstreamIndexPosting posting = { position, match_value };
+
+	if (postings == NULL) {
+		postings = g_array_new (FALSE, FALSE, sizeof (GsAppstreamIndexPosting));
+		g_hash_table_insert (tokens, g_strdup (token), postings);
+	}
+
+	/* components are added in order, so only the last one can match */
+	if (postings->len > 0) {
+		GsAppstreamIndexPosting *last = &g_array_index (postings,
+								GsAppstreamIndexPosting,
+								postings->len - 1);
+		if (last->position == position) {
+			last->match_value |= match_value;
+			return;
+		}
+	}
+	g_array_append_val (postings, posting);
+}
+
+/* this splits the text the same way as xb_builder_node_tokenize_text() */
+static void
+gs_appstream_index_add_text (GHashTable *tokens,
+			     const gchar *text,
+			     guint32 position,
+			     guint16 match_value)
+{
+	g_auto(GStrv) tokens_folded = NULL;
+	g_auto(GStrv) tokens_ascii = NULL;
+
+	if (text == NULL)
+		return;
+	tokens_folded = g_str_tokenize_and_fold (text, NULL, &tokens_ascii);
+	for (guint i = 0; tokens_folded[i] != NULL; i++) {
+#if LIBXMLB_CHECK_VERSION(0, 3, 1)
+		if (!xb_string_token_valid (tokens_folded[i]))
+			continue;
+#endif
+		gs_appstream_index_add_token (tokens, tokens_folded[i], position, match_value);
+	}
+	for (guint i = 0; tokens_ascii[i] != NULL; i++) {
+#if LIBXMLB_CHECK_VERSION(0, 3, 1)
+		if (!xb_string_token_valid (tokens_ascii[i]))
+			continue;
+#endif
+		gs_appstream_index_add_token (tokens, tokens_ascii[i], position, match_value);
+	}
+}
+
+static void
+gs_appstream_index_add_children (GHashTable *tokens,
+				 XbNode *parent,
+				 const gchar *element,
+				 guint32 position,
+				 guint16 match_value)
+{
+	g_autoptr(XbNode) n = xb_node_get_child (parent);
+
+	while (n != NULL) {
+		XbNode *next;
+		if (g_strcmp0 (xb_node_get_element (n), element) == 0)
+			gs_appstream_index_add_text (tokens, xb_node_get_text (n),
+						     position, match_value);
+		next = xb_node_get_next (n);
+		g_object_unref (n);
+		n = next;
+	}
+}
+
+static void
+gs_appstream_index_add_categories (GHashTable *categories,
+				   XbNode *parent,
+				   guint32 position)
+{
+	g_autoptr(XbNode) n = xb_node_get_child (parent);
+
+	while (n != NULL) {
+		XbNode *next;
+		const gchar *text = xb_node_get_text (n);
+
+		if (text != NULL && g_strcmp0 (xb_node_get_element (n), "category") == 0) {
+			GArray *positions = g_hash_table_lookup (categories, text);
+			if (positions == NULL) {
+				positions = g_array_new (FALSE, FALSE, sizeof (guint32));
+				g_hash_table_insert (categories, g_strdup (text), positions);
+			}
+			/* components are added in order, so only the last one can match */
+			if (positions->len == 0 ||
+			    g_array_index (positions, guint32, positions->len - 1) != position)
+				g_array_append_val (positions, position);
+		}
+		next = xb_node_get_next (n);
+		g_object_unref (n);
+		n = next;
+	}
+}
+
+/* this has to match the queries used in gs_appstream_search() */
+static void
+gs_appstream_index_add_component (GHashTable *tokens,
+				  GHashTable *categories,
+				  XbNode *component,
+				  guint32 position)
+{
+	g_autoptr(XbNode) n = xb_node_get_child (component);
+	g_autoptr(XbNode) parent = xb_node_get_parent (component);
+
+	while (n != NULL) {
+		XbNode *next;
+		const gchar *element = xb_node_get_element (n);
+		const gchar *text = xb_node_get_text (n);
+
+		if (g_strcmp0 (element, "id") == 0 ||
+		    g_strcmp0 (element, "launchable") == 0) {
+			gs_appstream_index_add_text (tokens, text, position,
+						     AS_SEARCH_TOKEN_MATCH_ID);
+		} else if (g_strcmp0 (element, "name") == 0) {
+			gs_appstream_index_add_text (tokens, text, position,
+						     AS_SEARCH_TOKEN_MATCH_NAME);
+		} else if (g_strcmp0 (element, "summary") == 0) {
+			gs_appstream_index_add_text (tokens, text, position,
+						     AS_SEARCH_TOKEN_MATCH_SUMMARY);
+		} else if (g_strcmp0 (element, "pkgname") == 0) {
+			gs_appstream_index_add_text (tokens, text, position,
+						     AS_SEARCH_TOKEN_MATCH_PKGNAME);
+		} else if (g_strcmp0 (element, "keywords") == 0) {
+			gs_appstream_index_add_children (tokens, n, "keyword", position,
+							 AS_SEARCH_TOKEN_MATCH_KEYWORD);
+		} else if (g_strcmp0 (element, "mimetypes") == 0) {
+			gs_appstream_index_add_children (tokens, n, "mimetype", position,
+							 AS_SEARCH_TOKEN_MATCH_MIMETYPE);
+		} else if (g_strcmp0 (element, "categories") == 0) {
+			gs_appstream_index_add_categories (categories, n, position);
+		}
+		next = xb_node_get_next (n);
+		g_object_unref (n);
+		n = next;
+	}
+
+	if (parent != NULL) {
+		gs_appstream_index_add_text (tokens,
+					     xb_node_get_attr (parent, "origin"),
+					     position,
+					     AS_SEARCH_TOKEN_MATCH_ORIGIN);
+	}
+}
+
+static void
+gs_appstream_index_add_lookup (GHashTable *lookup, const gchar *key, XbNode *component)
+{
+	GPtrArray *components = g_hash_table_lookup (lookup, key);
+
+	if (components == NULL) {
+		components = g_ptr_array_new_with_free_func (g_object_unref);
+		g_hash_table_insert (lookup, g_strdup (key), components);
+	}
+	g_ptr_array_add (components, g_object_ref (component));
+}
+
+/* installed AppData files are at the top level of the silo, and are found by
+ * ID but never by package name, as in the queries used when refining */
+static void
+gs_appstream_index_add_lookups (GsAppstreamIndex *self, XbNode *component)
+{
+	g_autoptr(XbNode) n = xb_node_get_child (component);
+	g_autoptr(XbNode) parent = xb_node_get_parent (component);
+	const gchar *id = NULL;
+
+	while (n != NULL) {
+		XbNode *next;
+		const gchar *element = xb_node_get_element (n);
+		const gchar *text = xb_node_get_text (n);
+
+		if (text != NULL && g_strcmp0 (element, "id") == 0) {
+			if (id == NULL)
+				id = text;
+		} else if (text != NULL && g_strcmp0 (element, "pkgname") == 0) {
+			if (parent != NULL)
+				gs_appstream_index_add_lookup (self->pkgnames, text, component);
+		}
+		next = xb_node_get_next (n);
+		g_object_unref (n);
+		n = next;
+	}
+
+	if (id != NULL)
+		gs_appstream_index_add_lookup (self->ids, id, component);
+}
+
+static gboolean
+gs_appstream_index_build_lookups (GsAppstreamIndex *self,
+				  XbSilo *silo,
+				  GCancellable *cancellable,
+				  GError **error)
+{
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GPtrArray) installed = NULL;
+	g_autoptr(GTimer) timer = g_timer_new ();
+
+	for (guint i = 0; i < self->components->len; i++) {
+		if (g_cancellable_set_error_if_cancelled (cancellable, error))
+			return FALSE;
+		gs_appstream_index_add_lookups (self, g_ptr_array_index (self->components, i));
+	}
+
+	/* installed AppData files come after the catalog, as in the queries */
+	installed = xb_silo_query (silo, "component", 0, &error_local);
+	if (installed == NULL) {
+		if (!g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_NOT_FOUND) &&
+		    !g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT)) {
+			g_propagate_error (error, g_steal_pointer (&error_local));
+			return FALSE;
+		}
+	} else {
+		for (guint i = 0; i < installed->len; i++)
+			gs_appstream_index_add_lookups (self, g_ptr_array_index (installed, i));
+	}
+
+	g_debug ("built lookups of %u IDs and %u package names in %.0fms",
+		 g_hash_table_size (self->ids),
+		 g_hash_table_size (self->pkgnames),
+		 g_timer_elapsed (timer, NULL) * 1000);
+	return TRUE;
+}
+
+static gint
+gs_appstream_index_strcmp_cb (gconstpointer a, gconstpointer b)
+{
+	return strcmp (*(const gchar **) a, *(const gchar **) b);
+}
+
+static GVariant *
+gs_appstream_index_build (XbSilo *silo,
+			  GPtrArray *components,
+			  GCancellable *cancellable,
+			  GError **error)
+{
+	GVariantBuilder builder_tokens;
+	GVariantBuilder builder_positions;
+	GVariantBuilder builder_match_values;
+	GVariantBuilder builder_categories;
+	GVariantBuilder builder_category_positions;
+	g_autoptr(GHashTable) tokens = NULL;
+	g_autoptr(GHashTable) categories = NULL;
+	g_autoptr(GPtrArray) keys = g_ptr_array_new ();
+	g_autoptr(GPtrArray) category_keys = g_ptr_array_new ();
+	g_autoptr(GTimer) timer = g_timer_new ();
+	GHashTableIter iter;
+	gpointer key;
+
+	tokens = g_hash_table_new_full (g_str_hash, g_str_equal,
+					g_free, (GDestroyNotify) g_array_unref);
+	categories = g_hash_table_new_full (g_str_hash, g_str_equal,
+					    g_free, (GDestroyNotify) g_array_unref);
+	for (guint i = 0; i < components->len; i++) {
+		XbNode *component = g_ptr_array_index (components, i);
+		if (g_cancellable_set_error_if_cancelled (cancellable, error))
+			return NULL;
+		gs_appstream_index_add_component (tokens, categories, component, i);
+	}
+
+	/* sort the tokens so we can do prefix matches with a bisection */
+	g_hash_table_iter_init (&iter, tokens);
+	while (g_hash_table_iter_next (&iter, &key, NULL))
+		g_ptr_array_add (keys, key);
+	g_ptr_array_sort (keys, gs_appstream_index_strcmp_cb);
+
+	g_variant_builder_init (&builder_tokens, G_VARIANT_TYPE ("as"));
+	g_variant_builder_init (&builder_positions, G_VARIANT_TYPE ("aau"));
+	g_variant_builder_init (&builder_match_values, G_VARIANT_TYPE ("aaq"));
+	for (guint i = 0; i < keys->len; i++) {
+		const gchar *token = g_ptr_array_index (keys, i);
+		GArray *postings = g_hash_table_lookup (tokens, token);
+		g_autofree guint32 *positions = g_new (guint32, postings->len);
+		g_autofree guint16 *match_values = g_new (guint16, postings->len);
+
+		for (guint j = 0; j < postings->len; j++) {
+			GsAppstreamIndexPosting *posting = &g_array_index (postings,
+									   GsAppstreamIndexPosting,
+									   j);
+			positions[j] = posting->position;
+			match_values[j] = posting->match_value;
+		}
+		g_variant_builder_add (&builder_tokens, "s", token);
+		g_variant_builder_add_value (&builder_positions,
+					     g_variant_new_fixed_array (G_VARIANT_TYPE_UINT32,
+									positions,
+									postings->len,
+									sizeof (guint32)));
+		g_variant_builder_add_value (&builder_match_values,
+					     g_variant_new_fixed_array (G_VARIANT_TYPE_UINT16,
+									match_values,
+									postings->len,
+									sizeof (guint16)));
+	}
+
+	/* categories are sorted too, so they can be found with a bisection */
+	g_hash_table_iter_init (&iter, categories);
+	while (g_hash_table_iter_next (&iter, &key, NULL))
+		g_ptr_array_add (category_keys, key);
+	g_ptr_array_sort (category_keys, gs_appstream_index_strcmp_cb);
+
+	g_variant_builder_init (&builder_categories, G_VARIANT_TYPE ("as"));
+	g_variant_builder_init (&builder_category_positions, G_VARIANT_TYPE ("aau"));
+	for (guint i = 0; i < category_keys->len; i++) {
+		const gchar *category = g_ptr_array_index (category_keys, i);
+		GArray *positions = g_hash_table_lookup (categories, category);
+
+		g_variant_builder_add (&builder_categories, "s", category);
+		g_variant_builder_add_value (&builder_category_positions,
+					     g_variant_new_fixed_array (G_VARIANT_TYPE_UINT32,
+									positions->data,
+									positions->len,
+									sizeof (guint32)));
+	}
+
+	g_debug ("built search index of %u tokens and %u categories for %u components in %.0fms",
+		 keys->len, category_keys->len, components->len,
+		 g_timer_elapsed (timer, NULL) * 1000);
+	return g_variant_ref_sink (g_variant_new (GS_APPSTREAM_INDEX_FORMAT,
+						  GS_APPSTREAM_INDEX_VERSION,
+						  xb_silo_get_guid (silo),
+						  components->len,
+						  &builder_tokens,
+						  &builder_positions,
+						  &builder_match_values,
+						  &builder_categories,
+						  &builder_category_positions));
+}
+
+static GVariant *
+gs_appstream_index_load (XbSilo *silo,
+			 const gchar *filename,
+			 guint n_components)
+{
+	guint32 version = 0;
+	guint32 n_components_saved = 0;
+	const gchar *guid = NULL;
+	g_autoptr(GBytes) bytes = NULL;
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GMappedFile) mapped_file = NULL;
+	g_autoptr(GVariant) root = NULL;
+
+	mapped_file = g_mapped_file_new (filename, FALSE, &error_local);
+	if (mapped_file == NULL) {
+		if (!g_error_matches (error_local, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+			g_debug ("failed to load %s: %s", filename, error_local->message);
+		return NULL;
+	}
+
+	/* the bytes keep the file mapped for as long as the variant exists */
+	bytes = g_mapped_file_get_bytes (mapped_file);
+	root = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE (GS_APPSTREAM_INDEX_FORMAT),
+							     bytes, FALSE));
+	g_variant_get_child (root, 0, "u", &version);
+	g_variant_get_child (root, 1, "&s", &guid);
+	g_variant_get_child (root, 2, "u", &n_components_saved);
+	if (version != GS_APPSTREAM_INDEX_VERSION ||
+	    g_strcmp0 (guid, xb_silo_get_guid (silo)) != 0 ||
+	    n_components_saved != n_components) {
+		g_debug ("%s is out of date, rebuilding", filename);
+		return NULL;
+	}
+	return g_steal_pointer (&root);
+}
+
+/**
+ * gs_appstream_index_new_for_silo:
+ * @silo: an #XbSilo
+ * @filename: (nullable): where to cache the index, or %NULL
+ * @cancellable: a #GCancellable, or %NULL
+ * @error: a #GError, or %NULL
+ *
+ * Loads the index for @silo from @filename if it is up to date, and otherwise
+ * builds it and saves it to @filename.
+ *
+ * The returned object keeps references to nodes in @silo, so should be
+ * destroyed at the same time as the silo.
+ *
+ * Returns: (transfer full): a #GsAppstreamIndex, or %NULL on error
+ */
+GsAppstreamIndex *
+gs_appstream_index_new_for_silo (XbSilo *silo,
+				 const gchar *filename,
+				 GCancellable *cancellable,
+				 GError **error)
+{
+	g_autoptr(GsAppstreamIndex) self = g_object_new (GS_TYPE_APPSTREAM_INDEX, NULL);
+	g_autoptr(GError) error_local = NULL;
+
+	g_return_val_if_fail (XB_IS_SILO (silo), NULL);
+
+	self->components = xb_silo_query (silo, "components/component", 0, &error_local);
+	if (self->components == NULL) {
+		if (!g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_NOT_FOUND) &&
+		    !g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT)) {
+			g_propagate_error (error, g_steal_pointer (&error_local));
+			return NULL;
+		}
+		self->components = g_ptr_array_new_with_free_func (g_object_unref);
+	}
+
+	if (filename != NULL)
+		self->root = gs_appstream_index_load (silo, filename, self->components->len);
+	if (self->root == NULL) {
+		self->root = gs_appstream_index_build (silo, self->components,
+						       cancellable, error);
+		if (self->root == NULL)
+			return NULL;
+		if (filename != NULL) {
+			g_autoptr(GError) error_save = NULL;
+			if (!g_file_set_contents (filename,
+						  g_variant_get_data (self->root),
+						  (gssize) g_variant_get_size (self->root),
+						  &error_save))
+				g_debug ("failed to save %s: %s", filename, error_save->message);
+		}
+	}
+	self->tokens = g_variant_get_child_value (self->root, 3);
+	self->positions = g_variant_get_child_value (self->root, 4);
+	self->match_values = g_variant_get_child_value (self->root, 5);
+	self->categories = g_variant_get_child_value (self->root, 6);
+	self->category_positions = g_variant_get_child_value (self->root, 7);
+
+	/* these are cheap enough to build each time, and are only in memory */
+	if (!gs_appstream_index_build_lookups (self, silo, cancellable, error))
+		return NULL;
+	return g_steal_pointer (&self);
+}
+
+/**
+ * gs_appstream_index_get_components:
+ * @self: a #GsAppstreamIndex
+ *
+ * Gets all the `<component>` nodes in the silo, in silo order.
+ *
+ * Returns: (transfer none) (element-type XbNode): components
+ */
+GPtrArray *
+gs_appstream_index_get_components (GsAppstreamIndex *self)
+{
+	g_return_val_if_fail (GS_IS_APPSTREAM_INDEX (self), NULL);
+	return self->components;
+}
+
+/* returns the first token which is not less than @value */
+static gsize
+gs_appstream_index_lower_bound (GsAppstreamIndex *self, const gchar *value)
+{
+	gsize lo = 0;
+	gsize hi = g_variant_n_children (self->tokens);
+
+	while (lo < hi) {
+		gsize mid = lo + (hi - lo) / 2;
+		g_autoptr(GVariant) token = g_variant_get_child_value (self->tokens, mid);
+		if (strcmp (g_variant_get_string (token, NULL), value) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/* returns the component positions for @category, in silo order, or %NULL */
+static GVariant *
+gs_appstream_index_lookup_category (GsAppstreamIndex *self, const gchar *category)
+{
+	gsize lo = 0;
+	gsize hi = g_variant_n_children (self->categories);
+
+	while (lo < hi) {
+		gsize mid = lo + (hi - lo) / 2;
+		g_autoptr(GVariant) name = g_variant_get_child_value (self->categories, mid);
+		gint rc = strcmp (g_variant_get_string (name, NULL), category);
+		if (rc == 0)
+			return g_variant_get_child_value (self->category_positions, mid);
+		if (rc < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return NULL;
+}
+
+/* calls @func for each component in @desktop_group, which is either
+ * `Category` or `Category::Subcategory`, in silo order, and returns the
+ * number of components */
+static guint
+gs_appstream_index_foreach_in_desktop_group (GsAppstreamIndex *self,
+					     const gchar *desktop_group,
+					     GFunc func,
+					     gpointer user_data)
+{
+	g_auto(GStrv) split = g_strsplit (desktop_group, "::", -1);
+	g_autoptr(GVariant) positions1 = NULL;
+	g_autoptr(GVariant) positions2 = NULL;
+	const guint32 *data1, *data2;
+	gsize len1 = 0, len2 = 0;
+	gsize i = 0, j = 0;
+	guint n_matches = 0;
+
+	if (g_strv_length (split) == 0 || g_strv_length (split) > 2)
+		return 0;
+	positions1 = gs_appstream_index_lookup_category (self, split[0]);
+	if (positions1 == NULL)
+		return 0;
+	data1 = g_variant_get_fixed_array (positions1, &len1, sizeof (guint32));
+
+	/* the "all" group for a parent category */
+	if (split[1] == NULL) {
+		for (i = 0; i < len1; i++) {
+			if (data1[i] >= self->components->len)
+				continue;
+			if (func != NULL)
+				func (g_ptr_array_index (self->components, data1[i]), user_data);
+			n_matches++;
+		}
+		return n_matches;
+	}
+
+	/* the components in both categories; both lists are sorted */
+	positions2 = gs_appstream_index_lookup_category (self, split[1]);
+	if (positions2 == NULL)
+		return 0;
+	data2 = g_variant_get_fixed_array (positions2, &len2, sizeof (guint32));
+	while (i < len1 && j < len2) {
+		if (data1[i] < data2[j]) {
+			i++;
+		} else if (data1[i] > data2[j]) {
+			j++;
+		} else {
+			if (data1[i] < self->components->len) {
+				if (func != NULL)
+					func (g_ptr_array_index (self->components, data1[i]), user_data);
+				n_matches++;
+			}
+			i++;
+			j++;
+		}
+	}
+	return n_matches;
+}
+
+/**
+ * gs_appstream_index_count_desktop_group:
+ * @self: a #GsAppstreamIndex
+ * @desktop_group: a desktop group, e.g. `AudioVideo::Player`
+ *
+ * Counts the components which are in all the categories of @desktop_group,
+ * which is the same as the number of results of a
+ * `components/component/categories/category[text()=…]` query for each part.
+ *
+ * Returns: the number of components
+ */
+guint
+gs_appstream_index_count_desktop_group (GsAppstreamIndex *self, const gchar *desktop_group)
+{
+	g_return_val_if_fail (GS_IS_APPSTREAM_INDEX (self), 0);
+	g_return_val_if_fail (desktop_group != NULL, 0);
+	return gs_appstream_index_foreach_in_desktop_group (self, desktop_group, NULL, NULL);
+}
+
+static void
+gs_appstream_index_add_node_cb (gpointer data, gpointer user_data)
+{
+	GPtrArray *components = user_data;
+	g_ptr_array_add (components, g_object_ref (data));
+}
+
+/**
+ * gs_appstream_index_get_desktop_group_components:
+ * @self: a #GsAppstreamIndex
+ * @desktop_group: a desktop group, e.g. `AudioVideo::Player`
+ *
+ * Gets the components which are in all the categories of @desktop_group,
+ * which are the results of a `components/component/categories/category[text()=…]`
+ * query for each part, without visiting the rest of the silo.
+ *
+ * Returns: (transfer container) (element-type XbNode): components, in silo order
+ */
+GPtrArray *
+gs_appstream_index_get_desktop_group_components (GsAppstreamIndex *self, const gchar *desktop_group)
+{
+	GPtrArray *components = g_ptr_array_new_with_free_func (g_object_unref);
+
+	g_return_val_if_fail (GS_IS_APPSTREAM_INDEX (self), components);
+	g_return_val_if_fail (desktop_group != NULL, components);
+
+	gs_appstream_index_foreach_in_desktop_group (self, desktop_group,
+						     gs_appstream_index_add_node_cb,
+						     components);
+	return components;
+}
+
+/**
+ * gs_appstream_index_lookup_id:
+ * @self: a #GsAppstreamIndex
+ * @id: a component ID, e.g. `org.gnome.Software.desktop`
+ *
+ * Gets the components with the ID @id, which are the results of a
+ * `components/component/id[text()=…]` query in silo order, followed by any
+ * installed AppData files for @id.
+ *
+ * Installed AppData files are at the top level of the silo, so have no parent
+ * node.
+ *
+ * Returns: (transfer none) (element-type XbNode) (nullable): components, or
+ *   %NULL if there are none
+ */
+GPtrArray *
+gs_appstream_index_lookup_id (GsAppstreamIndex *self, const gchar *id)
+{
+	g_return_val_if_fail (GS_IS_APPSTREAM_INDEX (self), NULL);
+	g_return_val_if_fail (id != NULL, NULL);
+	return g_hash_table_lookup (self->ids, id);
+}
+
+/**
+ * gs_appstream_index_lookup_pkgname:
+ * @self: a #GsAppstreamIndex
+ * @pkgname: a package name, e.g. `gnome-software`
+ *
+ * Gets the components which are provided by the package @pkgname.
+ *
+ * Returns: (transfer none) (element-type XbNode) (nullable): components in
+ *   silo order, or %NULL if there are none
+ */
+GPtrArray *
+gs_appstream_index_lookup_pkgname (GsAppstreamIndex *self, const gchar *pkgname)
+{
+	g_return_val_if_fail (GS_IS_APPSTREAM_INDEX (self), NULL);
+	g_return_val_if_fail (pkgname != NULL, NULL);
+	return g_hash_table_lookup (self->pkgnames, pkgname);
+}
+
+/* returns a hash of (position + 1) → match value */
+static GHashTable *
+gs_appstream_index_search_token (GsAppstreamIndex *self, const gchar *value)
+{
+	GHashTable *hits = g_hash_table_new (g_direct_hash, g_direct_equal);
+	gsize n_tokens = g_variant_n_children (self->tokens);
+
+	/* all the tokens starting with @value are adjacent */
+	for (gsize i = gs_appstream_index_lower_bound (self, value); i < n_tokens; i++) {
+		g_autoptr(GVariant) token = g_variant_get_child_value (self->tokens, i);
+		g_autoptr(GVariant) positions = NULL;
+		g_autoptr(GVariant) match_values = NULL;
+		const guint32 *positions_data;
+		const guint16 *match_values_data;
+		gsize n_positions = 0;
+		gsize n_match_values = 0;
+
+		if (!g_str_has_prefix (g_variant_get_string (token, NULL), value))
+			break;
+		positions = g_variant_get_child_value (self->positions, i);
+		match_values = g_variant_get_child_value (self->match_values, i);
+		positions_data = g_variant_get_fixed_array (positions, &n_positions, sizeof (guint32));
+		match_values_data = g_variant_get_fixed_array (match_values, &n_match_values, sizeof (guint16));
+		for (gsize j = 0; j < MIN (n_positions, n_match_values); j++) {
+			gpointer key = GUINT_TO_POINTER (positions_data[j] + 1);
+			guint match_value = GPOINTER_TO_UINT (g_hash_table_lookup (hits, key));
+			match_value |= match_values_data[j];
+			g_hash_table_insert (hits, key, GUINT_TO_POINTER (match_value));
+		}
+	}
+	return hits;
+}
+
+static gint
+gs_appstream_index_position_cmp_cb (gconstpointer a, gconstpointer b)
+{
+	guint pos_a = GPOINTER_TO_UINT (*(gconstpointer *) a);
+	guint pos_b = GPOINTER_TO_UINT (*(gconstpointer *) b);
+	if (pos_a < pos_b)
+		return -1;
+	if (pos_a > pos_b)
+		return 1;
+	return 0;
+}
+
+static void
+gs_appstream_index_match_clear (GsAppstreamIndexMatch *match)
+{
+	g_clear_object (&match->component);
+}
+
+/**
+ * gs_appstream_index_search:
+ * @self: a #GsAppstreamIndex
+ * @values: search tokens, as returned by as_pool_build_search_tokens()
+ *
+ * Finds all the components where every one of @values is a prefix of a token
+ * in the ID, name, summary, package name, keywords, mimetypes or origin,
+ * which is the same as the `~=` queries done by gs_appstream_search().
+ *
+ * The cost depends on the number of results rather than the silo size.
+ *
+ * Returns: (transfer full) (element-type GsAppstreamIndexMatch): matches,
+ *   in silo order
+ */
+GArray *
+gs_appstream_index_search (GsAppstreamIndex *self, const gchar * const *values)
+{
+	GArray *matches = g_array_new (FALSE, FALSE, sizeof (GsAppstreamIndexMatch));
+	GHashTableIter iter;
+	gpointer key, value;
+	g_autoptr(GHashTable) hits = NULL;
+	g_autoptr(GPtrArray) positions = g_ptr_array_new ();
+
+	g_return_val_if_fail (GS_IS_APPSTREAM_INDEX (self), matches);
+
+	g_array_set_clear_func (matches, (GDestroyNotify) gs_appstream_index_match_clear);
+
+	/* do *all* search keywords match */
+	for (guint i = 0; values[i] != NULL; i++) {
+		g_autoptr(GHashTable) hits_tmp = gs_appstream_index_search_token (self, values[i]);
+		if (hits == NULL) {
+			hits = g_steal_pointer (&hits_tmp);
+			continue;
+		}
+		g_hash_table_iter_init (&iter, hits);
+		while (g_hash_table_iter_next (&iter, &key, &value)) {
+			gpointer value_tmp = g_hash_table_lookup (hits_tmp, key);
+			if (value_tmp == NULL) {
+				g_hash_table_iter_remove (&iter);
+				continue;
+			}
+			g_hash_table_iter_replace (&iter, GUINT_TO_POINTER (GPOINTER_TO_UINT (value) |
+									    GPOINTER_TO_UINT (value_tmp)));
+		}
+		if (g_hash_table_size (hits) == 0)
+			break;
+	}
+	if (hits == NULL)
+		return matches;
+
+	/* return in silo order, like a full scan would */
+	g_hash_table_iter_init (&iter, hits);
+	while (g_hash_table_iter_next (&iter, &key, NULL))
+		g_ptr_array_add (positions, key);
+	g_ptr_array_sort (positions, gs_appstream_index_position_cmp_cb);
+	for (guint i = 0; i < positions->len; i++) {
+		gpointer position = g_ptr_array_index (positions, i);
+		guint idx = GPOINTER_TO_UINT (position) - 1;
+		GsAppstreamIndexMatch match;
+
+		if (idx >= self->components->len)
+			continue;
+		match.component = g_object_ref (g_ptr_array_index (self->components, idx));
+		match.match_value = (guint16) GPOINTER_TO_UINT (g_hash_table_lookup (hits, position));
+		g_array_append_val (matches, match);
+	}
+	return matches;
+}
+
+static void
+gs_appstream_index_finalize (GObject *object)
+{
+	GsAppstreamIndex *self = GS_APPSTREAM_INDEX (object);
+
+	g_clear_pointer (&self->components, g_ptr_array_unref);
+	g_clear_pointer (&self->tokens, g_variant_unref);
+	g_clear_pointer (&self->positions, g_variant_unref);
+	g_clear_pointer (&self->match_values, g_variant_unref);
+	g_clear_pointer (&self->categories, g_variant_unref);
+	g_clear_pointer (&self->category_positions, g_variant_unref);
+	g_clear_pointer (&self->root, g_variant_unref);
+	g_clear_pointer (&self->ids, g_hash_table_unref);
+	g_clear_pointer (&self->pkgnames, g_hash_table_unref);
+
+	G_OBJECT_CLASS (gs_appstream_index_parent_class)->finalize (object);
+}
+
+static void
+gs_appstream_index_class_init (GsAppstreamIndexClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	object_class->finalize = gs_appstream_index_finalize;
+}
+
+static void
+gs_appstream_index_init (GsAppstreamIndex *self)
+{
+	self->ids = g_hash_table_new_full (g_str_hash, g_str_equal,
+					   g_free, (GDestroyNotify) g_ptr_array_unref);
+	self->pkgnames = g_hash_table_new_full (g_str_hash, g_str_equal,
+						g_free, (GDestroyNotify) g_ptr_array_unref);
+}
@@ -0,0 +1,36 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ * vi:set noexpandtab tabstop=8 shiftwidth=8:
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ */
+
+#pragma once
+
+#include "gs-appstream.h"
+#include "gs-appstream-index-private.h"
+
+G_BEGIN_DECLS
+
+gboolean	 gs_appstream_search_with_index		(GsPlugin	*plugin,
+							 XbSilo		*silo,
+							 GsAppstreamIndex *index,
+							 const gchar * const *values,
+							 GsAppList	*list,
+							 GCancellable	*cancellable,
+							 GError		**error);
+gboolean	 gs_appstream_add_categories_with_index	(XbSilo		*silo,
+							 GsAppstreamIndex *index,
+							 GPtrArray	*list,
+							 GCancellable	*cancellable,
+							 GError		**error);
+gboolean	 gs_appstream_add_category_apps_with_index (GsPlugin	*plugin,
+							 XbSilo		*silo,
+							 GsAppstreamIndex *index,
+							 GsCategory	*category,
+							 GsAppList	*list,
+							 GCancellable	*cancellable,
+							 GError		**error);
+
+G_END_DECLS
@@ -12,7 +12,8 @@
 #include <gnome-software.h>
 #include <locale.h>
 
-#include "gs-appstream.h"
+#include "gs-appstream-private.h"
+#include "gs-category-private.h"
 
 #define	GS_APPSTREAM_MAX_SCREENSHOTS	5
 
@@ -1339,13 +1340,82 @@ gs_appstream_silo_search_component (GPtrArray *array, XbNode *component, const g
 	return matches_sum;
 }
 
+/* the plugin loader narrows the results of recent searches itself, and
+ * needs the text which is searched but is not otherwise kept on the app */
+static void
+gs_appstream_search_set_metadata (GsApp *app,
+				  XbNode *component,
+				  const gchar *xpath,
+				  const gchar *key)
+{
+	g_autoptr(GPtrArray) nodes = xb_node_query (component, xpath, 0, NULL);
+	g_autoptr(GPtrArray) strv = g_ptr_array_new ();
+	g_autoptr(GVariant) tmp = NULL;
+
+	for (guint i = 0; nodes != NULL && i < nodes->len; i++) {
+		const gchar *text = xb_node_get_text (g_ptr_array_index (nodes, i));
+		if (text != NULL)
+			g_ptr_array_add (strv, (gpointer) text);
+	}
+	tmp = g_variant_ref_sink (g_variant_new_strv ((const gchar * const *) strv->pdata,
+						      (gssize) strv->len));
+	gs_app_set_metadata_variant (app, key, tmp);
+}
+
+static gboolean
+gs_appstream_search_add_component (GsPlugin *plugin,
+				   XbSilo *silo,
+				   XbNode *component,
+				   guint16 match_value,
+				   GsAppList *list,
+				   GError **error)
+{
+	g_autoptr(GsApp) app = gs_appstream_create_app (plugin, silo, component, error);
+	if (app == NULL)
+		return FALSE;
+	if (gs_app_has_quirk (app, GS_APP_QUIRK_IS_WILDCARD)) {
+		g_debug ("not returning wildcard %s",
+			 gs_app_get_unique_id (app));
+		return TRUE;
+	}
+	g_debug ("add %s", gs_app_get_unique_id (app));
+	gs_app_set_match_value (app, match_value);
+	gs_appstream_search_set_metadata (app, component, "keywords/keyword",
+					  "GnomeSoftware::search-keywords");
+	gs_appstream_search_set_metadata (app, component, "mimetypes/mimetype",
+					  "GnomeSoftware::search-mimetypes");
+	gs_app_list_add (list, app);
+
+	if (gs_app_get_kind (app) == AS_COMPONENT_KIND_ADDON) {
+		g_autoptr(GPtrArray) extends = NULL;
+
+		/* add the parent app as a wildcard, to be refined later */
+		gs_appstream_search_set_metadata (app, component, "extends",
+						  "GnomeSoftware::search-extends");
+		extends = xb_node_query (component, "extends", 0, NULL);
+		for (guint jj = 0; extends && jj < extends->len; jj++) {
+			XbNode *extend = g_ptr_array_index (extends, jj);
+			g_autoptr(GsApp) app2 = NULL;
+			const gchar *tmp;
+			app2 = gs_app_new (xb_node_get_text (extend));
+			gs_app_add_quirk (app2, GS_APP_QUIRK_IS_WILDCARD);
+			tmp = xb_node_query_attr (extend, "../..", "origin", NULL);
+			if (gs_appstream_origin_valid (tmp))
+				gs_app_set_origin_appstream (app2, tmp);
+			gs_app_list_add (list, app2);
+		}
+	}
+	return TRUE;
+}
+
 gboolean
-gs_appstream_search (GsPlugin *plugin,
-		     XbSilo *silo,
-		     const gchar * const *values,
-		     GsAppList *list,
-		     GCancellable *cancellable,
-		     GError **error)
+gs_appstream_search_with_index (GsPlugin *plugin,
+				XbSilo *silo,
+				GsAppstreamIndex *index,
+				const gchar * const *values,
+				GsAppList *list,
+				GCancellable *cancellable,
+				GError **error)
 {
 	g_autoptr(GError) error_local = NULL;
 	g_autoptr(GPtrArray) array = g_ptr_array_new_with_free_func ((GDestroyNotify) gs_appstream_search_helper_free);
@@ -1366,6 +1436,21 @@ gs_appstream_search (GsPlugin *plugin,
 		{ AS_SEARCH_TOKEN_MATCH_NONE,	NULL }
 	};
 
+	/* use the prebuilt token index, which only visits the results */
+	if (index != NULL) {
+		g_autoptr(GArray) matches = gs_appstream_index_search (index, values);
+		for (guint i = 0; i < matches->len; i++) {
+			GsAppstreamIndexMatch *match = &g_array_index (matches, GsAppstreamIndexMatch, i);
+			if (!gs_appstream_search_add_component (plugin, silo,
+								match->component,
+								match->match_value,
+								list, error))
+				return FALSE;
+		}
+		g_debug ("indexed search took %fms", g_timer_elapsed (timer, NULL) * 1000);
+		return TRUE;
+	}
+
 	/* add some weighted queries */
 	for (guint i = 0; queries[i].xpath != NULL; i++) {
 		g_autoptr(GError) error_query = NULL;
@@ -1394,35 +1479,9 @@ gs_appstream_search (GsPlugin *plugin,
 		XbNode *component = g_ptr_array_index (components, i);
 		guint16 match_value = gs_appstream_silo_search_component (array, component, values);
 		if (match_value != 0) {
-			g_autoptr(GsApp) app = gs_appstream_create_app (plugin, silo, component, error);
-			if (app == NULL)
+			if (!gs_appstream_search_add_component (plugin, silo, component,
+								match_value, list, error))
 				return FALSE;
-			if (gs_app_has_quirk (app, GS_APP_QUIRK_IS_WILDCARD)) {
-				g_debug ("not returning wildcard %s",
-					 gs_app_get_unique_id (app));
-				continue;
-			}
-			g_debug ("add %s", gs_app_get_unique_id (app));
-			gs_app_set_match_value (app, match_value);
-			gs_app_list_add (list, app);
-
-			if (gs_app_get_kind (app) == AS_COMPONENT_KIND_ADDON) {
-				g_autoptr(GPtrArray) extends = NULL;
-
-				/* add the parent app as a wildcard, to be refined later */
-				extends = xb_node_query (component, "extends", 0, NULL);
-				for (guint jj = 0; extends && jj < extends->len; jj++) {
-					XbNode *extend = g_ptr_array_index (extends, jj);
-					g_autoptr(GsApp) app2 = NULL;
-					const gchar *tmp;
-					app2 = gs_app_new (xb_node_get_text (extend));
-					gs_app_add_quirk (app2, GS_APP_QUIRK_IS_WILDCARD);
-					tmp = xb_node_query_attr (extend, "../..", "origin", NULL);
-					if (gs_appstream_origin_valid (tmp))
-						gs_app_set_origin_appstream (app2, tmp);
-					gs_app_list_add (list, app2);
-				}
-			}
 		}
 	}
 	g_debug ("search took %fms", g_timer_elapsed (timer, NULL) * 1000);
@@ -1430,11 +1489,25 @@ gs_appstream_search (GsPlugin *plugin,
 }
 
 gboolean
-gs_appstream_add_category_apps (XbSilo *silo,
-				GsCategory *category,
-				GsAppList *list,
-				GCancellable *cancellable,
-				GError **error)
+gs_appstream_search (GsPlugin *plugin,
+		     XbSilo *silo,
+		     const gchar * const *values,
+		     GsAppList *list,
+		     GCancellable *cancellable,
+		     GError **error)
+{
+	return gs_appstream_search_with_index (plugin, silo, NULL, values, list,
+					       cancellable, error);
+}
+
+gboolean
+gs_appstream_add_category_apps_with_index (GsPlugin *plugin,
+					   XbSilo *silo,
+					   GsAppstreamIndex *index,
+					   GsCategory *category,
+					   GsAppList *list,
+					   GCancellable *cancellable,
+					   GError **error)
 {
 	GPtrArray *desktop_groups;
 	g_autoptr(GError) error_local = NULL;
@@ -1444,6 +1517,43 @@ gs_appstream_add_category_apps (XbSilo *silo,
 		g_warning ("no desktop_groups for %s", gs_category_get_id (category));
 		return TRUE;
 	}
+
+	/* look the components up in the prebuilt category lists, and return
+	 * them as real apps rather than wildcards which need resolving; the
+	 * exception is override components without a name, which are added
+	 * as wildcards like below so they are resolved to the apps they
+	 * extend */
+	if (index != NULL) {
+		for (guint j = 0; j < desktop_groups->len; j++) {
+			const gchar *desktop_group = g_ptr_array_index (desktop_groups, j);
+			g_autoptr(GPtrArray) components = NULL;
+
+			components = gs_appstream_index_get_desktop_group_components (index, desktop_group);
+			for (guint i = 0; i < components->len; i++) {
+				XbNode *component = g_ptr_array_index (components, i);
+				g_autoptr(GsApp) app = NULL;
+
+				if (g_cancellable_set_error_if_cancelled (cancellable, error))
+					return FALSE;
+				app = gs_appstream_create_app (plugin, silo, component, error);
+				if (app == NULL)
+					return FALSE;
+				if (gs_app_has_quirk (app, GS_APP_QUIRK_IS_WILDCARD)) {
+					const gchar *id = xb_node_query_text (component, "id", NULL);
+					g_autoptr(GsApp) app_wildcard = NULL;
+					if (id == NULL)
+						continue;
+					app_wildcard = gs_app_new (id);
+					gs_app_add_quirk (app_wildcard, GS_APP_QUIRK_IS_WILDCARD);
+					gs_app_list_add (list, app_wildcard);
+					continue;
+				}
+				gs_app_list_add (list, app);
+			}
+		}
+		return TRUE;
+	}
+
 	for (guint j = 0; j < desktop_groups->len; j++) {
 		const gchar *desktop_group = g_ptr_array_index (desktop_groups, j);
 		g_autofree gchar *xpath = NULL;
@@ -1487,6 +1597,18 @@ gs_appstream_add_category_apps (XbSilo *silo,
 	return TRUE;
 }
 
+gboolean
+gs_appstream_add_category_apps (XbSilo *silo,
+				GsCategory *category,
+				GsAppList *list,
+				GCancellable *cancellable,
+				GError **error)
+{
+	/* the plugin is only needed to create apps from the index */
+	return gs_appstream_add_category_apps_with_index (NULL, silo, NULL, category,
+							  list, cancellable, error);
+}
+
 static guint
 gs_appstream_count_component_for_groups (XbSilo      *silo,
                                          const gchar *desktop_group)
@@ -1523,12 +1645,15 @@ gs_appstream_count_component_for_groups (XbSilo      *silo,
 }
 
 /* we're not actually adding categories here, we're just setting the number of
- * applications available in each category */
+ * applications available in each category; with an @index the counts are
+ * exact and come from the category lists built with the silo, otherwise the
+ * silo is queried and the counts are capped */
 gboolean
-gs_appstream_add_categories (XbSilo *silo,
-			     GPtrArray *list,
-			     GCancellable *cancellable,
-			     GError **error)
+gs_appstream_add_categories_with_index (XbSilo *silo,
+					GsAppstreamIndex *index,
+					GPtrArray *list,
+					GCancellable *cancellable,
+					GError **error)
 {
 	for (guint j = 0; j < list->len; j++) {
 		GsCategory *parent = GS_CATEGORY (g_ptr_array_index (list, j));
@@ -1539,14 +1664,17 @@ gs_appstream_add_categories (XbSilo *silo,
 			GPtrArray *groups = gs_category_get_desktop_groups (cat);
 			for (guint k = 0; k < groups->len; k++) {
 				const gchar *group = g_ptr_array_index (groups, k);
-				guint cnt = gs_appstream_count_component_for_groups (silo, group);
-				for (guint l = 0; l < cnt; l++) {
-					gs_category_increment_size (parent);
-					if (children->len > 1) {
-						/* Parent category has multiple groups, so increment
-						 * each group's size too */
-						gs_category_increment_size (cat);
-					}
+				guint cnt;
+
+				if (index != NULL)
+					cnt = gs_appstream_index_count_desktop_group (index, group);
+				else
+					cnt = gs_appstream_count_component_for_groups (silo, group);
+				gs_category_add_size (parent, cnt);
+				if (children->len > 1) {
+					/* Parent category has multiple groups, so increment
+					 * each group's size too */
+					gs_category_add_size (cat, cnt);
 				}
 			}
 		}
@@ -1555,6 +1683,16 @@ gs_appstream_add_categories (XbSilo *silo,
 	return TRUE;
 }
 
+gboolean
+gs_appstream_add_categories (XbSilo *silo,
+			     GPtrArray *list,
+			     GCancellable *cancellable,
+			     GError **error)
+{
+	return gs_appstream_add_categories_with_index (silo, NULL, list,
+						       cancellable, error);
+}
+
 gboolean
 gs_appstream_add_popular (XbSilo *silo,
 			  GsAppList *list,
@@ -16,6 +16,8 @@ G_BEGIN_DECLS
 void		 gs_category_sort_children	(GsCategory	*category);
 void		 gs_category_set_size		(GsCategory	*category,
 						 guint		 size);
+void		 gs_category_add_size		(GsCategory	*category,
+						 guint		 value);
 gchar		*gs_category_to_string		(GsCategory	*category);
 
 G_END_DECLS
@@ -144,6 +144,28 @@ gs_category_set_size (GsCategory *category, guint size)
 	g_object_notify_by_pspec (G_OBJECT (category), obj_props[PROP_SIZE]);
 }
 
+/**
+ * gs_category_add_size:
+ * @category: a #GsCategory
+ * @value: the number of applications to add
+ *
+ * Adds @value to the size count, notifying once rather than once for each
+ * application as gs_category_increment_size() would.
+ *
+ * Since: 42
+ **/
+void
+gs_category_add_size (GsCategory *category, guint value)
+{
+	g_return_if_fail (GS_IS_CATEGORY (category));
+
+	if (value == 0)
+		return;
+
+	category->size += value;
+	g_object_notify_by_pspec (G_OBJECT (category), obj_props[PROP_SIZE]);
+}
+
 /**
  * gs_category_increment_size:
  * @category: a #GsCategory
@@ -0,0 +1,903 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ * vi:set noexpandtab tabstop=8 shiftwidth=8:
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ */
+
+/**
+ * SECTION:gs-icon-pack
+ * @short_description: Packed store for downloaded icons
+ *
+ * #GsIconPack keeps the remote icons which have been downloaded in a single
+ * append-only file, rather than as one PNG file per icon. Each icon is stored
+ * as PNG data pre-scaled to the sizes it is rendered at (64, 128 and 160
+ * pixels, times the scale factor), so it only has to be decoded, never
+ * scaled, when it is shown.
+ *
+ * The file is memory mapped when it is opened, so the only I/O at startup is
+ * a walk over the record headers to build the index, and it is mapped again
+ * whenever records are appended, so icons are always read from the mapping.
+ * Every record contains the URI of its icon, and the index is keyed by the
+ * URI string. Icons are decoded without holding any lock, and decoded icons
+ * are only kept for as long as they are in use.
+ *
+ * Records are appended under an exclusive file lock, and records appended by
+ * other processes are indexed the next time the lock is taken. When the file
+ * is full, the icons which were used least recently are dropped. As other
+ * processes may have the file mapped, it is never truncated: the icons which
+ * are kept are written to a new file, which is moved over the old one. The
+ * same happens to drop a record which was only partly written, and to start
+ * afresh when the format changes.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "gs-icon-pack.h"
+#include "gs-utils.h"
+
+#define GS_ICON_PACK_MAGIC		"GSICPAK"
+#define GS_ICON_PACK_VERSION		2
+#define GS_ICON_PACK_BYTE_ORDER		0x01020304
+#define GS_ICON_PACK_RECORD_MAGIC	0x32524947	/* "GIR2" */
+#define GS_ICON_PACK_MAX_FILE_SIZE	(64 * 1024 * 1024)
+#define GS_ICON_PACK_MAX_DIMENSION	1024
+#define GS_ICON_PACK_MAX_URI_LEN	4096
+
+typedef struct {
+	gchar		 magic[8];
+	guint32		 version;
+	guint32		 byte_order;
+} GsIconPackHeader;
+
+/* followed by @uri_len bytes of URI, with no nul terminator, and then
+ * @data_len bytes of PNG data */
+typedef struct {
+	guint32		 magic;
+	guint32		 width;
+	guint32		 height;
+	guint32		 uri_len;
+	guint32		 data_len;
+	guint32		 reserved;
+} GsIconPackRecord;
+
+typedef struct {
+	guint		 width;
+	guint		 height;
+	gsize		 offset;	/* of the PNG data in the file */
+	gsize		 data_len;
+	GWeakRef	 texture;	/* (nullable): while it is in use */
+} GsIconPackVariant;
+
+typedef struct {
+	gchar		*uri;
+	GPtrArray	*variants;	/* (element-type GsIconPackVariant), smallest first */
+	guint64		 last_used;
+} GsIconPackEntry;
+
+/* a record found in the file, before it is indexed */
+typedef struct {
+	gsize		 uri_offset;
+	gsize		 uri_len;
+	guint		 width;
+	guint		 height;
+	gsize		 offset;
+	gsize		 data_len;
+} GsIconPackPending;
+
+/* The file is only locked, read and written with @io_mutex held, so lookups
+ * on the main thread never wait for another process or for a compaction.
+ * The index is only changed with both mutexes held, so the I/O paths can
+ * read it with just @io_mutex; lookups take @mutex. */
+struct _GsIconPack
+{
+	GObject		 parent_instance;
+	GMutex		 io_mutex;
+	GMutex		 mutex;
+	gchar		*filename;
+	gint		 fd;		/* (io_mutex) */
+	gsize		 end;		/* (io_mutex) of the last record indexed, or 0 if not loaded */
+	GBytes		*mapped_bytes;	/* (nullable): covering every indexed record */
+	guint64		 use_count;
+	GHashTable	*entries;	/* (element-type utf8 GsIconPackEntry) */
+};
+
+G_DEFINE_TYPE (GsIconPack, gs_icon_pack, G_TYPE_OBJECT)
+
+static void
+gs_icon_pack_set_error_from_errno (GError      **error,
+                                   gint          errsv,
+                                   const gchar  *message)
+{
+	g_set_error (error,
+		     G_IO_ERROR,
+		     g_io_error_from_errno (errsv),
+		     "%s: %s",
+		     message, g_strerror (errsv));
+}
+
+static void
+gs_icon_pack_variant_free (GsIconPackVariant *variant)
+{
+	g_weak_ref_clear (&variant->texture);
+	g_slice_free (GsIconPackVariant, variant);
+}
+
+static void
+gs_icon_pack_entry_free (GsIconPackEntry *entry)
+{
+	g_free (entry->uri);
+	g_ptr_array_unref (entry->variants);
+	g_slice_free (GsIconPackEntry, entry);
+}
+
+static gint
+gs_icon_pack_variant_sort_cb (gconstpointer a,
+                              gconstpointer b)
+{
+	const GsIconPackVariant *variant_a = *((GsIconPackVariant **) a);
+	const GsIconPackVariant *variant_b = *((GsIconPackVariant **) b);
+
+	if (variant_a->width < variant_b->width)
+		return -1;
+	if (variant_a->width > variant_b->width)
+		return 1;
+	return 0;
+}
+
+/* most recently used first */
+static gint
+gs_icon_pack_entry_sort_cb (gconstpointer a,
+                            gconstpointer b)
+{
+	const GsIconPackEntry *entry_a = *((GsIconPackEntry **) a);
+	const GsIconPackEntry *entry_b = *((GsIconPackEntry **) b);
+
+	if (entry_a->last_used > entry_b->last_used)
+		return -1;
+	if (entry_a->last_used < entry_b->last_used)
+		return 1;
+	return 0;
+}
+
+/* must be called with both mutexes held; a later variant of the same width
+ * replaces the earlier one */
+static void
+gs_icon_pack_insert (GsIconPack        *self,
+                     const gchar       *uri,
+                     gsize              uri_len,
+                     guint              width,
+                     guint              height,
+                     gsize              offset,
+                     gsize              data_len)
+{
+	GsIconPackEntry *entry;
+	GsIconPackVariant *variant;
+	g_autofree gchar *uri_str = g_strndup (uri, uri_len);
+
+	entry = g_hash_table_lookup (self->entries, uri_str);
+	if (entry == NULL) {
+		entry = g_slice_new0 (GsIconPackEntry);
+		entry->uri = g_steal_pointer (&uri_str);
+		entry->variants = g_ptr_array_new_with_free_func ((GDestroyNotify) gs_icon_pack_variant_free);
+		g_hash_table_insert (self->entries, entry->uri, entry);
+	}
+	for (guint i = 0; i < entry->variants->len; i++) {
+		variant = g_ptr_array_index (entry->variants, i);
+		if (variant->width == width) {
+			g_ptr_array_remove_index (entry->variants, i);
+			break;
+		}
+	}
+
+	variant = g_slice_new0 (GsIconPackVariant);
+	variant->width = width;
+	variant->height = height;
+	variant->offset = offset;
+	variant->data_len = data_len;
+	g_weak_ref_init (&variant->texture, NULL);
+	g_ptr_array_add (entry->variants, variant);
+	g_ptr_array_sort (entry->variants, gs_icon_pack_variant_sort_cb);
+
+	/* records later in the file were added more recently */
+	entry->last_used = ++self->use_count;
+}
+
+static gboolean
+gs_icon_pack_record_is_valid (const GsIconPackRecord *record)
+{
+	return record->magic == GS_ICON_PACK_RECORD_MAGIC &&
+	       record->width > 0 && record->width <= GS_ICON_PACK_MAX_DIMENSION &&
+	       record->height > 0 && record->height <= GS_ICON_PACK_MAX_DIMENSION &&
+	       record->uri_len > 0 && record->uri_len <= GS_ICON_PACK_MAX_URI_LEN &&
+	       record->data_len > 0 && record->data_len <= GS_ICON_PACK_MAX_FILE_SIZE;
+}
+
+/* find the complete records in @data from @offset, returning the offset
+ * just past the last one */
+static gsize
+gs_icon_pack_find_records (const guint8  *data,
+                           gsize          len,
+                           gsize          offset,
+                           GArray        *pending)
+{
+	while (len - offset >= sizeof (GsIconPackRecord)) {
+		GsIconPackRecord record;
+		GsIconPackPending item;
+
+		memcpy (&record, data + offset, sizeof (record));
+		if (!gs_icon_pack_record_is_valid (&record) ||
+		    len - offset - sizeof (record) < (gsize) record.uri_len + record.data_len)
+			break;
+
+		item.uri_offset = offset + sizeof (record);
+		item.uri_len = record.uri_len;
+		item.width = record.width;
+		item.height = record.height;
+		item.offset = item.uri_offset + record.uri_len;
+		item.data_len = record.data_len;
+		g_array_append_val (pending, item);
+		offset = item.offset + record.data_len;
+	}
+	return offset;
+}
+
+static gboolean
+gs_icon_pack_write_all (gint           fd,
+                        const guint8  *data,
+                        gsize          len,
+                        goffset        offset,
+                        GError       **error)
+{
+	while (len > 0) {
+		gssize written = pwrite (fd, data, len, offset);
+		if (written < 0) {
+			gint errsv = errno;
+			if (errsv == EINTR)
+				continue;
+			gs_icon_pack_set_error_from_errno (error, errsv, "Failed to write icon pack");
+			return FALSE;
+		}
+		data += written;
+		len -= (gsize) written;
+		offset += written;
+	}
+	return TRUE;
+}
+
+/* must be called with @io_mutex held */
+static void
+gs_icon_pack_unload (GsIconPack *self)
+{
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->mutex);
+	g_hash_table_remove_all (self->entries);
+	g_clear_pointer (&self->mapped_bytes, g_bytes_unref);
+	self->end = 0;
+}
+
+/* write the records of @entries to @fd, storing the new offset of each
+ * variant's data in @offsets; must be called with @io_mutex held */
+static gboolean
+gs_icon_pack_write_entries (GsIconPack  *self,
+                            gint         fd,
+                            GPtrArray   *entries,
+                            GArray      *offsets,
+                            gsize       *end,
+                            GError     **error)
+{
+	GsIconPackHeader header = { GS_ICON_PACK_MAGIC,
+				    GS_ICON_PACK_VERSION,
+				    GS_ICON_PACK_BYTE_ORDER };
+	gsize offset = sizeof (header);
+
+	if (!gs_icon_pack_write_all (fd, (const guint8 *) &header, sizeof (header), 0, error))
+		return FALSE;
+
+	for (guint i = 0; i < entries->len; i++) {
+		GsIconPackEntry *entry = g_ptr_array_index (entries, i);
+		gsize uri_len = strlen (entry->uri);
+
+		for (guint j = 0; j < entry->variants->len; j++) {
+			GsIconPackVariant *variant = g_ptr_array_index (entry->variants, j);
+			GsIconPackRecord record = { 0, };
+			const guint8 *data = g_bytes_get_data (self->mapped_bytes, NULL);
+
+			record.magic = GS_ICON_PACK_RECORD_MAGIC;
+			record.width = variant->width;
+			record.height = variant->height;
+			record.uri_len = (guint32) uri_len;
+			record.data_len = (guint32) variant->data_len;
+			if (!gs_icon_pack_write_all (fd, (const guint8 *) &record, sizeof (record), (goffset) offset, error) ||
+			    !gs_icon_pack_write_all (fd, (const guint8 *) entry->uri, uri_len, (goffset) (offset + sizeof (record)), error) ||
+			    !gs_icon_pack_write_all (fd, data + variant->offset, variant->data_len,
+						     (goffset) (offset + sizeof (record) + uri_len), error))
+				return FALSE;
+			offset += sizeof (record) + uri_len;
+			g_array_append_val (offsets, offset);
+			offset += variant->data_len;
+		}
+	}
+
+	*end = offset;
+	return TRUE;
+}
+
+/* Writes the most recently used icons which fit in @max_size bytes to a new
+ * file, and moves it over the old one; the old one is never truncated, as
+ * other processes may have it mapped. Must be called with @io_mutex held and
+ * the file locked, and the new file is locked in turn. Lookups carry on with
+ * the old mapping until the new offsets are swapped in at the end. */
+static gboolean
+gs_icon_pack_compact (GsIconPack  *self,
+                      gsize        max_size,
+                      GError     **error)
+{
+	GHashTableIter iter;
+	gpointer value;
+	gsize size = sizeof (GsIconPackHeader);
+	gsize end = 0;
+	gint fd;
+	guint n_offsets = 0;
+	g_autofree gchar *tmp_filename = g_strconcat (self->filename, ".XXXXXX", NULL);
+	g_autoptr(GArray) offsets = g_array_new (FALSE, FALSE, sizeof (gsize));
+	g_autoptr(GPtrArray) entries = g_ptr_array_new ();
+	g_autoptr(GPtrArray) kept = g_ptr_array_new ();
+	g_autoptr(GHashTable) kept_set = g_hash_table_new (g_direct_hash, g_direct_equal);
+	g_autoptr(GMappedFile) mapped = NULL;
+	g_autoptr(GMutexLocker) locker = NULL;
+
+	/* lookups update the use counts */
+	locker = g_mutex_locker_new (&self->mutex);
+	g_hash_table_iter_init (&iter, self->entries);
+	while (g_hash_table_iter_next (&iter, NULL, &value))
+		g_ptr_array_add (entries, value);
+	g_ptr_array_sort (entries, gs_icon_pack_entry_sort_cb);
+	g_clear_pointer (&locker, g_mutex_locker_free);
+	for (guint i = 0; i < entries->len; i++) {
+		GsIconPackEntry *entry = g_ptr_array_index (entries, i);
+		gsize entry_size = 0;
+
+		for (guint j = 0; j < entry->variants->len; j++) {
+			GsIconPackVariant *variant = g_ptr_array_index (entry->variants, j);
+			entry_size += sizeof (GsIconPackRecord) + strlen (entry->uri) + variant->data_len;
+		}
+		if (size + entry_size > max_size)
+			continue;
+		size += entry_size;
+		g_ptr_array_add (kept, entry);
+	}
+
+	fd = g_mkstemp_full (tmp_filename, O_RDWR | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		gs_icon_pack_set_error_from_errno (error, errno, "Failed to create icon pack");
+		return FALSE;
+	}
+	if (!gs_icon_pack_write_entries (self, fd, kept, offsets, &end, error)) {
+		close (fd);
+		g_unlink (tmp_filename);
+		return FALSE;
+	}
+	if (flock (fd, LOCK_EX) < 0 || g_rename (tmp_filename, self->filename) < 0) {
+		gs_icon_pack_set_error_from_errno (error, errno, "Failed to replace icon pack");
+		close (fd);
+		g_unlink (tmp_filename);
+		return FALSE;
+	}
+
+	/* switch to the new file; closing the old one drops its lock, and
+	 * other processes notice that it was replaced once they get it */
+	close (self->fd);
+	self->fd = fd;
+	mapped = g_mapped_file_new_from_fd (self->fd, FALSE, error);
+	if (mapped == NULL) {
+		gs_icon_pack_unload (self);
+		return FALSE;
+	}
+
+	locker = g_mutex_locker_new (&self->mutex);
+	for (guint i = 0; i < kept->len; i++) {
+		GsIconPackEntry *entry = g_ptr_array_index (kept, i);
+
+		for (guint j = 0; j < entry->variants->len; j++) {
+			GsIconPackVariant *variant = g_ptr_array_index (entry->variants, j);
+			variant->offset = g_array_index (offsets, gsize, n_offsets++);
+		}
+		g_hash_table_add (kept_set, entry);
+	}
+	g_hash_table_iter_init (&iter, self->entries);
+	while (g_hash_table_iter_next (&iter, NULL, &value)) {
+		if (!g_hash_table_contains (kept_set, value))
+			g_hash_table_iter_remove (&iter);
+	}
+	g_clear_pointer (&self->mapped_bytes, g_bytes_unref);
+	self->mapped_bytes = g_mapped_file_get_bytes (mapped);
+	self->end = end;
+	return TRUE;
+}
+
+/* Brings the index up to date with the file, which must be locked; this
+ * maps the file again and indexes the records appended since it was last
+ * mapped, by this or other processes, and drops a record which was only
+ * partly written. Must be called with @io_mutex held. */
+static gboolean
+gs_icon_pack_sync (GsIconPack  *self,
+                   GError     **error)
+{
+	struct stat st;
+	gsize start = self->end;
+	gsize end;
+	gsize len = 0;
+	const guint8 *data;
+	g_autoptr(GArray) pending = g_array_new (FALSE, FALSE, sizeof (GsIconPackPending));
+	g_autoptr(GBytes) bytes = NULL;
+	g_autoptr(GMappedFile) mapped = NULL;
+	g_autoptr(GMutexLocker) locker = NULL;
+
+	if (fstat (self->fd, &st) < 0) {
+		gs_icon_pack_set_error_from_errno (error, errno, "Failed to stat icon pack");
+		return FALSE;
+	}
+
+	/* the file should only ever grow */
+	if ((gsize) st.st_size < start) {
+		gs_icon_pack_unload (self);
+		start = 0;
+	}
+
+	/* nothing new */
+	if (start > 0 && (gsize) st.st_size == start)
+		return TRUE;
+
+	/* start afresh, with no icons, if the file is new or too big */
+	if (st.st_size < (goffset) sizeof (GsIconPackHeader) ||
+	    st.st_size > GS_ICON_PACK_MAX_FILE_SIZE) {
+		gs_icon_pack_unload (self);
+		return gs_icon_pack_compact (self, 0, error);
+	}
+
+	mapped = g_mapped_file_new_from_fd (self->fd, FALSE, error);
+	if (mapped == NULL)
+		return FALSE;
+	bytes = g_mapped_file_get_bytes (mapped);
+	data = g_bytes_get_data (bytes, &len);
+	if (start == 0) {
+		GsIconPackHeader header;
+
+		/* or if it is in another format */
+		memcpy (&header, data, sizeof (header));
+		if (memcmp (header.magic, GS_ICON_PACK_MAGIC, sizeof (header.magic)) != 0 ||
+		    header.version != GS_ICON_PACK_VERSION ||
+		    header.byte_order != GS_ICON_PACK_BYTE_ORDER) {
+			gs_icon_pack_unload (self);
+			return gs_icon_pack_compact (self, 0, error);
+		}
+		start = sizeof (header);
+	}
+	end = gs_icon_pack_find_records (data, len, start, pending);
+
+	/* the parsing is done before swapping in the new mapping */
+	locker = g_mutex_locker_new (&self->mutex);
+	for (guint i = 0; i < pending->len; i++) {
+		GsIconPackPending *item = &g_array_index (pending, GsIconPackPending, i);
+		gs_icon_pack_insert (self,
+				     (const gchar *) data + item->uri_offset,
+				     item->uri_len,
+				     item->width,
+				     item->height,
+				     item->offset,
+				     item->data_len);
+	}
+	g_clear_pointer (&self->mapped_bytes, g_bytes_unref);
+	self->mapped_bytes = g_steal_pointer (&bytes);
+	g_clear_pointer (&locker, g_mutex_locker_free);
+	self->end = end;
+
+	/* drop a record which was only partly written */
+	if (end < len)
+		return gs_icon_pack_compact (self, GS_ICON_PACK_MAX_FILE_SIZE, error);
+	return TRUE;
+}
+
+/* Takes the file lock, switching to the file at @filename first if another
+ * process replaced it. Must be called with @io_mutex held. */
+static gboolean
+gs_icon_pack_lock (GsIconPack  *self,
+                   GError     **error)
+{
+	while (TRUE) {
+		struct stat st_fd, st_path;
+
+		if (self->fd < 0) {
+			self->fd = open (self->filename, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+			if (self->fd < 0) {
+				gs_icon_pack_set_error_from_errno (error, errno, "Failed to open icon pack");
+				return FALSE;
+			}
+		}
+		if (flock (self->fd, LOCK_EX) < 0 || fstat (self->fd, &st_fd) < 0) {
+			gs_icon_pack_set_error_from_errno (error, errno, "Failed to lock icon pack");
+			return FALSE;
+		}
+		if (g_stat (self->filename, &st_path) == 0 &&
+		    st_path.st_dev == st_fd.st_dev &&
+		    st_path.st_ino == st_fd.st_ino)
+			return TRUE;
+
+		/* replaced or removed since it was opened */
+		gs_icon_pack_unload (self);
+		close (self->fd);
+		self->fd = -1;
+	}
+}
+
+/**
+ * gs_icon_pack_new:
+ * @filename: the file to store the icons in, which is created if needed
+ * @error: a #GError, or %NULL
+ *
+ * Opens the icon pack at @filename, mapping it and indexing the icons it
+ * already contains.
+ *
+ * Returns: (transfer full): a #GsIconPack, or %NULL on error
+ *
+ * Since: 42
+ **/
+GsIconPack *
+gs_icon_pack_new (const gchar  *filename,
+                  GError      **error)
+{
+	g_autoptr(GsIconPack) self = g_object_new (GS_TYPE_ICON_PACK, NULL);
+	gboolean ret;
+
+	g_return_val_if_fail (filename != NULL, NULL);
+
+	self->filename = g_strdup (filename);
+	if (!gs_icon_pack_lock (self, error))
+		return NULL;
+	ret = gs_icon_pack_sync (self, error);
+	if (self->fd >= 0)
+		flock (self->fd, LOCK_UN);
+	if (!ret)
+		return NULL;
+	return g_steal_pointer (&self);
+}
+
+/**
+ * gs_icon_pack_get_default:
+ *
+ * Gets the icon pack in the user cache directory, opening it on first use.
+ *
+ * Returns: (transfer none) (nullable): the #GsIconPack, or %NULL if it could
+ *     not be opened
+ *
+ * Since: 42
+ **/
+GsIconPack *
+gs_icon_pack_get_default (void)
+{
+	static gsize initialised = 0;
+	static GsIconPack *pack = NULL;
+
+	if (g_once_init_enter (&initialised)) {
+		g_autofree gchar *filename = NULL;
+		g_autoptr(GError) error = NULL;
+
+		filename = gs_utils_get_cache_filename ("icons", "icons.pack",
+							GS_UTILS_CACHE_FLAG_WRITEABLE |
+							GS_UTILS_CACHE_FLAG_CREATE_DIRECTORY,
+							&error);
+		if (filename != NULL)
+			pack = gs_icon_pack_new (filename, &error);
+		if (pack == NULL)
+			g_debug ("failed to open icon pack: %s", error->message);
+		g_once_init_leave (&initialised, 1);
+	}
+	return pack;
+}
+
+/**
+ * gs_icon_pack_contains:
+ * @self: a #GsIconPack
+ * @uri: the URI the icon was downloaded from
+ * @width: (out) (optional): return location for the width of the largest
+ *     stored size, or %NULL
+ * @height: (out) (optional): return location for the height of the largest
+ *     stored size, or %NULL
+ *
+ * Checks whether the icon for @uri is in the pack.
+ *
+ * Returns: %TRUE if the icon is stored
+ *
+ * Since: 42
+ **/
+gboolean
+gs_icon_pack_contains (GsIconPack  *self,
+                       const gchar *uri,
+                       guint       *width,
+                       guint       *height)
+{
+	GsIconPackEntry *entry;
+	GsIconPackVariant *variant;
+	g_autoptr(GMutexLocker) locker = NULL;
+
+	g_return_val_if_fail (GS_IS_ICON_PACK (self), FALSE);
+	g_return_val_if_fail (uri != NULL, FALSE);
+
+	locker = g_mutex_locker_new (&self->mutex);
+	entry = g_hash_table_lookup (self->entries, uri);
+	if (entry == NULL)
+		return FALSE;
+	entry->last_used = ++self->use_count;
+	variant = g_ptr_array_index (entry->variants, entry->variants->len - 1);
+	if (width != NULL)
+		*width = variant->width;
+	if (height != NULL)
+		*height = variant->height;
+	return TRUE;
+}
+
+/* a record for @pixbuf, encoded as PNG */
+static GBytes *
+gs_icon_pack_record_new_for_pixbuf (const gchar  *uri,
+                                    GdkPixbuf    *pixbuf,
+                                    GError      **error)
+{
+	GsIconPackRecord record = { 0, };
+	gsize uri_len = strlen (uri);
+	gsize png_len = 0;
+	guint8 *data;
+	g_autofree gchar *png = NULL;
+
+	if (!gdk_pixbuf_save_to_buffer (pixbuf, &png, &png_len, "png", error, NULL))
+		return NULL;
+
+	record.magic = GS_ICON_PACK_RECORD_MAGIC;
+	record.width = (guint32) gdk_pixbuf_get_width (pixbuf);
+	record.height = (guint32) gdk_pixbuf_get_height (pixbuf);
+	record.uri_len = (guint32) uri_len;
+	record.data_len = (guint32) png_len;
+
+	data = g_malloc (sizeof (record) + uri_len + png_len);
+	memcpy (data, &record, sizeof (record));
+	memcpy (data + sizeof (record), uri, uri_len);
+	memcpy (data + sizeof (record) + uri_len, png, png_len);
+	return g_bytes_new_take (data, sizeof (record) + uri_len + png_len);
+}
+
+/**
+ * gs_icon_pack_add_pixbuf:
+ * @self: a #GsIconPack
+ * @uri: the URI the icon was downloaded from
+ * @pixbuf: the icon
+ * @scale: the scale factor the icon is rendered at
+ * @error: a #GError, or %NULL
+ *
+ * Adds an icon to the pack, scaled down to each of the sizes it is rendered
+ * at which are smaller than @pixbuf, and at the size of @pixbuf itself. If
+ * the pack is full, the icons which were used least recently are dropped to
+ * make room.
+ *
+ * This can be called from any thread.
+ *
+ * Returns: %TRUE on success
+ *
+ * Since: 42
+ **/
+gboolean
+gs_icon_pack_add_pixbuf (GsIconPack   *self,
+                         const gchar  *uri,
+                         GdkPixbuf    *pixbuf,
+                         guint         scale,
+                         GError      **error)
+{
+	const guint sizes[] = { 64, 128, 160 };
+	gsize total_len = 0;
+	gsize offset;
+	gsize uri_len;
+	gboolean ret;
+	gboolean add_original = FALSE;
+	g_autoptr(GPtrArray) records = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
+	g_autoptr(GMutexLocker) locker = NULL;
+
+	g_return_val_if_fail (GS_IS_ICON_PACK (self), FALSE);
+	g_return_val_if_fail (uri != NULL, FALSE);
+	g_return_val_if_fail (GDK_IS_PIXBUF (pixbuf), FALSE);
+	g_return_val_if_fail (scale >= 1, FALSE);
+
+	uri_len = strlen (uri);
+	if (uri_len > GS_ICON_PACK_MAX_URI_LEN) {
+		g_set_error_literal (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_INVALID_ARGUMENT,
+				     "Icon URI is too long");
+		return FALSE;
+	}
+
+	/* the scaling and encoding is done before taking the lock */
+	for (guint i = 0; i < G_N_ELEMENTS (sizes); i++) {
+		guint size = sizes[i] * scale;
+		g_autoptr(GdkPixbuf) scaled = NULL;
+		GBytes *record;
+
+		if ((guint) gdk_pixbuf_get_width (pixbuf) <= size &&
+		    (guint) gdk_pixbuf_get_height (pixbuf) <= size) {
+			add_original = TRUE;
+			break;
+		}
+		scaled = gdk_pixbuf_scale_simple (pixbuf, (gint) size, (gint) size,
+						  GDK_INTERP_BILINEAR);
+		record = gs_icon_pack_record_new_for_pixbuf (uri, scaled, error);
+		if (record == NULL)
+			return FALSE;
+		g_ptr_array_add (records, record);
+	}
+	if (add_original) {
+		GBytes *record = gs_icon_pack_record_new_for_pixbuf (uri, pixbuf, error);
+		if (record == NULL)
+			return FALSE;
+		g_ptr_array_add (records, record);
+	}
+	for (guint i = 0; i < records->len; i++)
+		total_len += g_bytes_get_size (g_ptr_array_index (records, i));
+
+	/* lookups can carry on while waiting for the file lock */
+	locker = g_mutex_locker_new (&self->io_mutex);
+
+	/* other processes may be appending too */
+	if (!gs_icon_pack_lock (self, error))
+		return FALSE;
+	ret = gs_icon_pack_sync (self, error);
+
+	/* make room by dropping the least recently used icons */
+	if (ret && self->end + total_len > GS_ICON_PACK_MAX_FILE_SIZE)
+		ret = gs_icon_pack_compact (self, GS_ICON_PACK_MAX_FILE_SIZE / 2, error);
+
+	/* a record which is only partly written is dropped the next time the
+	 * file is synced, so there is nothing to undo on failure */
+	offset = self->end;
+	for (guint i = 0; ret && i < records->len; i++) {
+		GBytes *record = g_ptr_array_index (records, i);
+		gsize len = 0;
+		const guint8 *data = g_bytes_get_data (record, &len);
+
+		ret = gs_icon_pack_write_all (self->fd, data, len, (goffset) offset, error);
+		offset += len;
+	}
+
+	/* index the new records the same way as those from other processes */
+	if (ret)
+		ret = gs_icon_pack_sync (self, error);
+	if (self->fd >= 0)
+		flock (self->fd, LOCK_UN);
+	return ret;
+}
+
+/**
+ * gs_icon_pack_lookup:
+ * @self: a #GsIconPack
+ * @uri: the URI the icon was downloaded from
+ * @size: the size the icon is to be rendered at, in device pixels
+ *
+ * Gets the icon for @uri in the smallest stored size which is at least @size,
+ * or the largest one if none is big enough.
+ *
+ * The same texture is returned for as long as it is in use. The #GdkPixbuf
+ * it was created from is attached to it as `GnomeSoftware::pixbuf` data, as
+ * #GdkTexture cannot be serialized as a #GIcon.
+ *
+ * Returns: (transfer full) (nullable): a #GdkTexture, or %NULL if the icon
+ *     is not in the pack or cannot be loaded
+ *
+ * Since: 42
+ **/
+GdkTexture *
+gs_icon_pack_lookup (GsIconPack  *self,
+                     const gchar *uri,
+                     guint        size)
+{
+	GsIconPackEntry *entry;
+	GsIconPackVariant *variant = NULL;
+	GdkTexture *texture;
+	guint width;
+	g_autoptr(GBytes) data = NULL;
+	g_autoptr(GdkPixbuf) pixbuf = NULL;
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GInputStream) stream = NULL;
+	g_autoptr(GMutexLocker) locker = NULL;
+
+	g_return_val_if_fail (GS_IS_ICON_PACK (self), NULL);
+	g_return_val_if_fail (uri != NULL, NULL);
+
+	locker = g_mutex_locker_new (&self->mutex);
+	entry = g_hash_table_lookup (self->entries, uri);
+	if (entry == NULL)
+		return NULL;
+	entry->last_used = ++self->use_count;
+	for (guint i = 0; i < entry->variants->len; i++) {
+		variant = g_ptr_array_index (entry->variants, i);
+		if (MAX (variant->width, variant->height) >= size)
+			break;
+	}
+
+	texture = g_weak_ref_get (&variant->texture);
+	if (texture != NULL)
+		return texture;
+
+	/* the data stays valid if the file is mapped again meanwhile */
+	width = variant->width;
+	data = g_bytes_new_from_bytes (self->mapped_bytes, variant->offset, variant->data_len);
+	g_clear_pointer (&locker, g_mutex_locker_free);
+
+	stream = g_memory_input_stream_new_from_bytes (data);
+	pixbuf = gdk_pixbuf_new_from_stream (stream, NULL, &error_local);
+	if (pixbuf == NULL) {
+		g_debug ("failed to load %s from icon pack: %s", uri, error_local->message);
+		return NULL;
+	}
+	texture = gdk_texture_new_for_pixbuf (pixbuf);
+	g_object_set_data_full (G_OBJECT (texture), "GnomeSoftware::pixbuf",
+				g_object_ref (pixbuf), g_object_unref);
+
+	/* the variant may have been replaced or dropped while decoding, and
+	 * another thread may have decoded it too */
+	locker = g_mutex_locker_new (&self->mutex);
+	entry = g_hash_table_lookup (self->entries, uri);
+	for (guint i = 0; entry != NULL && i < entry->variants->len; i++) {
+		GdkTexture *texture_other;
+
+		variant = g_ptr_array_index (entry->variants, i);
+		if (variant->width != width)
+			continue;
+		texture_other = g_weak_ref_get (&variant->texture);
+		if (texture_other != NULL) {
+			g_object_unref (texture);
+			return texture_other;
+		}
+		g_weak_ref_set (&variant->texture, texture);
+		break;
+	}
+	return texture;
+}
+
+static void
+gs_icon_pack_finalize (GObject *object)
+{
+	GsIconPack *self = GS_ICON_PACK (object);
+
+	g_hash_table_unref (self->entries);
+	g_clear_pointer (&self->mapped_bytes, g_bytes_unref);
+	if (self->fd >= 0)
+		close (self->fd);
+	g_free (self->filename);
+	g_mutex_clear (&self->mutex);
+	g_mutex_clear (&self->io_mutex);
+
+	G_OBJECT_CLASS (gs_icon_pack_parent_class)->finalize (object);
+}
+
+static void
+gs_icon_pack_class_init (GsIconPackClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	object_class->finalize = gs_icon_pack_finalize;
+}
+
+static void
+gs_icon_pack_init (GsIconPack *self)
+{
+	g_mutex_init (&self->io_mutex);
+	g_mutex_init (&self->mutex);
+	self->fd = -1;
+	self->entries = g_hash_table_new_full (g_str_hash, g_str_equal,
+					       NULL, (GDestroyNotify) gs_icon_pack_entry_free);
+}
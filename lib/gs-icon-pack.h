@@ -0,0 +1,38 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ * vi:set noexpandtab tabstop=8 shiftwidth=8:
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ */
+
+#pragma once
+
+#include <gdk/gdk.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <glib.h>
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define GS_TYPE_ICON_PACK (gs_icon_pack_get_type ())
+
+G_DECLARE_FINAL_TYPE (GsIconPack, gs_icon_pack, GS, ICON_PACK, GObject)
+
+GsIconPack	*gs_icon_pack_new		(const gchar	*filename,
+						 GError		**error);
+GsIconPack	*gs_icon_pack_get_default	(void);
+gboolean	 gs_icon_pack_contains		(GsIconPack	*self,
+						 const gchar	*uri,
+						 guint		*width,
+						 guint		*height);
+gboolean	 gs_icon_pack_add_pixbuf	(GsIconPack	*self,
+						 const gchar	*uri,
+						 GdkPixbuf	*pixbuf,
+						 guint		 scale,
+						 GError		**error);
+GdkTexture	*gs_icon_pack_lookup		(GsIconPack	*self,
+						 const gchar	*uri,
+						 guint		 size);
+
+G_END_DECLS
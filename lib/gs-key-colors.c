@@ -22,15 +22,21 @@
  * the app’s icon, or manually specified as an override.
  *
  * Use gs_calculate_key_colors() to calculate the key colors from an app’s icon.
+ * gs_calculate_key_colors_cached() does the same, but remembers the results
+ * across runs.
  *
  * Since: 40
  */
 
 #include "config.h"
 
+#include <fcntl.h>
 #include <glib.h>
+#include <glib/gstdio.h>
 #include <gdk/gdk.h>
 #include <gdk-pixbuf/gdk-pixbuf.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "gs-key-colors.h"
 
@@ -39,7 +45,7 @@
  * been chosen by examining 1000 icons to subjectively see how many key colors
  * each has. The number of key colors ranged from 1 to 6, but the mode was
  * definitely 3. */
-const guint n_clusters = 3;
+#define N_CLUSTERS 3
 
 /* Discard pixels with less than this level of alpha. Almost all icons have a
  * transparent background/border at 100% transparency, and a blending fringe
@@ -50,73 +56,53 @@ const guint n_clusters = 3;
  * can’t discard non-opaque pixels entirely. */
 const guint minimum_alpha = 0.5 * 255;
 
+/* The opaque pixels of an icon, stored as a structure of arrays so that the
+ * distance and accumulation loops in k_means() can be vectorised by the
+ * compiler. All the arrays have one element per opaque pixel. */
 typedef struct {
-	guint8 red;
-	guint8 green;
-	guint8 blue;
-} Pixel8;
+	gint32 *red;
+	gint32 *green;
+	gint32 *blue;
+	guint32 *cluster;
+	gsize n_pixels;
+} ClusterPixels;
 
 typedef struct {
-	Pixel8 color;
-	union {
-		guint8 alpha;
-		guint8 cluster;
-	};
-} ClusterPixel8;
+	gint32 red[N_CLUSTERS];
+	gint32 green[N_CLUSTERS];
+	gint32 blue[N_CLUSTERS];
+} ClusterCentres;
 
-typedef struct {
-	guint red;
-	guint green;
-	guint blue;
-	guint n_members;
-} CentroidAccumulator;
-
-static inline ClusterPixel8 *
-get_pixel (guint8 *pixels,
-           guint   x,
-           guint   y,
-           guint   rowstride,
-           guint   n_channels)
+/* Branchless, so the loop over the pixels calling it can be vectorised.
+ *
+ * The distance is the square of the Euclidean distance rather than its square
+ * root, to save some time, as only the ordering of distances matters. The
+ * arithmetic can’t overflow, as the R/G/B components have a maximum value of
+ * 255 but the arithmetic is done in 32-bit variables.
+ *
+ * NOTE: This has to return stable results when more than one cluster is
+ * equidistant from the pixel, or the k_means() function may not terminate. The
+ * lowest-numbered cluster is chosen. */
+static inline guint32
+nearest_cluster (gint32                red,
+                 gint32                green,
+                 gint32                blue,
+                 const ClusterCentres *centres)
 {
-	return (ClusterPixel8 *) (pixels + y * rowstride + x * n_channels);
-}
+	guint32 nearest = 0;
+	gint32 nearest_distance = G_MAXINT32;
 
-static inline guint
-color_distance (const Pixel8 *a,
-                const Pixel8 *b)
-{
-	/* Take the absolute value rather than the square root to save some
-	 * time, as the caller is comparing distances.
-	 *
-	 * The arithmetic here can’t overflow, as the R/G/B components have a
-	 * maximum value of 255 but the arithmetic is done in (at least) 32-bit
-	 * variables.*/
-	gint dr = b->red - a->red;
-	gint dg = b->green - a->green;
-	gint db = b->blue - a->blue;
-
-	return abs (dr * dr + dg * dg + db * db);
-}
+	for (guint32 i = 0; i < N_CLUSTERS; i++) {
+		gint32 dr = red - centres->red[i];
+		gint32 dg = green - centres->green[i];
+		gint32 db = blue - centres->blue[i];
+		gint32 distance = dr * dr + dg * dg + db * db;
 
-/* NOTE: This has to return stable results when more than one cluster is
- * equidistant from the @pixel, or the k_means() function may not terminate. */
-static inline gsize
-nearest_cluster (const Pixel8 *pixel,
-                 const Pixel8 *cluster_centres,
-                 gsize         n_cluster_centres)
-{
-	gsize nearest_cluster = 0;
-	guint nearest_cluster_distance = color_distance (&cluster_centres[0], pixel);
-
-	for (gsize i = 1; i < n_cluster_centres; i++) {
-		guint distance = color_distance (&cluster_centres[i], pixel);
-		if (distance < nearest_cluster_distance) {
-			nearest_cluster = i;
-			nearest_cluster_distance = distance;
-		}
+		nearest = (distance < nearest_distance) ? i : nearest;
+		nearest_distance = MIN (distance, nearest_distance);
 	}
 
-	return nearest_cluster;
+	return nearest;
 }
 
 /* A variant of g_random_int_range() which chooses without replacement,
@@ -165,7 +151,7 @@ random_int_range_no_replacement (guint max_ints,
  * centroid is itself a color, which can then be used as the key color to
  * return.
  *
- * The number of clusters is limited to @n_clusters, as a subjective survey of
+ * The number of clusters is limited to %N_CLUSTERS, as a subjective survey of
  * 1000 icons found that they commonly used this number of key colors.
  *
  * Various other shortcuts have been taken which make this approach quite
@@ -178,12 +164,11 @@ k_means (GArray    *colors,
 {
 	gint rowstride, n_channels;
 	gint width, height;
-	guint8 *raw_pixels;
-	ClusterPixel8 *pixels;
-	const ClusterPixel8 *pixels_end;
-	Pixel8 cluster_centres[n_clusters];
-	CentroidAccumulator cluster_accumulators[n_clusters];
-	gboolean used_clusters[n_clusters];
+	const guint8 *raw_pixels;
+	ClusterPixels pixels;
+	ClusterCentres cluster_centres;
+	guint32 cluster_n_members[N_CLUSTERS];
+	gboolean used_clusters[N_CLUSTERS];
 	guint n_used_clusters = 0;
 	guint n_assignments_changed;
 	guint n_iterations = 0;
@@ -191,7 +176,7 @@ k_means (GArray    *colors,
 
 	n_channels = gdk_pixbuf_get_n_channels (pb);
 	rowstride = gdk_pixbuf_get_rowstride (pb);
-	raw_pixels = gdk_pixbuf_get_pixels (pb);
+	raw_pixels = gdk_pixbuf_read_pixels (pb);
 	width = gdk_pixbuf_get_width (pb);
 	height = gdk_pixbuf_get_height (pb);
 
@@ -201,12 +186,18 @@ k_means (GArray    *colors,
 	g_assert (rowstride == width * n_channels);
 	g_assert (n_channels == 4);
 
-	pixels = (ClusterPixel8 *) raw_pixels;
-	pixels_end = &pixels[height * width];
-
-	memset (cluster_centres, 0, sizeof (cluster_centres));
+	memset (&cluster_centres, 0, sizeof (cluster_centres));
+	memset (cluster_n_members, 0, sizeof (cluster_n_members));
 	memset (used_clusters, 0, sizeof (used_clusters));
 
+	/* Split out the pixels which are opaque enough to be considered, so
+	 * none of the loops below need to check the alpha. */
+	pixels.red = g_new (gint32, width * height);
+	pixels.green = g_new (gint32, width * height);
+	pixels.blue = g_new (gint32, width * height);
+	pixels.cluster = g_new (guint32, width * height);
+	pixels.n_pixels = 0;
+
 	/* Initialise the clusters using the Random Partition method: randomly
 	 * assign a starting cluster to each pixel.
 	 *
@@ -215,11 +206,17 @@ k_means (GArray    *colors,
 	 * they aren’t transparent or duplicated colors mean that the
 	 * initialisation step may never complete. Consider the case of an icon
 	 * which is a block of solid color. */
-	for (ClusterPixel8 *p = pixels; p < pixels_end; p++) {
-		if (p->alpha < minimum_alpha)
-			p->cluster = G_N_ELEMENTS (cluster_centres);
-		else
-			p->cluster = random_int_range_no_replacement (G_N_ELEMENTS (cluster_centres), used_clusters, &n_used_clusters);
+	for (const guint8 *p = raw_pixels; p < raw_pixels + width * height * 4; p += 4) {
+		gsize i = pixels.n_pixels;
+
+		if (p[3] < minimum_alpha)
+			continue;
+
+		pixels.red[i] = p[0];
+		pixels.green[i] = p[1];
+		pixels.blue[i] = p[2];
+		pixels.cluster[i] = random_int_range_no_replacement (N_CLUSTERS, used_clusters, &n_used_clusters);
+		pixels.n_pixels++;
 	}
 
 	/* Iterate until every cluster is relatively settled. This is determined
@@ -239,58 +236,85 @@ k_means (GArray    *colors,
 	n_iterations = 0;
 	do {
 		/* Update step. Re-calculate the centroid of each cluster from
-		 * the colors which are in it. */
-		memset (cluster_accumulators, 0, sizeof (cluster_accumulators));
-
-		for (const ClusterPixel8 *p = pixels; p < pixels_end; p++) {
-			if (p->cluster >= G_N_ELEMENTS (cluster_centres))
-				continue;
-
-			cluster_accumulators[p->cluster].red += p->color.red;
-			cluster_accumulators[p->cluster].green += p->color.green;
-			cluster_accumulators[p->cluster].blue += p->color.blue;
-			cluster_accumulators[p->cluster].n_members++;
-		}
-
-		for (gsize i = 0; i < G_N_ELEMENTS (cluster_centres); i++) {
-			if (cluster_accumulators[i].n_members == 0)
+		 * the colors which are in it. Each cluster is summed in its
+		 * own pass over the pixels, which avoids indexing the sums by
+		 * cluster and so keeps the pass vectorisable. */
+		for (guint32 c = 0; c < N_CLUSTERS; c++) {
+			guint32 red = 0, green = 0, blue = 0, n_members = 0;
+
+			for (gsize i = 0; i < pixels.n_pixels; i++) {
+				guint32 is_member = (pixels.cluster[i] == c);
+
+				red += is_member * pixels.red[i];
+				green += is_member * pixels.green[i];
+				blue += is_member * pixels.blue[i];
+				n_members += is_member;
+			}
+
+			cluster_n_members[c] = n_members;
+			if (n_members == 0)
 				continue;
 
-			cluster_centres[i].red = cluster_accumulators[i].red / cluster_accumulators[i].n_members;
-			cluster_centres[i].green = cluster_accumulators[i].green / cluster_accumulators[i].n_members;
-			cluster_centres[i].blue = cluster_accumulators[i].blue / cluster_accumulators[i].n_members;
+			cluster_centres.red[c] = red / n_members;
+			cluster_centres.green[c] = green / n_members;
+			cluster_centres.blue[c] = blue / n_members;
 		}
 
 		/* Update assignments of colors to clusters. */
 		n_assignments_changed = 0;
-		for (ClusterPixel8 *p = pixels; p < pixels_end; p++) {
-			gsize new_cluster;
-
-			if (p->cluster >= G_N_ELEMENTS (cluster_centres))
-				continue;
-
-			new_cluster = nearest_cluster (&p->color, cluster_centres, G_N_ELEMENTS (cluster_centres));
-			if (new_cluster != p->cluster)
-				n_assignments_changed++;
-			p->cluster = new_cluster;
+		for (gsize i = 0; i < pixels.n_pixels; i++) {
+			guint32 new_cluster = nearest_cluster (pixels.red[i],
+							       pixels.green[i],
+							       pixels.blue[i],
+							       &cluster_centres);
+
+			n_assignments_changed += (new_cluster != pixels.cluster[i]);
+			pixels.cluster[i] = new_cluster;
 		}
 
 		n_iterations++;
 	} while (n_assignments_changed > assignments_termination_limit && n_iterations < 50);
 
 	/* Output the cluster centres: these are the icon’s key colors. */
-	for (gsize i = 0; i < G_N_ELEMENTS (cluster_centres); i++) {
+	for (gsize i = 0; i < N_CLUSTERS; i++) {
 		GdkRGBA color;
 
-		if (cluster_accumulators[i].n_members == 0)
+		if (cluster_n_members[i] == 0)
 			continue;
 
-		color.red = (gdouble) cluster_centres[i].red / 255.0;
-		color.green = (gdouble) cluster_centres[i].green / 255.0;
-		color.blue = (gdouble) cluster_centres[i].blue / 255.0;
+		color.red = (gdouble) cluster_centres.red[i] / 255.0;
+		color.green = (gdouble) cluster_centres.green[i] / 255.0;
+		color.blue = (gdouble) cluster_centres.blue[i] / 255.0;
 		color.alpha = 1.0;
 		g_array_append_val (colors, color);
 	}
+
+	g_free (pixels.red);
+	g_free (pixels.green);
+	g_free (pixels.blue);
+	g_free (pixels.cluster);
+}
+
+/* Scale @pixbuf down to 32×32, with an alpha channel for k_means() */
+static GdkPixbuf *
+prepare_pixbuf (GdkPixbuf *pixbuf)
+{
+	g_autoptr(GdkPixbuf) pb_small = NULL;
+
+	/* people almost always use BILINEAR scaling with pixbufs, but we can
+	 * use NEAREST here since we only care about the rough colour data, not
+	 * whether the edges in the image are smooth and visually appealing;
+	 * NEAREST is twice as fast as BILINEAR */
+	pb_small = gdk_pixbuf_scale_simple (pixbuf, 32, 32, GDK_INTERP_NEAREST);
+
+	/* require an alpha channel for storing temporary values; most images
+	 * have one already, about 2% don’t */
+	if (gdk_pixbuf_get_n_channels (pixbuf) != 4) {
+		g_autoptr(GdkPixbuf) temp = g_steal_pointer (&pb_small);
+		pb_small = gdk_pixbuf_add_alpha (temp, FALSE, 0, 0, 0);
+	}
+
+	return g_steal_pointer (&pb_small);
 }
 
 /**
@@ -311,24 +335,165 @@ k_means (GArray    *colors,
 GArray *
 gs_calculate_key_colors (GdkPixbuf *pixbuf)
 {
-	g_autoptr(GdkPixbuf) pb_small = NULL;
+	g_autoptr(GdkPixbuf) pb_small = prepare_pixbuf (pixbuf);
 	g_autoptr(GArray) colors = g_array_new (FALSE, FALSE, sizeof (GdkRGBA));
 
-	/* people almost always use BILINEAR scaling with pixbufs, but we can
-	 * use NEAREST here since we only care about the rough colour data, not
-	 * whether the edges in the image are smooth and visually appealing;
-	 * NEAREST is twice as fast as BILINEAR */
-	pb_small = gdk_pixbuf_scale_simple (pixbuf, 32, 32, GDK_INTERP_NEAREST);
+	/* get a list of key colors */
+	k_means (colors, pb_small);
 
-	/* require an alpha channel for storing temporary values; most images
-	 * have one already, about 2% don’t */
-	if (gdk_pixbuf_get_n_channels (pixbuf) != 4) {
-		g_autoptr(GdkPixbuf) temp = g_steal_pointer (&pb_small);
-		pb_small = gdk_pixbuf_add_alpha (temp, FALSE, 0, 0, 0);
+	return g_steal_pointer (&colors);
+}
+
+/* The persistent cache is a file of fixed-size records, appended to as new
+ * icons are seen, and read in full on first use. */
+#define KEY_COLORS_CACHE_MAX_RECORDS	65536
+
+typedef struct {
+	guint64 hash;
+	guint8 n_colors;
+	guint8 colors[N_CLUSTERS][3];
+	guint8 padding[15 - N_CLUSTERS * 3];
+} KeyColorsRecord;
+
+G_STATIC_ASSERT (sizeof (KeyColorsRecord) == 24);
+
+static GMutex key_colors_cache_mutex;
+static gchar *key_colors_cache_filename = NULL;  /* (owned) (nullable) */
+static GHashTable *key_colors_cache = NULL;  /* (element-type guint64 KeyColorsRecord) (owned) (nullable) */
+static guint key_colors_cache_n_records = 0;
+
+/* must be called with the mutex held */
+static void
+key_colors_cache_load (const gchar *cache_filename)
+{
+	g_autofree gchar *data = NULL;
+	gsize len = 0;
+
+	if (g_strcmp0 (key_colors_cache_filename, cache_filename) == 0)
+		return;
+
+	g_free (key_colors_cache_filename);
+	key_colors_cache_filename = g_strdup (cache_filename);
+	g_clear_pointer (&key_colors_cache, g_hash_table_unref);
+	key_colors_cache = g_hash_table_new_full (g_int64_hash, g_int64_equal, NULL, g_free);
+	key_colors_cache_n_records = 0;
+
+	if (!g_file_get_contents (cache_filename, &data, &len, NULL))
+		return;
+
+	/* start afresh rather than growing forever */
+	if (len / sizeof (KeyColorsRecord) >= KEY_COLORS_CACHE_MAX_RECORDS) {
+		g_unlink (cache_filename);
+		return;
 	}
 
-	/* get a list of key colors */
+	for (gsize offset = 0; len - offset >= sizeof (KeyColorsRecord); offset += sizeof (KeyColorsRecord)) {
+		KeyColorsRecord *record = g_new (KeyColorsRecord, 1);
+
+		memcpy (record, data + offset, sizeof (*record));
+		if (record->n_colors > N_CLUSTERS) {
+			g_free (record);
+			break;
+		}
+		g_hash_table_replace (key_colors_cache, &record->hash, record);
+		key_colors_cache_n_records++;
+	}
+}
+
+/* must be called with the mutex held */
+static void
+key_colors_cache_add (GArray  *colors,
+                      guint64  hash)
+{
+	KeyColorsRecord *record = g_new0 (KeyColorsRecord, 1);
+	gint fd;
+
+	record->hash = hash;
+	record->n_colors = (guint8) colors->len;
+	for (guint i = 0; i < colors->len; i++) {
+		const GdkRGBA *color = &g_array_index (colors, GdkRGBA, i);
+		record->colors[i][0] = (guint8) (color->red * 255.0 + 0.5);
+		record->colors[i][1] = (guint8) (color->green * 255.0 + 0.5);
+		record->colors[i][2] = (guint8) (color->blue * 255.0 + 0.5);
+	}
+	g_hash_table_replace (key_colors_cache, &record->hash, record);
+
+	/* the file is started afresh when next loaded */
+	if (key_colors_cache_n_records >= KEY_COLORS_CACHE_MAX_RECORDS)
+		return;
+
+	/* a single write of a small record, so concurrent appends from other
+	 * processes do not interleave */
+	fd = g_open (key_colors_cache_filename, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+	if (fd < 0)
+		return;
+	if (write (fd, record, sizeof (*record)) != sizeof (*record))
+		g_debug ("failed to write key colors cache %s", key_colors_cache_filename);
+	close (fd);
+	key_colors_cache_n_records++;
+}
+
+/**
+ * gs_calculate_key_colors_cached:
+ * @pixbuf: an app icon to calculate key colors from
+ * @cache_filename: file to store the key colors of icons in
+ *
+ * Like gs_calculate_key_colors(), but the key colors are stored persistently in
+ * @cache_filename, keyed by a hash of the icon contents, so they only need to
+ * be calculated once per icon.
+ *
+ * This can be called from any thread.
+ *
+ * Returns: (transfer full) (element-type GdkRGBA): key colors for @pixbuf
+ * Since: 42
+ */
+GArray *
+gs_calculate_key_colors_cached (GdkPixbuf   *pixbuf,
+                                const gchar *cache_filename)
+{
+	g_autoptr(GdkPixbuf) pb_small = NULL;
+	g_autoptr(GArray) colors = g_array_new (FALSE, FALSE, sizeof (GdkRGBA));
+	g_autoptr(GMutexLocker) locker = NULL;
+	const guint8 *pixels;
+	guint64 hash = 0xcbf29ce484222325;
+	gsize len;
+	KeyColorsRecord *record;
+
+	g_return_val_if_fail (GDK_IS_PIXBUF (pixbuf), NULL);
+	g_return_val_if_fail (cache_filename != NULL, NULL);
+
+	pb_small = prepare_pixbuf (pixbuf);
+
+	/* FNV-1a over the scaled pixels, which is all k_means() looks at */
+	pixels = gdk_pixbuf_read_pixels (pb_small);
+	len = gdk_pixbuf_get_byte_length (pb_small);
+	for (gsize i = 0; i < len; i++) {
+		hash ^= pixels[i];
+		hash *= 0x100000001b3;
+	}
+
+	locker = g_mutex_locker_new (&key_colors_cache_mutex);
+	key_colors_cache_load (cache_filename);
+	record = g_hash_table_lookup (key_colors_cache, &hash);
+	if (record != NULL) {
+		for (guint i = 0; i < record->n_colors; i++) {
+			GdkRGBA color;
+
+			color.red = (gdouble) record->colors[i][0] / 255.0;
+			color.green = (gdouble) record->colors[i][1] / 255.0;
+			color.blue = (gdouble) record->colors[i][2] / 255.0;
+			color.alpha = 1.0;
+			g_array_append_val (colors, color);
+		}
+		return g_steal_pointer (&colors);
+	}
+	g_clear_pointer (&locker, g_mutex_locker_free);
+
 	k_means (colors, pb_small);
 
+	locker = g_mutex_locker_new (&key_colors_cache_mutex);
+	if (g_strcmp0 (key_colors_cache_filename, cache_filename) == 0)
+		key_colors_cache_add (colors, hash);
+
 	return g_steal_pointer (&colors);
 }
@@ -23,5 +23,7 @@
 G_BEGIN_DECLS
 
 GArray	*gs_calculate_key_colors	(GdkPixbuf	*pixbuf);
+GArray	*gs_calculate_key_colors_cached	(GdkPixbuf	*pixbuf,
+					 const gchar	*cache_filename);
 
 G_END_DECLS
@@ -38,9 +38,18 @@
 #include <json-glib/json-glib.h>
 #include <libsoup/soup.h>
 #include <locale.h>
+#include <glib/gstdio.h>
 #include <math.h>
 #include <string.h>
 
+/* version, mtime and size of the ratings.json it was converted from, sorted
+ * app IDs and six star counts for each ID */
+#define GS_ODRS_PROVIDER_RATINGS_FORMAT		"(uttasau)"
+#define GS_ODRS_PROVIDER_RATINGS_VERSION	2
+
+/* requests to the server in flight at once when fetching reviews for a list */
+#define GS_ODRS_PROVIDER_MAX_FETCHES		4
+
 /* Element in self->ratings, all allocated in one big block and sorted
  * alphabetically to reduce the number of allocations and fragmentation. */
 typedef struct {
@@ -68,6 +77,11 @@ struct _GsOdrsProvider
 	gchar		*user_hash;  /* (not nullable) (owned) */
 	gchar		*review_server;  /* (not nullable) (owned) */
 	GArray		*ratings;  /* (element-type GsOdrsRating) (mutex ratings_mutex) (owned) (nullable) */
+	GVariant	*ratings_ids_variant;  /* (mutex ratings_mutex) (owned) (nullable) */
+	GVariant	*ratings_stars_variant;  /* (mutex ratings_mutex) (owned) (nullable) */
+	const gchar	**ratings_ids;  /* (mutex ratings_mutex) (owned) (nullable), strings owned by ratings_ids_variant */
+	const guint32	*ratings_stars;  /* (mutex ratings_mutex) (nullable), owned by ratings_stars_variant */
+	gsize		 ratings_n_ids;  /* (mutex ratings_mutex) */
 	GMutex		 ratings_mutex;
 	GsApp		*cached_origin;
 	guint64		 max_cache_age_secs;
@@ -108,10 +122,9 @@ gs_odrs_provider_load_ratings_for_app (JsonObject   *json_app,
 	return TRUE;
 }
 
-static gboolean
-gs_odrs_provider_load_ratings (GsOdrsProvider  *self,
-                               const gchar     *filename,
-                               GError         **error)
+static GArray *
+gs_odrs_provider_parse_ratings (const gchar  *filename,
+                                GError      **error)
 {
 	JsonNode *json_root;
 	JsonObject *json_item;
@@ -120,7 +133,6 @@ gs_odrs_provider_load_ratings (GsOdrsProvider  *self,
 	JsonNode *json_app_node;
 	JsonObjectIter iter;
 	g_autoptr(GArray) new_ratings = NULL;
-	g_autoptr(GMutexLocker) locker = NULL;
 
 	/* parse the data and find the success */
 	json_parser = json_parser_new_immutable ();
@@ -130,7 +142,7 @@ gs_odrs_provider_load_ratings (GsOdrsProvider  *self,
 	if (!json_parser_load_from_file (json_parser, filename, error)) {
 #endif
 		gs_utils_error_convert_json_glib (error);
-		return FALSE;
+		return NULL;
 	}
 	json_root = json_parser_get_root (json_parser);
 	if (json_root == NULL) {
@@ -138,14 +150,14 @@ gs_odrs_provider_load_ratings (GsOdrsProvider  *self,
 				     GS_PLUGIN_ERROR,
 				     GS_PLUGIN_ERROR_INVALID_FORMAT,
 				     "no ratings root");
-		return FALSE;
+		return NULL;
 	}
 	if (json_node_get_node_type (json_root) != JSON_NODE_OBJECT) {
 		g_set_error_literal (error,
 				     GS_PLUGIN_ERROR,
 				     GS_PLUGIN_ERROR_INVALID_FORMAT,
 				     "no ratings array");
-		return FALSE;
+		return NULL;
 	}
 
 	json_item = json_node_get_object (json_root);
@@ -173,14 +185,187 @@ gs_odrs_provider_load_ratings (GsOdrsProvider  *self,
 	/* Allow for binary searches later. */
 	g_array_sort (new_ratings, (GCompareFunc) rating_compare);
 
+	return g_steal_pointer (&new_ratings);
+}
+
+static GVariant *
+gs_odrs_provider_ratings_to_variant (GArray  *ratings,
+                                     guint64  json_mtime,
+                                     guint64  json_size)
+{
+	g_autoptr(GPtrArray) ids = g_ptr_array_sized_new (ratings->len + 1);
+	g_autoptr(GArray) stars = g_array_sized_new (FALSE, FALSE, sizeof (guint32), ratings->len * 6);
+	GVariant *children[5];
+
+	for (guint i = 0; i < ratings->len; i++) {
+		const GsOdrsRating *rating = &g_array_index (ratings, GsOdrsRating, i);
+		g_ptr_array_add (ids, rating->app_id);
+		g_array_append_vals (stars, rating->n_star_ratings, 6);
+	}
+
+	children[0] = g_variant_new_uint32 (GS_ODRS_PROVIDER_RATINGS_VERSION);
+	children[1] = g_variant_new_uint64 (json_mtime);
+	children[2] = g_variant_new_uint64 (json_size);
+	children[3] = g_variant_new_strv ((const gchar * const *) ids->pdata, ids->len);
+	children[4] = g_variant_new_fixed_array (G_VARIANT_TYPE_UINT32,
+						 stars->data, stars->len,
+						 sizeof (guint32));
+	return g_variant_ref_sink (g_variant_new_tuple (children, G_N_ELEMENTS (children)));
+}
+
+/* maps the binary ratings converted from the ratings.json with @json_mtime
+ * and @json_size, returning %NULL if it is missing or out of date */
+static GVariant *
+gs_odrs_provider_load_ratings_variant (const gchar *filename,
+                                       guint64      json_mtime,
+                                       guint64      json_size)
+{
+	guint32 version = 0;
+	guint64 json_mtime_saved = 0;
+	guint64 json_size_saved = 0;
+	gsize n_stars = 0;
+	g_autoptr(GBytes) bytes = NULL;
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GMappedFile) mapped_file = NULL;
+	g_autoptr(GVariant) root = NULL;
+	g_autoptr(GVariant) ids = NULL;
+	g_autoptr(GVariant) stars = NULL;
+
+	mapped_file = g_mapped_file_new (filename, FALSE, &error_local);
+	if (mapped_file == NULL) {
+		if (!g_error_matches (error_local, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+			g_debug ("failed to load %s: %s", filename, error_local->message);
+		return NULL;
+	}
+
+	/* the bytes keep the file mapped for as long as the variant exists */
+	bytes = g_mapped_file_get_bytes (mapped_file);
+	root = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE (GS_ODRS_PROVIDER_RATINGS_FORMAT),
+							     bytes, FALSE));
+	g_variant_get_child (root, 0, "u", &version);
+	g_variant_get_child (root, 1, "t", &json_mtime_saved);
+	g_variant_get_child (root, 2, "t", &json_size_saved);
+	ids = g_variant_get_child_value (root, 3);
+	stars = g_variant_get_child_value (root, 4);
+	g_variant_get_fixed_array (stars, &n_stars, sizeof (guint32));
+	if (version != GS_ODRS_PROVIDER_RATINGS_VERSION ||
+	    json_mtime_saved != json_mtime ||
+	    json_size_saved != json_size ||
+	    n_stars != g_variant_n_children (ids) * 6) {
+		g_debug ("%s is out of date, rebuilding", filename);
+		return NULL;
+	}
+	return g_steal_pointer (&root);
+}
+
+static gboolean
+gs_odrs_provider_load_ratings (GsOdrsProvider  *self,
+                               const gchar     *filename,
+                               GError         **error)
+{
+	GStatBuf st;
+	guint64 json_mtime = 0;
+	guint64 json_size = 0;
+	gsize n_stars = 0;
+	g_autofree gchar *dirname = g_path_get_dirname (filename);
+	g_autofree gchar *filename_bin = g_build_filename (dirname, "ratings.bin", NULL);
+	g_autofree const gchar **ids = NULL;
+	const guint32 *stars = NULL;
+	g_autoptr(GArray) new_ratings = NULL;
+	g_autoptr(GVariant) root = NULL;
+	g_autoptr(GVariant) ids_variant = NULL;
+	g_autoptr(GVariant) stars_variant = NULL;
+	g_autoptr(GMutexLocker) locker = NULL;
+
+	if (g_stat (filename, &st) == 0) {
+		json_mtime = (guint64) st.st_mtime;
+		json_size = (guint64) st.st_size;
+	}
+
+	/* the JSON only changes on refresh, so convert it once into a form
+	 * which can be mapped and searched directly */
+	root = gs_odrs_provider_load_ratings_variant (filename_bin, json_mtime, json_size);
+	if (root == NULL) {
+		g_autoptr(GError) error_local = NULL;
+
+		new_ratings = gs_odrs_provider_parse_ratings (filename, error);
+		if (new_ratings == NULL)
+			return FALSE;
+
+		root = gs_odrs_provider_ratings_to_variant (new_ratings, json_mtime, json_size);
+		if (!g_file_set_contents (filename_bin,
+					  g_variant_get_data (root),
+					  (gssize) g_variant_get_size (root),
+					  &error_local)) {
+			g_debug ("failed to save %s, using parsed ratings: %s",
+				 filename_bin, error_local->message);
+			g_clear_pointer (&root, g_variant_unref);
+		} else {
+			g_clear_pointer (&root, g_variant_unref);
+			root = gs_odrs_provider_load_ratings_variant (filename_bin, json_mtime, json_size);
+		}
+	}
+
+	/* only the pointers to the strings are allocated */
+	if (root != NULL) {
+		g_clear_pointer (&new_ratings, g_array_unref);
+		ids_variant = g_variant_get_child_value (root, 3);
+		ids = g_variant_get_strv (ids_variant, NULL);
+		stars_variant = g_variant_get_child_value (root, 4);
+		stars = g_variant_get_fixed_array (stars_variant, &n_stars, sizeof (guint32));
+	}
+
 	/* Update the shared state */
 	locker = g_mutex_locker_new (&self->ratings_mutex);
 	g_clear_pointer (&self->ratings, g_array_unref);
+	g_clear_pointer (&self->ratings_ids, g_free);
+	g_clear_pointer (&self->ratings_ids_variant, g_variant_unref);
+	g_clear_pointer (&self->ratings_stars_variant, g_variant_unref);
 	self->ratings = g_steal_pointer (&new_ratings);
+	self->ratings_ids_variant = g_steal_pointer (&ids_variant);
+	self->ratings_stars_variant = g_steal_pointer (&stars_variant);
+	self->ratings_ids = g_steal_pointer (&ids);
+	self->ratings_stars = stars;
+	self->ratings_n_ids = n_stars / 6;
 
 	return TRUE;
 }
 
+/* called with ratings_mutex held */
+static const guint32 *
+gs_odrs_provider_lookup_rating (GsOdrsProvider *self,
+                                const gchar    *app_id)
+{
+	if (self->ratings_ids != NULL) {
+		gsize lo = 0;
+		gsize hi = self->ratings_n_ids;
+
+		while (lo < hi) {
+			gsize mid = lo + (hi - lo) / 2;
+			gint cmp = strcmp (app_id, self->ratings_ids[mid]);
+			if (cmp == 0)
+				return self->ratings_stars + mid * 6;
+			if (cmp < 0)
+				hi = mid;
+			else
+				lo = mid + 1;
+		}
+		return NULL;
+	}
+
+	if (self->ratings != NULL) {
+		const GsOdrsRating search_rating = { (gchar *) app_id, { 0, }};
+		guint found_index;
+
+		if (!g_array_binary_search (self->ratings, &search_rating,
+					    (GCompareFunc) rating_compare, &found_index))
+			return NULL;
+		return g_array_index (self->ratings, GsOdrsRating, found_index).n_star_ratings;
+	}
+
+	return NULL;
+}
+
 static AsReview *
 gs_odrs_provider_parse_review_object (JsonObject *item)
 {
@@ -583,7 +768,7 @@ gs_odrs_provider_refine_ratings (GsOdrsProvider  *self,
 
 	locker = g_mutex_locker_new (&self->ratings_mutex);
 
-	if (!self->ratings) {
+	if (self->ratings == NULL && self->ratings_ids == NULL) {
 		g_autofree gchar *cache_filename = NULL;
 
 		g_clear_pointer (&locker, g_mutex_locker_free);
@@ -602,25 +787,20 @@ gs_odrs_provider_refine_ratings (GsOdrsProvider  *self,
 
 		locker = g_mutex_locker_new (&self->ratings_mutex);
 
-		if (!self->ratings)
+		if (self->ratings == NULL && self->ratings_ids == NULL)
 			return TRUE;
 	}
 
 	for (guint i = 0; i < reviewable_ids->len; i++) {
 		const gchar *id = g_ptr_array_index (reviewable_ids, i);
-		const GsOdrsRating search_rating = { (gchar *) id, { 0, }};
-		guint found_index;
-		const GsOdrsRating *found_rating;
+		const guint32 *n_star_ratings = gs_odrs_provider_lookup_rating (self, id);
 
-		if (!g_array_binary_search (self->ratings, &search_rating,
-					    (GCompareFunc) rating_compare, &found_index))
+		if (n_star_ratings == NULL)
 			continue;
 
-		found_rating = &g_array_index (self->ratings, GsOdrsRating, found_index);
-
 		/* copy into accumulator array */
 		for (guint j = 0; j < 6; j++)
-			ratings_raw[j] += found_rating->n_star_ratings[j];
+			ratings_raw[j] += n_star_ratings[j];
 		cnt++;
 	}
 	if (cnt == 0)
@@ -680,55 +860,55 @@ gs_odrs_provider_get_compat_ids (GsApp *app)
 	return g_steal_pointer (&json_node);
 }
 
-static GPtrArray *
-gs_odrs_provider_fetch_for_app (GsOdrsProvider  *self,
-                                GsApp           *app,
-				GCancellable	*cancellable,
-                                GError         **error)
+static gchar *
+gs_odrs_provider_get_reviews_cache_filename (GsApp   *app,
+                                             GError **error)
 {
-	JsonNode *json_compat_ids;
-	const gchar *version;
-	guint status_code;
-	gconstpointer downloaded_data;
-	gsize downloaded_data_length;
-	g_autofree gchar *cachefn_basename = NULL;
-	g_autofree gchar *cachefn = NULL;
-	g_autofree gchar *data = NULL;
-	g_autofree gchar *uri = NULL;
-	g_autoptr(GFile) cachefn_file = NULL;
-	g_autoptr(GPtrArray) reviews = NULL;
-	g_autoptr(JsonBuilder) builder = NULL;
-	g_autoptr(JsonGenerator) json_generator = NULL;
-	g_autoptr(JsonNode) json_root = NULL;
-	g_autoptr(SoupMessage) msg = NULL;
-#if SOUP_CHECK_VERSION(3, 0, 0)
-	g_autoptr(GBytes) bytes = NULL;
-#endif
+	g_autofree gchar *cachefn_basename = g_strdup_printf ("%s.json", gs_app_get_id (app));
+	return gs_utils_get_cache_filename ("odrs",
+					    cachefn_basename,
+					    GS_UTILS_CACHE_FLAG_WRITEABLE |
+					    GS_UTILS_CACHE_FLAG_CREATE_DIRECTORY,
+					    error);
+}
 
-	/* look in the cache */
-	cachefn_basename = g_strdup_printf ("%s.json", gs_app_get_id (app));
-	cachefn = gs_utils_get_cache_filename ("odrs",
-					       cachefn_basename,
-					       GS_UTILS_CACHE_FLAG_WRITEABLE |
-					       GS_UTILS_CACHE_FLAG_CREATE_DIRECTORY,
-					       error);
-	if (cachefn == NULL)
-		return NULL;
-	cachefn_file = g_file_new_for_path (cachefn);
-	if (gs_utils_get_file_age (cachefn_file) < self->max_cache_age_secs) {
-		g_autoptr(GMappedFile) mapped_file = NULL;
+/* sets @reviews_out to %NULL if there is no fresh enough cached data */
+static gboolean
+gs_odrs_provider_fetch_from_cache (GsOdrsProvider  *self,
+                                   GsApp           *app,
+                                   const gchar     *cachefn,
+                                   GPtrArray      **reviews_out,
+                                   GError         **error)
+{
+	g_autoptr(GFile) cachefn_file = g_file_new_for_path (cachefn);
+	g_autoptr(GMappedFile) mapped_file = NULL;
 
-		mapped_file = g_mapped_file_new (cachefn, FALSE, error);
-		if (mapped_file == NULL)
-			return NULL;
+	*reviews_out = NULL;
+	if (gs_utils_get_file_age (cachefn_file) >= self->max_cache_age_secs)
+		return TRUE;
 
-		g_debug ("got review data for %s from %s",
-			 gs_app_get_id (app), cachefn);
-		return gs_odrs_provider_parse_reviews (self,
+	mapped_file = g_mapped_file_new (cachefn, FALSE, error);
+	if (mapped_file == NULL)
+		return FALSE;
+
+	g_debug ("got review data for %s from %s",
+		 gs_app_get_id (app), cachefn);
+	*reviews_out = gs_odrs_provider_parse_reviews (self,
 						       g_mapped_file_get_contents (mapped_file),
 						       g_mapped_file_get_length (mapped_file),
 						       error);
-	}
+	return *reviews_out != NULL;
+}
+
+static gchar *
+gs_odrs_provider_build_fetch_request (GsOdrsProvider *self,
+                                      GsApp          *app)
+{
+	JsonNode *json_compat_ids;
+	const gchar *version;
+	g_autoptr(JsonBuilder) builder = NULL;
+	g_autoptr(JsonGenerator) json_generator = NULL;
+	g_autoptr(JsonNode) json_root = NULL;
 
 	/* not always available */
 	version = gs_app_get_version (app);
@@ -762,29 +942,19 @@ gs_odrs_provider_fetch_for_app (GsOdrsProvider  *self,
 	json_generator = json_generator_new ();
 	json_generator_set_pretty (json_generator, TRUE);
 	json_generator_set_root (json_generator, json_root);
-	data = json_generator_to_data (json_generator, NULL);
-	if (data == NULL)
-		return NULL;
-	uri = g_strdup_printf ("%s/fetch", self->review_server);
-	g_debug ("Updating ODRS cache for %s from %s to %s; request %s", gs_app_get_id (app),
-		 uri, cachefn, data);
-	msg = soup_message_new (SOUP_METHOD_POST, uri);
-#if SOUP_CHECK_VERSION(3, 0, 0)
-	g_odrs_provider_set_message_request_body (msg, "application/json; charset=utf-8",
-						  data, strlen (data));
-	bytes = soup_session_send_and_read (self->session, msg, cancellable, error);
-	if (bytes == NULL)
-		return NULL;
+	return json_generator_to_data (json_generator, NULL);
+}
+
+static GPtrArray *
+gs_odrs_provider_parse_fetch_response (GsOdrsProvider  *self,
+                                       const gchar     *cachefn,
+                                       guint            status_code,
+                                       const gchar     *downloaded_data,
+                                       gsize            downloaded_data_length,
+                                       GError         **error)
+{
+	g_autoptr(GPtrArray) reviews = NULL;
 
-	downloaded_data = g_bytes_get_data (bytes, &downloaded_data_length);
-	status_code = soup_message_get_status (msg);
-#else
-	soup_message_set_request (msg, "application/json; charset=utf-8",
-				  SOUP_MEMORY_COPY, data, strlen (data));
-	status_code = soup_session_send_message (self->session, msg);
-	downloaded_data = msg->response_body ? msg->response_body->data : NULL;
-	downloaded_data_length = msg->response_body ? msg->response_body->length : 0;
-#endif
 	if (status_code != SOUP_STATUS_OK) {
 		if (!gs_odrs_provider_parse_success (downloaded_data, downloaded_data_length, error))
 			return NULL;
@@ -808,21 +978,13 @@ gs_odrs_provider_fetch_for_app (GsOdrsProvider  *self,
 	return g_steal_pointer (&reviews);
 }
 
-static gboolean
-gs_odrs_provider_refine_reviews (GsOdrsProvider  *self,
-                                 GsApp           *app,
-                                 GCancellable    *cancellable,
-                                 GError         **error)
+static void
+gs_odrs_provider_add_reviews (GsOdrsProvider *self,
+                              GsApp          *app,
+                              GPtrArray      *reviews)
 {
-	AsReview *review;
-	g_autoptr(GPtrArray) reviews = NULL;
-
-	/* get from server */
-	reviews = gs_odrs_provider_fetch_for_app (self, app, cancellable, error);
-	if (reviews == NULL)
-		return FALSE;
 	for (guint i = 0; i < reviews->len; i++) {
-		review = g_ptr_array_index (reviews, i);
+		AsReview *review = g_ptr_array_index (reviews, i);
 
 		/* save this on the application object so we can use it for
 		 * submitting a new review */
@@ -842,6 +1004,201 @@ gs_odrs_provider_refine_reviews (GsOdrsProvider  *self,
 		}
 		gs_app_add_review (app, review);
 	}
+}
+
+/* one request to the server, shared by every app in the list with the ID */
+typedef struct {
+	GPtrArray	*apps;  /* (element-type GsApp) (owned) */
+	gchar		*cachefn;  /* (owned) */
+	SoupMessage	*msg;  /* (owned) (nullable) */
+#if SOUP_CHECK_VERSION(3, 0, 0)
+	GBytes		*bytes;  /* (owned) (nullable) */
+#endif
+	GError		*error;  /* (owned) (nullable) */
+} GsOdrsProviderFetch;
+
+typedef struct {
+	GsOdrsProvider	*self;  /* (unowned) */
+	GCancellable	*cancellable;  /* (unowned) (nullable) */
+} GsOdrsProviderFetchBatch;
+
+static void
+gs_odrs_provider_fetch_free (GsOdrsProviderFetch *fetch)
+{
+	g_ptr_array_unref (fetch->apps);
+	g_free (fetch->cachefn);
+	g_clear_object (&fetch->msg);
+#if SOUP_CHECK_VERSION(3, 0, 0)
+	g_clear_pointer (&fetch->bytes, g_bytes_unref);
+#endif
+	g_clear_error (&fetch->error);
+	g_slice_free (GsOdrsProviderFetch, fetch);
+}
+
+/* runs one request of a batch in a thread of the batch's pool, using the
+ * blocking API as the session may be in use from other threads */
+static void
+gs_odrs_provider_fetch_thread_cb (gpointer data, gpointer user_data)
+{
+	GsOdrsProviderFetch *fetch = data;
+	GsOdrsProviderFetchBatch *batch = user_data;
+	GsOdrsProvider *self = batch->self;
+	GsApp *app = g_ptr_array_index (fetch->apps, 0);
+	g_autofree gchar *data_request = NULL;
+	g_autofree gchar *uri = NULL;
+
+	if (g_cancellable_set_error_if_cancelled (batch->cancellable, &fetch->error))
+		return;
+
+	data_request = gs_odrs_provider_build_fetch_request (self, app);
+	if (data_request == NULL) {
+		g_set_error_literal (&fetch->error,
+				     GS_PLUGIN_ERROR,
+				     GS_PLUGIN_ERROR_FAILED,
+				     "failed to build request");
+		return;
+	}
+	uri = g_strdup_printf ("%s/fetch", self->review_server);
+	g_debug ("Updating ODRS cache for %s from %s to %s; request %s", gs_app_get_id (app),
+		 uri, fetch->cachefn, data_request);
+	fetch->msg = soup_message_new (SOUP_METHOD_POST, uri);
+#if SOUP_CHECK_VERSION(3, 0, 0)
+	g_odrs_provider_set_message_request_body (fetch->msg, "application/json; charset=utf-8",
+						  data_request, strlen (data_request));
+	fetch->bytes = soup_session_send_and_read (self->session, fetch->msg,
+						   batch->cancellable, &fetch->error);
+#else
+	soup_message_set_request (fetch->msg, "application/json; charset=utf-8",
+				  SOUP_MEMORY_COPY, data_request, strlen (data_request));
+	soup_session_send_message (self->session, fetch->msg);
+#endif
+}
+
+static GPtrArray *
+gs_odrs_provider_fetch_finish (GsOdrsProvider      *self,
+                               GsOdrsProviderFetch *fetch,
+                               GError             **error)
+{
+	guint status_code;
+	gconstpointer downloaded_data;
+	gsize downloaded_data_length;
+
+	if (fetch->error != NULL) {
+		g_propagate_error (error, g_steal_pointer (&fetch->error));
+		return NULL;
+	}
+#if SOUP_CHECK_VERSION(3, 0, 0)
+	downloaded_data = g_bytes_get_data (fetch->bytes, &downloaded_data_length);
+	status_code = soup_message_get_status (fetch->msg);
+#else
+	status_code = fetch->msg->status_code;
+	downloaded_data = fetch->msg->response_body ? fetch->msg->response_body->data : NULL;
+	downloaded_data_length = fetch->msg->response_body ? fetch->msg->response_body->length : 0;
+#endif
+	return gs_odrs_provider_parse_fetch_response (self, fetch->cachefn, status_code,
+						      downloaded_data, downloaded_data_length,
+						      error);
+}
+
+/* fetches the reviews of every app in @list which has none yet, from the
+ * cache where possible and otherwise with concurrent requests, adding the
+ * apps it tried to @handled */
+static gboolean
+gs_odrs_provider_refine_reviews (GsOdrsProvider  *self,
+                                 GsAppList       *list,
+                                 GHashTable      *handled,
+                                 GCancellable    *cancellable,
+                                 GError         **error)
+{
+	GsOdrsProviderFetchBatch batch = { 0, };
+	g_autoptr(GPtrArray) fetches = NULL;
+	g_autoptr(GHashTable) fetch_by_id = g_hash_table_new (g_str_hash, g_str_equal);
+	GThreadPool *pool;
+
+	fetches = g_ptr_array_new_with_free_func ((GDestroyNotify) gs_odrs_provider_fetch_free);
+	for (guint i = 0; i < gs_app_list_length (list); i++) {
+		GsApp *app = gs_app_list_index (list, i);
+		GsOdrsProviderFetch *fetch;
+		g_autofree gchar *cachefn = NULL;
+		g_autoptr(GPtrArray) reviews = NULL;
+		g_autoptr(GError) error_local = NULL;
+
+		/* not valid */
+		if (gs_app_get_kind (app) == AS_COMPONENT_KIND_ADDON)
+			continue;
+		if (gs_app_get_id (app) == NULL)
+			continue;
+		if (gs_app_get_reviews (app)->len > 0)
+			continue;
+		g_hash_table_add (handled, app);
+
+		/* apps with the same ID share one request */
+		fetch = g_hash_table_lookup (fetch_by_id, gs_app_get_id (app));
+		if (fetch != NULL) {
+			g_ptr_array_add (fetch->apps, g_object_ref (app));
+			continue;
+		}
+
+		/* look in the cache */
+		cachefn = gs_odrs_provider_get_reviews_cache_filename (app, error);
+		if (cachefn == NULL)
+			return FALSE;
+		if (!gs_odrs_provider_fetch_from_cache (self, app, cachefn, &reviews, &error_local)) {
+			if (!g_error_matches (error_local, GS_PLUGIN_ERROR, GS_PLUGIN_ERROR_NO_NETWORK)) {
+				g_prefix_error (&error_local, "failed to refine app: ");
+				g_propagate_error (error, g_steal_pointer (&error_local));
+				return FALSE;
+			}
+			g_debug ("failed to refine app %s: %s",
+				 gs_app_get_unique_id (app), error_local->message);
+			continue;
+		}
+		if (reviews != NULL) {
+			gs_odrs_provider_add_reviews (self, app, reviews);
+			continue;
+		}
+
+		fetch = g_slice_new0 (GsOdrsProviderFetch);
+		fetch->apps = g_ptr_array_new_with_free_func (g_object_unref);
+		g_ptr_array_add (fetch->apps, g_object_ref (app));
+		fetch->cachefn = g_steal_pointer (&cachefn);
+		g_hash_table_insert (fetch_by_id, (gpointer) gs_app_get_id (app), fetch);
+		g_ptr_array_add (fetches, fetch);
+	}
+	if (fetches->len == 0)
+		return TRUE;
+
+	/* run up to GS_ODRS_PROVIDER_MAX_FETCHES requests at once, waiting
+	 * for all of them when the pool is freed */
+	batch.self = self;
+	batch.cancellable = cancellable;
+	pool = g_thread_pool_new (gs_odrs_provider_fetch_thread_cb, &batch,
+				  GS_ODRS_PROVIDER_MAX_FETCHES, FALSE, NULL);
+	for (guint i = 0; i < fetches->len; i++)
+		g_thread_pool_push (pool, g_ptr_array_index (fetches, i), NULL);
+	g_thread_pool_free (pool, FALSE, TRUE);
+
+	for (guint i = 0; i < fetches->len; i++) {
+		GsOdrsProviderFetch *fetch = g_ptr_array_index (fetches, i);
+		g_autoptr(GPtrArray) reviews = NULL;
+		g_autoptr(GError) error_local = NULL;
+
+		reviews = gs_odrs_provider_fetch_finish (self, fetch, &error_local);
+		if (reviews == NULL) {
+			if (!g_error_matches (error_local, GS_PLUGIN_ERROR, GS_PLUGIN_ERROR_NO_NETWORK)) {
+				g_prefix_error (&error_local, "failed to refine app: ");
+				g_propagate_error (error, g_steal_pointer (&error_local));
+				return FALSE;
+			}
+			g_debug ("failed to refine app %s: %s",
+				 gs_app_get_unique_id (g_ptr_array_index (fetch->apps, 0)),
+				 error_local->message);
+			continue;
+		}
+		for (guint j = 0; j < fetch->apps->len; j++)
+			gs_odrs_provider_add_reviews (self, g_ptr_array_index (fetch->apps, j), reviews);
+	}
+
 	return TRUE;
 }
 
@@ -858,13 +1215,11 @@ refine_app (GsOdrsProvider       *self,
 	if (gs_app_get_id (app) == NULL)
 		return TRUE;
 
-	/* add reviews if possible */
+	/* reviews are fetched for the whole list in gs_odrs_provider_refine(),
+	 * so this is only set for apps which already had them */
 	if (flags & GS_PLUGIN_REFINE_FLAGS_REQUIRE_REVIEWS) {
 		if (gs_app_get_reviews(app)->len > 0)
 			return TRUE;
-		if (!gs_odrs_provider_refine_reviews (self, app,
-						      cancellable, error))
-			return FALSE;
 	}
 
 	/* add ratings if possible */
@@ -1123,6 +1478,9 @@ gs_odrs_provider_finalize (GObject *object)
 	g_free (self->distro);
 	g_free (self->review_server);
 	g_clear_pointer (&self->ratings, g_array_unref);
+	g_clear_pointer (&self->ratings_ids, g_free);
+	g_clear_pointer (&self->ratings_ids_variant, g_variant_unref);
+	g_clear_pointer (&self->ratings_stars_variant, g_variant_unref);
 	g_mutex_clear (&self->ratings_mutex);
 
 	G_OBJECT_CLASS (gs_odrs_provider_parent_class)->finalize (object);
@@ -1346,16 +1704,28 @@ gs_odrs_provider_refine (GsOdrsProvider       *self,
                          GCancellable         *cancellable,
                          GError              **error)
 {
+	g_autoptr(GHashTable) fetched = g_hash_table_new (g_direct_hash, g_direct_equal);
+
 	/* nothing to do here */
 	if ((flags & (GS_PLUGIN_REFINE_FLAGS_REQUIRE_REVIEWS |
 		      GS_PLUGIN_REFINE_FLAGS_REQUIRE_REVIEW_RATINGS |
 		      GS_PLUGIN_REFINE_FLAGS_REQUIRE_RATING)) == 0)
 		return TRUE;
 
+	/* fetch the reviews for all the apps at once */
+	if (flags & GS_PLUGIN_REFINE_FLAGS_REQUIRE_REVIEWS) {
+		if (!gs_odrs_provider_refine_reviews (self, list, fetched, cancellable, error))
+			return FALSE;
+	}
+
 	for (guint i = 0; i < gs_app_list_length (list); i++) {
 		GsApp *app = gs_app_list_index (list, i);
+		GsPluginRefineFlags app_flags = flags;
 		g_autoptr(GError) local_error = NULL;
-		if (!refine_app (self, app, flags, cancellable, &local_error)) {
+
+		if (g_hash_table_contains (fetched, app))
+			app_flags &= ~GS_PLUGIN_REFINE_FLAGS_REQUIRE_REVIEWS;
+		if (!refine_app (self, app, app_flags, cancellable, &local_error)) {
 			if (g_error_matches (local_error, GS_PLUGIN_ERROR, GS_PLUGIN_ERROR_NO_NETWORK)) {
 				g_debug ("failed to refine app %s: %s",
 					 gs_app_get_unique_id (app), local_error->message);
@@ -31,6 +31,9 @@ guint			 gs_plugin_job_get_timeout		(GsPluginJob	*self);
 guint64			 gs_plugin_job_get_age			(GsPluginJob	*self);
 GsAppListSortFunc	 gs_plugin_job_get_sort_func		(GsPluginJob	*self,
 								 gpointer	*user_data_out);
+GsAppListSortKeyFunc	 gs_plugin_job_get_sort_key_func	(GsPluginJob	*self,
+								 GsAppListSortFlags *flags_out,
+								 gpointer	*user_data_out);
 const gchar		*gs_plugin_job_get_search		(GsPluginJob	*self);
 GsApp			*gs_plugin_job_get_app			(GsPluginJob	*self);
 GsAppList		*gs_plugin_job_get_list			(GsPluginJob	*self);
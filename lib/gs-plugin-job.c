@@ -30,6 +30,9 @@ struct _GsPluginJob
 	GsPluginAction		 action;
 	GsAppListSortFunc	 sort_func;
 	gpointer		 sort_func_data;
+	GsAppListSortKeyFunc	 sort_key_func;
+	GsAppListSortFlags	 sort_key_flags;
+	gpointer		 sort_key_func_data;
 	gchar			*search;
 	GsApp			*app;
 	GsAppList		*list;
@@ -303,6 +306,28 @@ gs_plugin_job_get_sort_func (GsPluginJob *self, gpointer *user_data_out)
 	return self->sort_func;
 }
 
+/* takes precedence over any sort_func, as keys are only built once per app */
+void
+gs_plugin_job_set_sort_key_func (GsPluginJob *self, GsAppListSortKeyFunc sort_key_func,
+				 GsAppListSortFlags flags, gpointer user_data)
+{
+	g_return_if_fail (GS_IS_PLUGIN_JOB (self));
+	self->sort_key_func = sort_key_func;
+	self->sort_key_flags = flags;
+	self->sort_key_func_data = user_data;
+}
+
+GsAppListSortKeyFunc
+gs_plugin_job_get_sort_key_func (GsPluginJob *self, GsAppListSortFlags *flags_out, gpointer *user_data_out)
+{
+	g_return_val_if_fail (GS_IS_PLUGIN_JOB (self), NULL);
+	if (flags_out != NULL)
+		*flags_out = self->sort_key_flags;
+	if (user_data_out != NULL)
+		*user_data_out = self->sort_key_func_data;
+	return self->sort_key_func;
+}
+
 void
 gs_plugin_job_set_search (GsPluginJob *self, const gchar *search)
 {
@@ -39,6 +39,10 @@ void		 gs_plugin_job_set_age			(GsPluginJob	*self,
 void		 gs_plugin_job_set_sort_func		(GsPluginJob	*self,
 							 GsAppListSortFunc sort_func,
 							 gpointer	 user_data);
+void		 gs_plugin_job_set_sort_key_func	(GsPluginJob	*self,
+							 GsAppListSortKeyFunc sort_key_func,
+							 GsAppListSortFlags flags,
+							 gpointer	 user_data);
 void		 gs_plugin_job_set_search		(GsPluginJob	*self,
 							 const gchar	*search);
 void		 gs_plugin_job_set_app			(GsPluginJob	*self,
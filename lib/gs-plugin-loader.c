@@ -24,6 +24,7 @@
 #include "gs-category-manager.h"
 #include "gs-category-private.h"
 #include "gs-external-appstream-utils.h"
+#include "gs-icon.h"
 #include "gs-ioprio.h"
 #include "gs-os-release.h"
 #include "gs-plugin-loader.h"
@@ -31,10 +32,39 @@
 #include "gs-plugin-event.h"
 #include "gs-plugin-job-private.h"
 #include "gs-plugin-private.h"
+#include "gs-remote-icon.h"
 #include "gs-utils.h"
 
 #define GS_PLUGIN_LOADER_UPDATES_CHANGED_DELAY	3	/* s */
 #define GS_PLUGIN_LOADER_RELOAD_DELAY		5	/* s */
+#define GS_PLUGIN_LOADER_SEARCH_CACHE_SIZE	8
+#define GS_PLUGIN_LOADER_SEARCH_CACHE_MAX_AGE	60	/* s */
+#define GS_PLUGIN_LOADER_REFINE_MAX_THREADS	8
+#define GS_PLUGIN_LOADER_BACKGROUND_SLOTS	4
+#define GS_PLUGIN_LOADER_SCHEDULER_AGING	2	/* s */
+
+typedef enum {
+	GS_PLUGIN_LOADER_LANE_INTERACTIVE,
+	GS_PLUGIN_LOADER_LANE_BACKGROUND,
+	GS_PLUGIN_LOADER_LANE_LAST
+} GsPluginLoaderLane;
+
+typedef struct {
+	GQueue			 queue;		/* (element-type GsPluginLoaderQueuedTask) */
+	guint			 max_slots;	/* 0 for no limit */
+	guint			 slots_used;
+	guint			 n_running;
+	guint			 n_started;
+	guint64			 wait_total;	/* µs */
+	guint64			 wait_max;	/* µs */
+} GsPluginLoaderLaneState;
+
+typedef struct {
+	GTask			*task;		/* (owned) */
+	GsPluginLoaderLane	 lane;
+	gboolean		 exclusive;
+	gint64			 queued;	/* monotonic µs */
+} GsPluginLoaderQueuedTask;
 
 struct _GsPluginLoader
 {
@@ -53,12 +83,30 @@ struct _GsPluginLoader
 	GPtrArray		*pending_apps;
 
 	GThreadPool		*queued_ops_pool;
+	GMutex			 scheduler_mutex;
+	GsPluginLoaderLaneState	 lanes[GS_PLUGIN_LOADER_LANE_LAST];
+	guint			 max_exclusive_running;
+	guint			 n_exclusive_running;
+	gboolean		 scheduler_stopped;
+	GThreadPool		*refine_pool;
+	GPtrArray		*refine_graph;		/* (element-type GsPluginLoaderRefineNode) (nullable) */
+	GHashTable		*vfuncs;		/* (nullable) function name : GArray of GsPluginLoaderVfunc */
+
+	GMutex			 refine_inflight_mutex;
+	GCond			 refine_inflight_cond;
+	GHashTable		*refine_inflight;	/* unique-id : GsPluginLoaderRefineInflight */
 
 	GSettings		*settings;
 
 	GMutex			 events_by_id_mutex;
 	GHashTable		*events_by_id;		/* unique-id : GsPluginEvent */
 
+	GMutex			 search_cache_mutex;
+	GQueue			 search_cache;		/* (element-type GsPluginLoaderSearchCacheEntry), most recent first */
+	guint			 search_cache_generation;
+	guint			 search_cache_hits;
+	guint			 search_cache_misses;
+
 	gchar			**compatible_projects;
 	guint			 scale;
 
@@ -82,7 +130,12 @@ struct _GsPluginLoader
 
 static void gs_plugin_loader_monitor_network (GsPluginLoader *plugin_loader);
 static void add_app_to_install_queue (GsPluginLoader *plugin_loader, GsApp *app);
-static void gs_plugin_loader_process_in_thread_pool_cb (gpointer data, gpointer user_data);
+static void gs_plugin_loader_scheduler_worker_cb (gpointer data, gpointer user_data);
+static GsPluginLoaderLane gs_plugin_loader_scheduler_release_slot (GsPluginLoader *plugin_loader);
+static void gs_plugin_loader_scheduler_reacquire_slot (GsPluginLoader *plugin_loader, GsPluginLoaderLane lane);
+
+/* the lane plus one of the slot held by the job running in this thread */
+static GPrivate scheduler_lane_private;
 
 G_DEFINE_TYPE (GsPluginLoader, gs_plugin_loader, G_TYPE_OBJECT)
 
@@ -159,6 +212,11 @@ typedef gboolean	 (*GsPluginRefineWildcardFunc)	(GsPlugin	*plugin,
 							 GsPluginRefineFlags refine_flags,
 							 GCancellable	*cancellable,
 							 GError		**error);
+typedef gboolean	 (*GsPluginRefineWildcardsFunc)	(GsPlugin	*plugin,
+							 GsAppList	*list,
+							 GsPluginRefineFlags refine_flags,
+							 GCancellable	*cancellable,
+							 GError		**error);
 typedef gboolean	 (*GsPluginRefreshFunc)		(GsPlugin	*plugin,
 							 guint		 cache_age,
 							 GCancellable	*cancellable,
@@ -185,6 +243,104 @@ typedef gboolean	 (*GsPluginGetLangPacksFunc)	(GsPlugin	*plugin,
 							 GCancellable	*cancellable,
 							 GError		**error);
 
+/* the signature of a vfunc, where it cannot be told from the job action */
+typedef enum {
+	GS_PLUGIN_LOADER_VFUNC_KIND_ACTION,		/* named after the action */
+	GS_PLUGIN_LOADER_VFUNC_KIND_REFINE_WILDCARDS,
+	GS_PLUGIN_LOADER_VFUNC_KIND_REFINE_WILDCARD,
+	GS_PLUGIN_LOADER_VFUNC_KIND_APP,		/* takes a single #GsApp */
+} GsPluginLoaderVfuncKind;
+
+/* an enabled plugin and its implementation of one vfunc */
+typedef struct {
+	GsPlugin		*plugin;	/* (unowned) */
+	gpointer		 func;		/* (nullable) */
+	GsPluginLoaderVfuncKind	 kind;
+} GsPluginLoaderVfunc;
+
+/* vfuncs which are called by the loader but not named after an action */
+static const struct {
+	const gchar		*function_name;
+	GsPluginLoaderVfuncKind	 kind;
+} gs_plugin_loader_extra_vfuncs[] = {
+	{ "gs_plugin_refine_wildcards",	GS_PLUGIN_LOADER_VFUNC_KIND_REFINE_WILDCARDS },
+	{ "gs_plugin_refine_wildcard",	GS_PLUGIN_LOADER_VFUNC_KIND_REFINE_WILDCARD },
+	{ "gs_plugin_update_app",	GS_PLUGIN_LOADER_VFUNC_KIND_APP },
+	{ "gs_plugin_download_app",	GS_PLUGIN_LOADER_VFUNC_KIND_APP },
+	{ "gs_plugin_adopt_app",	GS_PLUGIN_LOADER_VFUNC_KIND_APP },
+	{ NULL,				GS_PLUGIN_LOADER_VFUNC_KIND_ACTION }
+};
+
+static void
+gs_plugin_loader_vfunc_init (GsPluginLoaderVfunc *vfunc,
+			     GsPlugin *plugin,
+			     const gchar *function_name,
+			     GsPluginLoaderVfuncKind kind)
+{
+	vfunc->plugin = plugin;
+	vfunc->func = gs_plugin_get_symbol (plugin, function_name);
+	vfunc->kind = kind;
+}
+
+static void
+gs_plugin_loader_add_vfuncs (GsPluginLoader *plugin_loader,
+			     GHashTable *vfuncs,
+			     const gchar *function_name,
+			     GsPluginLoaderVfuncKind kind)
+{
+	GArray *array;
+
+	if (function_name == NULL || g_hash_table_contains (vfuncs, function_name))
+		return;
+	array = g_array_new (FALSE, FALSE, sizeof (GsPluginLoaderVfunc));
+	for (guint i = 0; i < plugin_loader->plugins->len; i++) {
+		GsPluginLoaderVfunc vfunc;
+		gs_plugin_loader_vfunc_init (&vfunc,
+					     g_ptr_array_index (plugin_loader->plugins, i),
+					     function_name, kind);
+		if (vfunc.func != NULL)
+			g_array_append_val (array, vfunc);
+	}
+	g_hash_table_insert (vfuncs, (gpointer) function_name, array);
+}
+
+/* resolve every vfunc the loader calls once the plugins are set up, so that
+ * running a job walks only the plugins implementing it rather than looking
+ * up the symbol in every plugin under its lock; this is never modified
+ * afterwards and so can be read from any thread without locking */
+static void
+gs_plugin_loader_build_vfuncs (GsPluginLoader *plugin_loader)
+{
+	g_autoptr(GHashTable) vfuncs = NULL;
+
+	vfuncs = g_hash_table_new_full (g_str_hash, g_str_equal,
+					NULL, (GDestroyNotify) g_array_unref);
+	for (guint i = 0; i < GS_PLUGIN_ACTION_LAST; i++) {
+		gs_plugin_loader_add_vfuncs (plugin_loader, vfuncs,
+					     gs_plugin_action_to_function_name (i),
+					     GS_PLUGIN_LOADER_VFUNC_KIND_ACTION);
+	}
+	for (guint i = 0; gs_plugin_loader_extra_vfuncs[i].function_name != NULL; i++) {
+		gs_plugin_loader_add_vfuncs (plugin_loader, vfuncs,
+					     gs_plugin_loader_extra_vfuncs[i].function_name,
+					     gs_plugin_loader_extra_vfuncs[i].kind);
+	}
+
+	g_clear_pointer (&plugin_loader->vfuncs, g_hash_table_unref);
+	plugin_loader->vfuncs = g_steal_pointer (&vfuncs);
+}
+
+/* the plugins implementing @function_name, in plugin order, or %NULL if the
+ * plugins have not been set up; plugins which disabled themselves since then
+ * are still included and have to be skipped by the caller */
+static GArray *
+gs_plugin_loader_get_vfuncs (GsPluginLoader *plugin_loader,
+			     const gchar *function_name)
+{
+	if (plugin_loader->vfuncs == NULL)
+		return NULL;
+	return g_hash_table_lookup (plugin_loader->vfuncs, function_name);
+}
 
 /* async helper */
 typedef struct {
@@ -199,6 +355,7 @@ typedef struct {
 	gboolean			 anything_ran;
 	guint				 timeout_id;
 	gboolean			 timeout_triggered;
+	gboolean			 plugin_failed;
 	gchar				**tokens;
 } GsPluginLoaderHelper;
 
@@ -292,10 +449,383 @@ gs_plugin_loader_job_debug (GsPluginLoaderHelper *helper)
 
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(GsPluginLoaderHelper, gs_plugin_loader_helper_free)
 
-static gint
-gs_plugin_loader_app_sort_name_cb (GsApp *app1, GsApp *app2, gpointer user_data)
+/* Results of recent searches, before any refining, filtering or truncation,
+ * so that a search which only narrows a recent one (typically the next
+ * keystroke, or a GetSubsearchResultSet() call from the shell) can be
+ * answered by filtering those in memory rather than asking every plugin. */
+typedef struct {
+	gchar		**tokens;
+	GPtrArray	*apps;		/* (element-type GsApp) */
+	GArray		*match_values;	/* (element-type guint), matches @apps */
+	gint64		 created;	/* monotonic, µs */
+} GsPluginLoaderSearchCacheEntry;
+
+static void
+gs_plugin_loader_search_cache_entry_free (GsPluginLoaderSearchCacheEntry *entry)
+{
+	g_strfreev (entry->tokens);
+	g_ptr_array_unref (entry->apps);
+	g_array_unref (entry->match_values);
+	g_slice_free (GsPluginLoaderSearchCacheEntry, entry);
+}
+
+static void
+gs_plugin_loader_search_cache_invalidate (GsPluginLoader *plugin_loader)
+{
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&plugin_loader->search_cache_mutex);
+	plugin_loader->search_cache_generation++;
+	g_queue_clear_full (&plugin_loader->search_cache,
+			    (GDestroyNotify) gs_plugin_loader_search_cache_entry_free);
+}
+
+static guint
+gs_plugin_loader_search_cache_get_generation (GsPluginLoader *plugin_loader)
+{
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&plugin_loader->search_cache_mutex);
+	return plugin_loader->search_cache_generation;
+}
+
+/* every app matching all of @tokens also matches all of @tokens_old, as the
+ * plugins match tokens as prefixes of the indexed words */
+static gboolean
+gs_plugin_loader_search_tokens_narrow (gchar **tokens_old, gchar **tokens)
+{
+	for (guint i = 0; tokens_old[i] != NULL; i++) {
+		gboolean found = FALSE;
+		for (guint j = 0; tokens[j] != NULL && !found; j++)
+			found = g_str_has_prefix (tokens[j], tokens_old[i]);
+		if (!found)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+static void
+gs_plugin_loader_search_cache_add (GsPluginLoader *plugin_loader,
+				   gchar **tokens,
+				   GsAppList *list,
+				   gint64 created,
+				   guint generation)
+{
+	GsPluginLoaderSearchCacheEntry *entry;
+	g_autoptr(GMutexLocker) locker = NULL;
+
+	entry = g_slice_new0 (GsPluginLoaderSearchCacheEntry);
+	entry->tokens = g_strdupv (tokens);
+	entry->apps = g_ptr_array_new_full (gs_app_list_length (list), g_object_unref);
+	entry->match_values = g_array_sized_new (FALSE, FALSE, sizeof (guint),
+						 gs_app_list_length (list));
+	entry->created = created;
+	for (guint i = 0; i < gs_app_list_length (list); i++) {
+		GsApp *app = gs_app_list_index (list, i);
+		guint match_value = gs_app_get_match_value (app);
+		g_ptr_array_add (entry->apps, g_object_ref (app));
+		g_array_append_val (entry->match_values, match_value);
+	}
+
+	locker = g_mutex_locker_new (&plugin_loader->search_cache_mutex);
+
+	/* something was installed or reloaded while the plugins ran */
+	if (generation != plugin_loader->search_cache_generation) {
+		gs_plugin_loader_search_cache_entry_free (entry);
+		return;
+	}
+
+	/* replace any older results for the same terms */
+	for (GList *l = plugin_loader->search_cache.head; l != NULL; l = l->next) {
+		GsPluginLoaderSearchCacheEntry *entry_tmp = l->data;
+		if (g_strv_equal ((const gchar * const *) entry_tmp->tokens,
+				  (const gchar * const *) tokens)) {
+			g_queue_delete_link (&plugin_loader->search_cache, l);
+			gs_plugin_loader_search_cache_entry_free (entry_tmp);
+			break;
+		}
+	}
+	g_queue_push_head (&plugin_loader->search_cache, entry);
+	while (g_queue_get_length (&plugin_loader->search_cache) > GS_PLUGIN_LOADER_SEARCH_CACHE_SIZE) {
+		gs_plugin_loader_search_cache_entry_free (g_queue_pop_tail (&plugin_loader->search_cache));
+	}
+}
+
+static void
+gs_plugin_loader_search_match_str (const gchar *str,
+				   gchar **tokens,
+				   guint16 match_value,
+				   guint16 *matches)
+{
+	g_auto(GStrv) words = NULL;
+	g_auto(GStrv) alternates = NULL;
+
+	if (str == NULL)
+		return;
+	words = g_str_tokenize_and_fold (str, NULL, &alternates);
+	for (guint i = 0; tokens[i] != NULL; i++) {
+		gboolean found = FALSE;
+		for (guint j = 0; words[j] != NULL && !found; j++)
+			found = g_str_has_prefix (words[j], tokens[i]);
+		for (guint j = 0; alternates[j] != NULL && !found; j++)
+			found = g_str_has_prefix (alternates[j], tokens[i]);
+		if (found)
+			matches[i] |= match_value;
+	}
+}
+
+/* keywords and mimetypes are not properties of the GsApp, so can only be
+ * matched if the plugin recorded them in the metadata */
+static gboolean
+gs_plugin_loader_search_match_metadata (GsApp *app,
+					const gchar *key,
+					gchar **tokens,
+					guint16 match_value,
+					guint16 *matches)
+{
+	GVariant *value = gs_app_get_metadata_variant (app, key);
+	g_autofree const gchar **strv = NULL;
+
+	if (value == NULL || !g_variant_is_of_type (value, G_VARIANT_TYPE_STRING_ARRAY))
+		return FALSE;
+	strv = g_variant_get_strv (value, NULL);
+	for (guint i = 0; strv[i] != NULL; i++)
+		gs_plugin_loader_search_match_str (strv[i], tokens, match_value, matches);
+	return TRUE;
+}
+
+#define GS_PLUGIN_LOADER_SEARCH_MATCH_HIDDEN	(AS_SEARCH_TOKEN_MATCH_KEYWORD | \
+						 AS_SEARCH_TOKEN_MATCH_MIMETYPE)
+
+/* returns %FALSE if whether @app matches @tokens cannot be told from what is
+ * known about it, and the plugins have to be asked again */
+static gboolean
+gs_plugin_loader_search_match_app (GsApp *app,
+				   gchar **tokens,
+				   gchar **tokens_old,
+				   guint match_value_old,
+				   gboolean *matched,
+				   guint *match_value)
+{
+	GPtrArray *sources = gs_app_get_sources (app);
+	guint n_tokens = g_strv_length (tokens);
+	gboolean hidden_known = TRUE;
+	g_autofree guint16 *matches = g_new0 (guint16, n_tokens);
+
+	gs_plugin_loader_search_match_str (gs_app_get_id (app), tokens,
+					   AS_SEARCH_TOKEN_MATCH_ID, matches);
+	gs_plugin_loader_search_match_str (gs_app_get_name (app), tokens,
+					   AS_SEARCH_TOKEN_MATCH_NAME, matches);
+	gs_plugin_loader_search_match_str (gs_app_get_summary (app), tokens,
+					   AS_SEARCH_TOKEN_MATCH_SUMMARY, matches);
+	gs_plugin_loader_search_match_str (gs_app_get_origin (app), tokens,
+					   AS_SEARCH_TOKEN_MATCH_ORIGIN, matches);
+	for (guint i = 0; i < sources->len; i++) {
+		gs_plugin_loader_search_match_str (g_ptr_array_index (sources, i), tokens,
+						   AS_SEARCH_TOKEN_MATCH_PKGNAME, matches);
+	}
+	if (!gs_plugin_loader_search_match_metadata (app, "GnomeSoftware::search-keywords", tokens,
+						     AS_SEARCH_TOKEN_MATCH_KEYWORD, matches))
+		hidden_known = FALSE;
+	if (!gs_plugin_loader_search_match_metadata (app, "GnomeSoftware::search-mimetypes", tokens,
+						     AS_SEARCH_TOKEN_MATCH_MIMETYPE, matches))
+		hidden_known = FALSE;
+
+	/* every token has to match something */
+	*matched = TRUE;
+	*match_value = 0;
+	for (guint i = 0; i < n_tokens; i++) {
+		if (matches[i] == 0 && !hidden_known) {
+			/* the plugin matched exactly this token last time */
+			if (!g_strv_contains ((const gchar * const *) tokens_old, tokens[i]))
+				return FALSE;
+			*match_value |= match_value_old & GS_PLUGIN_LOADER_SEARCH_MATCH_HIDDEN;
+			continue;
+		}
+		if (matches[i] == 0) {
+			*matched = FALSE;
+			return TRUE;
+		}
+		*match_value |= matches[i];
+	}
+	return TRUE;
+}
+
+static void
+gs_plugin_loader_search_add_extends (GsApp *app, GHashTable *extends)
+{
+	GVariant *value = gs_app_get_metadata_variant (app, "GnomeSoftware::search-extends");
+	g_autofree const gchar **strv = NULL;
+
+	if (value == NULL || !g_variant_is_of_type (value, G_VARIANT_TYPE_STRING_ARRAY))
+		return;
+	strv = g_variant_get_strv (value, NULL);
+	for (guint i = 0; strv[i] != NULL; i++)
+		g_hash_table_add (extends, (gpointer) strv[i]);
+}
+
+/* sets which of the results of @tokens_old also match @tokens in @keep, and
+ * returns %FALSE if that cannot be told for all of them */
+static gboolean
+gs_plugin_loader_search_cache_narrow (GPtrArray *apps,
+				      GArray *match_values,
+				      gchar **tokens_old,
+				      gchar **tokens,
+				      gboolean *keep,
+				      GArray *match_values_new)
+{
+	g_autoptr(GHashTable) extends_kept = g_hash_table_new (g_str_hash, g_str_equal);
+	g_autoptr(GHashTable) extends_dropped = g_hash_table_new (g_str_hash, g_str_equal);
+
+	for (guint i = 0; i < apps->len; i++) {
+		GsApp *app = g_ptr_array_index (apps, i);
+
+		/* decided by the apps which extend them, below */
+		if (gs_app_has_quirk (app, GS_APP_QUIRK_IS_WILDCARD))
+			continue;
+		if (!gs_plugin_loader_search_match_app (app, tokens, tokens_old,
+							g_array_index (match_values, guint, i),
+							&keep[i],
+							&g_array_index (match_values_new, guint, i))) {
+			g_debug ("cannot narrow results for %s from the cache",
+				 gs_app_get_unique_id (app));
+			return FALSE;
+		}
+		gs_plugin_loader_search_add_extends (app, keep[i] ? extends_kept : extends_dropped);
+	}
+
+	/* the plugins add the apps which a result extends as wildcards */
+	for (guint i = 0; i < apps->len; i++) {
+		GsApp *app = g_ptr_array_index (apps, i);
+		const gchar *id = gs_app_get_id (app);
+
+		if (!gs_app_has_quirk (app, GS_APP_QUIRK_IS_WILDCARD))
+			continue;
+		if (id != NULL && g_hash_table_contains (extends_kept, id)) {
+			keep[i] = TRUE;
+		} else if (id == NULL || !g_hash_table_contains (extends_dropped, id)) {
+			g_debug ("cannot narrow results for wildcard %s from the cache",
+				 gs_app_get_unique_id (app));
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/* adds the results for @tokens to @list if a recent search can answer it */
+static gboolean
+gs_plugin_loader_search_cache_lookup (GsPluginLoader *plugin_loader,
+				      gchar **tokens,
+				      GsAppList *list,
+				      guint generation)
+{
+	GsPluginLoaderSearchCacheEntry *entry = NULL;
+	gboolean exact = FALSE;
+	gint64 now = g_get_monotonic_time ();
+	gint64 created = 0;
+	g_autoptr(GPtrArray) apps = NULL;
+	g_autoptr(GArray) match_values = NULL;
+	g_autoptr(GTimer) timer = g_timer_new ();
+	g_autoptr(GArray) match_values_new = NULL;
+	g_autofree gboolean *keep = NULL;
+	g_auto(GStrv) tokens_old = NULL;
+	g_autofree gchar *tokens_old_str = NULL;
+
+	/* prefer the same terms, otherwise the smallest result set to narrow */
+	{
+		g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&plugin_loader->search_cache_mutex);
+		for (GList *l = plugin_loader->search_cache.head; l != NULL; l = l->next) {
+			GsPluginLoaderSearchCacheEntry *entry_tmp = l->data;
+			if (now - entry_tmp->created > GS_PLUGIN_LOADER_SEARCH_CACHE_MAX_AGE * G_USEC_PER_SEC)
+				continue;
+			if (g_strv_equal ((const gchar * const *) entry_tmp->tokens,
+					  (const gchar * const *) tokens)) {
+				entry = entry_tmp;
+				exact = TRUE;
+				break;
+			}
+			if (!gs_plugin_loader_search_tokens_narrow (entry_tmp->tokens, tokens))
+				continue;
+			if (entry == NULL || entry_tmp->apps->len < entry->apps->len)
+				entry = entry_tmp;
+		}
+		if (entry == NULL) {
+			plugin_loader->search_cache_misses++;
+			return FALSE;
+		}
+
+		/* most recently used */
+		g_queue_remove (&plugin_loader->search_cache, entry);
+		g_queue_push_head (&plugin_loader->search_cache, entry);
+
+		apps = g_ptr_array_ref (entry->apps);
+		match_values = g_array_ref (entry->match_values);
+		tokens_old = g_strdupv (entry->tokens);
+		created = entry->created;
+	}
+
+	/* check every app against all of the new tokens before using any */
+	keep = g_new0 (gboolean, apps->len);
+	match_values_new = g_array_copy (match_values);
+	if (exact) {
+		for (guint i = 0; i < apps->len; i++)
+			keep[i] = TRUE;
+	} else if (!gs_plugin_loader_search_cache_narrow (apps, match_values, tokens_old,
+							   tokens, keep, match_values_new)) {
+		g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&plugin_loader->search_cache_mutex);
+		plugin_loader->search_cache_misses++;
+		return FALSE;
+	}
+
+	/* the apps are shared with other searches, so always set the match
+	 * value again rather than relying on the last one set */
+	for (guint i = 0; i < apps->len; i++) {
+		GsApp *app = g_ptr_array_index (apps, i);
+		if (!keep[i])
+			continue;
+		gs_app_set_match_value (app, g_array_index (match_values_new, guint, i));
+		gs_app_list_add (list, app);
+	}
+
+	tokens_old_str = g_strjoinv (" ", tokens_old);
+	g_debug ("reused %u of %u results for ‘%s’ in %.1fms",
+		 gs_app_list_length (list), apps->len, tokens_old_str,
+		 g_timer_elapsed (timer, NULL) * 1000);
+
+	{
+		g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&plugin_loader->search_cache_mutex);
+		plugin_loader->search_cache_hits++;
+	}
+
+	/* the next keystroke can start from the narrower set */
+	if (!exact)
+		gs_plugin_loader_search_cache_add (plugin_loader, tokens, list,
+						   created, generation);
+	return TRUE;
+}
+
+static gchar *
+gs_plugin_loader_app_sort_name_key_cb (GsApp *app, gpointer user_data)
 {
-	return gs_utils_sort_strcmp (gs_app_get_name (app1), gs_app_get_name (app2));
+	return gs_app_dup_name_sort_key (app);
+}
+
+/**
+ * gs_plugin_loader_get_search_cache_stats:
+ * @plugin_loader: a #GsPluginLoader
+ * @n_hits: (out) (optional): return location for the number of searches
+ *   answered from the results of a recent search
+ * @n_misses: (out) (optional): return location for the number of searches
+ *   which had to ask the plugins
+ *
+ * Gets how well the cache of recent search results is working.
+ **/
+void
+gs_plugin_loader_get_search_cache_stats (GsPluginLoader *plugin_loader,
+					 guint *n_hits,
+					 guint *n_misses)
+{
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&plugin_loader->search_cache_mutex);
+	if (n_hits != NULL)
+		*n_hits = plugin_loader->search_cache_hits;
+	if (n_misses != NULL)
+		*n_misses = plugin_loader->search_cache_misses;
 }
 
 GsPlugin *
@@ -491,6 +1021,9 @@ gs_plugin_error_handle_failure (GsPluginLoaderHelper *helper,
 		return TRUE;
 	}
 
+	/* the results are incomplete */
+	helper->plugin_failed = TRUE;
+
 	if (gs_plugin_job_get_propagate_error (helper->plugin_job)) {
 		g_propagate_error (error, g_error_copy (error_local));
 		return FALSE;
@@ -530,15 +1063,16 @@ gs_plugin_error_handle_failure (GsPluginLoaderHelper *helper,
 static void
 gs_plugin_loader_run_adopt (GsPluginLoader *plugin_loader, GsAppList *list)
 {
+	GArray *vfuncs = gs_plugin_loader_get_vfuncs (plugin_loader, "gs_plugin_adopt_app");
 	guint i;
 	guint j;
 
 	/* go through each plugin in order */
-	for (i = 0; i < plugin_loader->plugins->len; i++) {
-		GsPluginAdoptAppFunc adopt_app_func = NULL;
-		GsPlugin *plugin = g_ptr_array_index (plugin_loader->plugins, i);
-		adopt_app_func = gs_plugin_get_symbol (plugin, "gs_plugin_adopt_app");
-		if (adopt_app_func == NULL)
+	for (i = 0; vfuncs != NULL && i < vfuncs->len; i++) {
+		GsPluginLoaderVfunc *vfunc = &g_array_index (vfuncs, GsPluginLoaderVfunc, i);
+		GsPluginAdoptAppFunc adopt_app_func = vfunc->func;
+		GsPlugin *plugin = vfunc->plugin;
+		if (!gs_plugin_get_enabled (plugin))
 			continue;
 		for (j = 0; j < gs_app_list_length (list); j++) {
 			GsApp *app = gs_app_list_index (list, j);
@@ -583,7 +1117,7 @@ gs_plugin_loader_review_score_sort_cb (gconstpointer a, gconstpointer b)
 
 static gboolean
 gs_plugin_loader_call_vfunc (GsPluginLoaderHelper *helper,
-			     GsPlugin *plugin,
+			     const GsPluginLoaderVfunc *vfunc,
 			     GsApp *app,
 			     GsAppList *list,
 			     GsPluginRefineFlags refine_flags,
@@ -592,18 +1126,19 @@ gs_plugin_loader_call_vfunc (GsPluginLoaderHelper *helper,
 {
 	GsPluginLoader *plugin_loader = helper->plugin_loader;
 	GsPluginAction action = gs_plugin_job_get_action (helper->plugin_job);
+	GsPlugin *plugin = vfunc->plugin;
+	gpointer func = vfunc->func;
 	gboolean ret = TRUE;
-	gpointer func = NULL;
 	g_autoptr(GError) error_local = NULL;
-	g_autoptr(GTimer) timer = g_timer_new ();
+	g_autoptr(GTimer) timer = NULL;
 #ifdef HAVE_SYSPROF
 	gint64 begin_time_nsec = SYSPROF_CAPTURE_CURRENT_TIME;
 #endif
 
-	/* load the possible symbol */
-	func = gs_plugin_get_symbol (plugin, helper->function_name);
-	if (func == NULL)
+	/* the plugin does not implement the vfunc, or has since been disabled */
+	if (func == NULL || !gs_plugin_get_enabled (plugin))
 		return TRUE;
+	timer = g_timer_new ();
 
 	/* at least one plugin supports this vfunc */
 	helper->anything_ran = TRUE;
@@ -630,42 +1165,52 @@ gs_plugin_loader_call_vfunc (GsPluginLoaderHelper *helper,
 		}
 		break;
 	case GS_PLUGIN_ACTION_REFINE:
-		if (g_strcmp0 (helper->function_name, "gs_plugin_refine_wildcard") == 0) {
-			GsPluginRefineWildcardFunc plugin_func = func;
-			ret = plugin_func (plugin, app, list, refine_flags, cancellable, &error_local);
-		} else if (g_strcmp0 (helper->function_name, "gs_plugin_refine") == 0) {
-			GsPluginRefineFunc plugin_func = func;
-			ret = plugin_func (plugin, list, refine_flags, cancellable, &error_local);
-		} else {
+		switch (vfunc->kind) {
+		case GS_PLUGIN_LOADER_VFUNC_KIND_REFINE_WILDCARD:
+			{
+				GsPluginRefineWildcardFunc plugin_func = func;
+				ret = plugin_func (plugin, app, list, refine_flags, cancellable, &error_local);
+			}
+			break;
+		case GS_PLUGIN_LOADER_VFUNC_KIND_REFINE_WILDCARDS:
+			{
+				GsPluginRefineWildcardsFunc plugin_func = func;
+				ret = plugin_func (plugin, list, refine_flags, cancellable, &error_local);
+			}
+			break;
+		case GS_PLUGIN_LOADER_VFUNC_KIND_ACTION:
+			{
+				GsPluginRefineFunc plugin_func = func;
+				ret = plugin_func (plugin, list, refine_flags, cancellable, &error_local);
+			}
+			break;
+		default:
 			g_critical ("function_name %s invalid for %s",
 				    helper->function_name,
 				    gs_plugin_action_to_string (action));
+			break;
 		}
 		break;
 	case GS_PLUGIN_ACTION_UPDATE:
-		if (g_strcmp0 (helper->function_name, "gs_plugin_update_app") == 0) {
-			GsPluginActionFunc plugin_func = func;
-			ret = plugin_func (plugin, app, cancellable, &error_local);
-		} else if (g_strcmp0 (helper->function_name, "gs_plugin_update") == 0) {
-			GsPluginUpdateFunc plugin_func = func;
-			ret = plugin_func (plugin, list, cancellable, &error_local);
-		} else {
-			g_critical ("function_name %s invalid for %s",
-				    helper->function_name,
-				    gs_plugin_action_to_string (action));
-		}
-		break;
 	case GS_PLUGIN_ACTION_DOWNLOAD:
-		if (g_strcmp0 (helper->function_name, "gs_plugin_download_app") == 0) {
-			GsPluginActionFunc plugin_func = func;
-			ret = plugin_func (plugin, app, cancellable, &error_local);
-		} else if (g_strcmp0 (helper->function_name, "gs_plugin_download") == 0) {
-			GsPluginUpdateFunc plugin_func = func;
-			ret = plugin_func (plugin, list, cancellable, &error_local);
-		} else {
+		switch (vfunc->kind) {
+		case GS_PLUGIN_LOADER_VFUNC_KIND_APP:
+			{
+				GsPluginActionFunc plugin_func = func;
+				ret = plugin_func (plugin, app, cancellable, &error_local);
+			}
+			break;
+		case GS_PLUGIN_LOADER_VFUNC_KIND_ACTION:
+			{
+				GsPluginUpdateFunc plugin_func = func;
+				ret = plugin_func (plugin, list, cancellable, &error_local);
+			}
+			break;
+		default:
 			g_critical ("function_name %s invalid for %s",
 				    helper->function_name,
 				    gs_plugin_action_to_string (action));
+			break;
 		}
 		break;
 	case GS_PLUGIN_ACTION_INSTALL:
@@ -872,52 +1417,453 @@ gs_plugin_loader_app_is_non_wildcard (GsApp *app, gpointer user_data)
 }
 
 static gboolean
-gs_plugin_loader_run_refine_filter (GsPluginLoaderHelper *helper,
-				    GsAppList *list,
-				    GsPluginRefineFlags refine_flags,
-				    GCancellable *cancellable,
-				    GError **error)
+gs_plugin_loader_list_has_wildcard (GsAppList *list)
 {
-	GsPluginLoader *plugin_loader = helper->plugin_loader;
+	for (guint i = 0; i < gs_app_list_length (list); i++) {
+		if (gs_app_has_quirk (gs_app_list_index (list, i), GS_APP_QUIRK_IS_WILDCARD))
+			return TRUE;
+	}
+	return FALSE;
+}
 
-	/* run each plugin */
+/* A plugin implementing gs_plugin_refine(), gs_plugin_refine_wildcards() or
+ * gs_plugin_refine_wildcard(),
+ * with the plugins which have to refine before it according to the
+ * GS_PLUGIN_RULE_RUN_AFTER and GS_PLUGIN_RULE_RUN_BEFORE rules */
+typedef struct {
+	GsPlugin		*plugin;	/* (unowned) */
+	GsPluginLoaderVfunc	 refine;
+	GsPluginLoaderVfunc	 refine_wildcards;
+	GsPluginLoaderVfunc	 refine_wildcard;
+	guint			 n_deps;
+	GArray			*dependents;	/* (element-type guint), indexes into refine_graph */
+} GsPluginLoaderRefineNode;
+
+static void
+gs_plugin_loader_refine_node_free (GsPluginLoaderRefineNode *node)
+{
+	g_array_unref (node->dependents);
+	g_slice_free (GsPluginLoaderRefineNode, node);
+}
+
+static gint
+gs_plugin_loader_find_plugin_index (GsPluginLoader *plugin_loader,
+				    const gchar *plugin_name)
+{
 	for (guint i = 0; i < plugin_loader->plugins->len; i++) {
 		GsPlugin *plugin = g_ptr_array_index (plugin_loader->plugins, i);
-		g_autoptr(GsAppList) app_list = NULL;
+		if (g_strcmp0 (gs_plugin_get_name (plugin), plugin_name) == 0)
+			return (gint) i;
+	}
+	return -1;
+}
+
+static gboolean
+gs_plugin_loader_plugin_can_refine (GsPlugin *plugin)
+{
+	return gs_plugin_get_symbol (plugin, "gs_plugin_refine") != NULL ||
+	       gs_plugin_get_symbol (plugin, "gs_plugin_refine_wildcards") != NULL ||
+	       gs_plugin_get_symbol (plugin, "gs_plugin_refine_wildcard") != NULL;
+}
+
+static void
+gs_plugin_loader_build_refine_graph (GsPluginLoader *plugin_loader)
+{
+	guint n_plugins = plugin_loader->plugins->len;
+	g_autofree gint *node_for_plugin = g_new (gint, n_plugins);
+	g_autoptr(GPtrArray) preds = g_ptr_array_new_with_free_func ((GDestroyNotify) g_array_unref);
+	g_autoptr(GPtrArray) graph = g_ptr_array_new_with_free_func ((GDestroyNotify) gs_plugin_loader_refine_node_free);
+	g_autofree gboolean *waits = NULL;	/* [node * n_nodes + pred] */
+
+	/* the direct predecessors of each enabled plugin */
+	for (guint i = 0; i < n_plugins; i++)
+		g_ptr_array_add (preds, g_array_new (FALSE, FALSE, sizeof (guint)));
+	for (guint i = 0; i < n_plugins; i++) {
+		GsPlugin *plugin = g_ptr_array_index (plugin_loader->plugins, i);
+		GPtrArray *deps;
+
+		if (!gs_plugin_get_enabled (plugin))
+			continue;
+		deps = gs_plugin_get_rules (plugin, GS_PLUGIN_RULE_RUN_AFTER);
+		for (guint j = 0; j < deps->len; j++) {
+			gint dep = gs_plugin_loader_find_plugin_index (plugin_loader,
+								       g_ptr_array_index (deps, j));
+			guint dep_idx = (guint) dep;
+			if (dep < 0 || dep_idx == i)
+				continue;
+			g_array_append_val (g_ptr_array_index (preds, i), dep_idx);
+		}
+		deps = gs_plugin_get_rules (plugin, GS_PLUGIN_RULE_RUN_BEFORE);
+		for (guint j = 0; j < deps->len; j++) {
+			gint dep = gs_plugin_loader_find_plugin_index (plugin_loader,
+								       g_ptr_array_index (deps, j));
+			if (dep < 0 || (guint) dep == i)
+				continue;
+			g_array_append_val (g_ptr_array_index (preds, (guint) dep), i);
+		}
+	}
 
-		/* run the batched plugin symbol then refine wildcards per-app */
-		helper->function_name = "gs_plugin_refine";
-		if (!gs_plugin_loader_call_vfunc (helper, plugin, NULL, list,
-						  refine_flags, cancellable, error)) {
+	/* only plugins which refine are in the graph, in plugin order */
+	for (guint i = 0; i < n_plugins; i++) {
+		GsPlugin *plugin = g_ptr_array_index (plugin_loader->plugins, i);
+		GsPluginLoaderRefineNode *node;
+
+		node_for_plugin[i] = -1;
+		if (!gs_plugin_loader_plugin_can_refine (plugin))
+			continue;
+		node = g_slice_new0 (GsPluginLoaderRefineNode);
+		node->plugin = plugin;
+		gs_plugin_loader_vfunc_init (&node->refine, plugin, "gs_plugin_refine",
+					     GS_PLUGIN_LOADER_VFUNC_KIND_ACTION);
+		gs_plugin_loader_vfunc_init (&node->refine_wildcards, plugin, "gs_plugin_refine_wildcards",
+					     GS_PLUGIN_LOADER_VFUNC_KIND_REFINE_WILDCARDS);
+		gs_plugin_loader_vfunc_init (&node->refine_wildcard, plugin, "gs_plugin_refine_wildcard",
+					     GS_PLUGIN_LOADER_VFUNC_KIND_REFINE_WILDCARD);
+		node->dependents = g_array_new (FALSE, FALSE, sizeof (guint));
+		node_for_plugin[i] = (gint) graph->len;
+		g_ptr_array_add (graph, node);
+	}
+
+	/* a plugin waits for every refining plugin it transitively runs
+	 * after, even when the plugins in between do not refine */
+	waits = g_new0 (gboolean, graph->len * graph->len);
+	for (guint i = 0; i < n_plugins; i++) {
+		g_autofree gboolean *visited = NULL;
+		g_autoptr(GArray) todo = NULL;
+		guint idx = (guint) node_for_plugin[i];
+
+		if (node_for_plugin[i] < 0)
+			continue;
+		visited = g_new0 (gboolean, n_plugins);
+		todo = g_array_new (FALSE, FALSE, sizeof (guint));
+		g_array_append_val (todo, i);
+		visited[i] = TRUE;
+		while (todo->len > 0) {
+			guint j = g_array_index (todo, guint, todo->len - 1);
+			GArray *preds_j = g_ptr_array_index (preds, j);
+			g_array_set_size (todo, todo->len - 1);
+			for (guint k = 0; k < preds_j->len; k++) {
+				guint pred = g_array_index (preds_j, guint, k);
+				if (visited[pred])
+					continue;
+				visited[pred] = TRUE;
+				g_array_append_val (todo, pred);
+				if (node_for_plugin[pred] >= 0)
+					waits[idx * graph->len + (guint) node_for_plugin[pred]] = TRUE;
+			}
+		}
+	}
+
+	/* a plugin which refines wildcards adds new apps to the list, which
+	 * every plugin after it has to see, and it has to see everything the
+	 * plugins before it did to the wildcards, so it runs on its own */
+	for (guint i = 0; i < graph->len; i++) {
+		GsPluginLoaderRefineNode *node = g_ptr_array_index (graph, i);
+		if (node->refine_wildcards.func == NULL &&
+		    node->refine_wildcard.func == NULL)
+			continue;
+		for (guint j = 0; j < i; j++)
+			waits[i * graph->len + j] = TRUE;
+		for (guint j = i + 1; j < graph->len; j++)
+			waits[j * graph->len + i] = TRUE;
+	}
+
+	for (guint i = 0; i < graph->len; i++) {
+		GsPluginLoaderRefineNode *node = g_ptr_array_index (graph, i);
+		for (guint j = 0; j < graph->len; j++) {
+			GsPluginLoaderRefineNode *node_pred = g_ptr_array_index (graph, j);
+			if (!waits[i * graph->len + j])
+				continue;
+			g_array_append_val (node_pred->dependents, i);
+			node->n_deps++;
+		}
+	}
+
+	for (guint i = 0; i < graph->len; i++) {
+		GsPluginLoaderRefineNode *node = g_ptr_array_index (graph, i);
+		g_debug ("refine graph: %s waits for %u plugins",
+			 gs_plugin_get_name (node->plugin), node->n_deps);
+	}
+
+	g_clear_pointer (&plugin_loader->refine_graph, g_ptr_array_unref);
+	plugin_loader->refine_graph = g_steal_pointer (&graph);
+}
+
+/* state shared by everything refining one list */
+typedef struct {
+	GMutex			 mutex;
+	GCond			 cond;
+	GsPluginLoaderHelper	*helper;
+	GsAppList		*list;
+	GsPluginRefineFlags	 refine_flags;
+	GCancellable		*cancellable;
+	guint			*n_deps;	/* per node, still to finish */
+	GQueue			 ready;		/* (element-type guint) */
+	guint			 n_running;
+	guint			 n_remaining;
+	GError			*error;
+} GsPluginLoaderRefineRun;
+
+typedef struct {
+	GsPluginLoaderRefineRun	*run;
+	guint			 idx;
+} GsPluginLoaderRefineTask;
+
+static gboolean
+gs_plugin_loader_refine_node_run (GsPluginLoaderRefineRun *run,
+				  GsPluginLoaderRefineNode *node,
+				  GsAppList *list,
+				  gboolean *anything_ran,
+				  GError **error)
+{
+	GsPlugin *plugin = node->plugin;
+	GsPluginJob *plugin_job_parent = run->helper->plugin_job;
+	g_autoptr(GsPluginJob) plugin_job = NULL;
+	g_autoptr(GsPluginLoaderHelper) helper = NULL;
+#ifdef HAVE_SYSPROF
+	gint64 begin_time_nsec G_GNUC_UNUSED = SYSPROF_CAPTURE_CURRENT_TIME;
+#endif
+
+	/* each stage gets its own job as the plugin is set on it */
+	plugin_job = gs_plugin_job_newv (GS_PLUGIN_ACTION_REFINE,
+					 "list", list,
+					 "refine-flags", run->refine_flags,
+					 "interactive", gs_plugin_job_get_interactive (plugin_job_parent),
+					 "propagate-error", gs_plugin_job_get_propagate_error (plugin_job_parent),
+					 NULL);
+	helper = gs_plugin_loader_helper_new (run->helper->plugin_loader, plugin_job);
+	helper->function_name_parent = run->helper->function_name_parent;
+	helper->timeout_triggered = run->helper->timeout_triggered;
+
+	/* run the batched plugin symbol then refine wildcards, all at once if
+	 * the plugin supports that and otherwise per-app */
+	helper->function_name = "gs_plugin_refine";
+	if (!gs_plugin_loader_call_vfunc (helper, &node->refine, NULL, list,
+					  run->refine_flags, run->cancellable, error)) {
+		return FALSE;
+	}
+
+	if (node->refine_wildcards.func != NULL) {
+		helper->function_name = "gs_plugin_refine_wildcards";
+		if (gs_plugin_loader_list_has_wildcard (list) &&
+		    !gs_plugin_loader_call_vfunc (helper, &node->refine_wildcards,
+						  NULL, list, run->refine_flags,
+						  run->cancellable, error)) {
 			return FALSE;
 		}
+	} else if (node->refine_wildcard.func != NULL) {
+		/* use a copy of the list for the loop because a function called
+		 * on the plugin may affect the list which can lead to problems
+		 * (e.g. inserting an app in the list on every call results in
+		 * an infinite loop) */
+		g_autoptr(GsAppList) app_list = gs_app_list_copy (list);
+		helper->function_name = "gs_plugin_refine_wildcard";
+
+		for (guint j = 0; j < gs_app_list_length (app_list); j++) {
+			GsApp *app = gs_app_list_index (app_list, j);
+			if (gs_app_has_quirk (app, GS_APP_QUIRK_IS_WILDCARD) &&
+			    !gs_plugin_loader_call_vfunc (helper, &node->refine_wildcard,
+							  app, list, run->refine_flags,
+							  run->cancellable, error)) {
+				return FALSE;
+			}
+		}
+	}
 
-		if (gs_plugin_get_symbol (plugin, "gs_plugin_refine_wildcard") != NULL) {
-			/* use a copy of the list for the loop because a function called
-			 * on the plugin may affect the list which can lead to problems
-			 * (e.g. inserting an app in the list on every call results in
-			 * an infinite loop) */
-			app_list = gs_app_list_copy (list);
-			helper->function_name = "gs_plugin_refine_wildcard";
-
-			for (guint j = 0; j < gs_app_list_length (app_list); j++) {
-				GsApp *app = gs_app_list_index (app_list, j);
-				if (gs_app_has_quirk (app, GS_APP_QUIRK_IS_WILDCARD) &&
-				    !gs_plugin_loader_call_vfunc (helper, plugin, app, NULL,
-								  refine_flags, cancellable, error)) {
-					return FALSE;
-				}
+	gs_plugin_status_update (plugin, NULL, GS_PLUGIN_STATUS_FINISHED);
+	*anything_ran = helper->anything_ran;
+
+#ifdef HAVE_SYSPROF
+	if (run->helper->plugin_loader->sysprof_writer != NULL) {
+		g_autofree gchar *sysprof_name = g_strconcat ("refine-stage:", gs_plugin_get_name (plugin), NULL);
+		g_autofree gchar *sysprof_message = g_strdup_printf ("%u apps", gs_app_list_length (list));
+		sysprof_capture_writer_add_mark (run->helper->plugin_loader->sysprof_writer,
+						 begin_time_nsec,
+						 sched_getcpu (),
+						 getpid (),
+						 SYSPROF_CAPTURE_CURRENT_TIME - begin_time_nsec,
+						 "gnome-software",
+						 sysprof_name,
+						 sysprof_message);
+	}
+#endif  /* HAVE_SYSPROF */
+
+	return TRUE;
+}
+
+static GHashTable *
+gs_plugin_loader_app_list_to_set (GsAppList *list)
+{
+	GHashTable *set = g_hash_table_new (g_direct_hash, g_direct_equal);
+	for (guint i = 0; i < gs_app_list_length (list); i++)
+		g_hash_table_add (set, gs_app_list_index (list, i));
+	return set;
+}
+
+/* runs one plugin on a private copy of the list, then applies any apps it
+ * added or removed to the shared list; called with run->mutex unlocked */
+static void
+gs_plugin_loader_refine_run_node (GsPluginLoaderRefineRun *run, guint idx)
+{
+	GsPluginLoader *plugin_loader = run->helper->plugin_loader;
+	GsPluginLoaderRefineNode *node = g_ptr_array_index (plugin_loader->refine_graph, idx);
+	gboolean anything_ran = FALSE;
+	gboolean ret;
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GsAppList) list = NULL;
+	g_autoptr(GHashTable) before = NULL;
+	g_autoptr(GHashTable) after = NULL;
+	g_autoptr(GMutexLocker) locker = NULL;
+
+	g_mutex_lock (&run->mutex);
+	list = gs_app_list_copy (run->list);
+	g_mutex_unlock (&run->mutex);
+	before = gs_plugin_loader_app_list_to_set (list);
+
+	ret = gs_plugin_loader_refine_node_run (run, node, list, &anything_ran, &error_local);
+	after = gs_plugin_loader_app_list_to_set (list);
+
+	locker = g_mutex_locker_new (&run->mutex);
+	if (anything_ran)
+		run->helper->anything_ran = TRUE;
+	if (!ret) {
+		if (run->error == NULL)
+			run->error = g_steal_pointer (&error_local);
+	} else {
+		GHashTableIter iter;
+		gpointer key;
+
+		/* merge in the same order the plugin left the list in */
+		g_hash_table_iter_init (&iter, before);
+		while (g_hash_table_iter_next (&iter, &key, NULL)) {
+			if (!g_hash_table_contains (after, key))
+				gs_app_list_remove (run->list, GS_APP (key));
+		}
+		for (guint i = 0; i < gs_app_list_length (list); i++) {
+			GsApp *app = gs_app_list_index (list, i);
+			if (!g_hash_table_contains (before, app))
+				gs_app_list_add (run->list, app);
+		}
+	}
+
+	/* unblock anything that was waiting for this plugin */
+	for (guint i = 0; i < node->dependents->len; i++) {
+		guint idx_dep = g_array_index (node->dependents, guint, i);
+		if (--run->n_deps[idx_dep] == 0)
+			g_queue_push_tail (&run->ready, GUINT_TO_POINTER (idx_dep));
+	}
+	run->n_running--;
+	run->n_remaining--;
+	g_cond_signal (&run->cond);
+}
+
+static void
+gs_plugin_loader_refine_thread_cb (gpointer data, gpointer user_data)
+{
+	GsPluginLoaderRefineTask *task = data;
+	g_autoptr(GMainContext) context = g_main_context_new ();
+	g_autoptr(GMainContextPusher) pusher = g_main_context_pusher_new (context);
+
+	gs_ioprio_init ();
+	gs_plugin_loader_refine_run_node (task->run, task->idx);
+	g_slice_free (GsPluginLoaderRefineTask, task);
+}
+
+/* runs every refining plugin once its dependencies are done, handing the
+ * independent ones to the refine pool and running one in this thread */
+static gboolean
+gs_plugin_loader_run_refine_plugins (GsPluginLoaderHelper *helper,
+				     GsAppList *list,
+				     GsPluginRefineFlags refine_flags,
+				     GCancellable *cancellable,
+				     GError **error)
+{
+	GsPluginLoader *plugin_loader = helper->plugin_loader;
+	GPtrArray *graph = plugin_loader->refine_graph;
+	GsPluginLoaderRefineRun run = { 0, };
+	g_autofree guint *n_deps = NULL;
+
+	if (graph == NULL || graph->len == 0)
+		return TRUE;
+
+	g_mutex_init (&run.mutex);
+	g_cond_init (&run.cond);
+	g_queue_init (&run.ready);
+	run.helper = helper;
+	run.list = list;
+	run.refine_flags = refine_flags;
+	run.cancellable = cancellable;
+	run.n_remaining = graph->len;
+	n_deps = g_new (guint, graph->len);
+	run.n_deps = n_deps;
+	for (guint i = 0; i < graph->len; i++) {
+		GsPluginLoaderRefineNode *node = g_ptr_array_index (graph, i);
+		n_deps[i] = node->n_deps;
+		if (n_deps[i] == 0)
+			g_queue_push_tail (&run.ready, GUINT_TO_POINTER (i));
+	}
+
+	g_mutex_lock (&run.mutex);
+	while (run.n_running > 0 || (run.error == NULL && run.n_remaining > 0)) {
+		guint idx;
+
+		if (run.error != NULL || g_queue_is_empty (&run.ready)) {
+			if (run.n_running == 0) {
+				g_set_error_literal (&run.error,
+						     GS_PLUGIN_ERROR,
+						     GS_PLUGIN_ERROR_PLUGIN_DEPSOLVE_FAILED,
+						     "refine plugins depend on each other");
+				break;
 			}
+			g_cond_wait (&run.cond, &run.mutex);
+			continue;
 		}
 
-		gs_plugin_status_update (plugin, NULL, GS_PLUGIN_STATUS_FINISHED);
+		idx = GPOINTER_TO_UINT (g_queue_pop_head (&run.ready));
+		while (!g_queue_is_empty (&run.ready)) {
+			GsPluginLoaderRefineTask *task = g_slice_new0 (GsPluginLoaderRefineTask);
+			task->run = &run;
+			task->idx = GPOINTER_TO_UINT (g_queue_pop_head (&run.ready));
+			run.n_running++;
+			g_thread_pool_push (plugin_loader->refine_pool, task, NULL);
+		}
+		run.n_running++;
+		g_mutex_unlock (&run.mutex);
+		gs_plugin_loader_refine_run_node (&run, idx);
+		g_mutex_lock (&run.mutex);
+	}
+	g_mutex_unlock (&run.mutex);
+
+	g_queue_clear (&run.ready);
+	g_cond_clear (&run.cond);
+	g_mutex_clear (&run.mutex);
+
+	if (run.error != NULL) {
+		g_propagate_error (error, run.error);
+		return FALSE;
 	}
+	return TRUE;
+}
+
+static gboolean
+gs_plugin_loader_run_refine_filter (GsPluginLoaderHelper *helper,
+				    GsAppList *list,
+				    GsPluginRefineFlags refine_flags,
+				    GCancellable *cancellable,
+				    GError **error)
+{
+	GsPluginLoader *plugin_loader = helper->plugin_loader;
+
+	if (refine_flags == GS_PLUGIN_REFINE_FLAGS_DEFAULT)
+		refine_flags = gs_plugin_job_get_refine_flags (helper->plugin_job);
+
+	/* run each plugin, concurrently where the rules allow it */
+	if (!gs_plugin_loader_run_refine_plugins (helper, list, refine_flags,
+						  cancellable, error))
+		return FALSE;
 
 	/* Add ODRS data if needed */
 	if (plugin_loader->odrs_provider != NULL) {
-		if (refine_flags == GS_PLUGIN_REFINE_FLAGS_DEFAULT)
-			refine_flags = gs_plugin_job_get_refine_flags (helper->plugin_job);
-
 		if (!gs_odrs_provider_refine (plugin_loader->odrs_provider,
 					      list, refine_flags, cancellable, error))
 			return FALSE;
@@ -1066,16 +2012,221 @@ app_thaw_notify_idle (gpointer data)
 	return G_SOURCE_REMOVE;
 }
 
+/* an app being refined by one job, which other jobs wanting the same or
+ * fewer refine flags for the same app can wait for instead of refining it
+ * again; protected by refine_inflight_mutex */
+typedef struct {
+	gchar			*unique_id;
+	GsApp			*app;		/* (owned) */
+	GsPluginRefineFlags	 refine_flags;
+	gconstpointer		 owner;
+	gboolean		 done;
+	gboolean		 success;
+	guint			 refcount;
+} GsPluginLoaderRefineInflight;
+
+/* called with refine_inflight_mutex held */
+static void
+gs_plugin_loader_refine_inflight_unref (GsPluginLoaderRefineInflight *inflight)
+{
+	if (--inflight->refcount > 0)
+		return;
+	g_free (inflight->unique_id);
+	g_object_unref (inflight->app);
+	g_slice_free (GsPluginLoaderRefineInflight, inflight);
+}
+
+/* returns the apps in @list this job has to refine itself, adding the
+ * refines it now owns to @owned and those it can reuse to @waiting */
+static GsAppList *
+gs_plugin_loader_refine_inflight_claim (GsPluginLoader *plugin_loader,
+					GsAppList *list,
+					GsPluginRefineFlags refine_flags,
+					GPtrArray *owned,
+					GPtrArray *waiting)
+{
+	GsAppList *refine_list = gs_app_list_new ();
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&plugin_loader->refine_inflight_mutex);
+
+	for (guint i = 0; i < gs_app_list_length (list); i++) {
+		GsApp *app = gs_app_list_index (list, i);
+		const gchar *unique_id = gs_app_get_unique_id (app);
+		GsPluginLoaderRefineInflight *inflight;
+
+		/* wildcards get replaced by the refine, so cannot be shared */
+		if (unique_id == NULL || gs_app_has_quirk (app, GS_APP_QUIRK_IS_WILDCARD)) {
+			gs_app_list_add (refine_list, app);
+			continue;
+		}
+
+		inflight = g_hash_table_lookup (plugin_loader->refine_inflight, unique_id);
+		if (inflight != NULL) {
+			/* the other job has to be refining this very object, with
+			 * at least the flags we need */
+			if (inflight->owner != list &&
+			    inflight->app == app &&
+			    (inflight->refine_flags & refine_flags) == refine_flags) {
+				inflight->refcount++;
+				g_ptr_array_add (waiting, inflight);
+			} else {
+				gs_app_list_add (refine_list, app);
+			}
+			continue;
+		}
+
+		inflight = g_slice_new0 (GsPluginLoaderRefineInflight);
+		inflight->unique_id = g_strdup (unique_id);
+		inflight->app = g_object_ref (app);
+		inflight->refine_flags = refine_flags;
+		inflight->owner = list;
+		inflight->refcount = 1;
+		g_hash_table_insert (plugin_loader->refine_inflight, inflight->unique_id, inflight);
+		g_ptr_array_add (owned, inflight);
+		gs_app_list_add (refine_list, app);
+	}
+
+	return refine_list;
+}
+
+/* marks the refines this job owned as finished and wakes any waiters */
+static void
+gs_plugin_loader_refine_inflight_release (GsPluginLoader *plugin_loader,
+					  GPtrArray *owned,
+					  gboolean success)
+{
+	g_autoptr(GMutexLocker) locker = NULL;
+
+	if (owned->len == 0)
+		return;
+
+	locker = g_mutex_locker_new (&plugin_loader->refine_inflight_mutex);
+	for (guint i = 0; i < owned->len; i++) {
+		GsPluginLoaderRefineInflight *inflight = g_ptr_array_index (owned, i);
+		inflight->done = TRUE;
+		inflight->success = success;
+		g_hash_table_remove (plugin_loader->refine_inflight, inflight->unique_id);
+		gs_plugin_loader_refine_inflight_unref (inflight);
+	}
+	g_ptr_array_set_size (owned, 0);
+	g_cond_broadcast (&plugin_loader->refine_inflight_cond);
+}
+
+static void
+gs_plugin_loader_refine_inflight_drop (GsPluginLoader *plugin_loader,
+				       GPtrArray *waiting)
+{
+	g_autoptr(GMutexLocker) locker = NULL;
+
+	if (waiting->len == 0)
+		return;
+
+	locker = g_mutex_locker_new (&plugin_loader->refine_inflight_mutex);
+	for (guint i = 0; i < waiting->len; i++)
+		gs_plugin_loader_refine_inflight_unref (g_ptr_array_index (waiting, i));
+	g_ptr_array_set_size (waiting, 0);
+}
+
+/* waits for the refines in @waiting to finish, adding the apps whose refine
+ * failed to @retry_list; the references in @waiting are always dropped */
+static gboolean
+gs_plugin_loader_refine_inflight_wait (GsPluginLoader *plugin_loader,
+				       GPtrArray *waiting,
+				       GsAppList *retry_list,
+				       GCancellable *cancellable,
+				       GError **error)
+{
+	g_autoptr(GMutexLocker) locker = NULL;
+	gboolean ret = TRUE;
+	GsPluginLoaderLane lane = GS_PLUGIN_LOADER_LANE_LAST;
+	gboolean released = FALSE;
+
+	if (waiting->len == 0)
+		return TRUE;
+
+	locker = g_mutex_locker_new (&plugin_loader->refine_inflight_mutex);
+	for (guint i = 0; i < waiting->len; i++) {
+		GsPluginLoaderRefineInflight *inflight = g_ptr_array_index (waiting, i);
+
+		/* let another job have our slot while we only wait */
+		if (!inflight->done && !released) {
+			lane = gs_plugin_loader_scheduler_release_slot (plugin_loader);
+			released = TRUE;
+		}
+
+		/* wake up now and again to notice if we were cancelled */
+		while (ret && !inflight->done) {
+			if (g_cancellable_set_error_if_cancelled (cancellable, error)) {
+				ret = FALSE;
+				break;
+			}
+			g_cond_wait_until (&plugin_loader->refine_inflight_cond,
+					   &plugin_loader->refine_inflight_mutex,
+					   g_get_monotonic_time () + G_TIME_SPAN_MILLISECOND * 100);
+		}
+		if (ret && !inflight->success)
+			gs_app_list_add (retry_list, inflight->app);
+		gs_plugin_loader_refine_inflight_unref (inflight);
+	}
+	g_ptr_array_set_size (waiting, 0);
+	gs_plugin_loader_scheduler_reacquire_slot (plugin_loader, lane);
+	return ret;
+}
+
+/* refines @sublist and applies any apps the refine added or removed to @list */
+static gboolean
+gs_plugin_loader_run_refine_sublist (GsPluginLoaderHelper *helper,
+				     GsAppList *list,
+				     GsAppList *sublist,
+				     GCancellable *cancellable,
+				     GError **error)
+{
+	g_autoptr(GsAppList) before = gs_app_list_copy (sublist);
+	g_autoptr(GsPluginLoaderHelper) helper2 = NULL;
+	g_autoptr(GsPluginJob) plugin_job = NULL;
+
+	if (gs_app_list_length (sublist) == 0)
+		return TRUE;
+
+	plugin_job = gs_plugin_job_newv (GS_PLUGIN_ACTION_REFINE,
+					 "list", sublist,
+					 "refine-flags", gs_plugin_job_get_refine_flags (helper->plugin_job),
+					 NULL);
+	helper2 = gs_plugin_loader_helper_new (helper->plugin_loader, plugin_job);
+	helper2->function_name_parent = helper->function_name;
+	if (!gs_plugin_loader_run_refine_internal (helper2, sublist, cancellable, error))
+		return FALSE;
+
+	if (sublist != list) {
+		g_autoptr(GHashTable) after = gs_plugin_loader_app_list_to_set (sublist);
+		g_autoptr(GHashTable) previous = gs_plugin_loader_app_list_to_set (before);
+
+		for (guint i = 0; i < gs_app_list_length (before); i++) {
+			GsApp *app = gs_app_list_index (before, i);
+			if (!g_hash_table_contains (after, app))
+				gs_app_list_remove (list, app);
+		}
+		for (guint i = 0; i < gs_app_list_length (sublist); i++) {
+			GsApp *app = gs_app_list_index (sublist, i);
+			if (!g_hash_table_contains (previous, app))
+				gs_app_list_add (list, app);
+		}
+	}
+	return TRUE;
+}
+
 static gboolean
 gs_plugin_loader_run_refine (GsPluginLoaderHelper *helper,
 			     GsAppList *list,
 			     GCancellable *cancellable,
 			     GError **error)
 {
+	GsPluginLoader *plugin_loader = helper->plugin_loader;
 	gboolean ret;
 	g_autoptr(GsAppList) freeze_list = NULL;
-	g_autoptr(GsPluginLoaderHelper) helper2 = NULL;
-	g_autoptr(GsPluginJob) plugin_job = NULL;
+	g_autoptr(GsAppList) refine_list = NULL;
+	g_autoptr(GsAppList) retry_list = NULL;
+	g_autoptr(GPtrArray) owned = g_ptr_array_new ();
+	g_autoptr(GPtrArray) waiting = g_ptr_array_new ();
 
 	/* nothing to do */
 	if (gs_app_list_length (list) == 0)
@@ -1088,14 +2239,34 @@ gs_plugin_loader_run_refine (GsPluginLoaderHelper *helper,
 		g_object_freeze_notify (G_OBJECT (app));
 	}
 
+	/* skip apps another job is already refining with enough flags */
+	refine_list = gs_plugin_loader_refine_inflight_claim (plugin_loader, list,
+							      gs_plugin_job_get_refine_flags (helper->plugin_job),
+							      owned, waiting);
+	if (waiting->len > 0) {
+		g_debug ("%s reusing %u in-flight refines",
+			 gs_plugin_action_to_string (gs_plugin_job_get_action (helper->plugin_job)),
+			 waiting->len);
+	}
+
 	/* first pass */
-	plugin_job = gs_plugin_job_newv (GS_PLUGIN_ACTION_REFINE,
-					 "list", list,
-					 "refine-flags", gs_plugin_job_get_refine_flags (helper->plugin_job),
-					 NULL);
-	helper2 = gs_plugin_loader_helper_new (helper->plugin_loader, plugin_job);
-	helper2->function_name_parent = helper->function_name;
-	ret = gs_plugin_loader_run_refine_internal (helper2, list, cancellable, error);
+	ret = gs_plugin_loader_run_refine_sublist (helper, list,
+						   waiting->len > 0 ? refine_list : list,
+						   cancellable, error);
+	gs_plugin_loader_refine_inflight_release (plugin_loader, owned, ret);
+
+	/* refine ourselves anything the other job failed to */
+	retry_list = gs_app_list_new ();
+	if (ret) {
+		ret = gs_plugin_loader_refine_inflight_wait (plugin_loader, waiting, retry_list,
+							     cancellable, error);
+	} else {
+		gs_plugin_loader_refine_inflight_drop (plugin_loader, waiting);
+	}
+	if (ret && gs_app_list_length (retry_list) > 0) {
+		ret = gs_plugin_loader_run_refine_sublist (helper, list, retry_list,
+							   cancellable, error);
+	}
 	if (!ret)
 		goto out;
 
@@ -1134,31 +2305,76 @@ out:
 		GsApp *app = gs_app_list_index (freeze_list, i);
 		g_idle_add (app_thaw_notify_idle, g_object_ref (app));
 	}
-	return ret;
+	return ret;
+}
+
+static gboolean
+gs_plugin_loader_job_has_sort (GsPluginJob *plugin_job)
+{
+	return gs_plugin_job_get_sort_key_func (plugin_job, NULL, NULL) != NULL ||
+	       gs_plugin_job_get_sort_func (plugin_job, NULL) != NULL;
+}
+
+/* returns FALSE if the job has nothing to sort by */
+static gboolean
+gs_plugin_loader_job_sort (GsPluginJob *plugin_job, GsAppList *list)
+{
+	GsAppListSortKeyFunc sort_key_func;
+	GsAppListSortFlags sort_key_flags;
+	GsAppListSortFunc sort_func;
+	gpointer sort_func_data;
+
+	sort_key_func = gs_plugin_job_get_sort_key_func (plugin_job, &sort_key_flags, &sort_func_data);
+	if (sort_key_func != NULL) {
+		gs_app_list_sort_by_key (list, sort_key_func, sort_key_flags, sort_func_data);
+		return TRUE;
+	}
+	sort_func = gs_plugin_job_get_sort_func (plugin_job, &sort_func_data);
+	if (sort_func != NULL) {
+		gs_app_list_sort (list, sort_func, sort_func_data);
+		return TRUE;
+	}
+	return FALSE;
 }
 
-static void
-gs_plugin_loader_job_sorted_truncation_again (GsPluginLoaderHelper *helper)
+/* returns FALSE if the job has nothing to sort by */
+static gboolean
+gs_plugin_loader_job_truncate_sorted (GsPluginJob *plugin_job,
+				      GsAppList *list,
+				      guint max_results)
 {
+	GsAppListSortKeyFunc sort_key_func;
+	GsAppListSortFlags sort_key_flags;
 	GsAppListSortFunc sort_func;
 	gpointer sort_func_data;
 
+	sort_key_func = gs_plugin_job_get_sort_key_func (plugin_job, &sort_key_flags, &sort_func_data);
+	if (sort_key_func != NULL) {
+		gs_app_list_truncate_sorted_by_key (list, max_results, sort_key_func,
+						    sort_key_flags, sort_func_data);
+		return TRUE;
+	}
+	sort_func = gs_plugin_job_get_sort_func (plugin_job, &sort_func_data);
+	if (sort_func != NULL) {
+		gs_app_list_truncate_sorted (list, max_results, sort_func, sort_func_data);
+		return TRUE;
+	}
+	return FALSE;
+}
+
+static void
+gs_plugin_loader_job_sorted_truncation_again (GsPluginLoaderHelper *helper)
+{
 	/* not valid */
 	if (gs_plugin_job_get_list (helper->plugin_job) == NULL)
 		return;
 
-	/* unset */
-	sort_func = gs_plugin_job_get_sort_func (helper->plugin_job, &sort_func_data);
-	if (sort_func == NULL)
-		return;
-	gs_app_list_sort (gs_plugin_job_get_list (helper->plugin_job), sort_func, sort_func_data);
+	gs_plugin_loader_job_sort (helper->plugin_job, gs_plugin_job_get_list (helper->plugin_job));
 }
 
 static void
 gs_plugin_loader_job_sorted_truncation (GsPluginLoaderHelper *helper)
 {
-	GsAppListSortFunc sort_func;
-	gpointer sort_func_data;
 	guint max_results;
 	GsAppList *list = gs_plugin_job_get_list (helper->plugin_job);
 
@@ -1178,16 +2394,13 @@ gs_plugin_loader_job_sorted_truncation (GsPluginLoaderHelper *helper)
 	/* nothing set */
 	g_debug ("truncating results to %u from %u",
 		 max_results, gs_app_list_length (list));
-	sort_func = gs_plugin_job_get_sort_func (helper->plugin_job, &sort_func_data);
-	if (sort_func == NULL) {
+	if (!gs_plugin_loader_job_truncate_sorted (helper->plugin_job, list, max_results)) {
 		GsPluginAction action = gs_plugin_job_get_action (helper->plugin_job);
 		g_debug ("no ->sort_func() set for %s, using random!",
 			 gs_plugin_action_to_string (action));
 		gs_app_list_randomize (list);
-	} else {
-		gs_app_list_sort (list, sort_func, sort_func_data);
+		gs_app_list_truncate (list, max_results);
 	}
-	gs_app_list_truncate (list, max_results);
 }
 
 static gboolean
@@ -1197,6 +2410,7 @@ gs_plugin_loader_run_results (GsPluginLoaderHelper *helper,
 {
 	GsPluginLoader *plugin_loader = helper->plugin_loader;
 	GsPluginAction action = gs_plugin_job_get_action (helper->plugin_job);
+	GArray *vfuncs;
 #ifdef HAVE_SYSPROF
 	gint64 begin_time_nsec G_GNUC_UNUSED = SYSPROF_CAPTURE_CURRENT_TIME;
 #endif
@@ -1216,14 +2430,16 @@ gs_plugin_loader_run_results (GsPluginLoaderHelper *helper,
 	}
 #endif
 
-	/* run each plugin */
-	for (guint i = 0; i < plugin_loader->plugins->len; i++) {
-		GsPlugin *plugin = g_ptr_array_index (plugin_loader->plugins, i);
+	/* run each plugin implementing the vfunc */
+	vfuncs = gs_plugin_loader_get_vfuncs (plugin_loader, helper->function_name);
+	for (guint i = 0; vfuncs != NULL && i < vfuncs->len; i++) {
+		GsPluginLoaderVfunc *vfunc = &g_array_index (vfuncs, GsPluginLoaderVfunc, i);
+		GsPlugin *plugin = vfunc->plugin;
 		if (g_cancellable_set_error_if_cancelled (cancellable, error)) {
 			gs_utils_error_convert_gio (error);
 			return FALSE;
 		}
-		if (!gs_plugin_loader_call_vfunc (helper, plugin, NULL, NULL,
+		if (!gs_plugin_loader_call_vfunc (helper, vfunc, NULL, NULL,
 						  GS_PLUGIN_REFINE_FLAGS_DEFAULT,
 						  cancellable, error)) {
 			return FALSE;
@@ -2231,6 +3447,7 @@ static void
 gs_plugin_loader_reload_cb (GsPlugin *plugin,
 			    GsPluginLoader *plugin_loader)
 {
+	gs_plugin_loader_search_cache_invalidate (plugin_loader);
 	if (plugin_loader->reload_id != 0)
 		return;
 	plugin_loader->reload_id =
@@ -2388,6 +3605,7 @@ gs_plugin_loader_plugin_dir_changed_cb (GFileMonitor *monitor,
 void
 gs_plugin_loader_clear_caches (GsPluginLoader *plugin_loader)
 {
+	gs_plugin_loader_search_cache_invalidate (plugin_loader);
 	for (guint i = 0; i < plugin_loader->plugins->len; i++) {
 		GsPlugin *plugin = g_ptr_array_index (plugin_loader->plugins, i);
 		gs_plugin_cache_invalidate (plugin);
@@ -2404,6 +3622,7 @@ gs_plugin_loader_clear_caches (GsPluginLoader *plugin_loader)
 void
 gs_plugin_loader_setup_again (GsPluginLoader *plugin_loader)
 {
+	GArray *vfuncs;
 #ifdef HAVE_SYSPROF
 	gint64 begin_time_nsec G_GNUC_UNUSED = SYSPROF_CAPTURE_CURRENT_TIME;
 #endif
@@ -2414,17 +3633,19 @@ gs_plugin_loader_setup_again (GsPluginLoader *plugin_loader)
 	/* remove any events */
 	gs_plugin_loader_remove_events (plugin_loader);
 
-	for (guint i = 0; i < plugin_loader->plugins->len; i++) {
+	vfuncs = gs_plugin_loader_get_vfuncs (plugin_loader, "gs_plugin_setup");
+	for (guint i = 0; vfuncs != NULL && i < vfuncs->len; i++) {
 		g_autoptr(GError) error_local = NULL;
 		g_autoptr(GsPluginLoaderHelper) helper = NULL;
 		g_autoptr(GsPluginJob) plugin_job = NULL;
-		GsPlugin *plugin = g_ptr_array_index (plugin_loader->plugins, i);
+		GsPluginLoaderVfunc *vfunc = &g_array_index (vfuncs, GsPluginLoaderVfunc, i);
+		GsPlugin *plugin = vfunc->plugin;
 		if (!gs_plugin_get_enabled (plugin))
 			continue;
 
 		plugin_job = gs_plugin_job_newv (GS_PLUGIN_ACTION_SETUP, NULL);
 		helper = gs_plugin_loader_helper_new (plugin_loader, plugin_job);
-		if (!gs_plugin_loader_call_vfunc (helper, plugin, NULL, NULL,
+		if (!gs_plugin_loader_call_vfunc (helper, vfunc, NULL, NULL,
 						  GS_PLUGIN_REFINE_FLAGS_DEFAULT,
 						  NULL, &error_local)) {
 			g_warning ("resetup of %s failed: %s",
@@ -2699,9 +3920,12 @@ gs_plugin_loader_setup (GsPluginLoader *plugin_loader,
 	plugin_job = gs_plugin_job_newv (GS_PLUGIN_ACTION_SETUP, NULL);
 	helper = gs_plugin_loader_helper_new (plugin_loader, plugin_job);
 	for (i = 0; i < plugin_loader->plugins->len; i++) {
+		GsPluginLoaderVfunc vfunc;
 		g_autoptr(GError) error_local = NULL;
 		plugin = g_ptr_array_index (plugin_loader->plugins, i);
-		if (!gs_plugin_loader_call_vfunc (helper, plugin, NULL, NULL,
+		gs_plugin_loader_vfunc_init (&vfunc, plugin, helper->function_name,
+					     GS_PLUGIN_LOADER_VFUNC_KIND_ACTION);
+		if (!gs_plugin_loader_call_vfunc (helper, &vfunc, NULL, NULL,
 						  GS_PLUGIN_REFINE_FLAGS_DEFAULT,
 						  cancellable, &error_local)) {
 			g_debug ("disabling %s as setup failed: %s",
@@ -2711,6 +3935,12 @@ gs_plugin_loader_setup (GsPluginLoader *plugin_loader,
 		}
 	}
 
+	/* the set of enabled plugins is now fixed */
+	gs_plugin_loader_build_vfuncs (plugin_loader);
+
+	/* work out which plugins can refine concurrently */
+	gs_plugin_loader_build_refine_graph (plugin_loader);
+
 	/* now we can load the install-queue */
 	if (!load_install_queue (plugin_loader, error))
 		return FALSE;
@@ -2820,11 +4050,40 @@ gs_plugin_loader_dispose (GObject *object)
 		plugin_loader->network_metered_notify_handler = 0;
 	}
 	if (plugin_loader->queued_ops_pool != NULL) {
-		/* stop accepting more requests and wait until any currently
+		/* stop starting queued jobs and wait until any currently
 		 * running ones are finished */
+		g_mutex_lock (&plugin_loader->scheduler_mutex);
+		plugin_loader->scheduler_stopped = TRUE;
+		g_mutex_unlock (&plugin_loader->scheduler_mutex);
 		g_thread_pool_free (plugin_loader->queued_ops_pool, TRUE, TRUE);
 		plugin_loader->queued_ops_pool = NULL;
 	}
+	for (guint i = 0; i < GS_PLUGIN_LOADER_LANE_LAST; i++) {
+		GsPluginLoaderQueuedTask *queued;
+		while ((queued = g_queue_pop_head (&plugin_loader->lanes[i].queue)) != NULL) {
+			GsPluginLoaderHelper *helper = g_task_get_task_data (queued->task);
+			GsApp *app = gs_plugin_job_get_app (helper->plugin_job);
+			GsPluginAction action = gs_plugin_job_get_action (helper->plugin_job);
+
+			/* the jobs never started, but whoever queued them is
+			 * still waiting for them to finish */
+			if (app != NULL && gs_app_get_pending_action (app) == action)
+				gs_app_set_pending_action (app, GS_PLUGIN_ACTION_UNKNOWN);
+			g_task_return_new_error (queued->task,
+						 G_IO_ERROR,
+						 G_IO_ERROR_CANCELLED,
+						 "The plugin loader was shut down before %s started",
+						 gs_plugin_action_to_string (action));
+			g_object_unref (queued->task);
+			g_slice_free (GsPluginLoaderQueuedTask, queued);
+		}
+	}
+	if (plugin_loader->refine_pool != NULL) {
+		g_thread_pool_free (plugin_loader->refine_pool, FALSE, TRUE);
+		plugin_loader->refine_pool = NULL;
+	}
+	g_clear_pointer (&plugin_loader->refine_graph, g_ptr_array_unref);
+	g_clear_pointer (&plugin_loader->vfuncs, g_hash_table_unref);
 	g_clear_object (&plugin_loader->network_monitor);
 	g_clear_object (&plugin_loader->soup_session);
 	g_clear_object (&plugin_loader->settings);
@@ -2855,6 +4114,14 @@ gs_plugin_loader_finalize (GObject *object)
 	g_mutex_clear (&plugin_loader->pending_apps_mutex);
 	g_mutex_clear (&plugin_loader->events_by_id_mutex);
 
+	g_queue_clear_full (&plugin_loader->search_cache,
+			    (GDestroyNotify) gs_plugin_loader_search_cache_entry_free);
+	g_mutex_clear (&plugin_loader->search_cache_mutex);
+	g_mutex_clear (&plugin_loader->scheduler_mutex);
+	g_hash_table_unref (plugin_loader->refine_inflight);
+	g_cond_clear (&plugin_loader->refine_inflight_cond);
+	g_mutex_clear (&plugin_loader->refine_inflight_mutex);
+
 	G_OBJECT_CLASS (gs_plugin_loader_parent_class)->finalize (object);
 }
 
@@ -2973,11 +4240,24 @@ gs_plugin_loader_init (GsPluginLoader *plugin_loader)
 	plugin_loader->scale = 1;
 	plugin_loader->plugins = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	plugin_loader->pending_apps = g_ptr_array_new_with_free_func ((GFreeFunc) g_object_unref);
-	plugin_loader->queued_ops_pool = g_thread_pool_new (gs_plugin_loader_process_in_thread_pool_cb,
-						   NULL,
-						   get_max_parallel_ops (),
+	for (i = 0; i < GS_PLUGIN_LOADER_LANE_LAST; i++)
+		g_queue_init (&plugin_loader->lanes[i].queue);
+	plugin_loader->max_exclusive_running = (guint) get_max_parallel_ops ();
+	plugin_loader->lanes[GS_PLUGIN_LOADER_LANE_BACKGROUND].max_slots = MAX (GS_PLUGIN_LOADER_BACKGROUND_SLOTS,
+										plugin_loader->max_exclusive_running);
+
+	/* only the background lane and the installs and updates are limited,
+	 * which the scheduler does itself */
+	plugin_loader->queued_ops_pool = g_thread_pool_new (gs_plugin_loader_scheduler_worker_cb,
+						   plugin_loader,
+						   -1,
 						   FALSE,
 						   NULL);
+	plugin_loader->refine_pool = g_thread_pool_new (gs_plugin_loader_refine_thread_cb,
+							NULL,
+							GS_PLUGIN_LOADER_REFINE_MAX_THREADS,
+							FALSE,
+							NULL);
 	plugin_loader->file_monitors = g_ptr_array_new_with_free_func ((GFreeFunc) g_object_unref);
 	plugin_loader->locations = g_ptr_array_new_with_free_func (g_free);
 	plugin_loader->settings = g_settings_new ("org.gnome.software");
@@ -2989,8 +4269,11 @@ gs_plugin_loader_init (GsPluginLoader *plugin_loader)
 							     (GDestroyNotify) g_object_unref);
 
 	/* share a soup session (also disable the double-compression) */
+	/* icons and reviews are fetched several at a time from the same
+	 * server, so allow more than the default two connections per host */
 	plugin_loader->soup_session = soup_session_new_with_options ("user-agent", gs_user_agent (),
 								     "timeout", 10,
+								     "max-conns-per-host", 8,
 								     NULL);
 
 	/* get the category manager */
@@ -3049,6 +4332,12 @@ gs_plugin_loader_init (GsPluginLoader *plugin_loader)
 
 	g_mutex_init (&plugin_loader->pending_apps_mutex);
 	g_mutex_init (&plugin_loader->events_by_id_mutex);
+	g_mutex_init (&plugin_loader->search_cache_mutex);
+	g_mutex_init (&plugin_loader->scheduler_mutex);
+	g_queue_init (&plugin_loader->search_cache);
+	g_mutex_init (&plugin_loader->refine_inflight_mutex);
+	g_cond_init (&plugin_loader->refine_inflight_cond);
+	plugin_loader->refine_inflight = g_hash_table_new (g_str_hash, g_str_equal);
 
 	/* monitor the network as the many UI operations need the network */
 	gs_plugin_loader_monitor_network (plugin_loader);
@@ -3224,18 +4513,20 @@ gs_plugin_loader_generic_update (GsPluginLoader *plugin_loader,
 {
 	guint cancel_handler_id = 0;
 	GsAppList *list;
+	GArray *vfuncs;
 
 	/* run each plugin, per-app version */
 	list = gs_plugin_job_get_list (helper->plugin_job);
-	for (guint i = 0; i < plugin_loader->plugins->len; i++) {
-		GsPluginActionFunc plugin_app_func = NULL;
-		GsPlugin *plugin = g_ptr_array_index (plugin_loader->plugins, i);
+	vfuncs = gs_plugin_loader_get_vfuncs (plugin_loader, helper->function_name);
+	for (guint i = 0; vfuncs != NULL && i < vfuncs->len; i++) {
+		GsPluginLoaderVfunc *vfunc = &g_array_index (vfuncs, GsPluginLoaderVfunc, i);
+		GsPluginActionFunc plugin_app_func = vfunc->func;
+		GsPlugin *plugin = vfunc->plugin;
 		if (g_cancellable_set_error_if_cancelled (cancellable, error)) {
 			gs_utils_error_convert_gio (error);
 			return FALSE;
 		}
-		plugin_app_func = gs_plugin_get_symbol (plugin, helper->function_name);
-		if (plugin_app_func == NULL)
+		if (!gs_plugin_get_enabled (plugin))
 			continue;
 
 		/* for each app */
@@ -3298,8 +4589,9 @@ gs_plugin_loader_process_thread_cb (GTask *task,
 	GsPluginRefineFlags filter_flags;
 	GsPluginRefineFlags refine_flags;
 	gboolean add_to_pending_array = FALSE;
+	gboolean invalidate_search_cache = FALSE;
+	guint search_cache_generation = 0;
 	guint max_results;
-	GsAppListSortFunc sort_func;
 	g_autoptr(GMainContext) context = g_main_context_new ();
 	g_autoptr(GMainContextPusher) pusher = g_main_context_pusher_new (context);
 #ifdef HAVE_SYSPROF
@@ -3320,18 +4612,55 @@ gs_plugin_loader_process_thread_cb (GTask *task,
 	if (add_to_pending_array)
 		gs_plugin_loader_pending_apps_add (plugin_loader, helper);
 
+	/* anything searched from now on might have changed */
+	switch (action) {
+	case GS_PLUGIN_ACTION_INSTALL:
+	case GS_PLUGIN_ACTION_REMOVE:
+	case GS_PLUGIN_ACTION_UPDATE:
+	case GS_PLUGIN_ACTION_REFRESH:
+	case GS_PLUGIN_ACTION_INSTALL_REPO:
+	case GS_PLUGIN_ACTION_REMOVE_REPO:
+	case GS_PLUGIN_ACTION_ENABLE_REPO:
+	case GS_PLUGIN_ACTION_DISABLE_REPO:
+		invalidate_search_cache = TRUE;
+		gs_plugin_loader_search_cache_invalidate (plugin_loader);
+		break;
+	case GS_PLUGIN_ACTION_SEARCH:
+		search_cache_generation = gs_plugin_loader_search_cache_get_generation (plugin_loader);
+		break;
+	default:
+		break;
+	}
+
+	/* narrow a recent search in memory if possible */
+	if (action == GS_PLUGIN_ACTION_SEARCH &&
+	    gs_plugin_loader_search_cache_lookup (plugin_loader, helper->tokens,
+						  list, search_cache_generation)) {
+		helper->anything_ran = TRUE;
+
 	/* run each plugin */
-	if (action != GS_PLUGIN_ACTION_REFINE) {
+	} else if (action != GS_PLUGIN_ACTION_REFINE) {
 		if (!gs_plugin_loader_run_results (helper, cancellable, &error)) {
 			if (add_to_pending_array) {
 				gs_app_set_state_recover (gs_plugin_job_get_app (helper->plugin_job));
 				gs_plugin_loader_pending_apps_remove (plugin_loader, helper);
 			}
+			if (invalidate_search_cache)
+				gs_plugin_loader_search_cache_invalidate (plugin_loader);
 			gs_utils_error_convert_gio (&error);
 			g_task_return_error (task, error);
 			return;
 		}
 
+		/* save the unfiltered results for narrower searches */
+		if (action == GS_PLUGIN_ACTION_SEARCH &&
+		    !helper->plugin_failed &&
+		    !g_cancellable_is_cancelled (cancellable)) {
+			gs_plugin_loader_search_cache_add (plugin_loader, helper->tokens,
+							   list, g_get_monotonic_time (),
+							   search_cache_generation);
+		}
+
 		if (action == GS_PLUGIN_ACTION_URL_TO_APP) {
 			const gchar *search = gs_plugin_job_get_search (helper->plugin_job);
 			if (search && g_ascii_strncasecmp (search, "file://", 7) == 0 && (
@@ -3384,6 +4713,10 @@ gs_plugin_loader_process_thread_cb (GTask *task,
 	if (add_to_pending_array)
 		gs_plugin_loader_pending_apps_remove (plugin_loader, helper);
 
+	/* drop anything searched while this was running */
+	if (invalidate_search_cache)
+		gs_plugin_loader_search_cache_invalidate (plugin_loader);
+
 	/* some functions are really required for proper operation */
 	switch (action) {
 	case GS_PLUGIN_ACTION_GET_INSTALLED:
@@ -3435,8 +4768,8 @@ gs_plugin_loader_process_thread_cb (GTask *task,
 	 * gs_plugin_loader_job_sorted_truncation() can do what it needs */
 	filter_flags = gs_plugin_job_get_filter_flags (helper->plugin_job);
 	max_results = gs_plugin_job_get_max_results (helper->plugin_job);
-	sort_func = gs_plugin_job_get_sort_func (helper->plugin_job, NULL);
-	if (filter_flags > 0 && max_results > 0 && sort_func != NULL) {
+	if (filter_flags > 0 && max_results > 0 &&
+	    gs_plugin_loader_job_has_sort (helper->plugin_job)) {
 		g_autoptr(GsPluginLoaderHelper) helper2 = NULL;
 		g_autoptr(GsPluginJob) plugin_job = NULL;
 		plugin_job = gs_plugin_job_newv (GS_PLUGIN_ACTION_REFINE,
@@ -3637,10 +4970,8 @@ gs_plugin_loader_process_thread_cb (GTask *task,
 }
 
 static void
-gs_plugin_loader_process_in_thread_pool_cb (gpointer data,
-					    gpointer user_data)
+gs_plugin_loader_run_task (GTask *task)
 {
-	GTask *task = data;
 	gpointer source_object = g_task_get_source_object (task);
 	gpointer task_data = g_task_get_task_data (task);
 	GCancellable *cancellable = g_task_get_cancellable (task);
@@ -3659,6 +4990,211 @@ gs_plugin_loader_process_in_thread_pool_cb (gpointer data,
 	g_object_unref (task);
 }
 
+static const gchar *
+gs_plugin_loader_lane_to_string (GsPluginLoaderLane lane)
+{
+	if (lane == GS_PLUGIN_LOADER_LANE_INTERACTIVE)
+		return "interactive";
+	if (lane == GS_PLUGIN_LOADER_LANE_BACKGROUND)
+		return "background";
+	return NULL;
+}
+
+static gboolean
+gs_plugin_loader_action_is_exclusive (GsPluginAction action)
+{
+	switch (action) {
+	case GS_PLUGIN_ACTION_INSTALL:
+	case GS_PLUGIN_ACTION_INSTALL_REPO:
+	case GS_PLUGIN_ACTION_UPDATE:
+	case GS_PLUGIN_ACTION_UPGRADE_DOWNLOAD:
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+static GsPluginLoaderLane
+gs_plugin_loader_job_get_lane (GsPluginJob *plugin_job)
+{
+	if (gs_plugin_job_get_interactive (plugin_job))
+		return GS_PLUGIN_LOADER_LANE_INTERACTIVE;
+
+	/* things the update monitor and the automatic updates do, or which
+	 * change the system without the user waiting on them */
+	switch (gs_plugin_job_get_action (plugin_job)) {
+	case GS_PLUGIN_ACTION_INSTALL:
+	case GS_PLUGIN_ACTION_REMOVE:
+	case GS_PLUGIN_ACTION_UPDATE:
+	case GS_PLUGIN_ACTION_DOWNLOAD:
+	case GS_PLUGIN_ACTION_REFRESH:
+	case GS_PLUGIN_ACTION_GET_UPDATES:
+	case GS_PLUGIN_ACTION_GET_DISTRO_UPDATES:
+	case GS_PLUGIN_ACTION_UPGRADE_DOWNLOAD:
+	case GS_PLUGIN_ACTION_UPGRADE_TRIGGER:
+	case GS_PLUGIN_ACTION_INSTALL_REPO:
+	case GS_PLUGIN_ACTION_REMOVE_REPO:
+	case GS_PLUGIN_ACTION_ENABLE_REPO:
+	case GS_PLUGIN_ACTION_DISABLE_REPO:
+		return GS_PLUGIN_LOADER_LANE_BACKGROUND;
+	default:
+		return GS_PLUGIN_LOADER_LANE_INTERACTIVE;
+	}
+}
+
+/* called with the scheduler mutex held */
+static GsPluginLoaderQueuedTask *
+gs_plugin_loader_scheduler_pop_lane (GsPluginLoader *plugin_loader,
+				     GsPluginLoaderLane lane)
+{
+	GsPluginLoaderLaneState *state = &plugin_loader->lanes[lane];
+
+	/* interactive jobs are never held back by other interactive jobs,
+	 * the user is waiting on all of them */
+	if (state->max_slots > 0 && state->slots_used >= state->max_slots)
+		return NULL;
+
+	for (GList *l = state->queue.head; l != NULL; l = l->next) {
+		GsPluginLoaderQueuedTask *queued = l->data;
+
+		/* installs and updates are also limited across both lanes */
+		if (queued->exclusive &&
+		    plugin_loader->n_exclusive_running >= plugin_loader->max_exclusive_running)
+			continue;
+
+		g_queue_delete_link (&state->queue, l);
+		return queued;
+	}
+	return NULL;
+}
+
+/* called with the scheduler mutex held */
+static GsPluginLoaderQueuedTask *
+gs_plugin_loader_scheduler_pop (GsPluginLoader *plugin_loader)
+{
+	GsPluginLoaderLaneState *background = &plugin_loader->lanes[GS_PLUGIN_LOADER_LANE_BACKGROUND];
+	GsPluginLoaderQueuedTask *queued = NULL;
+	gint64 now = g_get_monotonic_time ();
+
+	if (plugin_loader->scheduler_stopped)
+		return NULL;
+
+	/* background jobs which have waited too long go first, so they get
+	 * a turn at the installs and updates limit */
+	if (!g_queue_is_empty (&background->queue)) {
+		GsPluginLoaderQueuedTask *head = g_queue_peek_head (&background->queue);
+		if (now - head->queued > GS_PLUGIN_LOADER_SCHEDULER_AGING * G_USEC_PER_SEC)
+			queued = gs_plugin_loader_scheduler_pop_lane (plugin_loader,
+								      GS_PLUGIN_LOADER_LANE_BACKGROUND);
+	}
+	if (queued == NULL)
+		queued = gs_plugin_loader_scheduler_pop_lane (plugin_loader,
+							      GS_PLUGIN_LOADER_LANE_INTERACTIVE);
+	if (queued == NULL)
+		queued = gs_plugin_loader_scheduler_pop_lane (plugin_loader,
+							      GS_PLUGIN_LOADER_LANE_BACKGROUND);
+	if (queued == NULL)
+		return NULL;
+
+	/* account for the job */
+	plugin_loader->lanes[queued->lane].slots_used++;
+	plugin_loader->lanes[queued->lane].n_running++;
+	if (queued->exclusive)
+		plugin_loader->n_exclusive_running++;
+	return queued;
+}
+
+static void
+gs_plugin_loader_scheduler_worker_cb (gpointer data, gpointer user_data)
+{
+	GsPluginLoader *plugin_loader = GS_PLUGIN_LOADER (user_data);
+
+	/* keep running jobs until there is nothing this worker can start */
+	for (;;) {
+		GsPluginLoaderQueuedTask *queued;
+		GsPluginLoaderLane lane;
+		gboolean exclusive;
+		guint64 waited;
+
+		g_mutex_lock (&plugin_loader->scheduler_mutex);
+		queued = gs_plugin_loader_scheduler_pop (plugin_loader);
+		if (queued == NULL) {
+			g_mutex_unlock (&plugin_loader->scheduler_mutex);
+			break;
+		}
+		lane = queued->lane;
+		exclusive = queued->exclusive;
+		waited = (guint64) (g_get_monotonic_time () - queued->queued);
+		plugin_loader->lanes[lane].n_started++;
+		plugin_loader->lanes[lane].wait_total += waited;
+		plugin_loader->lanes[lane].wait_max = MAX (plugin_loader->lanes[lane].wait_max, waited);
+		g_debug ("starting %s job after %.1fms, %u still queued",
+			 gs_plugin_loader_lane_to_string (lane),
+			 (gdouble) waited / 1000,
+			 g_queue_get_length (&plugin_loader->lanes[lane].queue));
+		g_mutex_unlock (&plugin_loader->scheduler_mutex);
+
+		g_private_set (&scheduler_lane_private, GUINT_TO_POINTER (lane + 1));
+		gs_plugin_loader_run_task (queued->task);
+		g_private_set (&scheduler_lane_private, NULL);
+		g_slice_free (GsPluginLoaderQueuedTask, queued);
+
+		g_mutex_lock (&plugin_loader->scheduler_mutex);
+		plugin_loader->lanes[lane].slots_used--;
+		plugin_loader->lanes[lane].n_running--;
+		if (exclusive)
+			plugin_loader->n_exclusive_running--;
+		g_mutex_unlock (&plugin_loader->scheduler_mutex);
+	}
+}
+
+static void
+gs_plugin_loader_scheduler_kick (GsPluginLoader *plugin_loader)
+{
+	/* the worker checks what can run, so the data is unused */
+	g_thread_pool_push (plugin_loader->queued_ops_pool, GUINT_TO_POINTER (1), NULL);
+}
+
+/* gives up the slot of the job running in this thread while it waits on
+ * another job, returning the lane to pass to
+ * gs_plugin_loader_scheduler_reacquire_slot(), or %GS_PLUGIN_LOADER_LANE_LAST
+ * if the thread is not running a scheduled job */
+static GsPluginLoaderLane
+gs_plugin_loader_scheduler_release_slot (GsPluginLoader *plugin_loader)
+{
+	guint lane = GPOINTER_TO_UINT (g_private_get (&scheduler_lane_private));
+	gboolean stopped;
+
+	if (lane == 0)
+		return GS_PLUGIN_LOADER_LANE_LAST;
+	g_private_set (&scheduler_lane_private, NULL);
+
+	g_mutex_lock (&plugin_loader->scheduler_mutex);
+	plugin_loader->lanes[lane - 1].slots_used--;
+	stopped = plugin_loader->scheduler_stopped;
+	g_mutex_unlock (&plugin_loader->scheduler_mutex);
+
+	/* a queued job may be able to run now */
+	if (!stopped)
+		gs_plugin_loader_scheduler_kick (plugin_loader);
+	return (GsPluginLoaderLane) (lane - 1);
+}
+
+/* takes the slot back even if that puts the lane over its limit for a bit,
+ * as the job is already part-way through and holds no other resources */
+static void
+gs_plugin_loader_scheduler_reacquire_slot (GsPluginLoader *plugin_loader,
+					   GsPluginLoaderLane lane)
+{
+	if (lane == GS_PLUGIN_LOADER_LANE_LAST)
+		return;
+
+	g_mutex_lock (&plugin_loader->scheduler_mutex);
+	plugin_loader->lanes[lane].slots_used++;
+	g_mutex_unlock (&plugin_loader->scheduler_mutex);
+	g_private_set (&scheduler_lane_private, GUINT_TO_POINTER (lane + 1));
+}
+
 static gboolean
 gs_plugin_loader_job_timeout_cb (gpointer user_data)
 {
@@ -3691,12 +5227,25 @@ gs_plugin_loader_schedule_task (GsPluginLoader *plugin_loader,
 	GsPluginLoaderHelper *helper = g_task_get_task_data (task);
 	GsApp *app = gs_plugin_job_get_app (helper->plugin_job);
 
-	if (app != NULL) {
+	GsPluginAction action = gs_plugin_job_get_action (helper->plugin_job);
+	GsPluginLoaderQueuedTask *queued;
+
+	if (app != NULL && gs_plugin_loader_action_is_exclusive (action)) {
 		/* set the pending-action to the app */
-		GsPluginAction action = gs_plugin_job_get_action (helper->plugin_job);
 		gs_app_set_pending_action (app, action);
 	}
-	g_thread_pool_push (plugin_loader->queued_ops_pool, g_object_ref (task), NULL);
+
+	queued = g_slice_new0 (GsPluginLoaderQueuedTask);
+	queued->task = g_object_ref (task);
+	queued->lane = gs_plugin_loader_job_get_lane (helper->plugin_job);
+	queued->exclusive = gs_plugin_loader_action_is_exclusive (action);
+	queued->queued = g_get_monotonic_time ();
+
+	g_mutex_lock (&plugin_loader->scheduler_mutex);
+	g_queue_push_tail (&plugin_loader->lanes[queued->lane].queue, queued);
+	g_mutex_unlock (&plugin_loader->scheduler_mutex);
+
+	gs_plugin_loader_scheduler_kick (plugin_loader);
 }
 
 /**
@@ -3826,31 +5375,32 @@ gs_plugin_loader_job_process_async (GsPluginLoader *plugin_loader,
 	/* sorting fallbacks */
 	switch (action) {
 	case GS_PLUGIN_ACTION_SEARCH:
-		if (gs_plugin_job_get_sort_func (plugin_job, NULL) == NULL) {
+		if (!gs_plugin_loader_job_has_sort (plugin_job)) {
 			gs_plugin_job_set_sort_func (plugin_job,
 						     gs_plugin_loader_app_sort_match_value_cb, NULL);
 		}
 		break;
 	case GS_PLUGIN_ACTION_GET_RECENT:
-		if (gs_plugin_job_get_sort_func (plugin_job, NULL) == NULL) {
+		if (!gs_plugin_loader_job_has_sort (plugin_job)) {
 			gs_plugin_job_set_sort_func (plugin_job,
 						     gs_plugin_loader_app_sort_kind_cb, NULL);
 		}
 		break;
 	case GS_PLUGIN_ACTION_GET_CATEGORY_APPS:
-		if (gs_plugin_job_get_sort_func (plugin_job, NULL) == NULL) {
-			gs_plugin_job_set_sort_func (plugin_job,
-						     gs_plugin_loader_app_sort_name_cb, NULL);
+		if (!gs_plugin_loader_job_has_sort (plugin_job)) {
+			gs_plugin_job_set_sort_key_func (plugin_job,
+							 gs_plugin_loader_app_sort_name_key_cb,
+							 GS_APP_LIST_SORT_FLAG_NONE, NULL);
 		}
 		break;
 	case GS_PLUGIN_ACTION_GET_ALTERNATES:
-		if (gs_plugin_job_get_sort_func (plugin_job, NULL) == NULL) {
+		if (!gs_plugin_loader_job_has_sort (plugin_job)) {
 			gs_plugin_job_set_sort_func (plugin_job,
 						     gs_plugin_loader_app_sort_prio_cb, NULL);
 		}
 		break;
 	case GS_PLUGIN_ACTION_GET_DISTRO_UPDATES:
-		if (gs_plugin_job_get_sort_func (plugin_job, NULL) == NULL) {
+		if (!gs_plugin_loader_job_has_sort (plugin_job)) {
 			gs_plugin_job_set_sort_func (plugin_job,
 						     gs_plugin_loader_app_sort_version_cb, NULL);
 		}
@@ -3917,21 +5467,11 @@ gs_plugin_loader_job_process_async (GsPluginLoader *plugin_loader,
 		break;
 	}
 
-	switch (action) {
-	case GS_PLUGIN_ACTION_INSTALL:
-	case GS_PLUGIN_ACTION_INSTALL_REPO:
-	case GS_PLUGIN_ACTION_UPDATE:
-	case GS_PLUGIN_ACTION_UPGRADE_DOWNLOAD:
-		/* these actions must be performed by the thread pool because we
-		 * want to limit the number of them running in parallel */
-		gs_plugin_loader_schedule_task (plugin_loader, task);
-		return;
-	default:
-		break;
-	}
-
-	/* run in a thread */
-	g_task_run_in_thread (task, gs_plugin_loader_process_thread_cb);
+	/* run in a thread, straight away for interactive jobs and once the
+	 * background lane has a slot for anything else; installs, updates and
+	 * upgrade downloads are also limited in how many of them run in
+	 * parallel */
+	gs_plugin_loader_schedule_task (plugin_loader, task);
 }
 
 /******************************************************************************/
@@ -3947,6 +5487,18 @@ gboolean
 gs_plugin_loader_get_plugin_supported (GsPluginLoader *plugin_loader,
 				       const gchar *function_name)
 {
+	GArray *vfuncs = gs_plugin_loader_get_vfuncs (plugin_loader, function_name);
+
+	/* resolved when the plugins were set up */
+	if (vfuncs != NULL) {
+		for (guint i = 0; i < vfuncs->len; i++) {
+			GsPluginLoaderVfunc *vfunc = &g_array_index (vfuncs, GsPluginLoaderVfunc, i);
+			if (gs_plugin_get_enabled (vfunc->plugin))
+				return TRUE;
+		}
+		return FALSE;
+	}
+
 	for (guint i = 0; i < plugin_loader->plugins->len; i++) {
 		GsPlugin *plugin = g_ptr_array_index (plugin_loader->plugins, i);
 		if (gs_plugin_get_symbol (plugin, function_name) != NULL)
@@ -4156,17 +5708,68 @@ gs_plugin_loader_get_odrs_provider (GsPluginLoader *plugin_loader)
  *
  * Sets the number of maximum number of queued operations (install/update/upgrade-download)
  * to be processed at a time. If @max_ops is 0, then it will set the default maximum number.
+ *
+ * The background lane gets at least as many slots as this, so these operations
+ * do not have to wait for other background jobs.
  */
 void
 gs_plugin_loader_set_max_parallel_ops (GsPluginLoader *plugin_loader,
 				       guint max_ops)
 {
-	g_autoptr(GError) error = NULL;
 	if (max_ops == 0)
 		max_ops = get_max_parallel_ops ();
-	if (!g_thread_pool_set_max_threads (plugin_loader->queued_ops_pool, max_ops, &error))
-		g_warning ("Failed to set the maximum number of ops in parallel: %s",
-			   error->message);
+
+	g_mutex_lock (&plugin_loader->scheduler_mutex);
+	plugin_loader->max_exclusive_running = max_ops;
+	plugin_loader->lanes[GS_PLUGIN_LOADER_LANE_BACKGROUND].max_slots = MAX (GS_PLUGIN_LOADER_BACKGROUND_SLOTS, max_ops);
+	g_mutex_unlock (&plugin_loader->scheduler_mutex);
+
+	/* more jobs may be able to run now */
+	gs_plugin_loader_scheduler_kick (plugin_loader);
+}
+
+/**
+ * gs_plugin_loader_get_queue_stats:
+ * @plugin_loader: a #GsPluginLoader
+ * @interactive: %TRUE for the interactive lane, %FALSE for the background lane
+ * @n_queued: (out) (optional): return location for the number of waiting jobs
+ * @n_running: (out) (optional): return location for the number of running jobs
+ * @wait_avg_usec: (out) (optional): return location for the average time
+ *   jobs waited before being started, in microseconds
+ * @wait_max_usec: (out) (optional): return location for the longest time
+ *   a job waited before being started, in microseconds
+ *
+ * Gets statistics about one of the lanes jobs are scheduled in. Jobs which
+ * are interactive, or which the user is waiting on such as searches and
+ * details, go in the interactive lane; refreshes, updates and other
+ * modifications not requested interactively go in the background lane.
+ *
+ * Since: 42
+ */
+void
+gs_plugin_loader_get_queue_stats (GsPluginLoader *plugin_loader,
+				  gboolean interactive,
+				  guint *n_queued,
+				  guint *n_running,
+				  guint64 *wait_avg_usec,
+				  guint64 *wait_max_usec)
+{
+	GsPluginLoaderLaneState *state;
+	g_autoptr(GMutexLocker) locker = NULL;
+
+	g_return_if_fail (GS_IS_PLUGIN_LOADER (plugin_loader));
+
+	locker = g_mutex_locker_new (&plugin_loader->scheduler_mutex);
+	state = &plugin_loader->lanes[interactive ? GS_PLUGIN_LOADER_LANE_INTERACTIVE :
+						    GS_PLUGIN_LOADER_LANE_BACKGROUND];
+	if (n_queued != NULL)
+		*n_queued = g_queue_get_length (&state->queue);
+	if (n_running != NULL)
+		*n_running = state->n_running;
+	if (wait_avg_usec != NULL)
+		*wait_avg_usec = state->n_started > 0 ? state->wait_total / state->n_started : 0;
+	if (wait_max_usec != NULL)
+		*wait_max_usec = state->wait_max;
 }
 
 /**
@@ -4185,3 +5788,338 @@ gs_plugin_loader_get_category_manager (GsPluginLoader *plugin_loader)
 
 	return plugin_loader->category_manager;
 }
+
+/* version, language, and a dictionary for each app */
+#define GS_PLUGIN_LOADER_SNAPSHOT_FORMAT	"(usaa{sv})"
+#define GS_PLUGIN_LOADER_SNAPSHOT_VERSION	2
+
+static gchar *
+gs_plugin_loader_get_snapshot_filename (const gchar *name, GError **error)
+{
+	g_autofree gchar *basename = g_strdup_printf ("%s.gvariant", name);
+	return gs_utils_get_cache_filename ("snapshot",
+					    basename,
+					    GS_UTILS_CACHE_FLAG_WRITEABLE |
+					    GS_UTILS_CACHE_FLAG_CREATE_DIRECTORY,
+					    error);
+}
+
+static void
+gs_plugin_loader_snapshot_add_string (GVariantBuilder *builder,
+				      const gchar *key,
+				      const gchar *value)
+{
+	if (value != NULL)
+		g_variant_builder_add (builder, "{sv}", key, g_variant_new_string (value));
+}
+
+static GVariant *
+gs_plugin_loader_app_to_snapshot (GsApp *app)
+{
+	GVariantBuilder builder;
+	GPtrArray *icons = gs_app_get_icons (app);
+	GArray *key_colors = gs_app_peek_key_colors (app);
+	const gchar *css_keys[] = { "GnomeSoftware::FeatureTile-css",
+				    "GnomeSoftware::FeatureTile-css-rtl",
+				    NULL };
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+	gs_plugin_loader_snapshot_add_string (&builder, "id", gs_app_get_id (app));
+	g_variant_builder_add (&builder, "{sv}", "kind", g_variant_new_uint32 (gs_app_get_kind (app)));
+	g_variant_builder_add (&builder, "{sv}", "scope", g_variant_new_uint32 (gs_app_get_scope (app)));
+	g_variant_builder_add (&builder, "{sv}", "bundle-kind", g_variant_new_uint32 (gs_app_get_bundle_kind (app)));
+	g_variant_builder_add (&builder, "{sv}", "state", g_variant_new_uint32 (gs_app_get_state (app)));
+	g_variant_builder_add (&builder, "{sv}", "rating", g_variant_new_int32 (gs_app_get_rating (app)));
+	gs_plugin_loader_snapshot_add_string (&builder, "origin", gs_app_get_origin (app));
+	gs_plugin_loader_snapshot_add_string (&builder, "branch", gs_app_get_branch (app));
+	gs_plugin_loader_snapshot_add_string (&builder, "name", gs_app_get_name (app));
+	gs_plugin_loader_snapshot_add_string (&builder, "summary", gs_app_get_summary (app));
+	for (guint i = 0; css_keys[i] != NULL; i++)
+		gs_plugin_loader_snapshot_add_string (&builder, css_keys[i], gs_app_get_metadata_item (app, css_keys[i]));
+
+	/* only icons which can be loaded again without the plugins */
+	if (icons != NULL) {
+		GVariantBuilder builder_icons;
+		g_variant_builder_init (&builder_icons, G_VARIANT_TYPE ("a(vuuu)"));
+		for (guint i = 0; i < icons->len; i++) {
+			GIcon *icon = g_ptr_array_index (icons, i);
+			g_autoptr(GVariant) serialized = NULL;
+
+			/* a #GsRemoteIcon would serialize as its cache file,
+			 * which is not written when the icon pack is used */
+			if (GS_IS_REMOTE_ICON (icon))
+				serialized = g_variant_ref_sink (g_variant_new ("(sv)", "gs-remote-icon",
+										g_variant_new_string (gs_remote_icon_get_uri (GS_REMOTE_ICON (icon)))));
+			else
+				serialized = g_icon_serialize (icon);
+			if (serialized == NULL)
+				continue;
+			g_variant_builder_add (&builder_icons, "(vuuu)",
+					       serialized,
+					       gs_icon_get_width (icon),
+					       gs_icon_get_height (icon),
+					       gs_icon_get_scale (icon));
+		}
+		g_variant_builder_add (&builder, "{sv}", "icons", g_variant_builder_end (&builder_icons));
+	}
+
+	/* saves calculating these from the icon again */
+	if (key_colors != NULL && key_colors->len > 0) {
+		GVariantBuilder builder_colors;
+		g_variant_builder_init (&builder_colors, G_VARIANT_TYPE ("a(dddd)"));
+		for (guint i = 0; i < key_colors->len; i++) {
+			GdkRGBA *color = &g_array_index (key_colors, GdkRGBA, i);
+			g_variant_builder_add (&builder_colors, "(dddd)",
+					       (gdouble) color->red, (gdouble) color->green,
+					       (gdouble) color->blue, (gdouble) color->alpha);
+		}
+		g_variant_builder_add (&builder, "{sv}", "key-colors", g_variant_builder_end (&builder_colors));
+	}
+
+	return g_variant_builder_end (&builder);
+}
+
+static GsApp *
+gs_plugin_loader_app_from_snapshot (GVariant *dict)
+{
+	const gchar *tmp;
+	guint32 value;
+	gint32 rating;
+	GVariant *icons;
+	GVariant *key_colors;
+	g_autoptr(GsApp) app = NULL;
+	const gchar *css_keys[] = { "GnomeSoftware::FeatureTile-css",
+				    "GnomeSoftware::FeatureTile-css-rtl",
+				    NULL };
+
+	if (!g_variant_lookup (dict, "id", "&s", &tmp))
+		return NULL;
+	app = gs_app_new (tmp);
+	if (g_variant_lookup (dict, "kind", "u", &value))
+		gs_app_set_kind (app, value);
+	if (g_variant_lookup (dict, "scope", "u", &value))
+		gs_app_set_scope (app, value);
+	if (g_variant_lookup (dict, "bundle-kind", "u", &value))
+		gs_app_set_bundle_kind (app, value);
+	if (g_variant_lookup (dict, "origin", "&s", &tmp))
+		gs_app_set_origin (app, tmp);
+	if (g_variant_lookup (dict, "branch", "&s", &tmp))
+		gs_app_set_branch (app, tmp);
+	if (g_variant_lookup (dict, "name", "&s", &tmp))
+		gs_app_set_name (app, GS_APP_QUALITY_NORMAL, tmp);
+	if (g_variant_lookup (dict, "summary", "&s", &tmp))
+		gs_app_set_summary (app, GS_APP_QUALITY_NORMAL, tmp);
+	if (g_variant_lookup (dict, "rating", "i", &rating))
+		gs_app_set_rating (app, rating);
+
+	/* an install or removal in progress last time is not any more */
+	if (g_variant_lookup (dict, "state", "u", &value) &&
+	    (value == GS_APP_STATE_INSTALLED ||
+	     value == GS_APP_STATE_AVAILABLE ||
+	     value == GS_APP_STATE_UPDATABLE ||
+	     value == GS_APP_STATE_UPDATABLE_LIVE))
+		gs_app_set_state (app, value);
+
+	for (guint i = 0; css_keys[i] != NULL; i++) {
+		if (g_variant_lookup (dict, css_keys[i], "&s", &tmp))
+			gs_app_set_metadata (app, css_keys[i], tmp);
+	}
+
+	icons = g_variant_lookup_value (dict, "icons", G_VARIANT_TYPE ("a(vuuu)"));
+	if (icons != NULL) {
+		GVariantIter iter;
+		GVariant *serialized;
+		guint32 width, height, scale;
+
+		g_variant_iter_init (&iter, icons);
+		while (g_variant_iter_next (&iter, "(vuuu)", &serialized, &width, &height, &scale)) {
+			g_autoptr(GIcon) icon = NULL;
+
+			/* remote icons are looked up in the icon pack again */
+			if (g_variant_is_of_type (serialized, G_VARIANT_TYPE ("(sv)"))) {
+				const gchar *key = NULL;
+				const gchar *uri = NULL;
+				g_autoptr(GVariant) value = NULL;
+
+				g_variant_get (serialized, "(&sv)", &key, &value);
+				if (g_strcmp0 (key, "gs-remote-icon") == 0 &&
+				    g_variant_is_of_type (value, G_VARIANT_TYPE_STRING))
+					uri = g_variant_get_string (value, NULL);
+				if (uri != NULL &&
+				    (g_str_has_prefix (uri, "http:") || g_str_has_prefix (uri, "https:")))
+					icon = gs_remote_icon_new (uri);
+			}
+			if (icon == NULL)
+				icon = g_icon_deserialize (serialized);
+			g_variant_unref (serialized);
+			if (icon == NULL)
+				continue;
+			gs_icon_set_width (icon, width);
+			gs_icon_set_height (icon, height);
+			gs_icon_set_scale (icon, scale);
+			gs_app_add_icon (app, icon);
+		}
+		g_variant_unref (icons);
+	}
+
+	key_colors = g_variant_lookup_value (dict, "key-colors", G_VARIANT_TYPE ("a(dddd)"));
+	if (key_colors != NULL) {
+		GVariantIter iter;
+		gdouble red, green, blue, alpha;
+		g_autoptr(GArray) colors = g_array_new (FALSE, FALSE, sizeof (GdkRGBA));
+
+		g_variant_iter_init (&iter, key_colors);
+		while (g_variant_iter_next (&iter, "(dddd)", &red, &green, &blue, &alpha)) {
+			GdkRGBA color = { red, green, blue, alpha };
+			g_array_append_val (colors, color);
+		}
+		gs_app_set_key_colors (app, colors);
+		g_variant_unref (key_colors);
+	}
+
+	/* refined by the plugins once they are asked about it; there is no
+	 * management plugin until then, so nothing can be done with it */
+	gs_app_set_metadata (app, "GnomeSoftware::snapshot", "true");
+
+	return g_steal_pointer (&app);
+}
+
+static void
+gs_plugin_loader_save_snapshot_thread_cb (GTask *task,
+					  gpointer source_object,
+					  gpointer task_data,
+					  GCancellable *cancellable)
+{
+	GVariant *root = task_data;
+	g_autofree gchar *filename = NULL;
+	g_autoptr(GError) error_local = NULL;
+
+	filename = gs_plugin_loader_get_snapshot_filename (g_task_get_name (task), &error_local);
+	if (filename == NULL) {
+		g_debug ("failed to get snapshot filename: %s", error_local->message);
+		return;
+	}
+	if (!g_file_set_contents (filename,
+				  g_variant_get_data (root),
+				  (gssize) g_variant_get_size (root),
+				  &error_local)) {
+		g_debug ("failed to save %s: %s", filename, error_local->message);
+		return;
+	}
+	g_debug ("saved snapshot of %" G_GSIZE_FORMAT " bytes to %s",
+		 g_variant_get_size (root), filename);
+}
+
+/**
+ * gs_plugin_loader_save_snapshot:
+ * @plugin_loader: a #GsPluginLoader
+ * @name: a snapshot name, e.g. `overview-featured`
+ * @list: a #GsAppList
+ *
+ * Saves the parts of the apps in @list needed to draw them again before the
+ * plugins have been set up, so the next start can show them immediately.
+ *
+ * The snapshot is written in a worker thread and failures are only logged.
+ *
+ * Since: 42
+ **/
+void
+gs_plugin_loader_save_snapshot (GsPluginLoader *plugin_loader,
+				const gchar *name,
+				GsAppList *list)
+{
+	GVariantBuilder builder;
+	GVariant *root;
+	g_autoptr(GTask) task = NULL;
+
+	g_return_if_fail (GS_IS_PLUGIN_LOADER (plugin_loader));
+	g_return_if_fail (name != NULL);
+	g_return_if_fail (GS_IS_APP_LIST (list));
+
+	/* serialize here so the apps are not accessed from the thread */
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("aa{sv}"));
+	for (guint i = 0; i < gs_app_list_length (list); i++)
+		g_variant_builder_add_value (&builder, gs_plugin_loader_app_to_snapshot (gs_app_list_index (list, i)));
+	root = g_variant_ref_sink (g_variant_new (GS_PLUGIN_LOADER_SNAPSHOT_FORMAT,
+						  (guint32) GS_PLUGIN_LOADER_SNAPSHOT_VERSION,
+						  plugin_loader->language,
+						  &builder));
+
+	task = g_task_new (plugin_loader, NULL, NULL, NULL);
+	g_task_set_source_tag (task, gs_plugin_loader_save_snapshot);
+	g_task_set_name (task, name);
+	g_task_set_task_data (task, root, (GDestroyNotify) g_variant_unref);
+	g_task_run_in_thread (task, gs_plugin_loader_save_snapshot_thread_cb);
+}
+
+/**
+ * gs_plugin_loader_load_snapshot:
+ * @plugin_loader: a #GsPluginLoader
+ * @name: a snapshot name, e.g. `overview-featured`
+ * @error: a #GError, or %NULL
+ *
+ * Loads apps saved with gs_plugin_loader_save_snapshot(). The apps have the
+ * `GnomeSoftware::snapshot` metadata set and no management plugin, and are
+ * only suitable for display until they have been refined by the plugins.
+ *
+ * Snapshots saved by a different version or for a different language are
+ * rejected.
+ *
+ * Returns: (transfer full): a #GsAppList, or %NULL for error
+ *
+ * Since: 42
+ **/
+GsAppList *
+gs_plugin_loader_load_snapshot (GsPluginLoader *plugin_loader,
+				const gchar *name,
+				GError **error)
+{
+	guint32 version = 0;
+	const gchar *language = NULL;
+	GVariant *dict;
+	g_autofree gchar *filename = NULL;
+	g_autoptr(GBytes) bytes = NULL;
+	g_autoptr(GMappedFile) mapped = NULL;
+	g_autoptr(GVariant) root = NULL;
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GVariantIter) apps = NULL;
+	g_autoptr(GsAppList) list = gs_app_list_new ();
+
+	g_return_val_if_fail (GS_IS_PLUGIN_LOADER (plugin_loader), NULL);
+	g_return_val_if_fail (name != NULL, NULL);
+
+	filename = gs_plugin_loader_get_snapshot_filename (name, error);
+	if (filename == NULL)
+		return NULL;
+	mapped = g_mapped_file_new (filename, FALSE, &error_local);
+	if (mapped == NULL) {
+		g_set_error_literal (error,
+				     G_IO_ERROR,
+				     g_file_error_to_io_error (error_local->code),
+				     error_local->message);
+		gs_utils_error_convert_gio (error);
+		return NULL;
+	}
+	bytes = g_mapped_file_get_bytes (mapped);
+	root = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE (GS_PLUGIN_LOADER_SNAPSHOT_FORMAT),
+							     bytes, FALSE));
+	g_variant_get (root, "(u&saa{sv})", &version, &language, &apps);
+	if (version != GS_PLUGIN_LOADER_SNAPSHOT_VERSION ||
+	    g_strcmp0 (language, plugin_loader->language) != 0) {
+		g_set_error (error,
+			     GS_PLUGIN_ERROR,
+			     GS_PLUGIN_ERROR_INVALID_FORMAT,
+			     "snapshot %s is version %u for %s, expected %u for %s",
+			     filename, version, language,
+			     (guint) GS_PLUGIN_LOADER_SNAPSHOT_VERSION,
+			     plugin_loader->language);
+		return NULL;
+	}
+	while ((dict = g_variant_iter_next_value (apps)) != NULL) {
+		g_autoptr(GsApp) app = gs_plugin_loader_app_from_snapshot (dict);
+		if (app != NULL)
+			gs_app_list_add (list, app);
+		g_variant_unref (dict);
+	}
+	return g_steal_pointer (&list);
+}
@@ -95,8 +95,23 @@ GsPlugin	*gs_plugin_loader_find_plugin		(GsPluginLoader	*plugin_loader,
 							 const gchar	*plugin_name);
 void            gs_plugin_loader_set_max_parallel_ops  (GsPluginLoader *plugin_loader,
                                                         guint           max_ops);
+void		 gs_plugin_loader_get_queue_stats	(GsPluginLoader	*plugin_loader,
+							 gboolean	 interactive,
+							 guint		*n_queued,
+							 guint		*n_running,
+							 guint64	*wait_avg_usec,
+							 guint64	*wait_max_usec);
+void		 gs_plugin_loader_get_search_cache_stats (GsPluginLoader *plugin_loader,
+							 guint		*n_hits,
+							 guint		*n_misses);
 
 GsCategoryManager *gs_plugin_loader_get_category_manager (GsPluginLoader *plugin_loader);
+void		 gs_plugin_loader_save_snapshot		(GsPluginLoader	*plugin_loader,
+							 const gchar	*name,
+							 GsAppList	*list);
+GsAppList	*gs_plugin_loader_load_snapshot		(GsPluginLoader	*plugin_loader,
+							 const gchar	*name,
+							 GError		**error);
 void		 gs_plugin_loader_claim_error		(GsPluginLoader *plugin_loader,
 							 GsPlugin *plugin,
 							 GsPluginAction action,
@@ -423,6 +423,32 @@ gboolean	 gs_plugin_refine_wildcard		(GsPlugin	*plugin,
 							 GCancellable	*cancellable,
 							 GError		**error);
 
+/**
+ * gs_plugin_refine_wildcards:
+ * @plugin: a #GsPlugin
+ * @list: a #GsAppList
+ * @flags: a #GsPluginRefineFlags, e.g. %GS_PLUGIN_REFINE_FLAGS_REQUIRE_LICENSE
+ * @cancellable: a #GCancellable, or %NULL
+ * @error: a #GError, or %NULL
+ *
+ * Adds applications to @list that match any of the wildcard applications
+ * in @list, in the same way as gs_plugin_refine_wildcard().
+ *
+ * This allows plugins to resolve all the wildcards at once, for instance with
+ * one pass over an index. If a plugin implements this then
+ * gs_plugin_refine_wildcard() is not called.
+ *
+ * Plugins should iterate over a copy of @list, as the new applications are
+ * added to @list and must not be resolved again.
+ *
+ * Returns: %TRUE for success or if not relevant
+ **/
+gboolean	 gs_plugin_refine_wildcards		(GsPlugin	*plugin,
+							 GsAppList	*list,
+							 GsPluginRefineFlags flags,
+							 GCancellable	*cancellable,
+							 GError		**error);
+
 /**
  * gs_plugin_launch:
  * @plugin: a #GsPlugin
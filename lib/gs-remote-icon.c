@@ -20,6 +20,10 @@
  * Constructing a #GsRemoteIcon does not guarantee that the icon is cached. Call
  * gs_remote_icon_ensure_cached() for that.
  *
+ * Downloaded icons are stored in the #GsIconPack when it is available, rather
+ * than at that filename; gs_app_get_icon_for_size() returns them from there.
+ * The file is only written if the icon pack cannot be used.
+ *
  * #GsRemoteIcon is immutable after construction and hence is entirely thread
  * safe.
  *
@@ -35,9 +39,14 @@
 #include <glib-object.h>
 #include <libsoup/soup.h>
 
+#include "gs-icon-pack.h"
 #include "gs-remote-icon.h"
 #include "gs-utils.h"
 
+/* icons are small, so keep a few more requests in flight than for other
+ * downloads */
+#define GS_REMOTE_ICON_MAX_DOWNLOADS	8
+
 /* FIXME: Work around the fact that GFileIcon is not derivable, by deriving from
  * it anyway by copying its `struct GFileIcon` definition inline here. This will
  * work as long as the size of `struct GFileIcon` doesn’t change within GIO.
@@ -232,6 +241,91 @@ gs_remote_icon_get_uri (GsRemoteIcon *self)
 	return self->uri;
 }
 
+/* Whether the icon is in the icon pack or the cache directory, in which case
+ * the dimensions of the cached image are stored on the icon if they are not
+ * already. */
+static gboolean
+gs_remote_icon_check_cached (GsRemoteIcon *self,
+                             const gchar  *cache_filename)
+{
+	GsIconPack *pack = gs_icon_pack_get_default ();
+	gint width = 0, height = 0;
+	guint packed_width = 0, packed_height = 0;
+
+	if (pack != NULL &&
+	    gs_icon_pack_contains (pack, gs_remote_icon_get_uri (self),
+				   &packed_width, &packed_height)) {
+		if (!g_object_get_data (G_OBJECT (self), "width")) {
+			g_object_set_data (G_OBJECT (self), "width", GUINT_TO_POINTER (packed_width));
+			g_object_set_data (G_OBJECT (self), "height", GUINT_TO_POINTER (packed_height));
+		}
+		return TRUE;
+	}
+
+	if (!g_file_test (cache_filename, G_FILE_TEST_IS_REGULAR))
+		return FALSE;
+
+	/* Ensure the downloaded image dimensions are stored on the icon */
+	if (!g_object_get_data (G_OBJECT (self), "width") &&
+	    gdk_pixbuf_get_file_info (cache_filename, &width, &height)) {
+		g_object_set_data (G_OBJECT (self), "width", GINT_TO_POINTER (width));
+		g_object_set_data (G_OBJECT (self), "height", GINT_TO_POINTER (height));
+	}
+	return TRUE;
+}
+
+static void
+gs_remote_icon_set_size (GsRemoteIcon *self,
+                         GdkPixbuf    *pixbuf)
+{
+	g_object_set_data (G_OBJECT (self), "width", GUINT_TO_POINTER (gdk_pixbuf_get_width (pixbuf)));
+	g_object_set_data (G_OBJECT (self), "height", GUINT_TO_POINTER (gdk_pixbuf_get_height (pixbuf)));
+}
+
+static GdkPixbuf *
+gs_icon_save_scaled (GInputStream  *stream,
+                     const gchar   *uri,
+                     const gchar   *destination_path,
+                     guint          max_size,
+                     GCancellable  *cancellable,
+                     GError       **error)
+{
+	g_autoptr(GdkPixbuf) pixbuf = NULL;
+	g_autoptr(GdkPixbuf) scaled_pixbuf = NULL;
+
+	GsIconPack *pack = gs_icon_pack_get_default ();
+	g_autoptr(GError) error_local = NULL;
+
+	/* Typically these icons are 64x64px PNG files. If not, resize down
+	 * so it’s at most @max_size square, to minimise the size of the on-disk
+	 * cache.*/
+	pixbuf = gdk_pixbuf_new_from_stream (stream, cancellable, error);
+	if (pixbuf == NULL)
+		return NULL;
+
+	if ((guint) gdk_pixbuf_get_height (pixbuf) <= max_size &&
+	    (guint) gdk_pixbuf_get_width (pixbuf) <= max_size) {
+		scaled_pixbuf = g_object_ref (pixbuf);
+	} else {
+		scaled_pixbuf = gdk_pixbuf_scale_simple (pixbuf, max_size, max_size,
+							 GDK_INTERP_BILINEAR);
+	}
+
+	/* store it in the icon pack, in each size it is rendered at; the
+	 * maximum size is for a #GsFeatureTile, which is 160px per scale */
+	if (pack != NULL &&
+	    gs_icon_pack_add_pixbuf (pack, uri, scaled_pixbuf, MAX (1, max_size / 160), &error_local))
+		return g_steal_pointer (&scaled_pixbuf);
+	if (error_local != NULL)
+		g_debug ("failed to add %s to icon pack: %s", uri, error_local->message);
+
+	/* otherwise write a file */
+	if (!gdk_pixbuf_save (scaled_pixbuf, destination_path, "png", error, NULL))
+		return NULL;
+
+	return g_steal_pointer (&scaled_pixbuf);
+}
+
 static GdkPixbuf *
 gs_icon_download (SoupSession   *session,
                   const gchar   *uri,
@@ -243,8 +337,6 @@ gs_icon_download (SoupSession   *session,
 	guint status_code;
 	g_autoptr(SoupMessage) msg = NULL;
 	g_autoptr(GInputStream) stream = NULL;
-	g_autoptr(GdkPixbuf) pixbuf = NULL;
-	g_autoptr(GdkPixbuf) scaled_pixbuf = NULL;
 
 	/* Create the request */
 	msg = soup_message_new (SOUP_METHOD_GET, uri);
@@ -275,26 +367,7 @@ gs_icon_download (SoupSession   *session,
 		return NULL;
 	}
 
-	/* Typically these icons are 64x64px PNG files. If not, resize down
-	 * so it’s at most @max_size square, to minimise the size of the on-disk
-	 * cache.*/
-	pixbuf = gdk_pixbuf_new_from_stream (stream, cancellable, error);
-	if (pixbuf == NULL)
-		return NULL;
-
-	if ((guint) gdk_pixbuf_get_height (pixbuf) <= max_size &&
-	    (guint) gdk_pixbuf_get_width (pixbuf) <= max_size) {
-		scaled_pixbuf = g_object_ref (pixbuf);
-	} else {
-		scaled_pixbuf = gdk_pixbuf_scale_simple (pixbuf, max_size, max_size,
-							 GDK_INTERP_BILINEAR);
-	}
-
-	/* write file */
-	if (!gdk_pixbuf_save (scaled_pixbuf, destination_path, "png", error, NULL))
-		return NULL;
-
-	return g_steal_pointer (&scaled_pixbuf);
+	return gs_icon_save_scaled (stream, uri, destination_path, max_size, cancellable, error);
 }
 
 /**
@@ -345,24 +418,152 @@ gs_remote_icon_ensure_cached (GsRemoteIcon  *self,
 		return FALSE;
 
 	/* Already in cache? */
-	if (g_file_test (cache_filename, G_FILE_TEST_IS_REGULAR)) {
-		gint width = 0, height = 0;
-		/* Ensure the downloaded image dimensions are stored on the icon */
-		if (!g_object_get_data (G_OBJECT (self), "width") &&
-		    gdk_pixbuf_get_file_info (cache_filename, &width, &height)) {
-			g_object_set_data (G_OBJECT (self), "width", GINT_TO_POINTER (width));
-			g_object_set_data (G_OBJECT (self), "height", GINT_TO_POINTER (height));
-		}
+	if (gs_remote_icon_check_cached (self, cache_filename))
 		return TRUE;
-	}
 
 	cached_pixbuf = gs_icon_download (soup_session, uri, cache_filename, maximum_icon_size, cancellable, error);
 	if (cached_pixbuf == NULL)
 		return FALSE;
 
 	/* Ensure the dimensions are set correctly on the icon. */
-	g_object_set_data (G_OBJECT (self), "width", GUINT_TO_POINTER (gdk_pixbuf_get_width (cached_pixbuf)));
-	g_object_set_data (G_OBJECT (self), "height", GUINT_TO_POINTER (gdk_pixbuf_get_height (cached_pixbuf)));
+	gs_remote_icon_set_size (self, cached_pixbuf);
 
 	return TRUE;
 }
+
+/* one download, shared by all the icons with the same URI */
+typedef struct {
+	GPtrArray	*icons;  /* (element-type GsRemoteIcon) (owned) */
+	gchar		*cache_filename;  /* (owned) */
+	GError		*error;  /* (owned) (nullable) */
+} GsRemoteIconDownload;
+
+typedef struct {
+	SoupSession	*soup_session;  /* (unowned) */
+	guint		 maximum_icon_size;
+	GCancellable	*cancellable;  /* (unowned) (nullable) */
+} GsRemoteIconBatch;
+
+static void
+gs_remote_icon_download_free (GsRemoteIconDownload *download)
+{
+	g_ptr_array_unref (download->icons);
+	g_free (download->cache_filename);
+	g_clear_error (&download->error);
+	g_slice_free (GsRemoteIconDownload, download);
+}
+
+/* runs in a worker thread; #SoupSession is only safe to share between
+ * threads when using its blocking API, so each download is done with that,
+ * and decoded, scaled and written in the same thread */
+static void
+gs_remote_icon_download_thread_cb (gpointer data,
+                                   gpointer user_data)
+{
+	GsRemoteIconDownload *download = data;
+	GsRemoteIconBatch *batch = user_data;
+	g_autoptr(GdkPixbuf) cached_pixbuf = NULL;
+
+	if (g_cancellable_set_error_if_cancelled (batch->cancellable, &download->error))
+		return;
+
+	cached_pixbuf = gs_icon_download (batch->soup_session,
+					  gs_remote_icon_get_uri (g_ptr_array_index (download->icons, 0)),
+					  download->cache_filename,
+					  batch->maximum_icon_size,
+					  batch->cancellable, &download->error);
+	if (cached_pixbuf == NULL)
+		return;
+	for (guint i = 0; i < download->icons->len; i++)
+		gs_remote_icon_set_size (g_ptr_array_index (download->icons, i), cached_pixbuf);
+}
+
+/**
+ * gs_remote_icon_ensure_cached_many:
+ * @icons: (element-type GsRemoteIcon): icons to cache
+ * @soup_session: a #SoupSession to use to download the icons
+ * @maximum_icon_size: maximum size (in device pixels) of the icons to save
+ * @cancellable: (nullable): a #GCancellable, or %NULL
+ *
+ * Ensure all of @icons are present in the local cache, like
+ * gs_remote_icon_ensure_cached() does for each of them.
+ *
+ * Icons with the same URI are only downloaded once, and several downloads are
+ * run at the same time in worker threads, which also decode the downloaded
+ * icons and write them to the cache. This blocks until all of them are done.
+ * Icons which fail to download are logged and skipped.
+ *
+ * This can be called from any thread.
+ *
+ * Since: 42
+ */
+void
+gs_remote_icon_ensure_cached_many (GPtrArray     *icons,
+                                   SoupSession   *soup_session,
+                                   guint          maximum_icon_size,
+                                   GCancellable  *cancellable)
+{
+	GsRemoteIconBatch batch = { 0, };
+	g_autoptr(GPtrArray) downloads = NULL;
+	g_autoptr(GHashTable) download_by_uri = g_hash_table_new (g_str_hash, g_str_equal);
+	GThreadPool *pool;
+
+	g_return_if_fail (icons != NULL);
+	g_return_if_fail (SOUP_IS_SESSION (soup_session));
+	g_return_if_fail (maximum_icon_size > 0);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	downloads = g_ptr_array_new_with_free_func ((GDestroyNotify) gs_remote_icon_download_free);
+	for (guint i = 0; i < icons->len; i++) {
+		GsRemoteIcon *icon = g_ptr_array_index (icons, i);
+		const gchar *uri = gs_remote_icon_get_uri (icon);
+		GsRemoteIconDownload *download;
+		g_autofree gchar *cache_filename = NULL;
+		g_autoptr(GError) error_local = NULL;
+
+		/* icons with the same URI share one download */
+		download = g_hash_table_lookup (download_by_uri, uri);
+		if (download != NULL) {
+			g_ptr_array_add (download->icons, g_object_ref (icon));
+			continue;
+		}
+
+		cache_filename = gs_remote_icon_get_cache_filename (uri, TRUE, &error_local);
+		if (cache_filename == NULL) {
+			g_debug ("failed to cache icon %s: %s", uri, error_local->message);
+			continue;
+		}
+		if (gs_remote_icon_check_cached (icon, cache_filename))
+			continue;
+
+		download = g_slice_new0 (GsRemoteIconDownload);
+		download->icons = g_ptr_array_new_with_free_func (g_object_unref);
+		g_ptr_array_add (download->icons, g_object_ref (icon));
+		download->cache_filename = g_steal_pointer (&cache_filename);
+		g_hash_table_insert (download_by_uri, (gpointer) uri, download);
+		g_ptr_array_add (downloads, download);
+	}
+	if (downloads->len == 0)
+		return;
+
+	batch.soup_session = soup_session;
+	batch.maximum_icon_size = maximum_icon_size;
+	batch.cancellable = cancellable;
+
+	/* wait for all the downloads to finish */
+	pool = g_thread_pool_new (gs_remote_icon_download_thread_cb, &batch,
+				  (gint) MIN (downloads->len, GS_REMOTE_ICON_MAX_DOWNLOADS),
+				  FALSE, NULL);
+	for (guint i = 0; i < downloads->len; i++)
+		g_thread_pool_push (pool, g_ptr_array_index (downloads, i), NULL);
+	g_thread_pool_free (pool, FALSE, TRUE);
+
+	for (guint i = 0; i < downloads->len; i++) {
+		GsRemoteIconDownload *download = g_ptr_array_index (downloads, i);
+		if (download->error != NULL) {
+			g_debug ("failed to cache icon %s: %s",
+				 gs_remote_icon_get_uri (g_ptr_array_index (download->icons, 0)),
+				 download->error->message);
+		}
+	}
+}
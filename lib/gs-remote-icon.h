@@ -33,5 +33,10 @@ gboolean	 gs_remote_icon_ensure_cached	(GsRemoteIcon		 *self,
 						 guint			  maximum_icon_size,
 						 GCancellable		 *cancellable,
 						 GError			**error);
+void		 gs_remote_icon_ensure_cached_many
+						(GPtrArray		 *icons,
+						 SoupSession		 *soup_session,
+						 guint			  maximum_icon_size,
+						 GCancellable		 *cancellable);
 
 G_END_DECLS
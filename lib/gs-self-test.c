@@ -9,9 +9,15 @@
 
 #include "config.h"
 
+#include <string.h>
+#include <unistd.h>
+#include <glib/gstdio.h>
+
 #include "gnome-software-private.h"
 
 #include "gs-debug.h"
+#include "gs-icon-pack.h"
+#include "gs-key-colors.h"
 #include "gs-test.h"
 
 static gboolean
@@ -131,6 +137,76 @@ gs_utils_cache_func (void)
 	g_assert (g_str_has_suffix (fn2, "test/295099f59d12b3eb0b955325fcb699cd23792a89-baz"));
 }
 
+static gboolean
+gs_utils_file_size_exclude_b_cb (const gchar *filename,
+				 GFileTest file_kind,
+				 gpointer user_data)
+{
+	return g_strcmp0 (filename, "b") != 0;
+}
+
+static void
+gs_utils_file_size_func (void)
+{
+	gboolean ret;
+	guint64 size;
+	g_autofree gchar *tmpdir = NULL;
+	g_autofree gchar *fn = NULL;
+	g_autoptr(GError) error = NULL;
+	const gchar *files[] = { "top", "a/one", "a/deep/two", "b/three", NULL };
+	const gsize sizes[] = { 10, 100, 1000, 10000 };
+
+	tmpdir = g_dir_make_tmp ("gs-self-test-XXXXXX", &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (tmpdir);
+
+	for (guint i = 0; files[i] != NULL; i++) {
+		g_autofree gchar *path = g_build_filename (tmpdir, files[i], NULL);
+		g_autofree gchar *dirname = g_path_get_dirname (path);
+		g_autofree gchar *data = g_strnfill (sizes[i], 'x');
+		g_assert_cmpint (g_mkdir_with_parents (dirname, 0755), ==, 0);
+		ret = g_file_set_contents (path, data, -1, &error);
+		g_assert_no_error (error);
+		g_assert_true (ret);
+	}
+
+	/* a symlink to a file counts the file, a symlink to a directory is
+	 * not followed */
+	fn = g_build_filename (tmpdir, "link-top", NULL);
+	g_assert_cmpint (symlink ("top", fn), ==, 0);
+	g_clear_pointer (&fn, g_free);
+	fn = g_build_filename (tmpdir, "link-a", NULL);
+	g_assert_cmpint (symlink ("a", fn), ==, 0);
+	g_clear_pointer (&fn, g_free);
+
+	size = gs_utils_get_file_size (tmpdir, NULL, NULL, NULL);
+	g_assert_cmpint (size, ==, 11120);
+	size = gs_utils_get_file_size (tmpdir, gs_utils_file_size_exclude_b_cb, NULL, NULL);
+	g_assert_cmpint (size, ==, 1120);
+
+	/* the cached totals are not used once a directory changes */
+	fn = g_build_filename (tmpdir, "a", "deep", "four", NULL);
+	ret = g_file_set_contents (fn, "12345", -1, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	size = gs_utils_get_file_size (tmpdir, NULL, NULL, NULL);
+	g_assert_cmpint (size, ==, 11125);
+	size = gs_utils_get_file_size (tmpdir, gs_utils_file_size_exclude_b_cb, NULL, NULL);
+	g_assert_cmpint (size, ==, 1125);
+	g_assert_cmpint (g_unlink (fn), ==, 0);
+	size = gs_utils_get_file_size (tmpdir, NULL, NULL, NULL);
+	g_assert_cmpint (size, ==, 11120);
+
+	/* a single file */
+	g_clear_pointer (&fn, g_free);
+	fn = g_build_filename (tmpdir, "b", "three", NULL);
+	g_assert_cmpint (gs_utils_get_file_size (fn, NULL, NULL, NULL), ==, 10000);
+
+	ret = gs_utils_rmtree (tmpdir, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+}
+
 static void
 gs_utils_error_func (void)
 {
@@ -169,6 +245,46 @@ gs_utils_error_func (void)
 	g_assert_cmpstr (error->message, ==, "failed");
 }
 
+static void
+gs_utils_pixbuf_blur_func (void)
+{
+	g_autoptr(GdkPixbuf) flat = NULL;
+	g_autoptr(GdkPixbuf) impulse = NULL;
+	guint8 *pixels;
+	gint rowstride;
+
+	/* a flat image is unchanged, alpha included, across the vector and
+	 * scalar parts of each row */
+	flat = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, 37, 11);
+	gdk_pixbuf_fill (flat, 0x804020c0);
+	gs_utils_pixbuf_blur (flat, 5, 3);
+	pixels = gdk_pixbuf_get_pixels (flat);
+	rowstride = gdk_pixbuf_get_rowstride (flat);
+	for (gint y = 0; y < 11; y++) {
+		for (gint x = 0; x < 37; x++) {
+			const guint8 *p = pixels + y * rowstride + x * 4;
+			g_assert_cmpuint (p[0], ==, 0x80);
+			g_assert_cmpuint (p[1], ==, 0x40);
+			g_assert_cmpuint (p[2], ==, 0x20);
+			g_assert_cmpuint (p[3], ==, 0xc0);
+		}
+	}
+
+	/* a single pixel is spread evenly over the 3×3 box around it */
+	impulse = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8, 19, 9);
+	gdk_pixbuf_fill (impulse, 0x00000000);
+	pixels = gdk_pixbuf_get_pixels (impulse);
+	rowstride = gdk_pixbuf_get_rowstride (impulse);
+	memset (pixels + 4 * rowstride + 9 * 3, 0xff, 3);
+	gs_utils_pixbuf_blur (impulse, 1, 1);
+	for (gint y = 0; y < 9; y++) {
+		for (gint x = 0; x < 19; x++) {
+			gboolean in_box = ABS (y - 4) <= 1 && ABS (x - 9) <= 1;
+			g_assert_cmpuint (pixels[y * rowstride + x * 3 + 1], ==, in_box ? 255 / 3 / 3 : 0);
+		}
+	}
+}
+
 static void
 gs_utils_parse_evr_func (void)
 {
@@ -241,6 +357,423 @@ gs_utils_parse_evr_func (void)
 	}
 }
 
+static const gchar *odrs_fetch_response =
+	"[{\"user_hash\": \"deadbeef\", \"user_skey\": \"skey\", \"review_id\": 1,"
+	"  \"rating\": 80, \"summary\": \"Great\", \"description\": \"Works well\"}]";
+
+#if SOUP_CHECK_VERSION(3, 0, 0)
+static void
+gs_odrs_provider_fetch_handler_cb (SoupServer *server,
+				   SoupServerMessage *msg,
+				   const gchar *path,
+				   GHashTable *query,
+				   gpointer user_data)
+{
+	guint *n_requests = user_data;
+
+	g_atomic_int_inc (n_requests);
+	soup_server_message_set_status (msg, SOUP_STATUS_OK, NULL);
+	soup_server_message_set_response (msg, "application/json", SOUP_MEMORY_STATIC,
+					  odrs_fetch_response, strlen (odrs_fetch_response));
+}
+#else
+static void
+gs_odrs_provider_fetch_handler_cb (SoupServer *server,
+				   SoupMessage *msg,
+				   const gchar *path,
+				   GHashTable *query,
+				   SoupClientContext *client,
+				   gpointer user_data)
+{
+	guint *n_requests = user_data;
+
+	g_atomic_int_inc (n_requests);
+	soup_message_set_status (msg, SOUP_STATUS_OK);
+	soup_message_set_response (msg, "application/json", SOUP_MEMORY_STATIC,
+				   odrs_fetch_response, strlen (odrs_fetch_response));
+}
+#endif
+
+typedef struct {
+	GsOdrsProvider	*provider;
+	GsAppList	*list;
+	GError		*error;
+	gint		 done;
+} GsOdrsProviderTestRefine;
+
+static gpointer
+gs_odrs_provider_refine_thread_cb (gpointer user_data)
+{
+	GsOdrsProviderTestRefine *data = user_data;
+
+	gs_odrs_provider_refine (data->provider, data->list,
+				 GS_PLUGIN_REFINE_FLAGS_REQUIRE_REVIEWS,
+				 NULL, &data->error);
+	g_atomic_int_set (&data->done, 1);
+	g_main_context_wakeup (NULL);
+	return NULL;
+}
+
+/* the server runs in the default context, so refine from another thread */
+static void
+gs_odrs_provider_test_refine (GsOdrsProvider *provider, GsAppList *list)
+{
+	GsOdrsProviderTestRefine data = { provider, list, NULL, 0 };
+	GThread *thread;
+
+	thread = g_thread_new ("odrs-refine", gs_odrs_provider_refine_thread_cb, &data);
+	while (!g_atomic_int_get (&data.done))
+		g_main_context_iteration (NULL, TRUE);
+	g_thread_join (thread);
+	g_assert_no_error (data.error);
+}
+
+static void
+gs_odrs_provider_fetch_batch_func (void)
+{
+	guint n_requests = 0;
+	guint port;
+	GSList *uris;
+	g_autofree gchar *review_server = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GsAppList) list = gs_app_list_new ();
+	g_autoptr(GsAppList) list_cached = gs_app_list_new ();
+	g_autoptr(GsApp) app_dup = NULL;
+	g_autoptr(GsOdrsProvider) provider = NULL;
+	g_autoptr(SoupServer) server = NULL;
+	g_autoptr(SoupSession) session = NULL;
+
+	/* a fake review server counting the requests */
+	server = soup_server_new (NULL, NULL);
+	soup_server_add_handler (server, "/fetch",
+				 gs_odrs_provider_fetch_handler_cb, &n_requests, NULL);
+	soup_server_listen_local (server, 0, 0, &error);
+	g_assert_no_error (error);
+	uris = soup_server_get_uris (server);
+#if SOUP_CHECK_VERSION(3, 0, 0)
+	port = (guint) g_uri_get_port (uris->data);
+	g_slist_free_full (uris, (GDestroyNotify) g_uri_unref);
+#else
+	port = soup_uri_get_port (uris->data);
+	g_slist_free_full (uris, (GDestroyNotify) soup_uri_free);
+#endif
+	review_server = g_strdup_printf ("http://127.0.0.1:%u", port);
+
+	session = soup_session_new ();
+	provider = gs_odrs_provider_new (review_server, "deadbeef", "testos",
+					 3600, 20, session);
+
+	/* one request per ID, shared by apps with the same ID */
+	for (guint i = 0; i < 10; i++) {
+		g_autofree gchar *id = g_strdup_printf ("org.example.App%u", i);
+		g_autoptr(GsApp) app = gs_app_new (id);
+		gs_app_list_add (list, app);
+	}
+	app_dup = gs_app_new ("org.example.App0");
+	gs_app_set_branch (app_dup, "beta");
+	gs_app_list_add (list, app_dup);
+	g_assert_cmpuint (gs_app_list_length (list), ==, 11);
+	gs_odrs_provider_test_refine (provider, list);
+	g_assert_cmpuint (g_atomic_int_get (&n_requests), ==, 10);
+	for (guint i = 0; i < gs_app_list_length (list); i++) {
+		GsApp *app = gs_app_list_index (list, i);
+		g_assert_cmpuint (gs_app_get_reviews (app)->len, ==, 1);
+	}
+
+	/* the second time they all come from the cache */
+	for (guint i = 0; i < 10; i++) {
+		g_autofree gchar *id = g_strdup_printf ("org.example.App%u", i);
+		g_autoptr(GsApp) app = gs_app_new (id);
+		gs_app_list_add (list_cached, app);
+	}
+	gs_odrs_provider_test_refine (provider, list_cached);
+	g_assert_cmpuint (g_atomic_int_get (&n_requests), ==, 10);
+	for (guint i = 0; i < gs_app_list_length (list_cached); i++) {
+		GsApp *app = gs_app_list_index (list_cached, i);
+		g_assert_cmpuint (gs_app_get_reviews (app)->len, ==, 1);
+	}
+}
+
+#if SOUP_CHECK_VERSION(3, 0, 0)
+static void
+gs_remote_icon_download_handler_cb (SoupServer *server,
+				    SoupServerMessage *msg,
+				    const gchar *path,
+				    GHashTable *query,
+				    gpointer user_data)
+{
+	GBytes *png = user_data;
+
+	g_atomic_int_inc ((gint *) g_object_get_data (G_OBJECT (server), "n-requests"));
+	soup_server_message_set_status (msg, SOUP_STATUS_OK, NULL);
+	soup_server_message_set_response (msg, "image/png", SOUP_MEMORY_STATIC,
+					  g_bytes_get_data (png, NULL),
+					  g_bytes_get_size (png));
+}
+#else
+static void
+gs_remote_icon_download_handler_cb (SoupServer *server,
+				    SoupMessage *msg,
+				    const gchar *path,
+				    GHashTable *query,
+				    SoupClientContext *client,
+				    gpointer user_data)
+{
+	GBytes *png = user_data;
+
+	g_atomic_int_inc ((gint *) g_object_get_data (G_OBJECT (server), "n-requests"));
+	soup_message_set_status (msg, SOUP_STATUS_OK);
+	soup_message_set_response (msg, "image/png", SOUP_MEMORY_STATIC,
+				   g_bytes_get_data (png, NULL),
+				   g_bytes_get_size (png));
+}
+#endif
+
+typedef struct {
+	GPtrArray	*icons;
+	SoupSession	*session;
+	gint		 done;
+} GsRemoteIconTestDownload;
+
+static gpointer
+gs_remote_icon_download_thread_cb (gpointer user_data)
+{
+	GsRemoteIconTestDownload *data = user_data;
+
+	gs_remote_icon_ensure_cached_many (data->icons, data->session, 64, NULL);
+	g_atomic_int_set (&data->done, 1);
+	g_main_context_wakeup (NULL);
+	return NULL;
+}
+
+static void
+gs_remote_icon_download_batch_func (void)
+{
+	gint n_requests = 0;
+	guint port;
+	gsize png_len = 0;
+	gint64 start_time;
+	GSList *uris;
+	GThread *thread;
+	GsRemoteIconTestDownload data = { NULL, NULL, 0 };
+	g_autofree gchar *png_data = NULL;
+	g_autoptr(GBytes) png = NULL;
+	g_autoptr(GdkPixbuf) pixbuf = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) icons = g_ptr_array_new_with_free_func (g_object_unref);
+	g_autoptr(SoupServer) server = NULL;
+	g_autoptr(SoupSession) session = NULL;
+
+	/* a 128px icon, which gets scaled down when cached */
+	pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, 128, 128);
+	gdk_pixbuf_fill (pixbuf, 0x3584e4ff);
+	gdk_pixbuf_save_to_buffer (pixbuf, &png_data, &png_len, "png", &error, NULL);
+	g_assert_no_error (error);
+	png = g_bytes_new_static (png_data, png_len);
+
+	/* a fake icon server counting the requests */
+	server = soup_server_new (NULL, NULL);
+	g_object_set_data (G_OBJECT (server), "n-requests", &n_requests);
+	soup_server_add_handler (server, "/icons",
+				 gs_remote_icon_download_handler_cb, png, NULL);
+	soup_server_listen_local (server, 0, 0, &error);
+	g_assert_no_error (error);
+	uris = soup_server_get_uris (server);
+#if SOUP_CHECK_VERSION(3, 0, 0)
+	port = (guint) g_uri_get_port (uris->data);
+	g_slist_free_full (uris, (GDestroyNotify) g_uri_unref);
+#else
+	port = soup_uri_get_port (uris->data);
+	g_slist_free_full (uris, (GDestroyNotify) soup_uri_free);
+#endif
+
+	/* 500 icons, each URI used twice */
+	for (guint i = 0; i < 500; i++) {
+		g_autofree gchar *uri = g_strdup_printf ("http://127.0.0.1:%u/icons/%u.png",
+							 port, i % 250);
+		g_ptr_array_add (icons, gs_remote_icon_new (uri));
+	}
+
+	/* the server runs in the default context, so download from another thread */
+	session = soup_session_new_with_options ("max-conns-per-host", 8, NULL);
+	data.icons = icons;
+	data.session = session;
+	start_time = g_get_monotonic_time ();
+	thread = g_thread_new ("remote-icon-download", gs_remote_icon_download_thread_cb, &data);
+	while (!g_atomic_int_get (&data.done))
+		g_main_context_iteration (NULL, TRUE);
+	g_thread_join (thread);
+	g_test_message ("downloaded %u icons in %.1fms", icons->len,
+			(g_get_monotonic_time () - start_time) / 1000.f);
+
+	g_assert_cmpint (g_atomic_int_get (&n_requests), ==, 250);
+	g_assert_nonnull (gs_icon_pack_get_default ());
+	for (guint i = 0; i < icons->len; i++) {
+		GIcon *icon = g_ptr_array_index (icons, i);
+		g_autoptr(GdkTexture) texture = NULL;
+
+		g_assert_cmpint (GPOINTER_TO_INT (g_object_get_data (G_OBJECT (icon), "width")), ==, 64);
+		texture = gs_icon_pack_lookup (gs_icon_pack_get_default (),
+					       gs_remote_icon_get_uri (GS_REMOTE_ICON (icon)), 64);
+		g_assert_nonnull (texture);
+		g_assert_cmpint (gdk_texture_get_width (texture), ==, 64);
+	}
+
+	/* the second time they all come from the cache */
+	data.done = 0;
+	thread = g_thread_new ("remote-icon-download", gs_remote_icon_download_thread_cb, &data);
+	while (!g_atomic_int_get (&data.done))
+		g_main_context_iteration (NULL, TRUE);
+	g_thread_join (thread);
+	g_assert_cmpint (g_atomic_int_get (&n_requests), ==, 250);
+}
+
+static void
+gs_key_colors_cache_func (void)
+{
+	GStatBuf st;
+	g_autofree gchar *tmpdir = NULL;
+	g_autofree gchar *filename = NULL;
+	g_autoptr(GArray) colors = NULL;
+	g_autoptr(GArray) colors_cached = NULL;
+	g_autoptr(GdkPixbuf) pixbuf = NULL;
+	g_autoptr(GdkPixbuf) pixbuf_other = NULL;
+	g_autoptr(GError) error = NULL;
+
+	tmpdir = g_dir_make_tmp ("gs-self-test-key-colors-XXXXXX", &error);
+	g_assert_no_error (error);
+	filename = g_build_filename (tmpdir, "key-colors.bin", NULL);
+
+	/* calculated, then stored */
+	pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, 64, 64);
+	gdk_pixbuf_fill (pixbuf, 0x3584e4ff);
+	colors = gs_calculate_key_colors_cached (pixbuf, filename);
+	g_assert_cmpuint (colors->len, >, 0);
+	g_assert_cmpfloat_with_epsilon (g_array_index (colors, GdkRGBA, 0).red, 0x35 / 255.0, 0.001);
+	g_assert_cmpint (g_stat (filename, &st), ==, 0);
+	g_assert_cmpint (st.st_size, ==, 24);
+
+	/* the same icon comes from the cache */
+	colors_cached = gs_calculate_key_colors_cached (pixbuf, filename);
+	g_assert_cmpuint (colors_cached->len, ==, colors->len);
+	for (guint i = 0; i < colors->len; i++)
+		g_assert_true (gdk_rgba_equal (&g_array_index (colors, GdkRGBA, i),
+					       &g_array_index (colors_cached, GdkRGBA, i)));
+	g_assert_cmpint (g_stat (filename, &st), ==, 0);
+	g_assert_cmpint (st.st_size, ==, 24);
+
+	/* a different one does not */
+	pixbuf_other = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, 64, 64);
+	gdk_pixbuf_fill (pixbuf_other, 0xe01b24ff);
+	g_clear_pointer (&colors, g_array_unref);
+	colors = gs_calculate_key_colors_cached (pixbuf_other, filename);
+	g_assert_cmpfloat_with_epsilon (g_array_index (colors, GdkRGBA, 0).red, 0xe0 / 255.0, 0.001);
+	g_assert_cmpint (g_stat (filename, &st), ==, 0);
+	g_assert_cmpint (st.st_size, ==, 48);
+
+	g_assert_cmpint (g_unlink (filename), ==, 0);
+	g_assert_cmpint (g_rmdir (tmpdir), ==, 0);
+}
+
+static void
+gs_icon_pack_func (void)
+{
+	const gchar *uri = "https://example.com/icons/app.png";
+	const gchar *uri_other = "https://example.com/icons/app.png?size=64";
+	const gchar *uri_third = "https://example.com/icons/other.png";
+	guint width = 0, height = 0;
+	GStatBuf st, st_new;
+	FILE *file;
+	g_autofree guint8 *pixels = g_malloc (160 * 160 * 4);
+	g_autofree gchar *tmpdir = NULL;
+	g_autofree gchar *filename = NULL;
+	g_autoptr(GdkPixbuf) pixbuf = NULL;
+	g_autoptr(GdkTexture) texture = NULL;
+	g_autoptr(GdkTexture) texture_other = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GsIconPack) pack = NULL;
+	g_autoptr(GsIconPack) pack_other = NULL;
+
+	tmpdir = g_dir_make_tmp ("gs-self-test-icon-pack-XXXXXX", &error);
+	g_assert_no_error (error);
+	filename = g_build_filename (tmpdir, "icons.pack", NULL);
+	pack = gs_icon_pack_new (filename, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (pack);
+	g_assert_false (gs_icon_pack_contains (pack, uri, NULL, NULL));
+	g_assert_null (gs_icon_pack_lookup (pack, uri, 64));
+
+	/* a 160px icon is stored at 64, 128 and 160px */
+	pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8, 160, 160);
+	gdk_pixbuf_fill (pixbuf, 0x3584e4ff);
+	gs_icon_pack_add_pixbuf (pack, uri, pixbuf, 1, &error);
+	g_assert_no_error (error);
+	g_assert_true (gs_icon_pack_contains (pack, uri, &width, &height));
+	g_assert_cmpuint (width, ==, 160);
+	g_assert_cmpuint (height, ==, 160);
+	texture = gs_icon_pack_lookup (pack, uri, 100);
+	g_assert_cmpint (gdk_texture_get_width (texture), ==, 128);
+	g_clear_object (&texture);
+
+	/* the same texture is returned while it is in use */
+	texture = gs_icon_pack_lookup (pack, uri, 100);
+	texture_other = gs_icon_pack_lookup (pack, uri, 128);
+	g_assert_true (texture == texture_other);
+	g_clear_object (&texture);
+	g_clear_object (&texture_other);
+
+	/* icons are looked up by their full URI */
+	g_assert_false (gs_icon_pack_contains (pack, uri_other, NULL, NULL));
+
+	/* icons added by another process are picked up when adding */
+	pack_other = gs_icon_pack_new (filename, &error);
+	g_assert_no_error (error);
+	g_assert_true (gs_icon_pack_contains (pack_other, uri, NULL, NULL));
+	gs_icon_pack_add_pixbuf (pack_other, uri_other, pixbuf, 1, &error);
+	g_assert_no_error (error);
+	g_clear_object (&pixbuf);
+	pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8, 64, 64);
+	gdk_pixbuf_fill (pixbuf, 0xe01b24ff);
+	gs_icon_pack_add_pixbuf (pack, uri_third, pixbuf, 1, &error);
+	g_assert_no_error (error);
+	g_assert_true (gs_icon_pack_contains (pack, uri_other, &width, &height));
+	g_assert_cmpuint (width, ==, 160);
+	g_clear_object (&pack_other);
+
+	/* simulate a crash while appending */
+	g_assert_cmpint (g_stat (filename, &st), ==, 0);
+	file = g_fopen (filename, "ab");
+	g_assert_nonnull (file);
+	fwrite ("GIR2", 1, 4, file);
+	fclose (file);
+
+	/* the icons are mapped when reopening, and the partly written record
+	 * is dropped by replacing the file rather than truncating it */
+	g_clear_object (&pack);
+	pack = gs_icon_pack_new (filename, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (g_stat (filename, &st_new), ==, 0);
+	g_assert_cmpint (st_new.st_ino, !=, st.st_ino);
+	g_assert_cmpint (st_new.st_size, ==, st.st_size);
+	g_assert_true (gs_icon_pack_contains (pack, uri_other, NULL, NULL));
+	g_assert_true (gs_icon_pack_contains (pack, uri_third, &width, &height));
+	g_assert_cmpuint (width, ==, 64);
+	g_assert_true (gs_icon_pack_contains (pack, uri, &width, &height));
+	g_assert_cmpuint (width, ==, 160);
+	texture = gs_icon_pack_lookup (pack, uri, 32);
+	g_assert_cmpint (gdk_texture_get_width (texture), ==, 64);
+	g_clear_object (&texture);
+	texture = gs_icon_pack_lookup (pack, uri, 512);
+	g_assert_cmpint (gdk_texture_get_width (texture), ==, 160);
+	gdk_texture_download (texture, pixels, 160 * 4);
+	g_assert_cmpuint (pixels[3], ==, 0xff);
+	g_clear_object (&texture);
+
+	g_clear_object (&pack);
+	g_assert_cmpint (g_unlink (filename), ==, 0);
+	g_assert_cmpint (g_rmdir (tmpdir), ==, 0);
+}
+
 static void
 gs_plugin_download_rewrite_func (void)
 {
@@ -727,6 +1260,50 @@ gs_app_progress_clamping_func (void)
 	}
 }
 
+static void
+gs_app_notify_count_cb (GObject *object, GParamSpec *pspec, gpointer user_data)
+{
+	guint *cnt = (guint *) user_data;
+	(*cnt)++;
+}
+
+static void
+gs_app_notify_coalesce_func (void)
+{
+	guint cnt_progress = 0;
+	guint cnt_summary = 0;
+	guint n_queued_old, n_merged_old, n_dispatched_old;
+	guint n_queued, n_merged, n_dispatched;
+	g_autoptr(GsApp) app = gs_app_new ("gnome-software.desktop");
+
+	gs_test_flush_main_context ();
+	g_signal_connect (app, "notify::progress",
+			  G_CALLBACK (gs_app_notify_count_cb), &cnt_progress);
+	g_signal_connect (app, "notify::summary",
+			  G_CALLBACK (gs_app_notify_count_cb), &cnt_summary);
+	gs_app_get_notify_stats (&n_queued_old, &n_merged_old, &n_dispatched_old);
+
+	/* lots of changes before the main loop runs only notify once each */
+	for (guint i = 1; i <= 100; i++)
+		gs_app_set_progress (app, i);
+	gs_app_set_summary (app, GS_APP_QUALITY_NORMAL, "Application manager");
+	g_assert_cmpint (cnt_progress, ==, 0);
+	gs_test_flush_main_context ();
+	g_assert_cmpint (cnt_progress, ==, 1);
+	g_assert_cmpint (cnt_summary, ==, 1);
+	g_assert_cmpint (gs_app_get_progress (app), ==, 100);
+
+	gs_app_get_notify_stats (&n_queued, &n_merged, &n_dispatched);
+	g_assert_cmpint (n_queued - n_queued_old, ==, 101);
+	g_assert_cmpint (n_merged - n_merged_old, ==, 99);
+	g_assert_cmpint (n_dispatched - n_dispatched_old, ==, 1);
+
+	/* changes after the dispatch are notified again */
+	gs_app_set_progress (app, 50);
+	gs_test_flush_main_context ();
+	g_assert_cmpint (cnt_progress, ==, 2);
+}
+
 static void
 gs_app_list_wildcard_dedupe_func (void)
 {
@@ -794,6 +1371,259 @@ gs_app_list_performance_func (void)
 	g_print ("%.2fms ", g_timer_elapsed (timer, NULL) * 1000);
 }
 
+static guint
+gs_app_list_index_add_apps (guint n_apps)
+{
+	g_autoptr(GPtrArray) apps = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	g_autoptr(GsAppList) list = gs_app_list_new ();
+
+	for (guint i = 0; i < n_apps; i++) {
+		g_autofree gchar *id = g_strdup_printf ("org.example.App%05u", i);
+		g_autoptr(GsApp) app = gs_app_new (id);
+		gs_app_set_bundle_kind (app, AS_BUNDLE_KIND_FLATPAK);
+		gs_app_set_origin (app, "flathub");
+		g_ptr_array_add (apps, g_steal_pointer (&app));
+	}
+
+	/* add them twice so every add does a duplicate check and a lookup */
+	for (guint i = 0; i < apps->len; i++)
+		gs_app_list_add (list, g_ptr_array_index (apps, i));
+	for (guint i = 0; i < apps->len; i++)
+		gs_app_list_add (list, g_ptr_array_index (apps, i));
+	g_assert_cmpint (gs_app_list_length (list), ==, n_apps);
+	g_assert_true (gs_app_list_lookup (list, "*/flatpak/flathub/org.example.App00042/*") ==
+		       g_ptr_array_index (apps, 42));
+	return gs_app_list_get_n_compared (list);
+}
+
+static void
+gs_app_list_index_performance_func (void)
+{
+	guint n_compared_small = gs_app_list_index_add_apps (5000);
+	guint n_compared_large = gs_app_list_index_add_apps (50000);
+
+	g_print ("%u vs %u comparisons ", n_compared_small, n_compared_large);
+
+	/* each ID is only ever compared against apps with the same ID, so 10×
+	 * the apps is 10× the comparisons rather than 100× */
+	g_assert_cmpuint (n_compared_small, <=, 5000 + 1);
+	g_assert_cmpuint (n_compared_large, <=, 50000 + 1);
+}
+
+static void
+gs_app_list_index_lazy_func (void)
+{
+	g_autoptr(GsAppList) list = gs_app_list_new ();
+	g_autoptr(GsApp) app1 = gs_app_new ("app1");
+	g_autoptr(GsApp) app2 = gs_app_new (NULL);
+	g_autoptr(GsApp) app3 = gs_app_new ("app1");
+
+	/* the unique ID is only set after the app was added */
+	gs_app_list_add (list, app1);
+	gs_app_list_add (list, app2);
+	g_assert_null (gs_app_list_lookup (list, "*/*/*/app2/*"));
+	gs_app_set_id (app2, "app2");
+	g_assert_true (gs_app_list_lookup (list, "*/*/*/app2/*") == app2);
+
+	/* same unique ID, so a duplicate */
+	gs_app_list_add (list, app3);
+	g_assert_cmpint (gs_app_list_length (list), ==, 2);
+
+	/* lookups still work after the list is reordered and shrunk */
+	gs_app_list_remove (list, app1);
+	g_assert_null (gs_app_list_lookup (list, "*/*/*/app1/*"));
+	gs_app_list_add (list, app3);
+	g_assert_true (gs_app_list_lookup (list, "*/*/*/app1/*") == app3);
+	g_assert_true (gs_app_list_lookup (list, "*/*/*/*/*") == app2);
+
+	/* an indexed app changing to another ID is found under the new one */
+	gs_app_set_id (app2, "app4");
+	g_assert_null (gs_app_list_lookup (list, "*/*/*/app2/*"));
+	g_assert_true (gs_app_list_lookup (list, "*/*/*/app4/*") == app2);
+
+	/* and so is one with its unique ID replaced */
+	gs_app_set_unique_id (app3, "system/flatpak/flathub/app5/stable");
+	g_assert_null (gs_app_list_lookup (list, "*/*/*/app1/*"));
+	g_assert_true (gs_app_list_lookup (list, "*/*/*/app5/*") == app3);
+}
+
+static void
+gs_app_list_index_wildcard_func (void)
+{
+	g_autoptr(GsAppList) list = gs_app_list_new ();
+	g_autoptr(GsAppList) list_other = gs_app_list_new ();
+	g_autoptr(GsApp) app_other = gs_app_new ("other");
+	g_autoptr(GsApp) app_empty = gs_app_new ("app100");
+	guint n_compared;
+
+	for (guint i = 0; i < 100; i++) {
+		g_autofree gchar *id = g_strdup_printf ("app%u", i);
+		g_autoptr(GsApp) app = gs_app_new (id);
+		gs_app_list_add (list, app);
+	}
+	gs_app_list_add (list_other, app_other);
+
+	/* an app with an empty ID matches any component ID, in list order */
+	gs_app_list_add (list, app_empty);
+	g_assert_true (gs_app_list_lookup (list, "*/*/*/app42/*") == gs_app_list_index (list, 42));
+	gs_app_set_id (app_empty, "");
+	g_assert_true (gs_app_list_lookup (list, "*/*/*/app42/*") == gs_app_list_index (list, 42));
+	g_assert_true (gs_app_list_lookup (list, "*/*/*/app100/*") == app_empty);
+
+	/* an app in another list changing its ID keeps this index */
+	n_compared = gs_app_list_get_n_compared (list);
+	gs_app_set_id (app_other, "other2");
+	g_assert_true (gs_app_list_lookup (list, "*/*/*/app7/*") == gs_app_list_index (list, 7));
+	g_assert_cmpuint (gs_app_list_get_n_compared (list) - n_compared, <=, 2);
+}
+
+static gchar *
+gs_app_list_sort_key_cb (GsApp *app, gpointer user_data)
+{
+	guint *n_calls = user_data;
+	(*n_calls)++;
+	return gs_app_dup_name_sort_key (app);
+}
+
+static void
+gs_app_list_sort_by_key_func (void)
+{
+	g_autoptr(GsAppList) list = gs_app_list_new ();
+	const gchar *names[] = { "beta", "Alpha", "gamma", NULL, "alpha" };
+	guint n_calls = 0;
+
+	for (guint i = 0; i < G_N_ELEMENTS (names); i++) {
+		g_autofree gchar *id = g_strdup_printf ("app%u", i);
+		g_autoptr(GsApp) app = gs_app_new (id);
+		gs_app_set_name (app, GS_APP_QUALITY_NORMAL, names[i]);
+		gs_app_list_add (list, app);
+	}
+
+	/* one key per app, case is ignored, and equal keys keep their order */
+	gs_app_list_sort_by_key (list, gs_app_list_sort_key_cb, GS_APP_LIST_SORT_FLAG_NONE, &n_calls);
+	g_assert_cmpuint (n_calls, ==, G_N_ELEMENTS (names));
+	g_assert_cmpstr (gs_app_get_id (gs_app_list_index (list, 0)), ==, "app3");
+	g_assert_cmpstr (gs_app_get_id (gs_app_list_index (list, 1)), ==, "app1");
+	g_assert_cmpstr (gs_app_get_id (gs_app_list_index (list, 2)), ==, "app4");
+	g_assert_cmpstr (gs_app_get_id (gs_app_list_index (list, 3)), ==, "app0");
+	g_assert_cmpstr (gs_app_get_id (gs_app_list_index (list, 4)), ==, "app2");
+	g_assert_true (gs_app_list_lookup (list, "*/*/*/app2/*") == gs_app_list_index (list, 4));
+
+	/* the cached key follows a change of name */
+	gs_app_set_name (gs_app_list_index (list, 4), GS_APP_QUALITY_HIGHEST, "aardvark");
+	gs_app_list_sort_by_key (list, gs_app_list_sort_key_cb, GS_APP_LIST_SORT_FLAG_DESCENDING, &n_calls);
+	g_assert_cmpuint (n_calls, ==, 2 * G_N_ELEMENTS (names));
+	g_assert_cmpstr (gs_app_get_id (gs_app_list_index (list, 0)), ==, "app0");
+	g_assert_cmpstr (gs_app_get_id (gs_app_list_index (list, 3)), ==, "app2");
+	g_assert_cmpstr (gs_app_get_id (gs_app_list_index (list, 4)), ==, "app3");
+}
+
+static gint
+gs_app_list_match_value_cb (GsApp *app1, GsApp *app2, gpointer user_data)
+{
+	guint *n_calls = user_data;
+	(*n_calls)++;
+	return (gint) gs_app_get_match_value (app2) - (gint) gs_app_get_match_value (app1);
+}
+
+static gchar *
+gs_app_list_match_value_key_cb (GsApp *app, gpointer user_data)
+{
+	return g_strdup_printf ("%05x", gs_app_get_match_value (app));
+}
+
+static void
+gs_app_list_truncate_sorted_func (void)
+{
+	g_autoptr(GsAppList) list = gs_app_list_new ();
+	g_autoptr(GsAppList) list_sorted = NULL;
+	g_autoptr(GsAppList) list_selected = NULL;
+	g_autoptr(GsAppList) list_keys = NULL;
+	g_autoptr(GRand) rand = g_rand_new_with_seed (42);
+	g_autoptr(GTimer) timer = g_timer_new ();
+	guint n_calls_sort = 0;
+	guint n_calls_select = 0;
+	gdouble elapsed_sort, elapsed_select;
+
+	/* lots of search results, with plenty of equal match values */
+	for (guint i = 0; i < 10000; i++) {
+		g_autofree gchar *id = g_strdup_printf ("org.example.App%05u", i);
+		g_autoptr(GsApp) app = gs_app_new (id);
+		gs_app_set_match_value (app, (guint) g_rand_int_range (rand, 0, 500));
+		gs_app_list_add (list, app);
+	}
+	list_sorted = gs_app_list_copy (list);
+	list_selected = gs_app_list_copy (list);
+	list_keys = gs_app_list_copy (list);
+
+	/* what the loader used to do */
+	g_timer_reset (timer);
+	gs_app_list_sort (list_sorted, gs_app_list_match_value_cb, &n_calls_sort);
+	gs_app_list_truncate (list_sorted, 20);
+	elapsed_sort = g_timer_elapsed (timer, NULL);
+
+	g_timer_reset (timer);
+	gs_app_list_truncate_sorted (list_selected, 20, gs_app_list_match_value_cb, &n_calls_select);
+	elapsed_select = g_timer_elapsed (timer, NULL);
+	g_print ("%.2fms vs %.2fms ", elapsed_sort * 1000, elapsed_select * 1000);
+
+	/* the same apps in the same order, with far fewer comparisons */
+	gs_app_list_truncate_sorted_by_key (list_keys, 20, gs_app_list_match_value_key_cb,
+					    GS_APP_LIST_SORT_FLAG_DESCENDING, NULL);
+	g_assert_cmpint (gs_app_list_length (list_selected), ==, 20);
+	g_assert_cmpint (gs_app_list_length (list_keys), ==, 20);
+	for (guint i = 0; i < 20; i++) {
+		GsApp *app = gs_app_list_index (list_sorted, i);
+		g_assert_true (gs_app_list_index (list_selected, i) == app);
+		g_assert_true (gs_app_list_index (list_keys, i) == app);
+	}
+	g_assert_true (gs_app_list_has_flag (list_selected, GS_APP_LIST_FLAG_IS_TRUNCATED));
+	g_assert_cmpuint (n_calls_select * 2, <, n_calls_sort);
+
+	/* short lists are just sorted */
+	gs_app_list_truncate_sorted (list_selected, 50, gs_app_list_match_value_cb, &n_calls_select);
+	g_assert_cmpint (gs_app_list_length (list_selected), ==, 20);
+	gs_app_list_truncate_sorted (list_selected, 0, gs_app_list_match_value_cb, &n_calls_select);
+	g_assert_cmpint (gs_app_list_length (list_selected), ==, 0);
+}
+
+static void
+gs_app_list_filter_duplicates_performance_func (void)
+{
+	g_autoptr(GsAppList) list = gs_app_list_new ();
+	g_autoptr(GTimer) timer = NULL;
+
+	/* each package has a flatpak which provides the same ID */
+	for (guint i = 0; i < 10000; i++) {
+		g_autofree gchar *id = g_strdup_printf ("app%05u.desktop", i);
+		g_autofree gchar *id_flatpak = g_strdup_printf ("org.example.App%05u", i);
+		g_autofree gchar *unique_id = g_strdup_printf ("system/package/fedora/%s/*", id);
+		g_autofree gchar *unique_id_flatpak = g_strdup_printf ("user/flathub/*/%s/*", id_flatpak);
+		g_autoptr(GsApp) app = gs_app_new (id);
+		g_autoptr(GsApp) app_flatpak = gs_app_new (id_flatpak);
+
+		gs_app_set_unique_id (app, unique_id);
+		gs_app_set_priority (app, 0);
+		gs_app_list_add (list, app);
+		gs_app_add_provided_item (app_flatpak, AS_PROVIDED_KIND_ID, id);
+		gs_app_set_unique_id (app_flatpak, unique_id_flatpak);
+		gs_app_set_priority (app_flatpak, 100);
+		gs_app_list_add (list, app_flatpak);
+	}
+	g_assert_cmpint (gs_app_list_length (list), ==, 20000);
+
+	timer = g_timer_new ();
+	gs_app_list_filter_duplicates (list, GS_APP_LIST_FILTER_FLAG_KEY_ID_PROVIDES);
+	g_print ("%.2fms ", g_timer_elapsed (timer, NULL) * 1000);
+
+	/* the flatpaks win, and keep their order */
+	g_assert_cmpint (gs_app_list_length (list), ==, 10000);
+	g_assert_cmpstr (gs_app_get_id (gs_app_list_index (list, 0)), ==, "org.example.App00000");
+	g_assert_cmpstr (gs_app_get_id (gs_app_list_index (list, 9999)), ==, "org.example.App09999");
+	g_assert_true (gs_app_list_lookup (list, "*/*/*/org.example.App00042/*") ==
+		       gs_app_list_index (list, 42));
+}
+
 static void
 gs_app_list_related_func (void)
 {
@@ -826,20 +1656,33 @@ main (int argc, char **argv)
 	g_test_add_func ("/gnome-software/lib/utils{wilson}", gs_utils_wilson_func);
 	g_test_add_func ("/gnome-software/lib/utils{error}", gs_utils_error_func);
 	g_test_add_func ("/gnome-software/lib/utils{cache}", gs_utils_cache_func);
+	g_test_add_func ("/gnome-software/lib/utils{file-size}", gs_utils_file_size_func);
 	g_test_add_func ("/gnome-software/lib/utils{append-kv}", gs_utils_append_kv_func);
 	g_test_add_func ("/gnome-software/lib/utils{parse-evr}", gs_utils_parse_evr_func);
+	g_test_add_func ("/gnome-software/lib/utils{pixbuf-blur}", gs_utils_pixbuf_blur_func);
 	g_test_add_func ("/gnome-software/lib/os-release", gs_os_release_func);
 	g_test_add_func ("/gnome-software/lib/app", gs_app_func);
 	g_test_add_func ("/gnome-software/lib/app/progress-clamping", gs_app_progress_clamping_func);
+	g_test_add_func ("/gnome-software/lib/app{notify-coalesce}", gs_app_notify_coalesce_func);
 	g_test_add_func ("/gnome-software/lib/app{addons}", gs_app_addons_func);
 	g_test_add_func ("/gnome-software/lib/app{unique-id}", gs_app_unique_id_func);
 	g_test_add_data_func ("/gnome-software/lib/app{thread}", debug, gs_app_thread_func);
 	g_test_add_func ("/gnome-software/lib/app{list}", gs_app_list_func);
 	g_test_add_func ("/gnome-software/lib/app{list-wildcard-dedupe}", gs_app_list_wildcard_dedupe_func);
 	g_test_add_func ("/gnome-software/lib/app{list-performance}", gs_app_list_performance_func);
+	g_test_add_func ("/gnome-software/lib/app{list-index-performance}", gs_app_list_index_performance_func);
+	g_test_add_func ("/gnome-software/lib/app{list-index-lazy}", gs_app_list_index_lazy_func);
+	g_test_add_func ("/gnome-software/lib/app{list-index-wildcard}", gs_app_list_index_wildcard_func);
 	g_test_add_func ("/gnome-software/lib/app{list-related}", gs_app_list_related_func);
+	g_test_add_func ("/gnome-software/lib/app{list-sort-by-key}", gs_app_list_sort_by_key_func);
+	g_test_add_func ("/gnome-software/lib/app{list-truncate-sorted}", gs_app_list_truncate_sorted_func);
+	g_test_add_func ("/gnome-software/lib/app{list-filter-duplicates-performance}", gs_app_list_filter_duplicates_performance_func);
 	g_test_add_func ("/gnome-software/lib/plugin", gs_plugin_func);
 	g_test_add_func ("/gnome-software/lib/plugin{download-rewrite}", gs_plugin_download_rewrite_func);
+	g_test_add_func ("/gnome-software/lib/odrs-provider{fetch-batch}", gs_odrs_provider_fetch_batch_func);
+	g_test_add_func ("/gnome-software/lib/remote-icon{download-batch}", gs_remote_icon_download_batch_func);
+	g_test_add_func ("/gnome-software/lib/icon-pack", gs_icon_pack_func);
+	g_test_add_func ("/gnome-software/lib/key-colors{cache}", gs_key_colors_cache_func);
 
 	return g_test_run ();
 }
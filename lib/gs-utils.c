@@ -24,6 +24,10 @@
 #include <fnmatch.h>
 #include <math.h>
 #include <string.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include <glib/gstdio.h>
 #include <json-glib/json-glib.h>
 
@@ -1295,113 +1299,171 @@ gs_utils_build_unique_id (AsComponentScope scope,
 				_fix_data_id_part (branch));
 }
 
+/* Box sums are divided by the kernel size by multiplying with a 8.24
+ * fixed-point reciprocal, which is exact for every possible sum as long as
+ * the kernel is smaller than this; larger kernels fall back to division */
+#define GS_PIXBUF_BLUR_MAX_RECIP_KERNEL	256
+
+/* The vertical pass works on whole rows at a time, so it is written with
+ * vector extensions rather than relying on the auto-vectoriser, which does
+ * not touch the widening multiply at -O2 */
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_convertvector)
+#define GS_PIXBUF_BLUR_LANES		8
+typedef guint8 GsPixbufBlurBytes __attribute__ ((vector_size (GS_PIXBUF_BLUR_LANES)));
+typedef guint32 GsPixbufBlurSums __attribute__ ((vector_size (GS_PIXBUF_BLUR_LANES * 4)));
+#endif
+#endif
+
+/* picks the widest vector unit the CPU has when the kernel is first called */
+#ifdef HAVE_TARGET_CLONES
+#define GS_PIXBUF_BLUR_TARGETS		__attribute__ ((target_clones ("avx2", "default")))
+#else
+#define GS_PIXBUF_BLUR_TARGETS
+#endif
+
+static inline guint8
+gs_pixbuf_blur_divide (guint32 sum, guint kernel_size, guint32 recip)
+{
+	if (kernel_size < GS_PIXBUF_BLUR_MAX_RECIP_KERNEL)
+		return (guint8) ((sum * recip) >> 24);
+	return (guint8) (sum / kernel_size);
+}
+
 static void
-gs_pixbuf_blur_private (GdkPixbuf *src, GdkPixbuf *dest, guint radius, guint8 *div_kernel_size)
+gs_pixbuf_blur_horizontal (const guint8 *src,
+			   guint8 *dest,
+			   gint width,
+			   gint n_channels,
+			   guint radius,
+			   guint32 recip)
+{
+	guint kernel_size = 2 * radius + 1;
+	gint width_minus_1 = width - 1;
+
+	for (gint c = 0; c < n_channels; c++) {
+		guint32 sum = 0;
+
+		/* calc the initial sum of the kernel */
+		for (gint i = -(gint) radius; i <= (gint) radius; i++)
+			sum += src[CLAMP (i, 0, width_minus_1) * n_channels + c];
+
+		for (gint x = 0; x < width; x++) {
+			gint i1 = MIN (x + (gint) radius + 1, width_minus_1);
+			gint i2 = MAX (x - (gint) radius, 0);
+
+			/* set as the mean of the kernel, then slide it along */
+			dest[x * n_channels + c] = gs_pixbuf_blur_divide (sum, kernel_size, recip);
+			sum += src[i1 * n_channels + c];
+			sum -= src[i2 * n_channels + c];
+		}
+	}
+}
+
+/* writes one row of means and slides every column's kernel down a row */
+static void GS_PIXBUF_BLUR_TARGETS
+gs_pixbuf_blur_vertical_row (const guint8 *add,
+			     const guint8 *remove,
+			     guint32 *sums,
+			     guint8 *dest,
+			     gsize len,
+			     guint32 recip)
+{
+	gsize i = 0;
+
+#ifdef GS_PIXBUF_BLUR_LANES
+	for (; i + GS_PIXBUF_BLUR_LANES <= len; i += GS_PIXBUF_BLUR_LANES) {
+		GsPixbufBlurBytes a, r, mean;
+		GsPixbufBlurSums s;
+
+		memcpy (&a, add + i, sizeof (a));
+		memcpy (&r, remove + i, sizeof (r));
+		memcpy (&s, sums + i, sizeof (s));
+		mean = __builtin_convertvector ((s * recip) >> 24, GsPixbufBlurBytes);
+		memcpy (dest + i, &mean, sizeof (mean));
+		s += __builtin_convertvector (a, GsPixbufBlurSums);
+		s -= __builtin_convertvector (r, GsPixbufBlurSums);
+		memcpy (sums + i, &s, sizeof (s));
+	}
+#endif
+	for (; i < len; i++) {
+		dest[i] = (guint8) ((sums[i] * recip) >> 24);
+		sums[i] += add[i];
+		sums[i] -= remove[i];
+	}
+}
+
+static void
+gs_pixbuf_blur_vertical_row_slow (const guint8 *add,
+				  const guint8 *remove,
+				  guint32 *sums,
+				  guint8 *dest,
+				  gsize len,
+				  guint kernel_size)
+{
+	for (gsize i = 0; i < len; i++) {
+		dest[i] = (guint8) (sums[i] / kernel_size);
+		sums[i] += add[i];
+		sums[i] -= remove[i];
+	}
+}
+
+static void
+gs_pixbuf_blur_private (GdkPixbuf *src, GdkPixbuf *dest, guint radius, guint32 *sums)
 {
 	gint width, height, src_rowstride, dest_rowstride, n_channels;
-	guchar *p_src, *p_dest, *c1, *c2;
-	gint x, y, i, i1, i2, width_minus_1, height_minus_1, radius_plus_1;
-	gint r, g, b;
-	guchar *p_dest_row, *p_dest_col;
+	guchar *p_src, *p_dest;
+	gint height_minus_1;
+	guint kernel_size = 2 * radius + 1;
+	guint32 recip = ((1u << 24) + kernel_size - 1) / kernel_size;
+	gsize row_len;
 
 	width = gdk_pixbuf_get_width (src);
 	height = gdk_pixbuf_get_height (src);
 	n_channels = gdk_pixbuf_get_n_channels (src);
-	radius_plus_1 = radius + 1;
+	row_len = (gsize) width * n_channels;
 
 	/* horizontal blur */
 	p_src = gdk_pixbuf_get_pixels (src);
 	p_dest = gdk_pixbuf_get_pixels (dest);
 	src_rowstride = gdk_pixbuf_get_rowstride (src);
 	dest_rowstride = gdk_pixbuf_get_rowstride (dest);
-	width_minus_1 = width - 1;
-	for (y = 0; y < height; y++) {
-
-		/* calc the initial sums of the kernel */
-		r = g = b = 0;
-		for (i = -radius; i <= (gint) radius; i++) {
-			c1 = p_src + (CLAMP (i, 0, width_minus_1) * n_channels);
-			r += c1[0];
-			g += c1[1];
-			b += c1[2];
-		}
-
-		p_dest_row = p_dest;
-		for (x = 0; x < width; x++) {
-			/* set as the mean of the kernel */
-			p_dest_row[0] = div_kernel_size[r];
-			p_dest_row[1] = div_kernel_size[g];
-			p_dest_row[2] = div_kernel_size[b];
-			p_dest_row += n_channels;
-
-			/* the pixel to add to the kernel */
-			i1 = x + radius_plus_1;
-			if (i1 > width_minus_1)
-				i1 = width_minus_1;
-			c1 = p_src + (i1 * n_channels);
-
-			/* the pixel to remove from the kernel */
-			i2 = x - radius;
-			if (i2 < 0)
-				i2 = 0;
-			c2 = p_src + (i2 * n_channels);
-
-			/* calc the new sums of the kernel */
-			r += c1[0] - c2[0];
-			g += c1[1] - c2[1];
-			b += c1[2] - c2[2];
-		}
-
-		p_src += src_rowstride;
-		p_dest += dest_rowstride;
+	for (gint y = 0; y < height; y++) {
+		gs_pixbuf_blur_horizontal (p_src + (gsize) y * src_rowstride,
+					   p_dest + (gsize) y * dest_rowstride,
+					   width, n_channels, radius, recip);
 	}
 
-	/* vertical blur */
+	/* vertical blur, a row at a time so that every column of the row is
+	 * handled by the same contiguous pass */
 	p_src = gdk_pixbuf_get_pixels (dest);
 	p_dest = gdk_pixbuf_get_pixels (src);
 	src_rowstride = gdk_pixbuf_get_rowstride (dest);
 	dest_rowstride = gdk_pixbuf_get_rowstride (src);
 	height_minus_1 = height - 1;
-	for (x = 0; x < width; x++) {
-
-		/* calc the initial sums of the kernel */
-		r = g = b = 0;
-		for (i = -radius; i <= (gint) radius; i++) {
-			c1 = p_src + (CLAMP (i, 0, height_minus_1) * src_rowstride);
-			r += c1[0];
-			g += c1[1];
-			b += c1[2];
-		}
 
-		p_dest_col = p_dest;
-		for (y = 0; y < height; y++) {
-			/* set as the mean of the kernel */
-
-			p_dest_col[0] = div_kernel_size[r];
-			p_dest_col[1] = div_kernel_size[g];
-			p_dest_col[2] = div_kernel_size[b];
-			p_dest_col += dest_rowstride;
-
-			/* the pixel to add to the kernel */
-			i1 = y + radius_plus_1;
-			if (i1 > height_minus_1)
-				i1 = height_minus_1;
-			c1 = p_src + (i1 * src_rowstride);
-
-			/* the pixel to remove from the kernel */
-			i2 = y - radius;
-			if (i2 < 0)
-				i2 = 0;
-			c2 = p_src + (i2 * src_rowstride);
-
-			/* calc the new sums of the kernel */
-			r += c1[0] - c2[0];
-			g += c1[1] - c2[1];
-			b += c1[2] - c2[2];
-		}
+	/* calc the initial sums of the kernel */
+	memset (sums, 0, row_len * sizeof (guint32));
+	for (gint i = -(gint) radius; i <= (gint) radius; i++) {
+		const guchar *c1 = p_src + (gsize) CLAMP (i, 0, height_minus_1) * src_rowstride;
+		for (gsize j = 0; j < row_len; j++)
+			sums[j] += c1[j];
+	}
 
-		p_src += n_channels;
-		p_dest += n_channels;
+	for (gint y = 0; y < height; y++) {
+		/* the rows to add to and remove from the kernel */
+		const guchar *c1 = p_src + (gsize) MIN (y + (gint) radius + 1, height_minus_1) * src_rowstride;
+		const guchar *c2 = p_src + (gsize) MAX (y - (gint) radius, 0) * src_rowstride;
+
+		if (kernel_size < GS_PIXBUF_BLUR_MAX_RECIP_KERNEL) {
+			gs_pixbuf_blur_vertical_row (c1, c2, sums,
+						     p_dest + (gsize) y * dest_rowstride,
+						     row_len, recip);
+		} else {
+			gs_pixbuf_blur_vertical_row_slow (c1, c2, sums,
+							  p_dest + (gsize) y * dest_rowstride,
+							  row_len, kernel_size);
+		}
 	}
 }
 
@@ -1411,28 +1473,293 @@ gs_pixbuf_blur_private (GdkPixbuf *src, GdkPixbuf *dest, guint radius, guint8 *d
  * @radius: the pixel radius for the gaussian blur, typical values are 1..3
  * @iterations: Amount to blur the image, typical values are 1..5
  *
- * Blurs an image. Warning, this method is s..l..o..w... for large images.
+ * Blurs an image. All channels are blurred, including alpha.
+ *
+ * This is still linear in the number of pixels, so callers which only need
+ * a blurred placeholder should blur a downscaled copy of the image, and
+ * large images should be blurred off the main thread.
  **/
 void
 gs_utils_pixbuf_blur (GdkPixbuf *src, guint radius, guint iterations)
 {
-	gint kernel_size;
-	gint i;
-	g_autofree guchar *div_kernel_size = NULL;
+	g_autofree guint32 *sums = NULL;
 	g_autoptr(GdkPixbuf) tmp = NULL;
 
+	g_return_if_fail (GDK_IS_PIXBUF (src));
+	g_return_if_fail (gdk_pixbuf_get_bits_per_sample (src) == 8);
+
 	tmp = gdk_pixbuf_new (gdk_pixbuf_get_colorspace (src),
 			      gdk_pixbuf_get_has_alpha (src),
 			      gdk_pixbuf_get_bits_per_sample (src),
 			      gdk_pixbuf_get_width (src),
 			      gdk_pixbuf_get_height (src));
-	kernel_size = 2 * radius + 1;
-	div_kernel_size = g_new (guchar, 256 * kernel_size);
-	for (i = 0; i < 256 * kernel_size; i++)
-		div_kernel_size[i] = (guchar) (i / kernel_size);
+	sums = g_new (guint32, (gsize) gdk_pixbuf_get_width (src) * gdk_pixbuf_get_n_channels (src));
 
 	while (iterations-- > 0)
-		gs_pixbuf_blur_private (src, tmp, radius, div_kernel_size);
+		gs_pixbuf_blur_private (src, tmp, radius, sums);
+}
+
+/* Directory totals are reused while the directory itself is unchanged, but
+ * a file can grow without its directory changing, so they also expire */
+#define GS_UTILS_FILE_SIZE_CACHE_MAX_AGE	(5 * 60 * G_USEC_PER_SEC)
+#define GS_UTILS_FILE_SIZE_CACHE_MAX_ENTRIES	65536
+#define GS_UTILS_FILE_SIZE_MAX_THREADS		4
+
+typedef struct {
+	dev_t		 dev;
+	ino_t		 ino;
+	struct timespec	 mtime;
+	struct timespec	 ctime;
+	gint64		 timestamp;
+	guint64		 size;		/* of the included files directly inside */
+	GPtrArray	*subdirs;	/* (element-type utf8): included subdirectory names */
+} GsFileSizeCacheEntry;
+
+typedef struct {
+	GMutex			 mutex;
+	GCond			 cond;
+	guint			 n_pending;
+	guint64			 size;
+	gsize			 base_len;
+	GsFileSizeIncludeFunc	 include_func;
+	gpointer		 user_data;
+	gboolean		 use_cache;
+	GCancellable		*cancellable;
+} GsFileSizeWalk;
+
+typedef struct {
+	GsFileSizeWalk		*walk;
+	gchar			*path;
+} GsFileSizeItem;
+
+G_LOCK_DEFINE_STATIC (file_size_cache);
+static GHashTable *file_size_cache = NULL;	/* (element-type utf8 GsFileSizeCacheEntry) */
+
+static void
+gs_utils_file_size_cache_entry_free (GsFileSizeCacheEntry *entry)
+{
+	g_ptr_array_unref (entry->subdirs);
+	g_free (entry);
+}
+
+static gboolean
+gs_utils_timespec_equal (const struct timespec *a, const struct timespec *b)
+{
+	return a->tv_sec == b->tv_sec && a->tv_nsec == b->tv_nsec;
+}
+
+static gchar *
+gs_utils_file_size_cache_key (GsFileSizeWalk *walk, const gchar *path)
+{
+	/* the included files depend on the callback and on where the walk
+	 * started, as the callback gets paths relative to that */
+	return g_strdup_printf ("%p:%" G_GSIZE_FORMAT ":%s",
+				walk->include_func, walk->base_len, path);
+}
+
+static gboolean
+gs_utils_file_size_cache_lookup (GsFileSizeWalk *walk,
+				 const gchar *path,
+				 const struct stat *st,
+				 guint64 *size,
+				 GPtrArray *subdirs)
+{
+	GsFileSizeCacheEntry *entry;
+	g_autofree gchar *key = NULL;
+
+	if (!walk->use_cache)
+		return FALSE;
+
+	key = gs_utils_file_size_cache_key (walk, path);
+	G_LOCK (file_size_cache);
+	entry = file_size_cache != NULL ? g_hash_table_lookup (file_size_cache, key) : NULL;
+	if (entry == NULL ||
+	    entry->dev != st->st_dev ||
+	    entry->ino != st->st_ino ||
+	    !gs_utils_timespec_equal (&entry->mtime, &st->st_mtim) ||
+	    !gs_utils_timespec_equal (&entry->ctime, &st->st_ctim) ||
+	    g_get_monotonic_time () - entry->timestamp > GS_UTILS_FILE_SIZE_CACHE_MAX_AGE) {
+		G_UNLOCK (file_size_cache);
+		return FALSE;
+	}
+	*size = entry->size;
+	for (guint i = 0; i < entry->subdirs->len; i++)
+		g_ptr_array_add (subdirs, g_build_filename (path, g_ptr_array_index (entry->subdirs, i), NULL));
+	G_UNLOCK (file_size_cache);
+	return TRUE;
+}
+
+static void
+gs_utils_file_size_cache_insert (GsFileSizeWalk *walk,
+				 const gchar *path,
+				 const struct stat *st,
+				 guint64 size,
+				 GPtrArray *subdir_names)
+{
+	GsFileSizeCacheEntry *entry;
+
+	if (!walk->use_cache)
+		return;
+
+	entry = g_new0 (GsFileSizeCacheEntry, 1);
+	entry->dev = st->st_dev;
+	entry->ino = st->st_ino;
+	entry->mtime = st->st_mtim;
+	entry->ctime = st->st_ctim;
+	entry->timestamp = g_get_monotonic_time ();
+	entry->size = size;
+	entry->subdirs = g_ptr_array_ref (subdir_names);
+
+	G_LOCK (file_size_cache);
+	if (file_size_cache == NULL) {
+		file_size_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+							 (GDestroyNotify) gs_utils_file_size_cache_entry_free);
+	}
+	/* not worth an LRU; it is only refilled on the next walk */
+	if (g_hash_table_size (file_size_cache) >= GS_UTILS_FILE_SIZE_CACHE_MAX_ENTRIES)
+		g_hash_table_remove_all (file_size_cache);
+	g_hash_table_replace (file_size_cache, gs_utils_file_size_cache_key (walk, path), entry);
+	G_UNLOCK (file_size_cache);
+}
+
+/* Sums the included files directly inside @path and adds the full paths of
+ * the included subdirectories to @subdirs. Entries are stat()ed relative to
+ * the directory fd, and directories reported by readdir() need no stat() at
+ * all, as only file sizes are counted. */
+static guint64
+gs_utils_file_size_scan_dir (GsFileSizeWalk *walk,
+			     const gchar *path,
+			     GPtrArray *subdirs)
+{
+	DIR *dir;
+	struct dirent *dent;
+	struct stat st_dir;
+	guint64 size = 0;
+	int fd;
+	g_autoptr(GPtrArray) subdir_names = NULL;
+
+	fd = open (path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fd < 0)
+		return 0;
+	if (fstat (fd, &st_dir) != 0) {
+		close (fd);
+		return 0;
+	}
+	if (gs_utils_file_size_cache_lookup (walk, path, &st_dir, &size, subdirs)) {
+		close (fd);
+		return size;
+	}
+	dir = fdopendir (fd);
+	if (dir == NULL) {
+		close (fd);
+		return 0;
+	}
+
+	subdir_names = g_ptr_array_new_with_free_func (g_free);
+	while ((dent = readdir (dir)) != NULL) {
+		struct stat st = { 0, };
+		GFileTest file_kind;
+
+		if (g_cancellable_is_cancelled (walk->cancellable)) {
+			closedir (dir);
+			return size;
+		}
+		if (g_strcmp0 (dent->d_name, ".") == 0 || g_strcmp0 (dent->d_name, "..") == 0)
+			continue;
+
+		if (dent->d_type == DT_DIR) {
+			file_kind = G_FILE_TEST_IS_DIR;
+		} else if (fstatat (dirfd (dir), dent->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+			continue;
+		} else if (S_ISLNK (st.st_mode)) {
+			/* Count the target of a symlink, but do not follow
+			 * symlinks to directories, they can point to a shared
+			 * storage */
+			if (fstatat (dirfd (dir), dent->d_name, &st, 0) != 0)
+				continue;
+			file_kind = G_FILE_TEST_IS_SYMLINK;
+		} else if (S_ISDIR (st.st_mode)) {
+			file_kind = G_FILE_TEST_IS_DIR;
+		} else {
+			file_kind = G_FILE_TEST_IS_REGULAR;
+		}
+
+		if (walk->include_func != NULL) {
+			g_autofree gchar *full_path = g_build_filename (path, dent->d_name, NULL);
+			if (!walk->include_func (full_path + walk->base_len, file_kind, walk->user_data))
+				continue;
+		}
+
+		if (file_kind == G_FILE_TEST_IS_DIR) {
+			g_ptr_array_add (subdir_names, g_strdup (dent->d_name));
+			g_ptr_array_add (subdirs, g_build_filename (path, dent->d_name, NULL));
+		} else if (!S_ISDIR (st.st_mode)) {
+			size += st.st_size;
+		}
+	}
+	closedir (dir);
+
+	gs_utils_file_size_cache_insert (walk, path, &st_dir, size, subdir_names);
+	return size;
+}
+
+static GThreadPool *gs_utils_file_size_get_pool (void);
+
+static void
+gs_utils_file_size_push (GsFileSizeWalk *walk, gchar *path)
+{
+	GsFileSizeItem *item = g_new0 (GsFileSizeItem, 1);
+
+	item->walk = walk;
+	item->path = path;
+
+	g_mutex_lock (&walk->mutex);
+	walk->n_pending++;
+	g_mutex_unlock (&walk->mutex);
+	g_thread_pool_push (gs_utils_file_size_get_pool (), item, NULL);
+}
+
+static void
+gs_utils_file_size_worker_cb (gpointer data, gpointer user_data)
+{
+	GThreadPool *pool = gs_utils_file_size_get_pool ();
+	GsFileSizeItem *item = data;
+	GsFileSizeWalk *walk = item->walk;
+	guint64 size = 0;
+	g_autoptr(GPtrArray) todo = g_ptr_array_new_with_free_func (g_free);
+
+	g_ptr_array_add (todo, g_steal_pointer (&item->path));
+	g_free (item);
+
+	while (todo->len > 0 && !g_cancellable_is_cancelled (walk->cancellable)) {
+		g_autofree gchar *path = g_ptr_array_steal_index_fast (todo, todo->len - 1);
+		size += gs_utils_file_size_scan_dir (walk, path, todo);
+
+		/* hand a subdirectory over when a worker has nothing to do,
+		 * and carry on depth-first with the rest */
+		if (todo->len > 1 && g_thread_pool_unprocessed (pool) == 0)
+			gs_utils_file_size_push (walk, g_ptr_array_steal_index_fast (todo, 0));
+	}
+
+	g_mutex_lock (&walk->mutex);
+	walk->size += size;
+	if (--walk->n_pending == 0)
+		g_cond_signal (&walk->cond);
+	g_mutex_unlock (&walk->mutex);
+}
+
+static GThreadPool *
+gs_utils_file_size_get_pool (void)
+{
+	static GThreadPool *pool = NULL;
+
+	if (g_once_init_enter (&pool)) {
+		GThreadPool *tmp = g_thread_pool_new (gs_utils_file_size_worker_cb, NULL,
+						      GS_UTILS_FILE_SIZE_MAX_THREADS,
+						      FALSE, NULL);
+		g_once_init_leave (&pool, tmp);
+	}
+	return pool;
 }
 
 /**
@@ -1447,6 +1774,11 @@ gs_utils_pixbuf_blur (GdkPixbuf *src, guint radius, guint iterations)
  * When the @include_func is not %NULL, it can limit which files are included
  * in the resulting size. When it's %NULL, all files and subdirectories are included.
  *
+ * Subdirectories are scanned in parallel, so the @include_func can be called
+ * from several threads at once. When @user_data is %NULL, the totals of the
+ * scanned directories are cached, and reused by later calls for as long as
+ * the directories are not modified, for up to five minutes.
+ *
  * Returns: disk size of the @filename; or 0 when not found
  *
  * Since: 41
@@ -1462,50 +1794,33 @@ gs_utils_get_file_size (const gchar *filename,
 	g_return_val_if_fail (filename != NULL, 0);
 
 	if (g_file_test (filename, G_FILE_TEST_IS_DIR)) {
-		GSList *dirs_to_do = NULL;
-		gsize base_len = strlen (filename);
+		GsFileSizeWalk walk = { 0, };
 
 		/* The `include_func()` expects a path relative to the `filename`, without
-		   a leading dir separator. As the `dirs_to_do` contains the full path,
-		   constructed with `g_build_filename()`, the added dir separator needs
-		   to be skipped, when it's not part of the `filename` already. */
+		   a leading dir separator. As the subdirectory paths are constructed with
+		   `g_build_filename()`, the added dir separator needs to be skipped, when
+		   it's not part of the `filename` already. */
+		walk.base_len = strlen (filename);
 		if (!g_str_has_suffix (filename, G_DIR_SEPARATOR_S))
-			base_len++;
-
-		dirs_to_do = g_slist_prepend (dirs_to_do, g_strdup (filename));
-		while (dirs_to_do != NULL && !g_cancellable_is_cancelled (cancellable)) {
-			g_autofree gchar *path = NULL;
-			g_autoptr(GDir) dir = NULL;
-
-			/* Steal the top `path` out of the `dirs_to_do`. */
-			path = dirs_to_do->data;
-			dirs_to_do = g_slist_remove (dirs_to_do, path);
-
-			dir = g_dir_open (path, 0, NULL);
-			if (dir) {
-				const gchar *name;
-				while (name = g_dir_read_name (dir), name != NULL && !g_cancellable_is_cancelled (cancellable)) {
-					g_autofree gchar *full_path = g_build_filename (path, name, NULL);
-					GStatBuf st;
-
-					if (g_stat (full_path, &st) == 0 && (include_func == NULL ||
-					    include_func (full_path + base_len,
-							  g_file_test (full_path, G_FILE_TEST_IS_SYMLINK) ? G_FILE_TEST_IS_SYMLINK :
-							  S_ISDIR (st.st_mode) ? G_FILE_TEST_IS_DIR :
-							  G_FILE_TEST_IS_REGULAR,
-							  user_data))) {
-						if (S_ISDIR (st.st_mode)) {
-							/* Skip symlinks, they can point to a shared storage */
-							if (!g_file_test (full_path, G_FILE_TEST_IS_SYMLINK))
-								dirs_to_do = g_slist_prepend (dirs_to_do, g_steal_pointer (&full_path));
-						} else {
-							size += st.st_size;
-						}
-					}
-				}
-			}
-		}
-		g_slist_free_full (dirs_to_do, g_free);
+			walk.base_len++;
+		walk.include_func = include_func;
+		walk.user_data = user_data;
+		walk.cancellable = cancellable;
+
+		/* the callback result can only be cached when it does not
+		 * depend on anything else */
+		walk.use_cache = user_data == NULL;
+
+		g_mutex_init (&walk.mutex);
+		g_cond_init (&walk.cond);
+		gs_utils_file_size_push (&walk, g_strdup (filename));
+		g_mutex_lock (&walk.mutex);
+		while (walk.n_pending > 0)
+			g_cond_wait (&walk.cond, &walk.mutex);
+		size = walk.size;
+		g_mutex_unlock (&walk.mutex);
+		g_mutex_clear (&walk.mutex);
+		g_cond_clear (&walk.cond);
 	} else {
 		GStatBuf st;
 
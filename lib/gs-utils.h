@@ -114,7 +114,8 @@ void		 gs_utils_pixbuf_blur		(GdkPixbuf	*src,
  *
  * Check whether include the @filename in the size calculation.
  * The @filename is a relative path to the file name passed to
- * the #GsFileSizeIncludeFunc.
+ * the #GsFileSizeIncludeFunc. It can be called from several threads
+ * at once.
  *
  * Returns: Whether to include the @filename in the size calculation
  *
@@ -10,6 +10,7 @@
  */
 
 #include <glib.h>
+#include <glib/gstdio.h>
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gdk/gdk.h>
 #include <locale.h>
@@ -21,7 +22,12 @@
  * gs_calculate_key_colors() function. It is linked against libgnomesoftware, so
  * will use the function implementation from there. It outputs a HTML page which
  * lists each icon from the flathub appstream data in your home directory, along
- * with its extracted key colors and how long extraction took. */
+ * with its extracted key colors and how long extraction took.
+ *
+ * The throughput of gs_calculate_key_colors() is reported at the end, along
+ * with that of gs_calculate_key_colors_cached() once every icon is in the
+ * persistent cache, which is how the key colors are normally fetched. Run it
+ * against builds of two revisions to compare changes to the calculation. */
 
 static void
 print_colours (GString *html_output,
@@ -43,6 +49,49 @@ print_colours (GString *html_output,
 	g_string_append_printf (html_output, "</tr></table>");
 }
 
+static gdouble
+durations_sum_seconds (GArray *durations  /* (element-type gint64) */)
+{
+	gint64 sum = 0;
+
+	for (guint i = 0; i < durations->len; i++)
+		sum += g_array_index (durations, gint64, i);
+
+	return (gdouble) sum / G_USEC_PER_SEC;
+}
+
+/* Times gs_calculate_key_colors_cached() over all of @pixbufs, twice: once to
+ * fill an empty cache and once to read back from it. */
+static void
+measure_cached (GPtrArray *pixbufs,
+                GArray    *durations_fill,
+                GArray    *durations_hit)
+{
+	g_autofree gchar *cache_dir = g_dir_make_tmp ("profile-key-colors-XXXXXX", NULL);
+	g_autofree gchar *cache_filename = NULL;
+
+	if (cache_dir == NULL)
+		return;
+	cache_filename = g_build_filename (cache_dir, "key-colors.bin", NULL);
+
+	for (guint pass = 0; pass < 2; pass++) {
+		GArray *durations = (pass == 0) ? durations_fill : durations_hit;
+
+		for (guint i = 0; i < pixbufs->len; i++) {
+			g_autoptr(GArray) colours = NULL;
+			gint64 start_time, duration;
+
+			start_time = g_get_real_time ();
+			colours = gs_calculate_key_colors_cached (pixbufs->pdata[i], cache_filename);
+			duration = g_get_real_time () - start_time;
+			g_array_append_val (durations, duration);
+		}
+	}
+
+	g_unlink (cache_filename);
+	g_rmdir (cache_dir);
+}
+
 static void
 print_summary_statistics (GString *html_output,
                           GArray  *durations  /* (element-type gint64) */)
@@ -85,6 +134,8 @@ main (void)
 	g_autoptr(GPtrArray) pixbufs = g_ptr_array_new_with_free_func (g_object_unref);
 	g_autoptr(GString) html_output = g_string_new ("");
 	g_autoptr(GArray) durations = g_array_new (FALSE, FALSE, sizeof (gint64));
+	g_autoptr(GArray) durations_fill = g_array_new (FALSE, FALSE, sizeof (gint64));
+	g_autoptr(GArray) durations_hit = g_array_new (FALSE, FALSE, sizeof (gint64));
 
 	setlocale (LC_ALL, "");
 
@@ -167,7 +218,22 @@ main (void)
 	print_summary_statistics (html_output, durations);
 	g_string_append (html_output, "</td><td></td></tr></tfoot>");
 
-	g_string_append (html_output, "</table></body></html>");
+	g_string_append (html_output, "</table>");
+
+	/* Throughput, uncached and cached. */
+	measure_cached (pixbufs, durations_fill, durations_hit);
+	g_string_append_printf (html_output,
+				"<p>Throughput: %.0f icons/s calculated",
+				pixbufs->len / durations_sum_seconds (durations));
+	if (durations_hit->len > 0) {
+		g_string_append_printf (html_output,
+					", %.0f icons/s filling the cache, %.0f icons/s from the cache",
+					pixbufs->len / durations_sum_seconds (durations_fill),
+					pixbufs->len / durations_sum_seconds (durations_hit));
+	}
+	g_string_append (html_output, "</p>\n");
+
+	g_string_append (html_output, "</body></html>");
 
 	g_print ("%s\n", html_output->str);
 
@@ -13,7 +13,7 @@
 #include <gnome-software.h>
 #include <xmlb.h>
 
-#include "gs-appstream.h"
+#include "gs-appstream-private.h"
 #include "gs-plugin-appstream.h"
 
 /*
@@ -32,7 +32,9 @@ struct _GsPluginAppstream
 	GsPlugin		 parent;
 
 	XbSilo			*silo;
+	GsAppstreamIndex	*index;  /* (nullable), protected by silo_lock */
 	GRWLock			 silo_lock;
+	GMutex			 silo_rebuild_mutex;
 	GSettings		*settings;
 };
 
@@ -43,9 +45,11 @@ gs_plugin_appstream_dispose (GObject *object)
 {
 	GsPluginAppstream *self = GS_PLUGIN_APPSTREAM (object);
 
+	g_clear_object (&self->index);
 	g_clear_object (&self->silo);
 	g_clear_object (&self->settings);
 	g_rw_lock_clear (&self->silo_lock);
+	g_mutex_clear (&self->silo_rebuild_mutex);
 
 	G_OBJECT_CLASS (gs_plugin_appstream_parent_class)->dispose (object);
 }
@@ -58,6 +62,7 @@ gs_plugin_appstream_init (GsPluginAppstream *self)
 	/* XbSilo needs external locking as we destroy the silo and build a new
 	 * one when something changes */
 	g_rw_lock_init (&self->silo_lock);
+	g_mutex_init (&self->silo_rebuild_mutex);
 
 	/* need package name */
 	gs_plugin_add_rule (GS_PLUGIN (self), GS_PLUGIN_RULE_RUN_AFTER, "dpkg");
@@ -505,33 +510,27 @@ gs_plugin_appstream_load_appstream (GsPluginAppstream  *self,
 	return TRUE;
 }
 
+/* Compiles a new silo and search index, and then swaps them in. This is
+ * called with silo_rebuild_mutex held, but not silo_lock, so other threads
+ * can carry on using the old silo in the meantime. */
 static gboolean
-gs_plugin_appstream_check_silo (GsPluginAppstream  *self,
-                                GCancellable       *cancellable,
-                                GError            **error)
+gs_plugin_appstream_rebuild_silo (GsPluginAppstream  *self,
+                                  GCancellable       *cancellable,
+                                  GError            **error)
 {
 	const gchar *test_xml;
 	g_autofree gchar *blobfn = NULL;
 	g_autoptr(XbBuilder) builder = NULL;
 	g_autoptr(XbNode) n = NULL;
 	g_autoptr(GFile) file = NULL;
-	g_autoptr(GRWLockReaderLocker) reader_locker = NULL;
+	g_autoptr(XbSilo) silo = NULL;
+	g_autoptr(GsAppstreamIndex) silo_index = NULL;
 	g_autoptr(GRWLockWriterLocker) writer_locker = NULL;
 	g_autoptr(GPtrArray) parent_appdata = g_ptr_array_new_with_free_func (g_free);
 	g_autoptr(GPtrArray) parent_appstream = g_ptr_array_new_with_free_func (g_free);
 	const gchar *const *locales = g_get_language_names ();
 	g_autoptr(GMainContext) old_thread_default = NULL;
 
-	reader_locker = g_rw_lock_reader_locker_new (&self->silo_lock);
-	/* everything is okay */
-	if (self->silo != NULL && xb_silo_is_valid (self->silo))
-		return TRUE;
-	g_clear_pointer (&reader_locker, g_rw_lock_reader_locker_free);
-
-	/* drat! silo needs regenerating */
-	writer_locker = g_rw_lock_writer_locker_new (&self->silo_lock);
-	g_clear_object (&self->silo);
-
 	/* FIXME: https://gitlab.gnome.org/GNOME/gnome-software/-/issues/1422 */
 	old_thread_default = g_main_context_ref_thread_default ();
 	if (old_thread_default == g_main_context_default ())
@@ -665,11 +664,11 @@ gs_plugin_appstream_check_silo (GsPluginAppstream  *self,
 	if (old_thread_default != NULL)
 		g_main_context_pop_thread_default (old_thread_default);
 
-	self->silo = xb_builder_ensure (builder, file,
-					XB_BUILDER_COMPILE_FLAG_IGNORE_INVALID |
-					XB_BUILDER_COMPILE_FLAG_SINGLE_LANG,
-					NULL, error);
-	if (self->silo == NULL) {
+	silo = xb_builder_ensure (builder, file,
+				  XB_BUILDER_COMPILE_FLAG_IGNORE_INVALID |
+				  XB_BUILDER_COMPILE_FLAG_SINGLE_LANG,
+				  NULL, error);
+	if (silo == NULL) {
 		if (old_thread_default != NULL)
 			g_main_context_push_thread_default (old_thread_default);
 		return FALSE;
@@ -679,7 +678,7 @@ gs_plugin_appstream_check_silo (GsPluginAppstream  *self,
 	for (guint i = 0; i < parent_appstream->len; i++) {
 		const gchar *fn = g_ptr_array_index (parent_appstream, i);
 		g_autoptr(GFile) file_tmp = g_file_new_for_path (fn);
-		if (!xb_silo_watch_file (self->silo, file_tmp, cancellable, error)) {
+		if (!xb_silo_watch_file (silo, file_tmp, cancellable, error)) {
 			if (old_thread_default != NULL)
 				g_main_context_push_thread_default (old_thread_default);
 			return FALSE;
@@ -688,7 +687,7 @@ gs_plugin_appstream_check_silo (GsPluginAppstream  *self,
 	for (guint i = 0; i < parent_appdata->len; i++) {
 		const gchar *fn = g_ptr_array_index (parent_appdata, i);
 		g_autoptr(GFile) file_tmp = g_file_new_for_path (fn);
-		if (!xb_silo_watch_file (self->silo, file_tmp, cancellable, error)) {
+		if (!xb_silo_watch_file (silo, file_tmp, cancellable, error)) {
 			if (old_thread_default != NULL)
 				g_main_context_push_thread_default (old_thread_default);
 			return FALSE;
@@ -699,7 +698,7 @@ gs_plugin_appstream_check_silo (GsPluginAppstream  *self,
 		g_main_context_push_thread_default (old_thread_default);
 
 	/* test we found something */
-	n = xb_silo_query_first (self->silo, "components/component", NULL);
+	n = xb_silo_query_first (silo, "components/component", NULL);
 	if (n == NULL) {
 		g_warning ("No AppStream data, try 'make install-sample-data' in data/");
 		g_set_error (error,
@@ -709,17 +708,84 @@ gs_plugin_appstream_check_silo (GsPluginAppstream  *self,
 		return FALSE;
 	}
 
+	/* the search index is optional, so failing to build it is not fatal */
+	if (test_xml == NULL) {
+		g_autofree gchar *indexfn = NULL;
+		g_autoptr(GError) error_local = NULL;
+
+		indexfn = gs_utils_get_cache_filename ("appstream", "components.index",
+						       GS_UTILS_CACHE_FLAG_WRITEABLE |
+						       GS_UTILS_CACHE_FLAG_CREATE_DIRECTORY,
+						       &error_local);
+		if (indexfn != NULL)
+			silo_index = gs_appstream_index_new_for_silo (silo, indexfn,
+								      cancellable, &error_local);
+		if (silo_index == NULL)
+			g_warning ("failed to build search index: %s", error_local->message);
+	} else {
+		silo_index = gs_appstream_index_new_for_silo (silo, NULL,
+							      cancellable, error);
+		if (silo_index == NULL)
+			return FALSE;
+	}
+
+	/* readers only have to wait for the swap */
+	writer_locker = g_rw_lock_writer_locker_new (&self->silo_lock);
+	g_set_object (&self->silo, silo);
+	g_set_object (&self->index, silo_index);
+
 	/* success */
 	return TRUE;
 }
 
+/* If @block is %FALSE and another thread is already rebuilding the silo,
+ * the old silo is used until it is done rather than waiting; callers which
+ * need the result of a rebuild, such as refresh, must pass %TRUE. */
+static gboolean
+gs_plugin_appstream_check_silo (GsPluginAppstream  *self,
+                                gboolean            block,
+                                GCancellable       *cancellable,
+                                GError            **error)
+{
+	gboolean ret;
+	g_autoptr(GRWLockReaderLocker) reader_locker = NULL;
+
+	reader_locker = g_rw_lock_reader_locker_new (&self->silo_lock);
+	/* everything is okay */
+	if (self->silo != NULL && xb_silo_is_valid (self->silo))
+		return TRUE;
+	g_clear_pointer (&reader_locker, g_rw_lock_reader_locker_free);
+
+	/* drat! silo needs regenerating; if another thread is already doing
+	 * that, use the old silo until it is done unless asked to wait */
+	if (block) {
+		g_mutex_lock (&self->silo_rebuild_mutex);
+	} else if (!g_mutex_trylock (&self->silo_rebuild_mutex)) {
+		reader_locker = g_rw_lock_reader_locker_new (&self->silo_lock);
+		if (self->silo != NULL)
+			return TRUE;
+		g_clear_pointer (&reader_locker, g_rw_lock_reader_locker_free);
+		g_mutex_lock (&self->silo_rebuild_mutex);
+	}
+
+	/* it may have been rebuilt while waiting */
+	reader_locker = g_rw_lock_reader_locker_new (&self->silo_lock);
+	ret = self->silo != NULL && xb_silo_is_valid (self->silo);
+	g_clear_pointer (&reader_locker, g_rw_lock_reader_locker_free);
+	if (!ret)
+		ret = gs_plugin_appstream_rebuild_silo (self, cancellable, error);
+	g_mutex_unlock (&self->silo_rebuild_mutex);
+
+	return ret;
+}
+
 gboolean
 gs_plugin_setup (GsPlugin *plugin, GCancellable *cancellable, GError **error)
 {
 	GsPluginAppstream *self = GS_PLUGIN_APPSTREAM (plugin);
 
 	/* set up silo, compiling if required */
-	return gs_plugin_appstream_check_silo (self, cancellable, error);
+	return gs_plugin_appstream_check_silo (self, TRUE, cancellable, error);
 }
 
 gboolean
@@ -733,7 +799,7 @@ gs_plugin_url_to_app (GsPlugin *plugin,
 	g_autoptr(GRWLockReaderLocker) locker = NULL;
 
 	/* check silo is valid */
-	if (!gs_plugin_appstream_check_silo (self, cancellable, error))
+	if (!gs_plugin_appstream_check_silo (self, FALSE, cancellable, error))
 		return FALSE;
 
 	locker = g_rw_lock_reader_locker_new (&self->silo_lock);
@@ -916,6 +982,106 @@ gs_plugin_refine_from_pkgname (GsPluginAppstream    *self,
 	return TRUE;
 }
 
+/* prefer actual apps and then fallback to anything else, as in the
+ * query used by gs_plugin_refine_from_pkgname() */
+static XbNode *
+gs_plugin_appstream_get_best_pkgname_component (GPtrArray *components)
+{
+	const gchar *types[] = { "desktop", "console", "webapp", NULL };
+
+	for (guint j = 0; types[j] != NULL; j++) {
+		for (guint i = 0; i < components->len; i++) {
+			XbNode *component = g_ptr_array_index (components, i);
+			if (g_strcmp0 (xb_node_get_attr (component, "type"), types[j]) == 0)
+				return component;
+		}
+	}
+	return g_ptr_array_index (components, 0);
+}
+
+static gboolean
+gs_plugin_appstream_component_has_pkgname (XbNode *component)
+{
+	g_autoptr(XbNode) n = xb_node_get_child (component);
+
+	while (n != NULL) {
+		XbNode *next;
+		if (g_strcmp0 (xb_node_get_element (n), "pkgname") == 0)
+			return TRUE;
+		next = xb_node_get_next (n);
+		g_object_unref (n);
+		n = next;
+	}
+	return FALSE;
+}
+
+/* this is the same as gs_plugin_refine_from_id() and then
+ * gs_plugin_refine_from_pkgname(), but uses the lookup tables in the index
+ * rather than building and running queries for each app */
+static gboolean
+gs_plugin_appstream_refine_from_index (GsPluginAppstream    *self,
+                                       GsApp                *app,
+                                       GsPluginRefineFlags   flags,
+                                       GError              **error)
+{
+	GPtrArray *sources;
+	const gchar *id = gs_app_get_id (app);
+	gboolean found = FALSE;
+
+	/* find by ID */
+	if (id != NULL) {
+		GPtrArray *components = gs_appstream_index_lookup_id (self->index, id);
+		const gchar *origin = gs_app_get_origin_appstream (app);
+		gboolean installed = FALSE;
+
+		for (guint i = 0; components != NULL && i < components->len; i++) {
+			XbNode *component = g_ptr_array_index (components, i);
+			g_autoptr(XbNode) parent = xb_node_get_parent (component);
+
+			/* installed AppData files are not in a <components> */
+			if (parent == NULL) {
+				installed = TRUE;
+			} else {
+				if (origin != NULL && *origin != '\0' &&
+				    g_strcmp0 (xb_node_get_attr (parent, "origin"), origin) != 0)
+					continue;
+				if (g_strcmp0 (xb_node_get_attr (component, "type"), "webapp") != 0 &&
+				    !gs_plugin_appstream_component_has_pkgname (component))
+					continue;
+			}
+			if (!gs_appstream_refine_app (GS_PLUGIN (self), app, self->silo,
+						      component, flags, error))
+				return FALSE;
+			gs_plugin_appstream_set_compulsory_quirk (app, component);
+			found = TRUE;
+		}
+
+		/* if an installed desktop or appdata file exists set to installed */
+		if (installed && gs_app_get_state (app) == GS_APP_STATE_UNKNOWN)
+			gs_app_set_state (app, GS_APP_STATE_INSTALLED);
+	}
+	if (found)
+		return TRUE;
+
+	/* fall back to package name */
+	sources = gs_app_get_sources (app);
+	for (guint j = 0; j < sources->len; j++) {
+		const gchar *pkgname = g_ptr_array_index (sources, j);
+		GPtrArray *components = gs_appstream_index_lookup_pkgname (self->index, pkgname);
+		XbNode *component;
+
+		if (components == NULL)
+			continue;
+		component = gs_plugin_appstream_get_best_pkgname_component (components);
+		if (!gs_appstream_refine_app (GS_PLUGIN (self), app, self->silo, component, flags, error))
+			return FALSE;
+		gs_plugin_appstream_set_compulsory_quirk (app, component);
+	}
+
+	/* success */
+	return TRUE;
+}
+
 gboolean
 gs_plugin_refine (GsPlugin *plugin,
 		  GsAppList *list,
@@ -924,14 +1090,35 @@ gs_plugin_refine (GsPlugin *plugin,
 		  GError **error)
 {
 	GsPluginAppstream *self = GS_PLUGIN_APPSTREAM (plugin);
-	gboolean found = FALSE;
+	g_autoptr(GRWLockReaderLocker) locker = NULL;
 
 	/* check silo is valid */
-	if (!gs_plugin_appstream_check_silo (self, cancellable, error))
+	if (!gs_plugin_appstream_check_silo (self, FALSE, cancellable, error))
 		return FALSE;
 
+	/* resolve the whole list with hash lookups while holding the lock */
+	locker = g_rw_lock_reader_locker_new (&self->silo_lock);
+	if (self->index != NULL) {
+		for (guint i = 0; i < gs_app_list_length (list); i++) {
+			GsApp *app = gs_app_list_index (list, i);
+
+			/* not us */
+			if (gs_app_get_bundle_kind (app) != AS_BUNDLE_KIND_PACKAGE &&
+			    gs_app_get_bundle_kind (app) != AS_BUNDLE_KIND_UNKNOWN)
+				continue;
+
+			if (g_cancellable_set_error_if_cancelled (cancellable, error))
+				return FALSE;
+			if (!gs_plugin_appstream_refine_from_index (self, app, flags, error))
+				return FALSE;
+		}
+		return TRUE;
+	}
+	g_clear_pointer (&locker, g_rw_lock_reader_locker_free);
+
 	for (guint i = 0; i < gs_app_list_length (list); i++) {
 		GsApp *app = gs_app_list_index (list, i);
+		gboolean found = FALSE;
 
 		/* not us */
 		if (gs_app_get_bundle_kind (app) != AS_BUNDLE_KIND_PACKAGE &&
@@ -951,33 +1138,63 @@ gs_plugin_refine (GsPlugin *plugin,
 	return TRUE;
 }
 
-gboolean
-gs_plugin_refine_wildcard (GsPlugin *plugin,
-			   GsApp *app,
-			   GsAppList *list,
-			   GsPluginRefineFlags refine_flags,
-			   GCancellable *cancellable,
-			   GError **error)
+static gboolean
+gs_plugin_appstream_add_wildcard_apps (GsPluginAppstream    *self,
+                                       GsApp                *app,
+                                       GPtrArray            *components,
+                                       GsAppList            *list,
+                                       GsPluginRefineFlags   refine_flags,
+                                       GError              **error)
+{
+	for (guint i = 0; i < components->len; i++) {
+		XbNode *component = g_ptr_array_index (components, i);
+		g_autoptr(GsApp) new = NULL;
+
+		/* new app */
+		new = gs_appstream_create_app (GS_PLUGIN (self), self->silo, component, error);
+		if (new == NULL)
+			return FALSE;
+		gs_app_set_scope (new, AS_COMPONENT_SCOPE_SYSTEM);
+		gs_app_subsume_metadata (new, app);
+		if (!gs_appstream_refine_app (GS_PLUGIN (self), new, self->silo, component,
+					      refine_flags, error))
+			return FALSE;
+		gs_app_list_add (list, new);
+	}
+	return TRUE;
+}
+
+static gboolean
+gs_plugin_appstream_refine_wildcard (GsPluginAppstream    *self,
+                                     GsApp                *app,
+                                     GsAppList            *list,
+                                     GsPluginRefineFlags   refine_flags,
+                                     GError              **error)
 {
-	GsPluginAppstream *self = GS_PLUGIN_APPSTREAM (plugin);
 	const gchar *id;
 	g_autofree gchar *xpath = NULL;
 	g_autoptr(GError) error_local = NULL;
-	g_autoptr(GRWLockReaderLocker) locker = NULL;
 	g_autoptr(GPtrArray) components = NULL;
 
-	/* check silo is valid */
-	if (!gs_plugin_appstream_check_silo (self, cancellable, error))
-		return FALSE;
-
 	/* not enough info to find */
 	id = gs_app_get_id (app);
 	if (id == NULL)
 		return TRUE;
 
-	locker = g_rw_lock_reader_locker_new (&self->silo_lock);
-
 	/* find all app with package names when matching any prefixes */
+	if (self->index != NULL) {
+		GPtrArray *matches = gs_appstream_index_lookup_id (self->index, id);
+
+		components = g_ptr_array_new_with_free_func (g_object_unref);
+		for (guint i = 0; matches != NULL && i < matches->len; i++) {
+			XbNode *component = g_ptr_array_index (matches, i);
+			g_autoptr(XbNode) parent = xb_node_get_parent (component);
+			if (parent != NULL && gs_plugin_appstream_component_has_pkgname (component))
+				g_ptr_array_add (components, g_object_ref (component));
+		}
+		return gs_plugin_appstream_add_wildcard_apps (self, app, components, list,
+							      refine_flags, error);
+	}
 	xpath = g_strdup_printf ("components/component/id[text()='%s']/../pkgname/..", id);
 	components = xb_silo_query (self->silo, xpath, 0, &error_local);
 	if (components == NULL) {
@@ -988,20 +1205,39 @@ gs_plugin_refine_wildcard (GsPlugin *plugin,
 		g_propagate_error (error, g_steal_pointer (&error_local));
 		return FALSE;
 	}
-	for (guint i = 0; i < components->len; i++) {
-		XbNode *component = g_ptr_array_index (components, i);
-		g_autoptr(GsApp) new = NULL;
+	return gs_plugin_appstream_add_wildcard_apps (self, app, components, list,
+						      refine_flags, error);
+}
 
-		/* new app */
-		new = gs_appstream_create_app (GS_PLUGIN (self), self->silo, component, error);
-		if (new == NULL)
+gboolean
+gs_plugin_refine_wildcards (GsPlugin *plugin,
+			    GsAppList *list,
+			    GsPluginRefineFlags refine_flags,
+			    GCancellable *cancellable,
+			    GError **error)
+{
+	GsPluginAppstream *self = GS_PLUGIN_APPSTREAM (plugin);
+	g_autoptr(GRWLockReaderLocker) locker = NULL;
+	g_autoptr(GsAppList) wildcards = NULL;
+
+	/* check silo is valid */
+	if (!gs_plugin_appstream_check_silo (self, FALSE, cancellable, error))
+		return FALSE;
+
+	/* the new apps are added to @list, so don't look at those */
+	wildcards = gs_app_list_copy (list);
+
+	/* take the lock once for all the wildcards */
+	locker = g_rw_lock_reader_locker_new (&self->silo_lock);
+	for (guint i = 0; i < gs_app_list_length (wildcards); i++) {
+		GsApp *app = gs_app_list_index (wildcards, i);
+
+		if (!gs_app_has_quirk (app, GS_APP_QUIRK_IS_WILDCARD))
+			continue;
+		if (g_cancellable_set_error_if_cancelled (cancellable, error))
 			return FALSE;
-		gs_app_set_scope (new, AS_COMPONENT_SCOPE_SYSTEM);
-		gs_app_subsume_metadata (new, app);
-		if (!gs_appstream_refine_app (GS_PLUGIN (self), new, self->silo, component,
-					      refine_flags, error))
+		if (!gs_plugin_appstream_refine_wildcard (self, app, list, refine_flags, error))
 			return FALSE;
-		gs_app_list_add (list, new);
 	}
 
 	/* success */
@@ -1018,15 +1254,17 @@ gs_plugin_add_category_apps (GsPlugin *plugin,
 	GsPluginAppstream *self = GS_PLUGIN_APPSTREAM (plugin);
 	g_autoptr(GRWLockReaderLocker) locker = NULL;
 
-	if (!gs_plugin_appstream_check_silo (self, cancellable, error))
+	if (!gs_plugin_appstream_check_silo (self, FALSE, cancellable, error))
 		return FALSE;
 
 	locker = g_rw_lock_reader_locker_new (&self->silo_lock);
-	return gs_appstream_add_category_apps (self->silo,
-					       category,
-					       list,
-					       cancellable,
-					       error);
+	return gs_appstream_add_category_apps_with_index (plugin,
+							  self->silo,
+							  self->index,
+							  category,
+							  list,
+							  cancellable,
+							  error);
 }
 
 gboolean
@@ -1039,16 +1277,17 @@ gs_plugin_add_search (GsPlugin *plugin,
 	GsPluginAppstream *self = GS_PLUGIN_APPSTREAM (plugin);
 	g_autoptr(GRWLockReaderLocker) locker = NULL;
 
-	if (!gs_plugin_appstream_check_silo (self, cancellable, error))
+	if (!gs_plugin_appstream_check_silo (self, FALSE, cancellable, error))
 		return FALSE;
 
 	locker = g_rw_lock_reader_locker_new (&self->silo_lock);
-	return gs_appstream_search (plugin,
-				    self->silo,
-				    (const gchar * const *) values,
-				    list,
-				    cancellable,
-				    error);
+	return gs_appstream_search_with_index (plugin,
+					       self->silo,
+					       self->index,
+					       (const gchar * const *) values,
+					       list,
+					       cancellable,
+					       error);
 }
 
 gboolean
@@ -1062,7 +1301,7 @@ gs_plugin_add_installed (GsPlugin *plugin,
 	g_autoptr(GPtrArray) components = NULL;
 
 	/* check silo is valid */
-	if (!gs_plugin_appstream_check_silo (self, cancellable, error))
+	if (!gs_plugin_appstream_check_silo (self, FALSE, cancellable, error))
 		return FALSE;
 
 	locker = g_rw_lock_reader_locker_new (&self->silo_lock);
@@ -1095,12 +1334,12 @@ gs_plugin_add_categories (GsPlugin *plugin,
 	GsPluginAppstream *self = GS_PLUGIN_APPSTREAM (plugin);
 	g_autoptr(GRWLockReaderLocker) locker = NULL;
 
-	if (!gs_plugin_appstream_check_silo (self, cancellable, error))
+	if (!gs_plugin_appstream_check_silo (self, FALSE, cancellable, error))
 		return FALSE;
 
 	locker = g_rw_lock_reader_locker_new (&self->silo_lock);
-	return gs_appstream_add_categories (self->silo, list,
-					    cancellable, error);
+	return gs_appstream_add_categories_with_index (self->silo, self->index, list,
+						       cancellable, error);
 }
 
 gboolean
@@ -1112,7 +1351,7 @@ gs_plugin_add_popular (GsPlugin *plugin,
 	GsPluginAppstream *self = GS_PLUGIN_APPSTREAM (plugin);
 	g_autoptr(GRWLockReaderLocker) locker = NULL;
 
-	if (!gs_plugin_appstream_check_silo (self, cancellable, error))
+	if (!gs_plugin_appstream_check_silo (self, FALSE, cancellable, error))
 		return FALSE;
 
 	locker = g_rw_lock_reader_locker_new (&self->silo_lock);
@@ -1128,7 +1367,7 @@ gs_plugin_add_featured (GsPlugin *plugin,
 	GsPluginAppstream *self = GS_PLUGIN_APPSTREAM (plugin);
 	g_autoptr(GRWLockReaderLocker) locker = NULL;
 
-	if (!gs_plugin_appstream_check_silo (self, cancellable, error))
+	if (!gs_plugin_appstream_check_silo (self, FALSE, cancellable, error))
 		return FALSE;
 
 	locker = g_rw_lock_reader_locker_new (&self->silo_lock);
@@ -1145,7 +1384,7 @@ gs_plugin_add_recent (GsPlugin *plugin,
 	GsPluginAppstream *self = GS_PLUGIN_APPSTREAM (plugin);
 	g_autoptr(GRWLockReaderLocker) locker = NULL;
 
-	if (!gs_plugin_appstream_check_silo (self, cancellable, error))
+	if (!gs_plugin_appstream_check_silo (self, FALSE, cancellable, error))
 		return FALSE;
 
 	locker = g_rw_lock_reader_locker_new (&self->silo_lock);
@@ -1163,7 +1402,7 @@ gs_plugin_add_alternates (GsPlugin *plugin,
 	GsPluginAppstream *self = GS_PLUGIN_APPSTREAM (plugin);
 	g_autoptr(GRWLockReaderLocker) locker = NULL;
 
-	if (!gs_plugin_appstream_check_silo (self, cancellable, error))
+	if (!gs_plugin_appstream_check_silo (self, FALSE, cancellable, error))
 		return FALSE;
 
 	locker = g_rw_lock_reader_locker_new (&self->silo_lock);
@@ -1178,7 +1417,7 @@ gs_plugin_refresh (GsPlugin *plugin,
 		   GError **error)
 {
 	GsPluginAppstream *self = GS_PLUGIN_APPSTREAM (plugin);
-	return gs_plugin_appstream_check_silo (self, cancellable, error);
+	return gs_plugin_appstream_check_silo (self, TRUE, cancellable, error);
 }
 
 static void
@@ -20,7 +20,10 @@
  * Loads remote icons and converts them into local cached ones.
  *
  * It is provided so that each plugin handling icons does not
- * have to handle the download and caching functionality.
+ * have to handle the download and caching functionality. The icons of
+ * all the apps being refined are downloaded as one batch, so that
+ * several downloads are in flight at once and shared icons are only
+ * fetched once.
  *
  * FIXME: This plugin will eventually go away. Currently it only exists as the
  * plugin threading code is a convenient way of ensuring that loading the remote
@@ -41,30 +44,6 @@ gs_plugin_icons_init (GsPluginIcons *self)
 	gs_plugin_add_rule (GS_PLUGIN (self), GS_PLUGIN_RULE_RUN_AFTER, "appstream");
 }
 
-static gboolean
-refine_app (GsPlugin             *plugin,
-	    GsApp                *app,
-	    GsPluginRefineFlags   flags,
-	    GCancellable         *cancellable,
-	    GError              **error)
-{
-	SoupSession *soup_session;
-	guint maximum_icon_size;
-
-	/* not required */
-	if ((flags & GS_PLUGIN_REFINE_FLAGS_REQUIRE_ICON) == 0)
-		return TRUE;
-
-	soup_session = gs_plugin_get_soup_session (plugin);
-
-	/* Currently a 160px icon is needed for #GsFeatureTile, at most. */
-	maximum_icon_size = 160 * gs_plugin_get_scale (plugin);
-
-	gs_app_ensure_icons_downloaded (app, soup_session, maximum_icon_size, cancellable);
-
-	return TRUE;
-}
-
 gboolean
 gs_plugin_refine (GsPlugin             *plugin,
 		  GsAppList            *list,
@@ -72,14 +51,37 @@ gs_plugin_refine (GsPlugin             *plugin,
 		  GCancellable         *cancellable,
 		  GError              **error)
 {
+	g_autoptr(GPtrArray) remote_icons = NULL;
+	guint maximum_icon_size;
+
 	/* nothing to do here */
 	if ((flags & GS_PLUGIN_REFINE_FLAGS_REQUIRE_ICON) == 0)
 		return TRUE;
 
+	/* gather the remote icons of the whole list, so that they can be
+	 * downloaded concurrently and each URI fetched only once */
+	remote_icons = g_ptr_array_new_with_free_func (g_object_unref);
 	for (guint i = 0; i < gs_app_list_length (list); i++) {
 		GsApp *app = gs_app_list_index (list, i);
-		if (!refine_app (plugin, app, flags, cancellable, error))
-			return FALSE;
+		g_autoptr(GPtrArray) icons = gs_app_dup_icons (app);
+
+		for (guint j = 0; icons != NULL && j < icons->len; j++) {
+			GIcon *icon = g_ptr_array_index (icons, j);
+
+			/* Only remote icons need to be cached. */
+			if (GS_IS_REMOTE_ICON (icon))
+				g_ptr_array_add (remote_icons, g_object_ref (icon));
+		}
+	}
+
+	/* Currently a 160px icon is needed for #GsFeatureTile, at most. */
+	maximum_icon_size = 160 * gs_plugin_get_scale (plugin);
+
+	if (remote_icons->len > 0) {
+		gs_remote_icon_ensure_cached_many (remote_icons,
+						   gs_plugin_get_soup_session (plugin),
+						   maximum_icon_size,
+						   cancellable);
 	}
 
 	return TRUE;
@@ -51,6 +51,181 @@ gs_plugins_core_search_repo_name_func (GsPluginLoader *plugin_loader)
 	g_assert_cmpint (gs_app_get_kind (app), ==, AS_COMPONENT_KIND_DESKTOP_APP);
 }
 
+static void
+gs_plugins_core_categories_func (GsPluginLoader *plugin_loader)
+{
+	GsCategory *create = NULL;
+	GsCategory *viewers;
+	GsCategory *photography;
+	GsApp *app;
+	GsApp *app_taxi;
+	const gchar *info;
+	g_autofree gchar *xml_orig = g_strdup (g_getenv ("GS_SELF_TEST_APPSTREAM_XML"));
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) categories = NULL;
+	g_autoptr(GString) xml = NULL;
+	g_autoptr(GsApp) app_tmp = NULL;
+	g_autoptr(GsApp) app_tmp2 = NULL;
+	g_autoptr(GsAppList) list = NULL;
+	g_autoptr(GsPluginJob) plugin_job = NULL;
+
+	/* add more photography apps than the XPath count is capped at; they
+	 * are only added here as the other tests search the whole origin */
+	xml = g_string_new (NULL);
+	info = g_strstr_len (xml_orig, -1, "  <info>");
+	g_assert_nonnull (info);
+	g_string_append_len (xml, xml_orig, info - xml_orig);
+	for (guint i = 0; i < 12; i++) {
+		g_string_append_printf (xml,
+					"  <component type=\"desktop\">\n"
+					"    <id>photo%u.desktop</id>\n"
+					"    <name>Photo %u</name>\n"
+					"    <summary>Photos</summary>\n"
+					"    <categories>\n"
+					"      <category>Graphics</category>\n"
+					"      <category>Photography</category>\n"
+					"    </categories>\n"
+					"  </component>\n",
+					i, i);
+	}
+
+	/* and an app which is only put in a category by an override
+	 * component, which has no name of its own */
+	g_string_append (xml,
+			 "  <component type=\"desktop\">\n"
+			 "    <id>taxi.desktop</id>\n"
+			 "    <name>Taxi</name>\n"
+			 "    <summary>Taxi</summary>\n"
+			 "    <pkgname>taxi</pkgname>\n"
+			 "  </component>\n"
+			 "  <component merge=\"append\">\n"
+			 "    <id>taxi.desktop</id>\n"
+			 "    <categories>\n"
+			 "      <category>Graphics</category>\n"
+			 "      <category>Viewer</category>\n"
+			 "    </categories>\n"
+			 "  </component>\n");
+	g_string_append (xml, info);
+	g_setenv ("GS_SELF_TEST_APPSTREAM_XML", xml->str, TRUE);
+	gs_utils_rmtree (g_getenv ("GS_SELF_TEST_CACHEDIR"), NULL);
+	gs_plugin_loader_setup_again (plugin_loader);
+
+	/* the sizes come from the category lists in the appstream index, so
+	 * they are exact rather than capped at 10 */
+	plugin_job = gs_plugin_job_newv (GS_PLUGIN_ACTION_GET_CATEGORIES, NULL);
+	categories = gs_plugin_loader_job_get_categories (plugin_loader, plugin_job, NULL, &error);
+	gs_test_flush_main_context ();
+	g_assert_no_error (error);
+	g_assert_nonnull (categories);
+
+	for (guint i = 0; i < categories->len; i++) {
+		GsCategory *category = g_ptr_array_index (categories, i);
+		if (g_strcmp0 (gs_category_get_id (category), "create") == 0)
+			create = category;
+	}
+	g_assert_nonnull (create);
+	viewers = gs_category_find_child (create, "viewers");
+	g_assert_nonnull (viewers);
+	g_assert_cmpuint (gs_category_get_size (viewers), ==, 2);
+	photography = gs_category_find_child (create, "photography");
+	g_assert_nonnull (photography);
+	g_assert_cmpuint (gs_category_get_size (photography), ==, 12);
+
+	/* each app is counted for the Graphics group, and then again for
+	 * Graphics::Viewer or Graphics::Photography */
+	g_assert_cmpuint (gs_category_get_size (create), ==, 28);
+
+	/* force these apps to be installed */
+	app_tmp = gs_plugin_loader_app_create (plugin_loader, "*/*/yellow/arachne.desktop/*", NULL, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (app_tmp);
+	gs_app_set_state (app_tmp, GS_APP_STATE_INSTALLED);
+	app_tmp2 = gs_plugin_loader_app_create (plugin_loader, "*/*/yellow/taxi.desktop/*", NULL, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (app_tmp2);
+	gs_app_set_state (app_tmp2, GS_APP_STATE_INSTALLED);
+
+	/* the apps come straight from the index, not as wildcards, apart from
+	 * the override, which is resolved to the app it extends */
+	g_clear_object (&plugin_job);
+	plugin_job = gs_plugin_job_newv (GS_PLUGIN_ACTION_GET_CATEGORY_APPS,
+					 "category", viewers,
+					 NULL);
+	list = gs_plugin_loader_job_process (plugin_loader, plugin_job, NULL, &error);
+	gs_test_flush_main_context ();
+	g_assert_no_error (error);
+	g_assert_nonnull (list);
+	g_assert_cmpint (gs_app_list_length (list), ==, 2);
+	app = gs_app_list_lookup (list, "*/*/yellow/arachne.desktop/*");
+	g_assert_nonnull (app);
+	g_assert_false (gs_app_has_quirk (app, GS_APP_QUIRK_IS_WILDCARD));
+	app_taxi = gs_app_list_lookup (list, "*/*/yellow/taxi.desktop/*");
+	g_assert_nonnull (app_taxi);
+	g_assert_false (gs_app_has_quirk (app_taxi, GS_APP_QUIRK_IS_WILDCARD));
+	g_assert_cmpstr (gs_app_get_name (app_taxi), ==, "Taxi");
+
+	/* put the original apps back for the other tests */
+	g_setenv ("GS_SELF_TEST_APPSTREAM_XML", xml_orig, TRUE);
+	gs_utils_rmtree (g_getenv ("GS_SELF_TEST_CACHEDIR"), NULL);
+	gs_plugin_loader_setup_again (plugin_loader);
+}
+
+static void
+gs_plugins_core_refine_func (GsPluginLoader *plugin_loader)
+{
+	GsApp *app;
+	gboolean ret;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GsApp) app_id = NULL;
+	g_autoptr(GsApp) app_pkgname = NULL;
+	g_autoptr(GsApp) app_wildcard = NULL;
+	g_autoptr(GsAppList) list = gs_app_list_new ();
+	g_autoptr(GsAppList) list_wildcard = gs_app_list_new ();
+	g_autoptr(GsPluginJob) plugin_job = NULL;
+
+	/* one app found by ID and one by package name, in the same refine */
+	app_id = gs_app_new ("arachne.desktop");
+	app_pkgname = gs_app_new (NULL);
+	gs_app_add_source (app_pkgname, "arachne");
+	gs_app_list_add (list, app_id);
+	gs_app_list_add (list, app_pkgname);
+	plugin_job = gs_plugin_job_newv (GS_PLUGIN_ACTION_REFINE,
+					 "list", list,
+					 NULL);
+	ret = gs_plugin_loader_job_action (plugin_loader, plugin_job, NULL, &error);
+	gs_test_flush_main_context ();
+	g_assert_no_error (error);
+	g_assert_true (ret);
+
+	g_assert_cmpstr (gs_app_get_name (app_id), ==, "test");
+	g_assert_cmpstr (gs_app_get_summary (app_id), ==, "Test");
+	g_assert_cmpstr (gs_app_get_id (app_pkgname), ==, "arachne.desktop");
+	g_assert_cmpstr (gs_app_get_name (app_pkgname), ==, "test");
+
+	/* the wildcard is replaced by the app it matches, which is then
+	 * refined by provenance even though it has no rule about appstream */
+	app_wildcard = gs_app_new ("arachne.desktop");
+	gs_app_add_quirk (app_wildcard, GS_APP_QUIRK_IS_WILDCARD);
+	gs_app_list_add (list_wildcard, app_wildcard);
+	g_clear_object (&plugin_job);
+	plugin_job = gs_plugin_job_newv (GS_PLUGIN_ACTION_REFINE,
+					 "list", list_wildcard,
+					 "refine-flags", GS_PLUGIN_REFINE_FLAGS_REQUIRE_PROVENANCE,
+					 NULL);
+	ret = gs_plugin_loader_job_action (plugin_loader, plugin_job, NULL, &error);
+	gs_test_flush_main_context ();
+	g_assert_no_error (error);
+	g_assert_true (ret);
+
+	g_assert_cmpint (gs_app_list_length (list_wildcard), ==, 1);
+	app = gs_app_list_index (list_wildcard, 0);
+	g_assert_cmpstr (gs_app_get_id (app), ==, "arachne.desktop");
+	g_assert_cmpstr (gs_app_get_name (app), ==, "test");
+	g_assert_false (gs_app_has_quirk (app, GS_APP_QUIRK_IS_WILDCARD));
+	g_assert_cmpstr (gs_app_get_origin (app), ==, "yellow");
+	g_assert_true (gs_app_has_quirk (app, GS_APP_QUIRK_PROVENANCE));
+}
+
 static void
 gs_plugins_core_os_release_func (GsPluginLoader *plugin_loader)
 {
@@ -198,6 +373,7 @@ main (int argc, char **argv)
 		"generic-updates",
 		"icons",
 		"os-release",
+		"provenance",
 		NULL
 	};
 
@@ -217,6 +393,7 @@ main (int argc, char **argv)
 	tmp_root = g_dir_make_tmp ("gnome-software-core-test-XXXXXX", NULL);
 	g_assert (tmp_root != NULL);
 	g_setenv ("GS_SELF_TEST_CACHEDIR", tmp_root, TRUE);
+	g_setenv ("GS_SELF_TEST_PROVENANCE_SOURCES", "yellow", TRUE);
 
 	os_release_filename = gs_test_get_filename (TESTDATADIR, "os-release");
 	g_assert (os_release_filename != NULL);
@@ -231,6 +408,10 @@ main (int argc, char **argv)
 		"    <summary>Test</summary>\n"
 		"    <icon type=\"stock\">system-file-manager</icon>\n"
 		"    <pkgname>arachne</pkgname>\n"
+		"    <categories>\n"
+		"      <category>Graphics</category>\n"
+		"      <category>Viewer</category>\n"
+		"    </categories>\n"
 		"  </component>\n"
 		"  <component type=\"os-upgrade\">\n"
 		"    <id>org.fedoraproject.fedora-25</id>\n"
@@ -259,6 +440,12 @@ main (int argc, char **argv)
 	g_test_add_data_func ("/gnome-software/plugins/core/search-repo-name",
 			      plugin_loader,
 			      (GTestDataFunc) gs_plugins_core_search_repo_name_func);
+	g_test_add_data_func ("/gnome-software/plugins/core/categories",
+			      plugin_loader,
+			      (GTestDataFunc) gs_plugins_core_categories_func);
+	g_test_add_data_func ("/gnome-software/plugins/core/refine",
+			      plugin_loader,
+			      (GTestDataFunc) gs_plugins_core_refine_func);
 	g_test_add_data_func ("/gnome-software/plugins/core/os-release",
 			      plugin_loader,
 			      (GTestDataFunc) gs_plugins_core_os_release_func);
@@ -27,6 +27,7 @@ struct _GsPluginDummy {
 	GsApp			*cached_origin;
 	GHashTable		*installed_apps;	/* id:1 */
 	GHashTable		*available_apps;	/* id:1 */
+	GMutex			 refine_count_mutex;
 };
 
 G_DEFINE_TYPE (GsPluginDummy, gs_plugin_dummy, GS_TYPE_PLUGIN)
@@ -47,6 +48,8 @@ gs_plugin_dummy_init (GsPluginDummy *self)
 {
 	GsPlugin *plugin = GS_PLUGIN (self);
 
+	g_mutex_init (&self->refine_count_mutex);
+
 	if (g_getenv ("GS_SELF_TEST_DUMMY_ENABLE") == NULL) {
 		g_debug ("disabling '%s' as not in self test",
 			 gs_plugin_get_name (plugin));
@@ -72,6 +75,16 @@ gs_plugin_dummy_dispose (GObject *object)
 	G_OBJECT_CLASS (gs_plugin_dummy_parent_class)->dispose (object);
 }
 
+static void
+gs_plugin_dummy_finalize (GObject *object)
+{
+	GsPluginDummy *self = GS_PLUGIN_DUMMY (object);
+
+	g_mutex_clear (&self->refine_count_mutex);
+
+	G_OBJECT_CLASS (gs_plugin_dummy_parent_class)->finalize (object);
+}
+
 gboolean
 gs_plugin_setup (GsPlugin      *plugin,
                  GCancellable  *cancellable,
@@ -606,6 +619,23 @@ refine_app (GsPluginDummy        *self,
             GCancellable         *cancellable,
             GError              **error)
 {
+	/* count the refines of apps the tests are watching, and keep them in
+	 * flight for a while so other jobs can try to refine them too */
+	if (gs_app_get_metadata_variant (app, "GnomeSoftware::dummy-refine-count") != NULL) {
+		g_autoptr(GVariant) count = NULL;
+		guint32 n_refines;
+
+		g_mutex_lock (&self->refine_count_mutex);
+		n_refines = g_variant_get_uint32 (gs_app_get_metadata_variant (app, "GnomeSoftware::dummy-refine-count"));
+		count = g_variant_ref_sink (g_variant_new_uint32 (n_refines + 1));
+		gs_app_set_metadata_variant (app, "GnomeSoftware::dummy-refine-count", NULL);
+		gs_app_set_metadata_variant (app, "GnomeSoftware::dummy-refine-count", count);
+		g_mutex_unlock (&self->refine_count_mutex);
+
+		if (!gs_plugin_dummy_delay (GS_PLUGIN (self), NULL, 500, cancellable, error))
+			return FALSE;
+	}
+
 	/* make the local system EOL */
 	if (gs_app_get_metadata_item (app, "GnomeSoftware::CpeName") != NULL)
 		gs_app_set_state (app, GS_APP_STATE_UNAVAILABLE);
@@ -889,6 +919,7 @@ gs_plugin_dummy_class_init (GsPluginDummyClass *klass)
 	GObjectClass *object_class = G_OBJECT_CLASS (klass);
 
 	object_class->dispose = gs_plugin_dummy_dispose;
+	object_class->finalize = gs_plugin_dummy_finalize;
 }
 
 GType
@@ -159,6 +159,77 @@ gs_plugins_dummy_refine_func (GsPluginLoader *plugin_loader)
 	g_assert_cmpstr (gs_app_get_url (app, AS_URL_KIND_HOMEPAGE), ==, "http://www.test.org/");
 }
 
+static void
+gs_plugins_dummy_refine_concurrent_cb (GObject *source,
+				       GAsyncResult *res,
+				       gpointer user_data)
+{
+	GsPluginLoader *plugin_loader = GS_PLUGIN_LOADER (source);
+	guint *n_pending = user_data;
+	gboolean ret;
+	g_autoptr(GError) error = NULL;
+
+	ret = gs_plugin_loader_job_action_finish (plugin_loader, res, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	(*n_pending)--;
+}
+
+static guint32
+gs_plugins_dummy_get_refine_count (GsApp *app)
+{
+	return g_variant_get_uint32 (gs_app_get_metadata_variant (app, "GnomeSoftware::dummy-refine-count"));
+}
+
+static void
+gs_plugins_dummy_refine_concurrent_func (GsPluginLoader *plugin_loader)
+{
+	guint n_pending = 2;
+	g_autoptr(GsApp) app = NULL;
+	g_autoptr(GsPluginJob) plugin_job1 = NULL;
+	g_autoptr(GsPluginJob) plugin_job2 = NULL;
+	g_autoptr(GVariant) count = g_variant_ref_sink (g_variant_new_uint32 (0));
+	GsPlugin *plugin;
+
+	/* refine the same app from two jobs at once, the second one wanting
+	 * fewer flags so it can reuse the first refine */
+	app = gs_app_new ("chiron.desktop");
+	plugin = gs_plugin_loader_find_plugin (plugin_loader, "dummy");
+	gs_app_set_management_plugin (app, plugin);
+	gs_app_set_metadata_variant (app, "GnomeSoftware::dummy-refine-count", count);
+	plugin_job1 = gs_plugin_job_newv (GS_PLUGIN_ACTION_REFINE,
+					  "app", app,
+					  "refine-flags", GS_PLUGIN_REFINE_FLAGS_REQUIRE_DESCRIPTION |
+							  GS_PLUGIN_REFINE_FLAGS_REQUIRE_LICENSE |
+							  GS_PLUGIN_REFINE_FLAGS_REQUIRE_URL,
+					  NULL);
+	plugin_job2 = gs_plugin_job_newv (GS_PLUGIN_ACTION_REFINE,
+					  "app", app,
+					  "refine-flags", GS_PLUGIN_REFINE_FLAGS_REQUIRE_LICENSE,
+					  NULL);
+	gs_plugin_loader_job_process_async (plugin_loader, plugin_job1, NULL,
+					    gs_plugins_dummy_refine_concurrent_cb, &n_pending);
+
+	/* only start the second job once the first is refining the app */
+	while (gs_plugins_dummy_get_refine_count (app) == 0) {
+		g_main_context_iteration (NULL, FALSE);
+		g_usleep (1000);
+	}
+	gs_plugin_loader_job_process_async (plugin_loader, plugin_job2, NULL,
+					    gs_plugins_dummy_refine_concurrent_cb, &n_pending);
+	while (n_pending > 0)
+		g_main_context_iteration (NULL, TRUE);
+	gs_test_flush_main_context ();
+
+	/* the second job waited for the first refine rather than doing its own */
+	g_assert_cmpuint (gs_plugins_dummy_get_refine_count (app), ==, 1);
+
+	/* both jobs see the data */
+	g_assert_cmpstr (gs_app_get_license (app), ==, "GPL-2.0+");
+	g_assert_cmpstr (gs_app_get_description (app), !=, NULL);
+	g_assert_cmpstr (gs_app_get_url (app, AS_URL_KIND_HOMEPAGE), ==, "http://www.test.org/");
+}
+
 static void
 gs_plugins_dummy_metadata_quirks (GsPluginLoader *plugin_loader)
 {
@@ -444,6 +515,55 @@ gs_plugins_dummy_search_func (GsPluginLoader *plugin_loader)
 	g_assert_cmpint (gs_app_get_kind (app), ==, AS_COMPONENT_KIND_DESKTOP_APP);
 }
 
+static void
+gs_plugins_dummy_search_narrow_func (GsPluginLoader *plugin_loader)
+{
+	const struct {
+		const gchar	*search;
+		guint		 n_results;
+		gboolean	 cached;
+	} searches[] = {
+		{ "teach",		1, FALSE },
+		{ "teaching app",	1, TRUE },
+		{ "teaching app",	1, TRUE },
+		/* keyword matches are checked against the new terms too */
+		{ "olymp",		1, FALSE },
+		{ "olympus",		1, TRUE },
+		{ "olympia",		0, TRUE },
+	};
+
+	/* a search which narrows a recent one is answered from memory */
+	for (guint i = 0; i < G_N_ELEMENTS (searches); i++) {
+		GsApp *app;
+		guint n_hits = 0;
+		guint n_hits_old = 0;
+		g_autoptr(GError) error = NULL;
+		g_autoptr(GsAppList) list = NULL;
+		g_autoptr(GsPluginJob) plugin_job = NULL;
+
+		gs_plugin_loader_get_search_cache_stats (plugin_loader, &n_hits_old, NULL);
+
+		plugin_job = gs_plugin_job_newv (GS_PLUGIN_ACTION_SEARCH,
+						 "search", searches[i].search,
+						 "refine-flags", GS_PLUGIN_REFINE_FLAGS_REQUIRE_ICON,
+						 NULL);
+		list = gs_plugin_loader_job_process (plugin_loader, plugin_job, NULL, &error);
+		gs_test_flush_main_context ();
+		g_assert_no_error (error);
+		g_assert (list != NULL);
+
+		g_assert_cmpint (gs_app_list_length (list), ==, searches[i].n_results);
+		if (searches[i].n_results > 0) {
+			app = gs_app_list_index (list, 0);
+			g_assert_cmpstr (gs_app_get_id (app), ==, "zeus.desktop");
+			g_assert_cmpint (gs_app_get_match_value (app), !=, 0);
+		}
+
+		gs_plugin_loader_get_search_cache_stats (plugin_loader, &n_hits, NULL);
+		g_assert_cmpuint (n_hits, ==, n_hits_old + (searches[i].cached ? 1 : 0));
+	}
+}
+
 static void
 gs_plugins_dummy_search_alternate_func (GsPluginLoader *plugin_loader)
 {
@@ -788,6 +908,9 @@ main (int argc, char **argv)
 		"    <summary>A teaching application</summary>\n"
 		"    <pkgname>zeus</pkgname>\n"
 		"    <icon type=\"stock\">drive-harddisk</icon>\n"
+		"    <keywords>\n"
+		"      <keyword>olympus</keyword>\n"
+		"    </keywords>\n"
 		"    <categories>\n"
 		"      <category>AudioVideo</category>\n"
 		"      <category>Player</category>\n"
@@ -845,6 +968,9 @@ main (int argc, char **argv)
 	g_assert (!gs_plugin_loader_get_enabled (plugin_loader, "notgoingtoexist"));
 	g_assert (gs_plugin_loader_get_enabled (plugin_loader, "appstream"));
 	g_assert (gs_plugin_loader_get_enabled (plugin_loader, "dummy"));
+	g_assert (gs_plugin_loader_get_plugin_supported (plugin_loader, "gs_plugin_add_search"));
+	g_assert (gs_plugin_loader_get_plugin_supported (plugin_loader, "gs_plugin_update_app"));
+	g_assert (!gs_plugin_loader_get_plugin_supported (plugin_loader, "gs_plugin_notgoingtoexist"));
 
 	/* plugin tests go here */
 	g_test_add_data_func ("/gnome-software/plugins/dummy/wildcard",
@@ -859,6 +985,9 @@ main (int argc, char **argv)
 	g_test_add_data_func ("/gnome-software/plugins/dummy/search",
 			      plugin_loader,
 			      (GTestDataFunc) gs_plugins_dummy_search_func);
+	g_test_add_data_func ("/gnome-software/plugins/dummy/search{narrow}",
+			      plugin_loader,
+			      (GTestDataFunc) gs_plugins_dummy_search_narrow_func);
 	g_test_add_data_func ("/gnome-software/plugins/dummy/search-alternate",
 			      plugin_loader,
 			      (GTestDataFunc) gs_plugins_dummy_search_alternate_func);
@@ -883,6 +1012,9 @@ main (int argc, char **argv)
 	g_test_add_data_func ("/gnome-software/plugins/dummy/refine",
 			      plugin_loader,
 			      (GTestDataFunc) gs_plugins_dummy_refine_func);
+	g_test_add_data_func ("/gnome-software/plugins/dummy/refine{concurrent}",
+			      plugin_loader,
+			      (GTestDataFunc) gs_plugins_dummy_refine_concurrent_func);
 	g_test_add_data_func ("/gnome-software/plugins/dummy/updates",
 			      plugin_loader,
 			      (GTestDataFunc) gs_plugins_dummy_updates_func);
@@ -19,7 +19,11 @@
 #include <glib/gi18n.h>
 #include <xmlb.h>
 
-#include "gs-appstream.h"
+#ifdef HAVE_SYSPROF
+#include <sysprof-capture.h>
+#endif
+
+#include "gs-appstream-private.h"
 #include "gs-flatpak-app.h"
 #include "gs-flatpak.h"
 #include "gs-flatpak-utils.h"
@@ -35,8 +39,11 @@ struct _GsFlatpak {
 	GFileMonitor		*monitor;
 	AsComponentScope	 scope;
 	GsPlugin		*plugin;
-	XbSilo			*silo;
+	GPtrArray		*silos;  /* (element-type GsFlatpakSilo) (nullable), protected by silo_lock */
+	gint			 silos_built_generation;  /* protected by silo_lock */
+	gint			 silos_generation;  /* (atomic) */
 	GRWLock			 silo_lock;
+	GMutex			 silo_rebuild_mutex;
 	gchar			*id;
 	guint			 changed_id;
 	GHashTable		*app_silos;
@@ -50,6 +57,94 @@ struct _GsFlatpak {
 
 G_DEFINE_TYPE (GsFlatpak, gs_flatpak, G_TYPE_OBJECT)
 
+/* Each enabled remote gets its own silo, as does the set of installed desktop
+ * files, so that a change to one of them only recompiles that one. Entries
+ * are never modified once created. */
+typedef struct {
+	gchar			*remote_name;  /* (nullable): NULL for installed desktop files */
+	XbSilo			*silo;
+	GsAppstreamIndex	*index;  /* (nullable) */
+} GsFlatpakSilo;
+
+static GsFlatpakSilo *
+gs_flatpak_silo_new (const gchar *remote_name, XbSilo *silo, GsAppstreamIndex *index)
+{
+	GsFlatpakSilo *sub = g_new0 (GsFlatpakSilo, 1);
+	sub->remote_name = g_strdup (remote_name);
+	sub->silo = g_object_ref (silo);
+	sub->index = (index != NULL) ? g_object_ref (index) : NULL;
+	return sub;
+}
+
+static void
+gs_flatpak_silo_free (GsFlatpakSilo *sub)
+{
+	g_free (sub->remote_name);
+	g_object_unref (sub->silo);
+	g_clear_object (&sub->index);
+	g_free (sub);
+}
+
+static GsFlatpakSilo *
+gs_flatpak_find_silo (GPtrArray *silos, const gchar *remote_name)
+{
+	for (guint i = 0; silos != NULL && i < silos->len; i++) {
+		GsFlatpakSilo *sub = g_ptr_array_index (silos, i);
+		if (g_strcmp0 (sub->remote_name, remote_name) == 0)
+			return sub;
+	}
+	return NULL;
+}
+
+/* must be called with silo_lock held */
+static gboolean
+gs_flatpak_silos_valid (GsFlatpak *self)
+{
+	if (self->silos == NULL)
+		return FALSE;
+	if (self->silos_built_generation != g_atomic_int_get (&self->silos_generation))
+		return FALSE;
+	for (guint i = 0; i < self->silos->len; i++) {
+		GsFlatpakSilo *sub = g_ptr_array_index (self->silos, i);
+		if (!xb_silo_is_valid (sub->silo))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/* The set of remotes may have changed, so look at it again on the next
+ * rescan; sub-silos which are still valid are reused. */
+static void
+gs_flatpak_silos_changed (GsFlatpak *self)
+{
+	g_atomic_int_inc (&self->silos_generation);
+}
+
+/* Forces every sub-silo to be reloaded on the next rescan; libxmlb still
+ * only recompiles the ones whose sources changed. Must be called with
+ * silo_lock held. */
+static void
+gs_flatpak_invalidate_silos (GsFlatpak *self)
+{
+	gs_flatpak_silos_changed (self);
+	for (guint i = 0; self->silos != NULL && i < self->silos->len; i++) {
+		GsFlatpakSilo *sub = g_ptr_array_index (self->silos, i);
+		xb_silo_invalidate (sub->silo);
+	}
+}
+
+/* must be called with silo_lock held */
+static XbSilo *
+gs_flatpak_get_silo_for_app (GsFlatpak *self, GsApp *app)
+{
+	GsFlatpakSilo *sub;
+
+	if (gs_app_get_origin (app) == NULL)
+		return NULL;
+	sub = gs_flatpak_find_silo (self->silos, gs_app_get_origin (app));
+	return (sub != NULL) ? sub->silo : NULL;
+}
+
 static void
 gs_plugin_refine_item_scope (GsFlatpak *self, GsApp *app)
 {
@@ -439,6 +534,7 @@ gs_plugin_flatpak_changed_cb (GFileMonitor *monitor,
 	g_autoptr(GError) error = NULL;
 	g_autoptr(GMutexLocker) locker = NULL;
 	g_autoptr(GRWLockWriterLocker) writer_locker = NULL;
+	GsFlatpakSilo *sub;
 
 	/* drop the installed refs cache */
 	locker = g_mutex_locker_new (&self->installed_refs_mutex);
@@ -450,9 +546,13 @@ gs_plugin_flatpak_changed_cb (GFileMonitor *monitor,
 	g_hash_table_remove_all (self->remote_title);
 	g_clear_pointer (&locker, g_mutex_locker_free);
 
+	/* only the installed desktop files and the set of remotes can have
+	 * changed; remote AppStream data is watched by its own sub-silo */
 	writer_locker = g_rw_lock_writer_locker_new (&self->silo_lock);
-	if (self->silo)
-		xb_silo_invalidate (self->silo);
+	sub = gs_flatpak_find_silo (self->silos, NULL);
+	if (sub != NULL)
+		xb_silo_invalidate (sub->silo);
+	gs_flatpak_silos_changed (self);
 	g_clear_pointer (&writer_locker, g_rw_lock_writer_locker_free);
 
 	if (gs_flatpak_get_busy (self)) {
@@ -935,30 +1035,13 @@ gs_flatpak_rescan_installed (GsFlatpak *self,
 	}
 }
 
-static gboolean
-gs_flatpak_rescan_appstream_store (GsFlatpak *self,
-				   GCancellable *cancellable,
-				   GError **error)
+static XbBuilder *
+gs_flatpak_new_builder (void)
 {
 	const gchar *const *locales = g_get_language_names ();
-	g_autofree gchar *blobfn = NULL;
-	g_autoptr(GFile) file = NULL;
-	g_autoptr(GPtrArray) xremotes = NULL;
-	g_autoptr(GRWLockReaderLocker) reader_locker = NULL;
-	g_autoptr(GRWLockWriterLocker) writer_locker = NULL;
 	g_autoptr(XbBuilder) builder = NULL;
 	g_autoptr(GMainContext) old_thread_default = NULL;
 
-	reader_locker = g_rw_lock_reader_locker_new (&self->silo_lock);
-	/* everything is okay */
-	if (self->silo != NULL && xb_silo_is_valid (self->silo))
-		return TRUE;
-	g_clear_pointer (&reader_locker, g_rw_lock_reader_locker_free);
-
-	/* drat! silo needs regenerating */
-	writer_locker = g_rw_lock_writer_locker_new (&self->silo_lock);
-	g_clear_object (&self->silo);
-
 	/* FIXME: https://gitlab.gnome.org/GNOME/gnome-software/-/issues/1422 */
 	old_thread_default = g_main_context_ref_thread_default ();
 	if (old_thread_default == g_main_context_default ())
@@ -968,7 +1051,6 @@ gs_flatpak_rescan_appstream_store (GsFlatpak *self,
 	builder = xb_builder_new ();
 	if (old_thread_default != NULL)
 		g_main_context_push_thread_default (old_thread_default);
-	g_clear_pointer (&old_thread_default, g_main_context_unref);
 
 	/* verbose profiling */
 	if (g_getenv ("GS_XMLB_VERBOSE") != NULL) {
@@ -981,38 +1063,45 @@ gs_flatpak_rescan_appstream_store (GsFlatpak *self,
 	for (guint i = 0; locales[i] != NULL; i++)
 		xb_builder_add_locale (builder, locales[i]);
 
-	/* go through each remote adding metadata */
-	xremotes = flatpak_installation_list_remotes (self->installation,
-						      cancellable,
-						      error);
-	if (xremotes == NULL) {
-		gs_flatpak_error_convert (error);
-		return FALSE;
-	}
-	for (guint i = 0; i < xremotes->len; i++) {
-		g_autoptr(GError) error_local = NULL;
-		FlatpakRemote *xremote = g_ptr_array_index (xremotes, i);
-		if (flatpak_remote_get_disabled (xremote))
-			continue;
-		g_debug ("found remote %s",
-			 flatpak_remote_get_name (xremote));
-		if (!gs_flatpak_add_apps_from_xremote (self, builder, xremote, cancellable, &error_local)) {
-			g_debug ("Failed to add apps from remote ‘%s’; skipping: %s",
-				 flatpak_remote_get_name (xremote), error_local->message);
-		}
-	}
+	return g_steal_pointer (&builder);
+}
 
-	/* add any installed files without AppStream info */
-	gs_flatpak_rescan_installed (self, builder, cancellable, error);
+/* Compiles the sub-silo for @remote_name, or for the installed desktop files
+ * if %NULL, and its search index. The blob is cached per sub-silo, so this
+ * only recompiles if the sources added to @builder have changed. */
+static GsFlatpakSilo *
+gs_flatpak_compile_silo (GsFlatpak *self,
+			 XbBuilder *builder,
+			 const gchar *remote_name,
+			 GCancellable *cancellable,
+			 GError **error)
+{
+	g_autofree gchar *basename = NULL;
+	g_autofree gchar *blob_basename = NULL;
+	g_autofree gchar *index_basename = NULL;
+	g_autofree gchar *blobfn = NULL;
+	g_autofree gchar *indexfn = NULL;
+	g_autoptr(GFile) file = NULL;
+	g_autoptr(XbSilo) silo = NULL;
+	g_autoptr(GsAppstreamIndex) silo_index = NULL;
+	g_autoptr(GMainContext) old_thread_default = NULL;
+	g_autoptr(GError) error_index = NULL;
+
+	if (remote_name != NULL)
+		basename = g_strdup_printf ("components-remote-%s", remote_name);
+	else
+		basename = g_strdup ("components-installed");
+	blob_basename = g_strconcat (basename, ".xmlb", NULL);
+	index_basename = g_strconcat (basename, ".index", NULL);
 
 	/* create per-user cache */
 	blobfn = gs_utils_get_cache_filename (gs_flatpak_get_id (self),
-					      "components.xmlb",
+					      blob_basename,
 					      GS_UTILS_CACHE_FLAG_WRITEABLE |
 					      GS_UTILS_CACHE_FLAG_CREATE_DIRECTORY,
 					      error);
 	if (blobfn == NULL)
-		return FALSE;
+		return NULL;
 	file = g_file_new_for_path (blobfn);
 	g_debug ("ensuring %s", blobfn);
 
@@ -1023,21 +1112,157 @@ gs_flatpak_rescan_appstream_store (GsFlatpak *self,
 	if (old_thread_default != NULL)
 		g_main_context_pop_thread_default (old_thread_default);
 
-	self->silo = xb_builder_ensure (builder, file,
-					XB_BUILDER_COMPILE_FLAG_IGNORE_INVALID |
-					XB_BUILDER_COMPILE_FLAG_SINGLE_LANG,
-					NULL, error);
+	silo = xb_builder_ensure (builder, file,
+				  XB_BUILDER_COMPILE_FLAG_IGNORE_INVALID |
+				  XB_BUILDER_COMPILE_FLAG_SINGLE_LANG,
+				  NULL, error);
 
 	if (old_thread_default != NULL)
 		g_main_context_push_thread_default (old_thread_default);
 
-	if (self->silo == NULL)
+	if (silo == NULL)
+		return NULL;
+
+	/* the search index is optional, so failing to build it is not fatal */
+	indexfn = gs_utils_get_cache_filename (gs_flatpak_get_id (self),
+					       index_basename,
+					       GS_UTILS_CACHE_FLAG_WRITEABLE |
+					       GS_UTILS_CACHE_FLAG_CREATE_DIRECTORY,
+					       &error_index);
+	if (indexfn != NULL)
+		silo_index = gs_appstream_index_new_for_silo (silo, indexfn,
+							      cancellable, &error_index);
+	if (silo_index == NULL)
+		g_warning ("failed to build search index for %s: %s",
+			   basename, error_index->message);
+
+	return gs_flatpak_silo_new (remote_name, silo, silo_index);
+}
+
+/* Compiles a new set of sub-silos, reusing the ones which are still valid,
+ * and then swaps them in. This is called with silo_rebuild_mutex held, but
+ * not silo_lock, so other threads can carry on using the old sub-silos in
+ * the meantime. */
+static gboolean
+gs_flatpak_rebuild_appstream_store (GsFlatpak *self,
+				    GCancellable *cancellable,
+				    GError **error)
+{
+	gint generation = g_atomic_int_get (&self->silos_generation);
+	GsFlatpakSilo *sub;
+	g_autoptr(GPtrArray) old_silos = NULL;
+	g_autoptr(GPtrArray) silos = NULL;
+	g_autoptr(GPtrArray) xremotes = NULL;
+	g_autoptr(GRWLockReaderLocker) reader_locker = NULL;
+	g_autoptr(GRWLockWriterLocker) writer_locker = NULL;
+
+	reader_locker = g_rw_lock_reader_locker_new (&self->silo_lock);
+	if (self->silos != NULL)
+		old_silos = g_ptr_array_ref (self->silos);
+	g_clear_pointer (&reader_locker, g_rw_lock_reader_locker_free);
+
+	/* go through each remote adding metadata */
+	xremotes = flatpak_installation_list_remotes (self->installation,
+						      cancellable,
+						      error);
+	if (xremotes == NULL) {
+		gs_flatpak_error_convert (error);
 		return FALSE;
+	}
+	silos = g_ptr_array_new_with_free_func ((GDestroyNotify) gs_flatpak_silo_free);
+	for (guint i = 0; i < xremotes->len; i++) {
+		g_autoptr(GError) error_local = NULL;
+		g_autoptr(XbBuilder) builder = NULL;
+		FlatpakRemote *xremote = g_ptr_array_index (xremotes, i);
+		const gchar *remote_name = flatpak_remote_get_name (xremote);
+		if (flatpak_remote_get_disabled (xremote))
+			continue;
+		g_debug ("found remote %s", remote_name);
+
+		/* nothing changed for this remote */
+		sub = gs_flatpak_find_silo (old_silos, remote_name);
+		if (sub != NULL && xb_silo_is_valid (sub->silo)) {
+			g_ptr_array_add (silos, gs_flatpak_silo_new (sub->remote_name, sub->silo, sub->index));
+			continue;
+		}
+
+		builder = gs_flatpak_new_builder ();
+		if (!gs_flatpak_add_apps_from_xremote (self, builder, xremote, cancellable, &error_local)) {
+			g_debug ("Failed to add apps from remote ‘%s’; skipping: %s",
+				 remote_name, error_local->message);
+			continue;
+		}
+		sub = gs_flatpak_compile_silo (self, builder, remote_name, cancellable, error);
+		if (sub == NULL)
+			return FALSE;
+		g_ptr_array_add (silos, sub);
+	}
+
+	/* add any installed files without AppStream info */
+	sub = gs_flatpak_find_silo (old_silos, NULL);
+	if (sub != NULL && xb_silo_is_valid (sub->silo)) {
+		g_ptr_array_add (silos, gs_flatpak_silo_new (NULL, sub->silo, sub->index));
+	} else {
+		g_autoptr(XbBuilder) builder = gs_flatpak_new_builder ();
+
+		gs_flatpak_rescan_installed (self, builder, cancellable, error);
+		sub = gs_flatpak_compile_silo (self, builder, NULL, cancellable, error);
+		if (sub == NULL)
+			return FALSE;
+		g_ptr_array_add (silos, sub);
+	}
+
+	/* readers only have to wait for the swap */
+	writer_locker = g_rw_lock_writer_locker_new (&self->silo_lock);
+	g_clear_pointer (&self->silos, g_ptr_array_unref);
+	self->silos = g_steal_pointer (&silos);
+	self->silos_built_generation = generation;
 
 	/* success */
 	return TRUE;
 }
 
+/* If @block is %FALSE and another thread is already rebuilding the silos,
+ * the old ones are used until it is done rather than waiting; callers which
+ * need the result of a rebuild, such as refresh, must pass %TRUE. */
+static gboolean
+gs_flatpak_rescan_appstream_store (GsFlatpak *self,
+				   gboolean block,
+				   GCancellable *cancellable,
+				   GError **error)
+{
+	gboolean ret;
+	g_autoptr(GRWLockReaderLocker) reader_locker = NULL;
+
+	reader_locker = g_rw_lock_reader_locker_new (&self->silo_lock);
+	/* everything is okay */
+	if (gs_flatpak_silos_valid (self))
+		return TRUE;
+	g_clear_pointer (&reader_locker, g_rw_lock_reader_locker_free);
+
+	/* drat! silos need regenerating; if another thread is already doing
+	 * that, use the old silos until it is done unless asked to wait */
+	if (block) {
+		g_mutex_lock (&self->silo_rebuild_mutex);
+	} else if (!g_mutex_trylock (&self->silo_rebuild_mutex)) {
+		reader_locker = g_rw_lock_reader_locker_new (&self->silo_lock);
+		if (self->silos != NULL)
+			return TRUE;
+		g_clear_pointer (&reader_locker, g_rw_lock_reader_locker_free);
+		g_mutex_lock (&self->silo_rebuild_mutex);
+	}
+
+	/* they may have been rebuilt while waiting */
+	reader_locker = g_rw_lock_reader_locker_new (&self->silo_lock);
+	ret = gs_flatpak_silos_valid (self);
+	g_clear_pointer (&reader_locker, g_rw_lock_reader_locker_free);
+	if (!ret)
+		ret = gs_flatpak_rebuild_appstream_store (self, cancellable, error);
+	g_mutex_unlock (&self->silo_rebuild_mutex);
+
+	return ret;
+}
+
 static gboolean
 gs_flatpak_rescan_app_data (GsFlatpak *self,
 			    GCancellable *cancellable,
@@ -1050,7 +1275,7 @@ gs_flatpak_rescan_app_data (GsFlatpak *self,
 		return res;
 	}
 
-	return gs_flatpak_rescan_appstream_store (self, cancellable, error);
+	return gs_flatpak_rescan_appstream_store (self, FALSE, cancellable, error);
 }
 
 gboolean
@@ -1172,12 +1397,52 @@ gs_flatpak_refresh_appstream_remote (GsFlatpak *self,
 	return TRUE;
 }
 
+typedef struct {
+	GsFlatpak	*self;
+	FlatpakRemote	*xremote;
+	GError		*error;
+} GsFlatpakRefreshHelper;
+
+static void
+gs_flatpak_refresh_helper_free (GsFlatpakRefreshHelper *helper)
+{
+	g_object_unref (helper->xremote);
+	g_clear_error (&helper->error);
+	g_slice_free (GsFlatpakRefreshHelper, helper);
+}
+
+static void
+gs_flatpak_refresh_appstream_thread_cb (gpointer data, gpointer user_data)
+{
+	GsFlatpakRefreshHelper *helper = data;
+	GCancellable *cancellable = user_data;
+	const gchar *remote_name = flatpak_remote_get_name (helper->xremote);
+#ifdef HAVE_SYSPROF
+	gint64 begin_time_nsec = SYSPROF_CAPTURE_CURRENT_TIME;
+#endif
+
+	gs_flatpak_refresh_appstream_remote (helper->self,
+					     remote_name,
+					     cancellable,
+					     &helper->error);
+
+#ifdef HAVE_SYSPROF
+	sysprof_collector_mark (begin_time_nsec,
+				SYSPROF_CAPTURE_CURRENT_TIME - begin_time_nsec,
+				"gnome-software",
+				"flatpak-refresh-remote",
+				remote_name);
+#endif  /* HAVE_SYSPROF */
+}
+
 static gboolean
 gs_flatpak_refresh_appstream (GsFlatpak *self, guint cache_age,
 			      GCancellable *cancellable, GError **error)
 {
-	gboolean ret;
+	guint max_parallel;
 	g_autoptr(GPtrArray) xremotes = NULL;
+	g_autoptr(GPtrArray) refreshes = NULL;
+	g_autoptr(GSettings) settings = NULL;
 
 	/* get remotes */
 	xremotes = flatpak_installation_list_remotes (self->installation,
@@ -1187,14 +1452,13 @@ gs_flatpak_refresh_appstream (GsFlatpak *self, guint cache_age,
 		gs_flatpak_error_convert (error);
 		return FALSE;
 	}
+	refreshes = g_ptr_array_new_with_free_func ((GDestroyNotify) gs_flatpak_refresh_helper_free);
 	for (guint i = 0; i < xremotes->len; i++) {
 		const gchar *remote_name;
 		guint tmp;
-		g_autoptr(GError) error_local = NULL;
-		g_autoptr(GFile) file = NULL;
 		g_autoptr(GFile) file_timestamp = NULL;
-		g_autofree gchar *appstream_fn = NULL;
 		FlatpakRemote *xremote = g_ptr_array_index (xremotes, i);
+		GsFlatpakRefreshHelper *helper;
 		g_autoptr(GMutexLocker) locker = NULL;
 
 		/* not enabled */
@@ -1225,17 +1489,50 @@ gs_flatpak_refresh_appstream (GsFlatpak *self, guint cache_age,
 		/* download new data */
 		g_debug ("%s is %u seconds old, so downloading new data",
 			 remote_name, tmp);
-		ret = gs_flatpak_refresh_appstream_remote (self,
-							   remote_name,
-							   cancellable,
-							   &error_local);
-		if (!ret) {
+		helper = g_slice_new0 (GsFlatpakRefreshHelper);
+		helper->self = self;
+		helper->xremote = g_object_ref (xremote);
+		g_ptr_array_add (refreshes, helper);
+	}
+
+	/* the remotes are independent, so download them at the same time;
+	 * the pool is freed only once all of them have finished */
+	settings = g_settings_new ("org.gnome.software");
+	max_parallel = g_settings_get_uint (settings, "refresh-max-parallel-remotes");
+	if (refreshes->len <= 1 || max_parallel <= 1) {
+		for (guint i = 0; i < refreshes->len; i++)
+			gs_flatpak_refresh_appstream_thread_cb (g_ptr_array_index (refreshes, i), cancellable);
+	} else {
+		GThreadPool *pool;
+
+		pool = g_thread_pool_new (gs_flatpak_refresh_appstream_thread_cb,
+					  cancellable,
+					  (gint) MIN (max_parallel, refreshes->len),
+					  FALSE,
+					  error);
+		if (pool == NULL)
+			return FALSE;
+		for (guint i = 0; i < refreshes->len; i++)
+			g_thread_pool_push (pool, g_ptr_array_index (refreshes, i), NULL);
+		g_thread_pool_free (pool, FALSE, TRUE);
+	}
+
+	/* handle the results in the order of the remotes */
+	for (guint i = 0; i < refreshes->len; i++) {
+		GsFlatpakRefreshHelper *helper = g_ptr_array_index (refreshes, i);
+		const gchar *remote_name = flatpak_remote_get_name (helper->xremote);
+		g_autoptr(GFile) file = NULL;
+		g_autofree gchar *appstream_fn = NULL;
+
+		if (helper->error != NULL) {
 			g_autoptr(GsPluginEvent) event = NULL;
-			if (g_error_matches (error_local,
+			if (g_error_matches (helper->error,
 					     GS_PLUGIN_ERROR,
 					     GS_PLUGIN_ERROR_FAILED)) {
+				g_autoptr(GMutexLocker) locker = NULL;
+
 				g_debug ("Failed to get AppStream metadata: %s",
-					 error_local->message);
+					 helper->error->message);
 
 				locker = g_mutex_locker_new (&self->broken_remotes_mutex);
 
@@ -1249,21 +1546,21 @@ gs_flatpak_refresh_appstream (GsFlatpak *self, guint cache_age,
 			/* allow the plugin loader to decide if this should be
 			 * shown the user, possibly only for interactive jobs */
 			event = gs_plugin_event_new ();
-			gs_flatpak_error_convert (&error_local);
-			gs_plugin_event_set_error (event, error_local);
+			gs_flatpak_error_convert (&helper->error);
+			gs_plugin_event_set_error (event, helper->error);
 			gs_plugin_event_add_flag (event, GS_PLUGIN_EVENT_FLAG_WARNING);
 			gs_plugin_report_event (self->plugin, event);
 			continue;
 		}
 
-		/* add the new AppStream repo to the shared silo */
-		file = flatpak_remote_get_appstream_dir (xremote, NULL);
+		/* the new AppStream data is picked up by the remote’s sub-silo */
+		file = flatpak_remote_get_appstream_dir (helper->xremote, NULL);
 		appstream_fn = g_file_get_path (file);
 		g_debug ("using AppStream metadata found at: %s", appstream_fn);
 	}
 
-	/* ensure the AppStream silo is up to date */
-	if (!gs_flatpak_rescan_appstream_store (self, cancellable, error))
+	/* ensure the AppStream silos are up to date, once for all the remotes */
+	if (!gs_flatpak_rescan_appstream_store (self, TRUE, cancellable, error))
 		return FALSE;
 
 	return TRUE;
@@ -1682,11 +1979,8 @@ gs_flatpak_app_install_source (GsFlatpak *self,
 		return FALSE;
 	}
 
-	/* invalidate cache */
-	g_rw_lock_reader_lock (&self->silo_lock);
-	if (self->silo != NULL)
-		xb_silo_invalidate (self->silo);
-	g_rw_lock_reader_unlock (&self->silo_lock);
+	/* the set of remotes changed */
+	gs_flatpak_silos_changed (self);
 
 	/* success */
 	gs_app_set_state (app, GS_APP_STATE_INSTALLED);
@@ -1904,8 +2198,7 @@ gs_flatpak_refresh (GsFlatpak *self,
 
 	/* manually do this in case we created the first appstream file */
 	g_rw_lock_reader_lock (&self->silo_lock);
-	if (self->silo != NULL)
-		xb_silo_invalidate (self->silo);
+	gs_flatpak_invalidate_silos (self);
 	g_rw_lock_reader_unlock (&self->silo_lock);
 
 	/* update AppStream metadata */
@@ -1913,7 +2206,7 @@ gs_flatpak_refresh (GsFlatpak *self,
 		return FALSE;
 
 	/* ensure valid */
-	if (!gs_flatpak_rescan_appstream_store (self, cancellable, error))
+	if (!gs_flatpak_rescan_appstream_store (self, TRUE, cancellable, error))
 		return FALSE;
 
 	/* success */
@@ -2975,25 +3268,29 @@ gs_flatpak_refine_appstream (GsFlatpak *self,
 	if (origin == NULL || source == NULL)
 		return TRUE;
 
-	/* find using source and origin */
+	/* find using source and origin; @silo is %NULL if there is no
+	 * AppStream data for the origin */
 	source_safe = xb_string_escape (source);
 	xpath = g_strdup_printf ("components[@origin='%s']/component/bundle[@type='flatpak'][text()='%s']/..",
 				 origin, source_safe);
-	component = xb_silo_query_first (silo, xpath, &error_local);
+	if (silo != NULL)
+		component = xb_silo_query_first (silo, xpath, &error_local);
 
 	/* Ensure the gs_flatpak_app_get_ref_*() metadata are set */
 	gs_refine_item_metadata (self, app, NULL, NULL);
 
 	/* If the app was renamed, use the appstream data from the new name;
 	 * usually it will not exist under the old name */
-	if (component == NULL && gs_flatpak_app_get_ref_kind (app) == FLATPAK_REF_KIND_APP)
+	if (component == NULL && silo != NULL &&
+	    gs_flatpak_app_get_ref_kind (app) == FLATPAK_REF_KIND_APP)
 		component = get_renamed_component (self, app, silo);
 
 	if (component == NULL) {
 		g_autoptr(FlatpakInstalledRef) installed_ref = NULL;
 		g_autoptr(GBytes) appstream_gz = NULL;
 
-		g_debug ("no match for %s: %s", xpath, error_local->message);
+		g_debug ("no match for %s: %s", xpath,
+			 (error_local != NULL) ? error_local->message : "no AppStream data for origin");
 		/* For apps installed from .flatpak bundles there may not be any remote
 		 * appstream data in @silo for it, so use the appstream data from
 		 * within the app.
@@ -3049,7 +3346,8 @@ gs_flatpak_refine_app_unlocked (GsFlatpak *self,
 	locker = g_rw_lock_reader_locker_new (&self->silo_lock);
 
 	/* always do AppStream properties */
-	if (!gs_flatpak_refine_appstream (self, app, self->silo, flags, cancellable, error))
+	if (!gs_flatpak_refine_appstream (self, app, gs_flatpak_get_silo_for_app (self, app),
+					  flags, cancellable, error))
 		return FALSE;
 
 	/* AppStream sets the source to appname/arch/branch */
@@ -3076,7 +3374,8 @@ gs_flatpak_refine_app_unlocked (GsFlatpak *self,
 
 	/* if the state was changed, perhaps set the version from the release */
 	if (old_state != gs_app_get_state (app)) {
-		if (!gs_flatpak_refine_appstream (self, app, self->silo, flags, cancellable, error))
+		if (!gs_flatpak_refine_appstream (self, app, gs_flatpak_get_silo_for_app (self, app),
+						  flags, cancellable, error))
 			return FALSE;
 	}
 
@@ -3220,31 +3519,38 @@ gs_flatpak_refine_app (GsFlatpak *self,
 	return gs_flatpak_refine_app_unlocked (self, app, flags, cancellable, error);
 }
 
-gboolean
-gs_flatpak_refine_wildcard (GsFlatpak *self, GsApp *app,
-			    GsAppList *list, GsPluginRefineFlags refine_flags,
-			    GCancellable *cancellable, GError **error)
+/* must be called with silo_lock held */
+static gboolean
+gs_flatpak_refine_wildcard_silo (GsFlatpak *self,
+				 GsFlatpakSilo *sub,
+				 GsApp *app,
+				 GsAppList *list,
+				 GsPluginRefineFlags refine_flags,
+				 GCancellable *cancellable,
+				 GError **error)
 {
-	const gchar *id;
+	const gchar *id = gs_app_get_id (app);
 	g_autofree gchar *xpath = NULL;
 	g_autoptr(GError) error_local = NULL;
 	g_autoptr(GPtrArray) components = NULL;
-	g_autoptr(GRWLockReaderLocker) locker = NULL;
-
-	/* not enough info to find */
-	id = gs_app_get_id (app);
-	if (id == NULL)
-		return TRUE;
-
-	/* ensure valid */
-	if (!gs_flatpak_rescan_app_data (self, cancellable, error))
-		return FALSE;
-
-	locker = g_rw_lock_reader_locker_new (&self->silo_lock);
 
 	/* find all apps when matching any prefixes */
-	xpath = g_strdup_printf ("components/component/id[text()='%s']/..", id);
-	components = xb_silo_query (self->silo, xpath, 0, &error_local);
+	if (sub->index != NULL) {
+		GPtrArray *matches = gs_appstream_index_lookup_id (sub->index, id);
+
+		components = g_ptr_array_new_with_free_func (g_object_unref);
+		for (guint i = 0; matches != NULL && i < matches->len; i++) {
+			XbNode *component = g_ptr_array_index (matches, i);
+			g_autoptr(XbNode) parent = xb_node_get_parent (component);
+			if (parent != NULL)
+				g_ptr_array_add (components, g_object_ref (component));
+		}
+		if (components->len == 0)
+			return TRUE;
+	} else {
+		xpath = g_strdup_printf ("components/component/id[text()='%s']/..", id);
+		components = xb_silo_query (sub->silo, xpath, 0, &error_local);
+	}
 	if (components == NULL) {
 		if (g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
 			return TRUE;
@@ -3259,7 +3565,7 @@ gs_flatpak_refine_wildcard (GsFlatpak *self, GsApp *app,
 	for (guint i = 0; i < components->len; i++) {
 		XbNode *component = g_ptr_array_index (components, i);
 		g_autoptr(GsApp) new = NULL;
-		new = gs_appstream_create_app (self->plugin, self->silo, component, error);
+		new = gs_appstream_create_app (self->plugin, sub->silo, component, error);
 		if (new == NULL)
 			return FALSE;
 		gs_flatpak_claim_app (self, new);
@@ -3273,6 +3579,52 @@ gs_flatpak_refine_wildcard (GsFlatpak *self, GsApp *app,
 	return TRUE;
 }
 
+/* the apps matching each wildcard in @wildcards are added to the list at the
+ * same position in @results, so that the caller can keep the order of the
+ * wildcards across installations */
+gboolean
+gs_flatpak_refine_wildcards (GsFlatpak *self,
+			     GsAppList *wildcards,
+			     GPtrArray *results,
+			     GsPluginRefineFlags refine_flags,
+			     GCancellable *cancellable,
+			     GError **error)
+{
+	g_autoptr(GRWLockReaderLocker) locker = NULL;
+
+	g_return_val_if_fail (results->len == gs_app_list_length (wildcards), FALSE);
+
+	/* ensure valid, once for all the wildcards */
+	if (!gs_flatpak_rescan_app_data (self, cancellable, error))
+		return FALSE;
+
+	locker = g_rw_lock_reader_locker_new (&self->silo_lock);
+	for (guint j = 0; j < gs_app_list_length (wildcards); j++) {
+		GsApp *app = gs_app_list_index (wildcards, j);
+		GsAppList *list = g_ptr_array_index (results, j);
+
+		if (!gs_app_has_quirk (app, GS_APP_QUIRK_IS_WILDCARD))
+			continue;
+
+		/* not enough info to find */
+		if (gs_app_get_id (app) == NULL)
+			continue;
+
+		if (g_cancellable_set_error_if_cancelled (cancellable, error))
+			return FALSE;
+
+		for (guint i = 0; self->silos != NULL && i < self->silos->len; i++) {
+			GsFlatpakSilo *sub = g_ptr_array_index (self->silos, i);
+			if (!gs_flatpak_refine_wildcard_silo (self, sub, app, list, refine_flags,
+							      cancellable, error))
+				return FALSE;
+		}
+	}
+
+	/* success */
+	return TRUE;
+}
+
 gboolean
 gs_flatpak_launch (GsFlatpak *self,
 		   GsApp *app,
@@ -3333,11 +3685,8 @@ gs_flatpak_app_remove_source (GsFlatpak *self,
 		return FALSE;
 	}
 
-	/* invalidate cache */
-	g_rw_lock_reader_lock (&self->silo_lock);
-	if (self->silo != NULL)
-		xb_silo_invalidate (self->silo);
-	g_rw_lock_reader_unlock (&self->silo_lock);
+	/* the set of remotes changed */
+	gs_flatpak_silos_changed (self);
 
 	gs_app_set_state (app, is_remove ? GS_APP_STATE_UNAVAILABLE : GS_APP_STATE_AVAILABLE);
 
@@ -3789,16 +4138,19 @@ gs_flatpak_search (GsFlatpak *self,
 		return FALSE;
 
 	locker = g_rw_lock_reader_locker_new (&self->silo_lock);
-	if (!gs_appstream_search (self->plugin, self->silo, values, list_tmp,
-				  cancellable, error))
-		return FALSE;
+	for (guint i = 0; self->silos != NULL && i < self->silos->len; i++) {
+		GsFlatpakSilo *sub = g_ptr_array_index (self->silos, i);
+		if (!gs_appstream_search_with_index (self->plugin, sub->silo, sub->index,
+						     values, list_tmp, cancellable, error))
+			return FALSE;
+	}
 
 	gs_flatpak_ensure_remote_title (self, cancellable);
 
 	gs_flatpak_claim_app_list (self, list_tmp);
 	gs_app_list_add_list (list, list_tmp);
 
-	/* Also search silos from installed apps which were missing from self->silo */
+	/* Also search silos from installed apps which were missing from self->silos */
 	app_silo_locker = g_mutex_locker_new (&self->app_silos_mutex);
 	g_hash_table_iter_init (&iter, self->app_silos);
 	while (g_hash_table_iter_next (&iter, &key, &value)) {
@@ -3853,13 +4205,28 @@ gs_flatpak_add_category_apps (GsFlatpak *self,
 {
 	g_autoptr(GRWLockReaderLocker) locker = NULL;
 
-	if (!gs_flatpak_rescan_appstream_store (self, cancellable, error))
+	if (!gs_flatpak_rescan_appstream_store (self, FALSE, cancellable, error))
 		return FALSE;
 
 	locker = g_rw_lock_reader_locker_new (&self->silo_lock);
-	return gs_appstream_add_category_apps (self->silo,
-					       category, list,
-					       cancellable, error);
+	for (guint i = 0; self->silos != NULL && i < self->silos->len; i++) {
+		GsFlatpakSilo *sub = g_ptr_array_index (self->silos, i);
+		g_autoptr(GsAppList) list_tmp = gs_app_list_new ();
+
+		if (!gs_appstream_add_category_apps_with_index (self->plugin, sub->silo, sub->index,
+								category, list_tmp,
+								cancellable, error))
+			return FALSE;
+
+		/* apps from the index are real apps, so claim them like search
+		 * results; wildcards for override components are skipped */
+		if (sub->index != NULL) {
+			gs_flatpak_ensure_remote_title (self, cancellable);
+			gs_flatpak_claim_app_list (self, list_tmp);
+		}
+		gs_app_list_add_list (list, list_tmp);
+	}
+	return TRUE;
 }
 
 gboolean
@@ -3874,8 +4241,13 @@ gs_flatpak_add_categories (GsFlatpak *self,
 		return FALSE;
 
 	locker = g_rw_lock_reader_locker_new (&self->silo_lock);
-	return gs_appstream_add_categories (self->silo,
-					    list, cancellable, error);
+	for (guint i = 0; self->silos != NULL && i < self->silos->len; i++) {
+		GsFlatpakSilo *sub = g_ptr_array_index (self->silos, i);
+		if (!gs_appstream_add_categories_with_index (sub->silo, sub->index,
+							     list, cancellable, error))
+			return FALSE;
+	}
+	return TRUE;
 }
 
 gboolean
@@ -3891,9 +4263,12 @@ gs_flatpak_add_popular (GsFlatpak *self,
 		return FALSE;
 
 	locker = g_rw_lock_reader_locker_new (&self->silo_lock);
-	if (!gs_appstream_add_popular (self->silo, list_tmp,
-				       cancellable, error))
-		return FALSE;
+	for (guint i = 0; self->silos != NULL && i < self->silos->len; i++) {
+		GsFlatpakSilo *sub = g_ptr_array_index (self->silos, i);
+		if (!gs_appstream_add_popular (sub->silo, list_tmp,
+					       cancellable, error))
+			return FALSE;
+	}
 
 	gs_app_list_add_list (list, list_tmp);
 
@@ -3913,9 +4288,12 @@ gs_flatpak_add_featured (GsFlatpak *self,
 		return FALSE;
 
 	locker = g_rw_lock_reader_locker_new (&self->silo_lock);
-	if (!gs_appstream_add_featured (self->silo, list_tmp,
-					cancellable, error))
-		return FALSE;
+	for (guint i = 0; self->silos != NULL && i < self->silos->len; i++) {
+		GsFlatpakSilo *sub = g_ptr_array_index (self->silos, i);
+		if (!gs_appstream_add_featured (sub->silo, list_tmp,
+						cancellable, error))
+			return FALSE;
+	}
 
 	gs_app_list_add_list (list, list_tmp);
 
@@ -3936,9 +4314,12 @@ gs_flatpak_add_alternates (GsFlatpak *self,
 		return FALSE;
 
 	locker = g_rw_lock_reader_locker_new (&self->silo_lock);
-	if (!gs_appstream_add_alternates (self->silo, app, list_tmp,
-					  cancellable, error))
-		return FALSE;
+	for (guint i = 0; self->silos != NULL && i < self->silos->len; i++) {
+		GsFlatpakSilo *sub = g_ptr_array_index (self->silos, i);
+		if (!gs_appstream_add_alternates (sub->silo, app, list_tmp,
+						  cancellable, error))
+			return FALSE;
+	}
 
 	gs_app_list_add_list (list, list_tmp);
 
@@ -3959,9 +4340,12 @@ gs_flatpak_add_recent (GsFlatpak *self,
 		return FALSE;
 
 	locker = g_rw_lock_reader_locker_new (&self->silo_lock);
-	if (!gs_appstream_add_recent (self->plugin, self->silo, list_tmp, age,
-				      cancellable, error))
-		return FALSE;
+	for (guint i = 0; self->silos != NULL && i < self->silos->len; i++) {
+		GsFlatpakSilo *sub = g_ptr_array_index (self->silos, i);
+		if (!gs_appstream_add_recent (self->plugin, sub->silo, list_tmp, age,
+					      cancellable, error))
+			return FALSE;
+	}
 
 	gs_flatpak_claim_app_list (self, list_tmp);
 	gs_app_list_add_list (list, list_tmp);
@@ -3983,8 +4367,11 @@ gs_flatpak_url_to_app (GsFlatpak *self,
 		return FALSE;
 
 	locker = g_rw_lock_reader_locker_new (&self->silo_lock);
-	if (!gs_appstream_url_to_app (self->plugin, self->silo, list_tmp, url, cancellable, error))
-		return FALSE;
+	for (guint i = 0; self->silos != NULL && i < self->silos->len; i++) {
+		GsFlatpakSilo *sub = g_ptr_array_index (self->silos, i);
+		if (!gs_appstream_url_to_app (self->plugin, sub->silo, list_tmp, url, cancellable, error))
+			return FALSE;
+	}
 
 	gs_flatpak_claim_app_list (self, list_tmp);
 	gs_app_list_add_list (list, list_tmp);
@@ -4033,8 +4420,7 @@ gs_flatpak_finalize (GObject *object)
 		g_signal_handler_disconnect (self->monitor, self->changed_id);
 		self->changed_id = 0;
 	}
-	if (self->silo != NULL)
-		g_object_unref (self->silo);
+	g_clear_pointer (&self->silos, g_ptr_array_unref);
 
 	g_free (self->id);
 	g_object_unref (self->installation);
@@ -4044,6 +4430,7 @@ gs_flatpak_finalize (GObject *object)
 	g_hash_table_unref (self->broken_remotes);
 	g_mutex_clear (&self->broken_remotes_mutex);
 	g_rw_lock_clear (&self->silo_lock);
+	g_mutex_clear (&self->silo_rebuild_mutex);
 	g_hash_table_unref (self->app_silos);
 	g_mutex_clear (&self->app_silos_mutex);
 	g_clear_pointer (&self->remote_title, g_hash_table_unref);
@@ -4065,6 +4452,7 @@ gs_flatpak_init (GsFlatpak *self)
 	/* XbSilo needs external locking as we destroy the silo and build a new
 	 * one when something changes */
 	g_rw_lock_init (&self->silo_lock);
+	g_mutex_init (&self->silo_rebuild_mutex);
 
 	g_mutex_init (&self->installed_refs_mutex);
 	self->installed_refs = NULL;
@@ -66,9 +66,9 @@ gboolean	gs_flatpak_refine_app_state	(GsFlatpak		*self,
 						 GsApp			*app,
 						 GCancellable		*cancellable,
 						 GError			**error);
-gboolean	gs_flatpak_refine_wildcard	(GsFlatpak		*self,
-						 GsApp			*app,
-						 GsAppList		*list,
+gboolean	gs_flatpak_refine_wildcards	(GsFlatpak		*self,
+						 GsAppList		*wildcards,
+						 GPtrArray		*results,
 						 GsPluginRefineFlags	 flags,
 						 GCancellable		*cancellable,
 						 GError			**error);
@@ -404,22 +404,31 @@ gs_plugin_refine (GsPlugin             *plugin,
 }
 
 gboolean
-gs_plugin_refine_wildcard (GsPlugin *plugin,
-			   GsApp *app,
-			   GsAppList *list,
-			   GsPluginRefineFlags flags,
-			   GCancellable *cancellable,
-			   GError **error)
+gs_plugin_refine_wildcards (GsPlugin *plugin,
+			    GsAppList *list,
+			    GsPluginRefineFlags flags,
+			    GCancellable *cancellable,
+			    GError **error)
 {
 	GsPluginFlatpak *self = GS_PLUGIN_FLATPAK (plugin);
+	g_autoptr(GsAppList) wildcards = gs_app_list_copy (list);
+	g_autoptr(GPtrArray) results = g_ptr_array_new_with_free_func (g_object_unref);
 
+	for (guint j = 0; j < gs_app_list_length (wildcards); j++)
+		g_ptr_array_add (results, gs_app_list_new ());
+
+	/* each installation is rescanned and locked once for all the wildcards */
 	for (guint i = 0; i < self->installations->len; i++) {
 		GsFlatpak *flatpak = g_ptr_array_index (self->installations, i);
-		if (!gs_flatpak_refine_wildcard (flatpak, app, list, flags,
-						 cancellable, error)) {
+		if (!gs_flatpak_refine_wildcards (flatpak, wildcards, results, flags,
+						  cancellable, error)) {
 			return FALSE;
 		}
 	}
+
+	/* keep the order of the wildcards rather than the installations */
+	for (guint j = 0; j < results->len; j++)
+		gs_app_list_add_list (list, g_ptr_array_index (results, j));
 	return TRUE;
 }
 
@@ -246,16 +246,19 @@ static void
 gs_application_initialize_ui (GsApplication *app)
 {
 	static gboolean initialized = FALSE;
+	gint64 startup_time;
 
 	if (initialized)
 		return;
 
 	initialized = TRUE;
 
+	startup_time = g_get_monotonic_time ();
 	gs_application_initialize_plugins (app);
 
 	/* setup UI */
 	app->shell = gs_shell_new ();
+	gs_shell_set_startup_time (app->shell, startup_time);
 	app->cancellable = g_cancellable_new ();
 
 	app->shell_loaded_handler_id = g_signal_connect (app->shell, "loaded",
@@ -67,6 +67,10 @@ static void gs_installed_page_pending_apps_changed_cb (GsPluginLoader *plugin_lo
 static void gs_installed_page_notify_state_changed_cb (GsApp *app,
 						       GParamSpec *pspec,
 						       GsInstalledPage *self);
+static void gs_installed_page_notify_sort_key_changed_cb (GsApp *app,
+							   GParamSpec *pspec,
+							   GsInstalledPage *self);
+static void gs_installed_page_invalidate_row_sort_key (GsAppRow *app_row);
 
 typedef enum {
 	GS_UPDATE_LIST_SECTION_INSTALLING_AND_REMOVING,
@@ -173,6 +177,8 @@ gs_installed_page_unreveal_row (GsAppRow *app_row)
 	if (app != NULL) {
 		g_signal_handlers_disconnect_matched (app, G_SIGNAL_MATCH_FUNC, 0, 0, NULL,
 						      G_CALLBACK (gs_installed_page_notify_state_changed_cb), NULL);
+		g_signal_handlers_disconnect_matched (app, G_SIGNAL_MATCH_FUNC, 0, 0, NULL,
+						      G_CALLBACK (gs_installed_page_notify_sort_key_changed_cb), NULL);
 	}
 
 	/* This check is required, because GsAppRow does not emit
@@ -286,6 +292,7 @@ gs_installed_page_notify_state_changed_cb (GsApp *app,
 
 	g_assert (app_row != NULL);
 
+	gs_installed_page_invalidate_row_sort_key (app_row);
 	gtk_list_box_row_changed (GTK_LIST_BOX_ROW (app_row));
 
 	/* Filter which applications can be shown in the installed page */
@@ -299,6 +306,19 @@ gs_installed_page_notify_state_changed_cb (GsApp *app,
 		gs_installed_page_maybe_move_app_row (self, app_row);
 }
 
+static void
+gs_installed_page_notify_sort_key_changed_cb (GsApp *app,
+                                              GParamSpec *pspec,
+                                              GsInstalledPage *self)
+{
+	GsAppRow *app_row = gs_installed_page_find_app_row (self, app);
+
+	g_assert (app_row != NULL);
+
+	gs_installed_page_invalidate_row_sort_key (app_row);
+	gtk_list_box_row_changed (GTK_LIST_BOX_ROW (app_row));
+}
+
 static gboolean
 should_show_installed_size (GsInstalledPage *self)
 {
@@ -339,6 +359,19 @@ gs_installed_page_add_app (GsInstalledPage *self, GsAppList *list, GsApp *app)
 	g_signal_connect_object (app, "notify::state",
 				 G_CALLBACK (gs_installed_page_notify_state_changed_cb),
 				 self, 0);
+	/* the rest of the sort key */
+	g_signal_connect_object (app, "notify::name",
+				 G_CALLBACK (gs_installed_page_notify_sort_key_changed_cb),
+				 self, 0);
+	g_signal_connect_object (app, "notify::kind",
+				 G_CALLBACK (gs_installed_page_notify_sort_key_changed_cb),
+				 self, 0);
+	g_signal_connect_object (app, "notify::special-kind",
+				 G_CALLBACK (gs_installed_page_notify_sort_key_changed_cb),
+				 self, 0);
+	g_signal_connect_object (app, "notify::quirk",
+				 G_CALLBACK (gs_installed_page_notify_sort_key_changed_cb),
+				 self, 0);
 
 	switch (gs_installed_page_get_app_section (app)) {
 	case GS_UPDATE_LIST_SECTION_INSTALLING_AND_REMOVING:
@@ -414,6 +447,8 @@ gs_installed_page_remove_all_cb (GtkWidget *container,
 		if (app != NULL) {
 			g_signal_handlers_disconnect_matched (app, G_SIGNAL_MATCH_FUNC, 0, 0, NULL,
 							      G_CALLBACK (gs_installed_page_notify_state_changed_cb), NULL);
+			g_signal_handlers_disconnect_matched (app, G_SIGNAL_MATCH_FUNC, 0, 0, NULL,
+							      G_CALLBACK (gs_installed_page_notify_sort_key_changed_cb), NULL);
 		}
 	} else {
 		g_warn_if_reached ();
@@ -574,30 +609,42 @@ gs_installed_page_get_app_sort_key (GsApp *app)
 		g_string_append (key, "2:");
 
 	/* finally, sort by short name */
-	if (gs_app_get_name (app) != NULL) {
-		sort_name = gs_utils_sort_key (gs_app_get_name (app));
+	sort_name = gs_app_dup_name_sort_key (app);
+	if (sort_name != NULL)
 		g_string_append (key, sort_name);
-	}
 
 	return g_string_free (key, FALSE);
 }
 
+/* The key is built the first time a row is sorted, and kept until the state,
+ * kind, special kind, quirks or name of its app change. */
+static const gchar *
+gs_installed_page_get_row_sort_key (GtkListBoxRow *row)
+{
+	gchar *key = g_object_get_data (G_OBJECT (row), "sort-key");
+
+	if (key == NULL) {
+		key = gs_installed_page_get_app_sort_key (gs_app_row_get_app (GS_APP_ROW (row)));
+		g_object_set_data_full (G_OBJECT (row), "sort-key", key, g_free);
+	}
+
+	return key;
+}
+
+static void
+gs_installed_page_invalidate_row_sort_key (GsAppRow *app_row)
+{
+	g_object_set_data (G_OBJECT (app_row), "sort-key", NULL);
+}
+
 static gint
 gs_installed_page_sort_func (GtkListBoxRow *a,
                              GtkListBoxRow *b,
                              gpointer user_data)
 {
-	GsApp *a1, *a2;
-	g_autofree gchar *key1 = NULL;
-	g_autofree gchar *key2 = NULL;
-
-	a1 = gs_app_row_get_app (GS_APP_ROW (a));
-	a2 = gs_app_row_get_app (GS_APP_ROW (b));
-	key1 = gs_installed_page_get_app_sort_key (a1);
-	key2 = gs_installed_page_get_app_sort_key (a2);
-
 	/* compare the keys according to the algorithm above */
-	return g_strcmp0 (key1, key2);
+	return g_strcmp0 (gs_installed_page_get_row_sort_key (a),
+			  gs_installed_page_get_row_sort_key (b));
 }
 
 static gboolean
@@ -231,3 +231,13 @@ gs_loading_page_new (void)
 	self = g_object_new (GS_TYPE_LOADING_PAGE, NULL);
 	return GS_LOADING_PAGE (self);
 }
+
+/* Runs the initial refresh without the page being shown, e.g. when the
+ * overview has already been painted from a snapshot. The ::refreshed signal
+ * is emitted when done, exactly as when switching to the page. */
+void
+gs_loading_page_refresh (GsLoadingPage *self)
+{
+	g_return_if_fail (GS_IS_LOADING_PAGE (self));
+	gs_loading_page_load (self);
+}
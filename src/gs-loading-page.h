@@ -25,5 +25,6 @@ struct _GsLoadingPageClass
 };
 
 GsLoadingPage	*gs_loading_page_new		(void);
+void		 gs_loading_page_refresh	(GsLoadingPage	*self);
 
 G_END_DECLS
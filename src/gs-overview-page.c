@@ -39,6 +39,7 @@ struct _GsOverviewPage
 	gboolean		 loading_recent;
 	gboolean		 loading_categories;
 	gboolean		 empty;
+	gboolean		 has_snapshot;
 	GHashTable		*category_hash;		/* id : GsCategory */
 	GsFedoraThirdParty	*third_party;
 	gboolean		 third_party_needs_question;
@@ -118,6 +119,33 @@ gs_overview_page_decrement_action_cnt (GsOverviewPage *self)
 	self->loading_recent = FALSE;
 }
 
+/* apps loaded from a snapshot have no management plugin, so their tiles
+ * are not clickable until the live results replace them */
+static gboolean
+gs_overview_page_app_is_snapshot (GsApp *app)
+{
+	return gs_app_get_metadata_item (app, "GnomeSoftware::snapshot") != NULL;
+}
+
+static void
+gs_overview_page_set_popular (GsOverviewPage *self, GsAppList *list)
+{
+	gs_widget_remove_all (self->box_popular, (GsRemoveFunc) gtk_flow_box_remove);
+
+	for (guint i = 0; i < gs_app_list_length (list) && i < N_TILES; i++) {
+		GsApp *app = gs_app_list_index (list, i);
+		GtkWidget *tile = gs_summary_tile_new (app);
+		g_signal_connect (tile, "clicked",
+			  G_CALLBACK (app_tile_clicked), self);
+		gtk_widget_set_sensitive (tile, !gs_overview_page_app_is_snapshot (app));
+		gtk_flow_box_insert (GTK_FLOW_BOX (self->box_popular), tile, -1);
+	}
+	gtk_widget_set_visible (self->box_popular, TRUE);
+	gtk_widget_set_visible (self->popular_heading, TRUE);
+
+	self->empty = FALSE;
+}
+
 static void
 gs_overview_page_get_popular_cb (GObject *source_object,
                                  GAsyncResult *res,
@@ -125,9 +153,6 @@ gs_overview_page_get_popular_cb (GObject *source_object,
 {
 	GsOverviewPage *self = GS_OVERVIEW_PAGE (user_data);
 	GsPluginLoader *plugin_loader = GS_PLUGIN_LOADER (source_object);
-	guint i;
-	GsApp *app;
-	GtkWidget *tile;
 	g_autoptr(GError) error = NULL;
 	g_autoptr(GsAppList) list = NULL;
 
@@ -149,23 +174,41 @@ gs_overview_page_get_popular_cb (GObject *source_object,
 	}
 
 	gs_app_list_randomize (list);
+	gs_app_list_truncate (list, N_TILES);
+	gs_overview_page_set_popular (self, list);
+	gs_plugin_loader_save_snapshot (plugin_loader, "overview-popular", list);
 
-	gs_widget_remove_all (self->box_popular, (GsRemoveFunc) gtk_flow_box_remove);
+out:
+	gs_overview_page_decrement_action_cnt (self);
+}
+
+static void
+gs_overview_page_set_recent (GsOverviewPage *self, GsAppList *list)
+{
+	gs_widget_remove_all (self->box_recent, (GsRemoveFunc) gtk_flow_box_remove);
+
+	for (guint i = 0; i < gs_app_list_length (list) && i < N_TILES; i++) {
+		GsApp *app = gs_app_list_index (list, i);
+		GtkWidget *tile = gs_summary_tile_new (app);
+		GtkWidget *child;
 
-	for (i = 0; i < gs_app_list_length (list) && i < N_TILES; i++) {
-		app = gs_app_list_index (list, i);
-		tile = gs_summary_tile_new (app);
 		g_signal_connect (tile, "clicked",
 			  G_CALLBACK (app_tile_clicked), self);
-		gtk_flow_box_insert (GTK_FLOW_BOX (self->box_popular), tile, -1);
+		gtk_widget_set_sensitive (tile, !gs_overview_page_app_is_snapshot (app));
+		child = gtk_flow_box_child_new ();
+		/* Manually creating the child is needed to avoid having it be
+		 * focusable but non activatable, and then have the child
+		 * focusable and activatable, which is annoying and confusing.
+		 */
+		gtk_widget_set_can_focus (child, FALSE);
+		gtk_widget_show (child);
+		gtk_flow_box_child_set_child (GTK_FLOW_BOX_CHILD (child), tile);
+		gtk_flow_box_insert (GTK_FLOW_BOX (self->box_recent), child, -1);
 	}
-	gtk_widget_set_visible (self->box_popular, TRUE);
-	gtk_widget_set_visible (self->popular_heading, TRUE);
+	gtk_widget_set_visible (self->box_recent, TRUE);
+	gtk_widget_set_visible (self->recent_heading, TRUE);
 
 	self->empty = FALSE;
-
-out:
-	gs_overview_page_decrement_action_cnt (self);
 }
 
 static void
@@ -173,10 +216,6 @@ gs_overview_page_get_recent_cb (GObject *source_object, GAsyncResult *res, gpoin
 {
 	GsOverviewPage *self = GS_OVERVIEW_PAGE (user_data);
 	GsPluginLoader *plugin_loader = GS_PLUGIN_LOADER (source_object);
-	guint i;
-	GsApp *app;
-	GtkWidget *tile;
-	GtkWidget *child;
 	g_autoptr(GError) error = NULL;
 	g_autoptr(GsAppList) list = NULL;
 
@@ -198,28 +237,9 @@ gs_overview_page_get_recent_cb (GObject *source_object, GAsyncResult *res, gpoin
 	}
 
 	gs_app_list_randomize (list);
-
-	gs_widget_remove_all (self->box_recent, (GsRemoveFunc) gtk_flow_box_remove);
-
-	for (i = 0; i < gs_app_list_length (list) && i < N_TILES; i++) {
-		app = gs_app_list_index (list, i);
-		tile = gs_summary_tile_new (app);
-		g_signal_connect (tile, "clicked",
-			  G_CALLBACK (app_tile_clicked), self);
-		child = gtk_flow_box_child_new ();
-		/* Manually creating the child is needed to avoid having it be
-		 * focusable but non activatable, and then have the child
-		 * focusable and activatable, which is annoying and confusing.
-		 */
-		gtk_widget_set_can_focus (child, FALSE);
-		gtk_widget_show (child);
-		gtk_flow_box_child_set_child (GTK_FLOW_BOX_CHILD (child), tile);
-		gtk_flow_box_insert (GTK_FLOW_BOX (self->box_recent), child, -1);
-	}
-	gtk_widget_set_visible (self->box_recent, TRUE);
-	gtk_widget_set_visible (self->recent_heading, TRUE);
-
-	self->empty = FALSE;
+	gs_app_list_truncate (list, N_TILES);
+	gs_overview_page_set_recent (self, list);
+	gs_plugin_loader_save_snapshot (plugin_loader, "overview-recent", list);
 
 out:
 	gs_overview_page_decrement_action_cnt (self);
@@ -241,6 +261,43 @@ filter_hi_res_icon (GsApp *app, gpointer user_data)
 	return (icon != NULL);
 }
 
+static void
+gs_overview_page_key_colors_thread (GTask *task,
+				    gpointer source_object,
+				    gpointer task_data,
+				    GCancellable *cancellable)
+{
+	GsAppList *list = task_data;
+
+	for (guint i = 0; i < gs_app_list_length (list); i++) {
+		if (g_cancellable_is_cancelled (cancellable))
+			break;
+		gs_app_ensure_key_colors (gs_app_list_index (list, i));
+	}
+
+	g_task_return_boolean (task, TRUE);
+}
+
+static void
+gs_overview_page_key_colors_cb (GObject *source_object,
+				GAsyncResult *result,
+				gpointer user_data)
+{
+	GsOverviewPage *self = GS_OVERVIEW_PAGE (source_object);
+	GsAppList *list = g_task_get_task_data (G_TASK (result));
+
+	if (g_task_had_error (G_TASK (result)) ||
+	    g_cancellable_is_cancelled (g_task_get_cancellable (G_TASK (result))))
+		goto out;
+
+	gs_featured_carousel_set_apps (GS_FEATURED_CAROUSEL (self->featured_carousel), list);
+	gtk_widget_set_sensitive (self->featured_carousel, TRUE);
+	gs_plugin_loader_save_snapshot (self->plugin_loader, "overview-featured", list);
+
+out:
+	gs_overview_page_decrement_action_cnt (self);
+}
+
 static void
 gs_overview_page_get_featured_cb (GObject *source_object,
                                   GAsyncResult *res,
@@ -276,10 +333,24 @@ gs_overview_page_get_featured_cb (GObject *source_object,
 	}
 
 	gtk_widget_set_visible (self->featured_carousel, gs_app_list_length (list) > 0);
-	gs_featured_carousel_set_apps (GS_FEATURED_CAROUSEL (self->featured_carousel), list);
-
 	self->empty = self->empty && (gs_app_list_length (list) == 0);
 
+	/* the feature tiles are drawn using the key colors of the icons, so
+	 * calculate them in a thread before showing the apps, rather than on
+	 * the main thread when each tile is first drawn */
+	if (gs_app_list_length (list) > 0) {
+		g_autoptr(GTask) task = NULL;
+
+		task = g_task_new (self, self->cancellable, gs_overview_page_key_colors_cb, NULL);
+		g_task_set_source_tag (task, gs_overview_page_get_featured_cb);
+		g_task_set_task_data (task, g_steal_pointer (&list), g_object_unref);
+		g_task_run_in_thread (task, gs_overview_page_key_colors_thread);
+		return;
+	}
+
+	gs_featured_carousel_set_apps (GS_FEATURED_CAROUSEL (self->featured_carousel), list);
+	gtk_widget_set_sensitive (self->featured_carousel, TRUE);
+
 out:
 	gs_overview_page_decrement_action_cnt (self);
 }
@@ -605,6 +676,52 @@ third_party_response_cb (GtkInfoBar *info_bar,
 					    self);
 }
 
+static void
+gs_overview_page_load_snapshots (GsOverviewPage *self)
+{
+	g_autoptr(GsAppList) featured = NULL;
+	g_autoptr(GsAppList) popular = NULL;
+	g_autoptr(GsAppList) recent = NULL;
+	g_autoptr(GError) error = NULL;
+
+	self->empty = TRUE;
+
+	featured = gs_plugin_loader_load_snapshot (self->plugin_loader, "overview-featured", &error);
+	if (featured != NULL && gs_app_list_length (featured) > 0) {
+		gtk_widget_set_visible (self->featured_carousel, TRUE);
+		gtk_widget_set_sensitive (self->featured_carousel, FALSE);
+		gs_featured_carousel_set_apps (GS_FEATURED_CAROUSEL (self->featured_carousel), featured);
+		self->empty = FALSE;
+	} else if (error != NULL) {
+		g_debug ("no featured snapshot: %s", error->message);
+		g_clear_error (&error);
+	}
+
+	popular = gs_plugin_loader_load_snapshot (self->plugin_loader, "overview-popular", &error);
+	if (popular != NULL && gs_app_list_length (popular) >= N_TILES) {
+		gs_overview_page_set_popular (self, popular);
+	} else if (error != NULL) {
+		g_debug ("no popular snapshot: %s", error->message);
+		g_clear_error (&error);
+	}
+
+	recent = gs_plugin_loader_load_snapshot (self->plugin_loader, "overview-recent", &error);
+	if (recent != NULL && gs_app_list_length (recent) >= N_TILES) {
+		gs_overview_page_set_recent (self, recent);
+	} else if (error != NULL) {
+		g_debug ("no recent snapshot: %s", error->message);
+		g_clear_error (&error);
+	}
+
+	/* the categories are not snapshotted, they get filled in when the
+	 * page is reloaded once the plugins are refreshed */
+	if (self->empty)
+		return;
+	self->has_snapshot = TRUE;
+	self->cache_valid = TRUE;
+	gtk_stack_set_visible_child_name (GTK_STACK (self->stack_overview), "overview");
+}
+
 static gboolean
 gs_overview_page_setup (GsPage *page,
                         GsShell *shell,
@@ -659,6 +776,9 @@ gs_overview_page_setup (GsPage *page,
 		gtk_flow_box_insert (GTK_FLOW_BOX (self->box_recent), tile, -1);
 	}
 
+	/* show what was there last time until the plugins have caught up */
+	gs_overview_page_load_snapshots (self);
+
 	return TRUE;
 }
 
@@ -775,6 +895,23 @@ gs_overview_page_class_init (GsOverviewPageClass *klass)
 	gtk_widget_class_bind_template_callback (widget_class, featured_carousel_app_clicked_cb);
 }
 
+/**
+ * gs_overview_page_get_has_snapshot:
+ * @self: a #GsOverviewPage
+ *
+ * Gets whether the page was filled from the apps shown in a previous run,
+ * and so can be shown before the plugins have been refreshed.
+ *
+ * Returns: %TRUE if the page was filled from a snapshot
+ */
+gboolean
+gs_overview_page_get_has_snapshot (GsOverviewPage *self)
+{
+	g_return_val_if_fail (GS_IS_OVERVIEW_PAGE (self), FALSE);
+
+	return self->has_snapshot;
+}
+
 GsOverviewPage *
 gs_overview_page_new (void)
 {
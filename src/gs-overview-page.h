@@ -20,5 +20,6 @@ G_DECLARE_FINAL_TYPE (GsOverviewPage, gs_overview_page, GS, OVERVIEW_PAGE, GsPag
 GsOverviewPage	*gs_overview_page_new		(void);
 void		 gs_overview_page_set_category	(GsOverviewPage		*self,
 						 const gchar		*category);
+gboolean	 gs_overview_page_get_has_snapshot	(GsOverviewPage		*self);
 
 G_END_DECLS
@@ -34,6 +34,7 @@ struct _GsScreenshotImage
 #if SOUP_CHECK_VERSION(3, 0, 0)
 	GCancellable	*cancellable;
 #endif
+	GCancellable	*blur_cancellable;
 	gchar		*filename;
 	const gchar	*current_image;
 	guint		 width;
@@ -119,6 +120,27 @@ as_screenshot_show_image (GsScreenshotImage *ssimg)
 	gs_screenshot_image_stop_spinner (ssimg);
 }
 
+/* The blurred image is only a placeholder, so blur a quarter size copy and
+ * scale that up rather than blurring at the full size */
+static GdkPixbuf *
+gs_pixbuf_scale_blurred (GdkPixbuf *original,
+			 guint width,
+			 guint height)
+{
+	g_autoptr(GdkPixbuf) pixbuf_small = NULL;
+
+	pixbuf_small = gdk_pixbuf_scale_simple (original,
+						(gint) MAX (width / 4, 1),
+						(gint) MAX (height / 4, 1),
+						GDK_INTERP_BILINEAR);
+	if (pixbuf_small == NULL)
+		return NULL;
+	gs_utils_pixbuf_blur (pixbuf_small, 1, 3);
+	return gdk_pixbuf_scale_simple (pixbuf_small,
+					(gint) width, (gint) height,
+					GDK_INTERP_BILINEAR);
+}
+
 static GdkPixbuf *
 gs_pixbuf_resample (GdkPixbuf *original,
 		    guint width,
@@ -150,12 +172,11 @@ gs_pixbuf_resample (GdkPixbuf *original,
 
 	/* is the aspect ratio of the source perfectly 16:9 */
 	if ((pixbuf_width / 16) * 9 == pixbuf_height) {
-		pixbuf = gdk_pixbuf_scale_simple (original,
-						  (gint) width, (gint) height,
-						  GDK_INTERP_HYPER);
 		if (blurred)
-			gs_utils_pixbuf_blur (pixbuf, 5, 3);
-		return g_steal_pointer (&pixbuf);
+			return gs_pixbuf_scale_blurred (original, width, height);
+		return gdk_pixbuf_scale_simple (original,
+						(gint) width, (gint) height,
+						GDK_INTERP_HYPER);
 	}
 
 	/* create new 16:9 pixbuf with alpha padding */
@@ -173,12 +194,16 @@ gs_pixbuf_resample (GdkPixbuf *original,
 		tmp_width = height * pixbuf_width / pixbuf_height;
 		tmp_height = height;
 	}
-	pixbuf_tmp = gdk_pixbuf_scale_simple (original,
-					      (gint) tmp_width,
-					      (gint) tmp_height,
-					      GDK_INTERP_HYPER);
-	if (blurred)
-		gs_utils_pixbuf_blur (pixbuf_tmp, 5, 3);
+	if (blurred) {
+		pixbuf_tmp = gs_pixbuf_scale_blurred (original, tmp_width, tmp_height);
+	} else {
+		pixbuf_tmp = gdk_pixbuf_scale_simple (original,
+						      (gint) tmp_width,
+						      (gint) tmp_height,
+						      GDK_INTERP_HYPER);
+	}
+	if (pixbuf_tmp == NULL)
+		return NULL;
 	gdk_pixbuf_copy_area (pixbuf_tmp,
 			      0, 0, /* of src */
 			      (gint) tmp_width,
@@ -207,21 +232,64 @@ gs_pixbuf_save_filename (GdkPixbuf *pixbuf,
 				NULL);
 }
 
+typedef struct {
+	gchar		*filename;
+	guint		 width;
+	guint		 height;
+} GsScreenshotBlurData;
+
 static void
-gs_screenshot_image_show_blurred (GsScreenshotImage *ssimg,
-				  const gchar *filename_thumb)
+gs_screenshot_blur_data_free (GsScreenshotBlurData *data)
 {
+	g_free (data->filename);
+	g_free (data);
+}
+
+static void
+gs_screenshot_image_blur_thread (GTask *task,
+				 gpointer source_object,
+				 gpointer task_data,
+				 GCancellable *cancellable)
+{
+	GsScreenshotBlurData *data = task_data;
 	g_autoptr(GdkPixbuf) pb_src = NULL;
 	g_autoptr(GdkPixbuf) pb = NULL;
+	g_autoptr(GError) error = NULL;
+
+	pb_src = gdk_pixbuf_new_from_file (data->filename, &error);
+	if (pb_src == NULL) {
+		g_task_return_error (task, g_steal_pointer (&error));
+		return;
+	}
+	if (g_task_return_error_if_cancelled (task))
+		return;
+	pb = gs_pixbuf_resample (pb_src, data->width, data->height, TRUE /* blurred */);
+	if (pb == NULL) {
+		g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED,
+					 "Failed to blur %s", data->filename);
+		return;
+	}
+	g_task_return_pointer (task, g_steal_pointer (&pb), g_object_unref);
+}
+
+static void
+gs_screenshot_image_blur_cb (GObject *source_object,
+			     GAsyncResult *result,
+			     gpointer user_data)
+{
+	GsScreenshotImage *ssimg = GS_SCREENSHOT_IMAGE (source_object);
+	g_autoptr(GdkPixbuf) pb = NULL;
+	g_autoptr(GError) error = NULL;
 
-	pb_src = gdk_pixbuf_new_from_file (filename_thumb, NULL);
-	if (pb_src == NULL)
+	pb = g_task_propagate_pointer (G_TASK (result), &error);
+	if (pb == NULL) {
+		if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+			g_debug ("failed to show blurred screenshot: %s", error->message);
 		return;
-	pb = gs_pixbuf_resample (pb_src,
-				 ssimg->width * ssimg->scale,
-				 ssimg->height * ssimg->scale,
-				 TRUE /* blurred */);
-	if (pb == NULL)
+	}
+
+	/* the full-size image got there first */
+	if (ssimg->showing_image)
 		return;
 
 	if (g_strcmp0 (ssimg->current_image, "image1") == 0) {
@@ -231,6 +299,29 @@ gs_screenshot_image_show_blurred (GsScreenshotImage *ssimg,
 	}
 }
 
+/* decoding and blurring even a thumbnail is too slow for the main thread */
+static void
+gs_screenshot_image_show_blurred (GsScreenshotImage *ssimg,
+				  const gchar *filename_thumb)
+{
+	GsScreenshotBlurData *data;
+	g_autoptr(GTask) task = NULL;
+
+	g_cancellable_cancel (ssimg->blur_cancellable);
+	g_clear_object (&ssimg->blur_cancellable);
+	ssimg->blur_cancellable = g_cancellable_new ();
+
+	data = g_new0 (GsScreenshotBlurData, 1);
+	data->filename = g_strdup (filename_thumb);
+	data->width = ssimg->width * ssimg->scale;
+	data->height = ssimg->height * ssimg->scale;
+
+	task = g_task_new (ssimg, ssimg->blur_cancellable, gs_screenshot_image_blur_cb, NULL);
+	g_task_set_source_tag (task, gs_screenshot_image_show_blurred);
+	g_task_set_task_data (task, data, (GDestroyNotify) gs_screenshot_blur_data_free);
+	g_task_run_in_thread (task, gs_screenshot_image_blur_thread);
+}
+
 static gboolean
 gs_screenshot_image_save_downloaded_img (GsScreenshotImage *ssimg,
 					 GdkPixbuf *pixbuf,
@@ -535,6 +626,10 @@ gs_screenshot_image_load_async (GsScreenshotImage *ssimg,
 	g_return_if_fail (ssimg->width != 0);
 	g_return_if_fail (ssimg->height != 0);
 
+	/* the previous blurred placeholder is no longer wanted */
+	g_cancellable_cancel (ssimg->blur_cancellable);
+	g_clear_object (&ssimg->blur_cancellable);
+
 	/* load an image according to the scale factor */
 	ssimg->scale = (guint) gtk_widget_get_scale_factor (GTK_WIDGET (ssimg));
 	im = as_screenshot_get_image (ssimg->screenshot,
@@ -744,6 +839,8 @@ gs_screenshot_image_dispose (GObject *object)
 #endif
 		g_clear_object (&ssimg->message);
 	}
+	g_cancellable_cancel (ssimg->blur_cancellable);
+	g_clear_object (&ssimg->blur_cancellable);
 	gs_widget_remove_all (GTK_WIDGET (ssimg), NULL);
 	g_clear_object (&ssimg->screenshot);
 	g_clear_object (&ssimg->session);
@@ -215,8 +215,9 @@ gs_search_page_waiting_show_cb (gpointer user_data)
 	return FALSE;
 }
 
+/* keys are sorted in descending order */
 static gchar *
-gs_search_page_get_app_sort_key (GsApp *app)
+gs_search_page_get_app_sort_key (GsApp *app, gpointer user_data)
 {
 	GString *key = g_string_sized_new (64);
 
@@ -252,16 +253,6 @@ gs_search_page_get_app_sort_key (GsApp *app)
 	return g_string_free (key, FALSE);
 }
 
-static gint
-gs_search_page_sort_cb (GsApp *app1, GsApp *app2, gpointer user_data)
-{
-	g_autofree gchar *key1 = NULL;
-	g_autofree gchar *key2 = NULL;
-	key1 = gs_search_page_get_app_sort_key (app1);
-	key2 = gs_search_page_get_app_sort_key (app2);
-	return g_strcmp0 (key2, key1);
-}
-
 static void
 gs_search_page_load (GsSearchPage *self)
 {
@@ -293,7 +284,8 @@ gs_search_page_load (GsSearchPage *self)
 					 "dedupe-flags", GS_APP_LIST_FILTER_FLAG_PREFER_INSTALLED |
 							 GS_APP_LIST_FILTER_FLAG_KEY_ID_PROVIDES,
 					 NULL);
-	gs_plugin_job_set_sort_func (plugin_job, gs_search_page_sort_cb, self);
+	gs_plugin_job_set_sort_key_func (plugin_job, gs_search_page_get_app_sort_key,
+					 GS_APP_LIST_SORT_FLAG_DESCENDING, self);
 	gs_plugin_loader_job_process_async (self->plugin_loader, plugin_job,
 					    self->search_cancellable,
 					    gs_search_page_get_search_cb,
@@ -98,8 +98,9 @@ search_done_cb (GObject *source,
 	g_application_release (g_application_get_default ());
 }
 
+/* keys are sorted in descending order */
 static gchar *
-gs_shell_search_provider_get_app_sort_key (GsApp *app)
+gs_shell_search_provider_get_app_sort_key (GsApp *app, gpointer user_data)
 {
 	GString *key = g_string_sized_new (64);
 
@@ -132,16 +133,6 @@ gs_shell_search_provider_get_app_sort_key (GsApp *app)
 	return g_string_free (key, FALSE);
 }
 
-static gint
-gs_shell_search_provider_sort_cb (GsApp *app1, GsApp *app2, gpointer user_data)
-{
-	g_autofree gchar *key1 = NULL;
-	g_autofree gchar *key2 = NULL;
-	key1 = gs_shell_search_provider_get_app_sort_key (app1);
-	key2 = gs_shell_search_provider_get_app_sort_key (app2);
-	return g_strcmp0 (key2, key1);
-}
-
 static void
 execute_search (GsShellSearchProvider  *self,
 		GDBusMethodInvocation  *invocation,
@@ -178,7 +169,8 @@ execute_search (GsShellSearchProvider  *self,
 					 "dedupe-flags", GS_APP_LIST_FILTER_FLAG_PREFER_INSTALLED |
 							 GS_APP_LIST_FILTER_FLAG_KEY_ID_PROVIDES,
 					 NULL);
-	gs_plugin_job_set_sort_func (plugin_job, gs_shell_search_provider_sort_cb, self);
+	gs_plugin_job_set_sort_key_func (plugin_job, gs_shell_search_provider_get_app_sort_key,
+					 GS_APP_LIST_SORT_FLAG_DESCENDING, self);
 	gs_plugin_loader_job_process_async (self->plugin_loader, plugin_job,
 					    self->cancellable,
 					    search_done_cb,
@@ -253,8 +245,17 @@ handle_get_result_metas (GsShellSearchProvider2	*skeleton,
 			if (icon_str != NULL) {
 				g_variant_builder_add (&meta, "{sv}", "gicon", g_variant_new_string (icon_str));
 			} else {
-				g_autoptr(GVariant) icon_serialized = g_icon_serialize (icon);
-				g_variant_builder_add (&meta, "{sv}", "icon", icon_serialized);
+				g_autoptr(GVariant) icon_serialized = NULL;
+				GObject *pixbuf = g_object_get_data (G_OBJECT (icon), "GnomeSoftware::pixbuf");
+
+				/* textures from the icon pack cannot be
+				 * serialized, but the pixbufs they came from can */
+				if (pixbuf != NULL)
+					icon_serialized = g_icon_serialize (G_ICON (pixbuf));
+				else
+					icon_serialized = g_icon_serialize (icon);
+				if (icon_serialized != NULL)
+					g_variant_builder_add (&meta, "{sv}", "icon", icon_serialized);
 			}
 		}
 
@@ -66,6 +66,7 @@ struct _GsShell
 	GSettings		*settings;
 	GCancellable		*cancellable;
 	GsPluginLoader		*plugin_loader;
+	gint64			 startup_time;
 	GtkWidget		*header_start_widget;
 	GtkWidget		*header_end_widget;
 	GtkWidget		*details_header_end_widget;
@@ -857,6 +858,18 @@ gs_shell_reload_cb (GsPluginLoader *plugin_loader, GsShell *shell)
 	}
 }
 
+static void
+gs_shell_log_first_overview (GsShell *shell, const gchar *source)
+{
+	/* only the first time the overview is shown is interesting */
+	if (shell->startup_time == 0)
+		return;
+	g_debug ("time to first overview: %.0fms (%s)",
+		 (g_get_monotonic_time () - shell->startup_time) / 1000.f,
+		 source);
+	shell->startup_time = 0;
+}
+
 static gboolean
 change_mode_idle (gpointer user_data)
 {
@@ -868,8 +881,10 @@ change_mode_idle (gpointer user_data)
 	/* Switch only when still on the loading page, otherwise the page
 	   could be changed from the command line or such, which would mean
 	   hiding the chosen page. */
-	if (gs_shell_get_mode (shell) == GS_SHELL_MODE_LOADING)
+	if (gs_shell_get_mode (shell) == GS_SHELL_MODE_LOADING) {
 		gs_shell_change_mode (shell, GS_SHELL_MODE_OVERVIEW, NULL, TRUE);
+		gs_shell_log_first_overview (shell, "live");
+	}
 
 	return G_SOURCE_REMOVE;
 }
@@ -2240,7 +2255,15 @@ gs_shell_setup (GsShell *shell, GsPluginLoader *plugin_loader, GCancellable *can
 	/* primary menu */
 	gs_shell_add_about_menu_item (shell);
 
-	if (g_settings_get_boolean (shell->settings, "download-updates")) {
+	if (g_settings_get_boolean (shell->settings, "download-updates") &&
+	    gs_overview_page_get_has_snapshot (GS_OVERVIEW_PAGE (shell->pages[GS_SHELL_MODE_OVERVIEW]))) {
+		/* show the apps from last time straight away, and refresh in
+		 * the background; initial_refresh_done() then reloads the
+		 * overview with the live results */
+		gs_shell_change_mode (shell, GS_SHELL_MODE_OVERVIEW, NULL, TRUE);
+		gs_shell_log_first_overview (shell, "snapshot");
+		gs_loading_page_refresh (GS_LOADING_PAGE (shell->pages[GS_SHELL_MODE_LOADING]));
+	} else if (g_settings_get_boolean (shell->settings, "download-updates")) {
 		/* show loading page, which triggers the initial refresh */
 		gs_shell_change_mode (shell, GS_SHELL_MODE_LOADING, NULL, TRUE);
 	} else {
@@ -2249,6 +2272,22 @@ gs_shell_setup (GsShell *shell, GsPluginLoader *plugin_loader, GCancellable *can
 	}
 }
 
+/**
+ * gs_shell_set_startup_time:
+ * @shell: a #GsShell
+ * @startup_time: monotonic time at which startup began, in microseconds
+ *
+ * Sets when startup began, so the time until the overview is first shown
+ * can be logged.
+ */
+void
+gs_shell_set_startup_time (GsShell *shell, gint64 startup_time)
+{
+	g_return_if_fail (GS_IS_SHELL (shell));
+
+	shell->startup_time = startup_time;
+}
+
 void
 gs_shell_reset_state (GsShell *shell)
 {